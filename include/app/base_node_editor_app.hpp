@@ -11,6 +11,7 @@
 //#include <imgui_canvas.h>
 
 #include "base_imgui_app.hpp"
+#include "font_loader.hpp"
 //-------------------------------------------------------------------
 
 
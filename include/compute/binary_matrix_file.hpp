@@ -0,0 +1,437 @@
+//-------------------------------------------------------------------
+/**
+ * @file binary_matrix_file.hpp
+ * @brief Layout of matrices dumped as raw binary files or NumPy .npy files.
+ *
+ * A binary matrix file is a header (possibly empty) followed by the
+ * elements of the matrix, row by row or column by column. Raw files are
+ * described by their element type, number of columns and header size,
+ * .npy files describe themselves in their header (format versions 1 to
+ * 3, see numpy.lib.format).
+ *
+ * Files of little-endian doubles can be mapped as they are (see
+ * MatrixStorage::attach_raw), the other ones are converted into doubles
+ * by the thread pool.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_BINARY_MATRIX_FILE_HPP_
+#define INCLUDE_COMPUTE_BINARY_MATRIX_FILE_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "thread_pool.hpp"
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+enum class BinaryElementType : int
+{
+    Float64 = 0,
+    Float32,
+    Int8,
+    UInt8,
+    Int16,
+    UInt16,
+    Int32,
+    UInt32,
+    Int64,
+    UInt64
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+inline int64_t get_element_size(BinaryElementType element_type)
+{
+    switch(element_type)
+    {
+        default:
+        case BinaryElementType::Float64:
+        case BinaryElementType::Int64:
+        case BinaryElementType::UInt64:
+            return 8;
+
+        case BinaryElementType::Float32:
+        case BinaryElementType::Int32:
+        case BinaryElementType::UInt32:
+            return 4;
+
+        case BinaryElementType::Int16:
+        case BinaryElementType::UInt16:
+            return 2;
+
+        case BinaryElementType::Int8:
+        case BinaryElementType::UInt8:
+            return 1;
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Where and how the elements of a matrix are stored in a binary file.
+ */
+//-------------------------------------------------------------------
+struct BinaryMatrixLayout
+{
+    BinaryElementType element_type = BinaryElementType::Float64;
+    bool is_big_endian = false;
+    bool is_column_major = false;       // Fortran order
+
+    uint64_t offset = 0;                // Bytes before the first element
+    int64_t rows = 0;
+    int64_t columns = 0;
+
+    int64_t size()const
+    {
+        return rows * columns;
+    }
+
+    uint64_t get_data_size()const
+    {
+        return uint64_t(size() * get_element_size(element_type));
+    }
+
+    // Little-endian doubles, aligned, can be used in place
+    bool can_be_mapped()const
+    {
+        return element_type == BinaryElementType::Float64 &&
+               !is_big_endian &&
+               offset % sizeof(double) == 0 &&
+               size() > 0;
+    }
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief The layout of a raw file of rows of the given number of columns.
+ *
+ * Trailing bytes that don't make a whole row are ignored.
+ */
+//-------------------------------------------------------------------
+inline BinaryMatrixLayout make_raw_matrix_layout(uint64_t file_size,
+                                                 BinaryElementType element_type,
+                                                 int64_t columns,
+                                                 uint64_t header_size)
+{
+    BinaryMatrixLayout layout;
+    layout.element_type = element_type;
+    layout.offset = header_size;
+
+    const uint64_t row_size = uint64_t(std::max(int64_t(1), columns) * get_element_size(element_type));
+
+    if(columns > 0 && file_size > header_size)
+    {
+        layout.rows = int64_t((file_size - header_size) / row_size);
+        layout.columns = layout.rows > 0 ? columns : 0;
+    }
+
+    return layout;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Detail
+{
+    // The text following "'key':" in an .npy header dictionary
+    inline std::string find_npy_header_value(const std::string& header, const std::string& key)
+    {
+        std::size_t position = header.find("'" + key + "'");
+
+        if(position == std::string::npos)
+            position = header.find("\"" + key + "\"");
+
+        if(position == std::string::npos)
+            return std::string();
+
+        position = header.find(':', position);
+
+        if(position == std::string::npos)
+            return std::string();
+
+        position = header.find_first_not_of(" ", position + 1);
+
+        return position == std::string::npos ? std::string() : header.substr(position);
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Reads the layout of an .npy file from its first bytes.
+ *
+ * 1-d arrays are read as a column, arrays of more than 2 dimensions as
+ * rows of their first dimension (their other dimensions flattened).
+ *
+ * @return false if it isn't an .npy file, or its elements aren't numbers
+ *         of a supported type.
+ */
+//-------------------------------------------------------------------
+inline bool parse_npy_header(const char* data, int64_t size, BinaryMatrixLayout& layout)
+{
+    constexpr char MAGIC[] = "\x93NUMPY";
+
+    if(size < 10 || std::memcmp(data, MAGIC, 6) != 0)
+        return false;
+
+    const int major_version = uint8_t(data[6]);
+
+    uint64_t header_size = 0;
+    uint64_t header_start = 0;
+
+    if(major_version == 1)
+    {
+        header_size = uint64_t(uint8_t(data[8])) | (uint64_t(uint8_t(data[9])) << 8);
+        header_start = 10;
+    }
+    else if((major_version == 2 || major_version == 3) && size >= 12)
+    {
+        for(int i = 0; i < 4; ++i)
+            header_size |= uint64_t(uint8_t(data[8 + i])) << (8 * i);
+
+        header_start = 12;
+    }
+    else
+    {
+        return false;
+    }
+
+    if(uint64_t(size) < header_start + header_size)
+        return false;
+
+    const std::string header(data + header_start, header_size);
+
+    // The type, like '<f8', '|u1' or '>i4'
+    const std::string description = Detail::find_npy_header_value(header, "descr");
+
+    if(description.size() < 4 || (description[0] != '\'' && description[0] != '"'))
+        return false;
+
+    const char byte_order = description[1];
+    const char kind = description[2];
+    const int64_t element_size = std::atoll(description.c_str() + 3);
+
+    BinaryMatrixLayout npy_layout;
+    npy_layout.is_big_endian = (byte_order == '>');
+
+    if(kind == 'f' && element_size == 8)
+        npy_layout.element_type = BinaryElementType::Float64;
+    else if(kind == 'f' && element_size == 4)
+        npy_layout.element_type = BinaryElementType::Float32;
+    else if((kind == 'u' || kind == 'b') && element_size == 1)
+        npy_layout.element_type = BinaryElementType::UInt8;
+    else if(kind == 'i' && element_size == 1)
+        npy_layout.element_type = BinaryElementType::Int8;
+    else if(kind == 'u' && element_size == 2)
+        npy_layout.element_type = BinaryElementType::UInt16;
+    else if(kind == 'i' && element_size == 2)
+        npy_layout.element_type = BinaryElementType::Int16;
+    else if(kind == 'u' && element_size == 4)
+        npy_layout.element_type = BinaryElementType::UInt32;
+    else if(kind == 'i' && element_size == 4)
+        npy_layout.element_type = BinaryElementType::Int32;
+    else if(kind == 'u' && element_size == 8)
+        npy_layout.element_type = BinaryElementType::UInt64;
+    else if(kind == 'i' && element_size == 8)
+        npy_layout.element_type = BinaryElementType::Int64;
+    else
+        return false;
+
+    npy_layout.is_column_major = Detail::find_npy_header_value(header, "fortran_order").rfind("True", 0) == 0;
+
+    // The shape, like (3, 4), (5,) or ()
+    const std::string shape = Detail::find_npy_header_value(header, "shape");
+
+    if(shape.empty() || shape[0] != '(')
+        return false;
+
+    std::vector<int64_t> dimensions;
+
+    for(std::size_t position = 1; position < shape.size() && shape[position] != ')'; ++position)
+    {
+        if(shape[position] >= '0' && shape[position] <= '9')
+        {
+            dimensions.push_back(std::atoll(shape.c_str() + position));
+
+            while(position + 1 < shape.size() && shape[position + 1] >= '0' && shape[position + 1] <= '9')
+                ++position;
+        }
+    }
+
+    npy_layout.rows = dimensions.empty() ? 1 : dimensions[0];
+    npy_layout.columns = 1;
+
+    for(std::size_t i = 1; i < dimensions.size(); ++i)
+        npy_layout.columns *= dimensions[i];
+
+    // The flattened dimensions of a Fortran-ordered array aren't
+    // contiguous columns, only 2-d ones are read as such
+    if(npy_layout.is_column_major && dimensions.size() > 2)
+        return false;
+
+    npy_layout.offset = header_start + header_size;
+
+    layout = npy_layout;
+
+    return true;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Reads the layout of an .npy file (see parse_npy_header) and checks it fits in the file.
+ */
+//-------------------------------------------------------------------
+inline bool read_npy_layout(const std::filesystem::path& filename, BinaryMatrixLayout& layout)
+{
+    std::error_code error;
+    const uint64_t file_size = std::filesystem::file_size(filename, error);
+
+    if(error)
+        return false;
+
+    // Headers are padded to a multiple of 64 bytes, and rarely bigger than a few hundred
+    std::vector<char> header(std::size_t(std::min(file_size, uint64_t(1) << 16)));
+
+    std::ifstream file(filename, std::ios::binary);
+
+    if(!file.read(header.data(), std::streamsize(header.size())))
+        return false;
+
+    BinaryMatrixLayout npy_layout;
+
+    if(!parse_npy_header(header.data(), int64_t(header.size()), npy_layout) ||
+       npy_layout.offset + npy_layout.get_data_size() > file_size)
+    {
+        return false;
+    }
+
+    layout = npy_layout;
+
+    return true;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Detail
+{
+    template<typename ElementType>
+    inline double read_binary_element(const char* element, bool is_big_endian)
+    {
+        char bytes[sizeof(ElementType)];
+        std::memcpy(bytes, element, sizeof(ElementType));
+
+        if(is_big_endian)
+            std::reverse(bytes, bytes + sizeof(ElementType));
+
+        ElementType value;
+        std::memcpy(&value, bytes, sizeof(ElementType));
+
+        return double(value);
+    }
+
+    // Converts rows [first_row, last_row) of the matrix
+    template<typename ElementType>
+    inline void convert_binary_rows(const char* data, const BinaryMatrixLayout& layout, int64_t first_row, int64_t last_row, double* output)
+    {
+        const int64_t row_stride = layout.is_column_major ? 1 : layout.columns;
+        const int64_t column_stride = layout.is_column_major ? layout.rows : 1;
+
+        for(int64_t i = first_row; i < last_row; ++i)
+        {
+            for(int64_t j = 0; j < layout.columns; ++j)
+            {
+                const char* element = data + (i * row_stride + j * column_stride) * int64_t(sizeof(ElementType));
+                output[i * layout.columns + j] = read_binary_element<ElementType>(element, layout.is_big_endian);
+            }
+        }
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Converts the elements of a binary matrix into a row-major matrix of doubles.
+ *
+ * @param data The file's contents, from the layout's offset on.
+ * @param output layout.rows * layout.columns doubles.
+ */
+//-------------------------------------------------------------------
+inline void convert_binary_matrix(const char* data, const BinaryMatrixLayout& layout, double* output)
+{
+    if(layout.size() == 0)
+        return;
+
+    const int64_t rows_per_task = std::max(int64_t(1), (int64_t(64) << 10) / std::max(int64_t(1), layout.columns));
+    const int64_t number_of_tasks = (layout.rows + rows_per_task - 1) / rows_per_task;
+
+    get_thread_pool().parallel_for(number_of_tasks, [&](int64_t task)
+    {
+        const int64_t first_row = task * rows_per_task;
+        const int64_t last_row = std::min(layout.rows, first_row + rows_per_task);
+
+        switch(layout.element_type)
+        {
+            default:
+            case BinaryElementType::Float64: Detail::convert_binary_rows<double>(data, layout, first_row, last_row, output); break;
+            case BinaryElementType::Float32: Detail::convert_binary_rows<float>(data, layout, first_row, last_row, output); break;
+            case BinaryElementType::Int8: Detail::convert_binary_rows<int8_t>(data, layout, first_row, last_row, output); break;
+            case BinaryElementType::UInt8: Detail::convert_binary_rows<uint8_t>(data, layout, first_row, last_row, output); break;
+            case BinaryElementType::Int16: Detail::convert_binary_rows<int16_t>(data, layout, first_row, last_row, output); break;
+            case BinaryElementType::UInt16: Detail::convert_binary_rows<uint16_t>(data, layout, first_row, last_row, output); break;
+            case BinaryElementType::Int32: Detail::convert_binary_rows<int32_t>(data, layout, first_row, last_row, output); break;
+            case BinaryElementType::UInt32: Detail::convert_binary_rows<uint32_t>(data, layout, first_row, last_row, output); break;
+            case BinaryElementType::Int64: Detail::convert_binary_rows<int64_t>(data, layout, first_row, last_row, output); break;
+            case BinaryElementType::UInt64: Detail::convert_binary_rows<uint64_t>(data, layout, first_row, last_row, output); break;
+        }
+    });
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_BINARY_MATRIX_FILE_HPP_
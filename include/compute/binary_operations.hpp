@@ -0,0 +1,244 @@
+//-------------------------------------------------------------------
+/**
+ * @file binary_operations.hpp
+ * @brief Elementwise binary operations between two matrices, with broadcasting.
+ *
+ * Two matrices can be combined when each of their dimensions either
+ * match or is 1 in one of them, in which case that row (or column) is
+ * repeated to fill the other one. For example a 1xN row is added to
+ * every row of an MxN matrix, and an Mx1 column to every column.
+ *
+ * Broadcasting is done with zero strides, so nothing is copied.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_BINARY_OPERATIONS_HPP_
+#define INCLUDE_COMPUTE_BINARY_OPERATIONS_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <algorithm>
+#include <cstdint>
+
+#include "matrix_view.hpp"
+#include "thread_pool.hpp"
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Binary operations that combine matching elements of two matrices
+//-------------------------------------------------------------------
+enum class BinaryOperation : int
+{
+    Add = 0,
+    Subtract,
+    Multiply,
+    Divide
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief True when the two matrices can be combined elementwise (see broadcasting above).
+ */
+//-------------------------------------------------------------------
+inline bool are_broadcastable(const MatrixView& a, const MatrixView& b)
+{
+    if(a.size() == 0 || b.size() == 0)
+        return false;
+
+    return (a.rows() == b.rows() || a.rows() == 1 || b.rows() == 1) &&
+           (a.columns() == b.columns() || a.columns() == 1 || b.columns() == 1);
+}
+
+
+
+/**
+ * @brief Returns the view stretched to rows x columns, repeating its single row or column.
+ */
+inline MatrixView broadcast(const MatrixView& view, int64_t rows, int64_t columns)
+{
+    return MatrixView(view.data(),
+                      rows,
+                      columns,
+                      (view.rows() == 1) ? 0 : view.row_stride(),
+                      (view.columns() == 1) ? 0 : view.column_stride());
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+template<BinaryOperation Operation>
+
+inline double apply_binary_operation(double a, double b)
+{
+    if constexpr(Operation == BinaryOperation::Add)
+        return a + b;
+    else if constexpr(Operation == BinaryOperation::Subtract)
+        return a - b;
+    else if constexpr(Operation == BinaryOperation::Multiply)
+        return a * b;
+    else
+        return a / b;
+}
+
+
+
+/**
+ * @brief Combines two strided rows into a contiguous one.
+ *
+ * The common cases (both rows contiguous, or one of them a single
+ * repeated value) get loops of their own so the compiler can vectorize
+ * them.
+ */
+template<BinaryOperation Operation>
+
+inline void apply_binary_operation(const double* a,
+                                   int64_t a_stride,
+                                   const double* b,
+                                   int64_t b_stride,
+                                   double* destination,
+                                   int64_t number_of_elements)
+{
+    if(a_stride == 1 && b_stride == 1)
+    {
+        for(int64_t i = 0; i < number_of_elements; ++i)
+            destination[i] = apply_binary_operation<Operation>(a[i], b[i]);
+    }
+    else if(a_stride == 1 && b_stride == 0)
+    {
+        const double b_value = *b;
+
+        for(int64_t i = 0; i < number_of_elements; ++i)
+            destination[i] = apply_binary_operation<Operation>(a[i], b_value);
+    }
+    else if(a_stride == 0 && b_stride == 1)
+    {
+        const double a_value = *a;
+
+        for(int64_t i = 0; i < number_of_elements; ++i)
+            destination[i] = apply_binary_operation<Operation>(a_value, b[i]);
+    }
+    else
+    {
+        for(int64_t i = 0; i < number_of_elements; ++i)
+            destination[i] = apply_binary_operation<Operation>(a[i * a_stride], b[i * b_stride]);
+    }
+}
+
+
+
+inline void apply_binary_operation(BinaryOperation operation,
+                                   const double* a,
+                                   int64_t a_stride,
+                                   const double* b,
+                                   int64_t b_stride,
+                                   double* destination,
+                                   int64_t number_of_elements)
+{
+    switch(operation)
+    {
+        default:
+        case BinaryOperation::Add:
+            apply_binary_operation<BinaryOperation::Add>(a, a_stride, b, b_stride, destination, number_of_elements);
+        break;
+
+        case BinaryOperation::Subtract:
+            apply_binary_operation<BinaryOperation::Subtract>(a, a_stride, b, b_stride, destination, number_of_elements);
+        break;
+
+        case BinaryOperation::Multiply:
+            apply_binary_operation<BinaryOperation::Multiply>(a, a_stride, b, b_stride, destination, number_of_elements);
+        break;
+
+        case BinaryOperation::Divide:
+            apply_binary_operation<BinaryOperation::Divide>(a, a_stride, b, b_stride, destination, number_of_elements);
+        break;
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Number of elements handed to a thread at a time
+constexpr int64_t BINARY_OPERATION_TASK_SIZE = int64_t(32) << 10;
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Combines two broadcastable matrices into a row-major destination.
+ *
+ * The destination must hold max(a.rows(), b.rows()) rows of
+ * max(a.columns(), b.columns()) elements. Rows are split across the
+ * thread pool in groups of about BINARY_OPERATION_TASK_SIZE elements.
+ *
+ * @return false (and nothing is written) if the matrices aren't broadcastable.
+ */
+//-------------------------------------------------------------------
+inline bool evaluate_binary_operation(BinaryOperation operation,
+                                      const MatrixView& a,
+                                      const MatrixView& b,
+                                      double* destination,
+                                      int64_t destination_row_stride)
+{
+    if(!are_broadcastable(a, b))
+        return false;
+
+    const int64_t rows = std::max(a.rows(), b.rows());
+    const int64_t columns = std::max(a.columns(), b.columns());
+
+    const MatrixView broadcasted_a = broadcast(a, rows, columns);
+    const MatrixView broadcasted_b = broadcast(b, rows, columns);
+
+    const int64_t rows_per_task = std::max(int64_t(1), BINARY_OPERATION_TASK_SIZE / columns);
+    const int64_t number_of_tasks = (rows + rows_per_task - 1) / rows_per_task;
+
+    get_thread_pool().parallel_for(number_of_tasks, [&](int64_t task)
+    {
+        const int64_t first_row = task * rows_per_task;
+        const int64_t last_row = std::min(rows, first_row + rows_per_task);
+
+        for(int64_t row = first_row; row < last_row; ++row)
+        {
+            apply_binary_operation(operation,
+                                   broadcasted_a.row_pointer(row),
+                                   broadcasted_a.column_stride(),
+                                   broadcasted_b.row_pointer(row),
+                                   broadcasted_b.column_stride(),
+                                   destination + row * destination_row_stride,
+                                   columns);
+        }
+    });
+
+    return true;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_BINARY_OPERATIONS_HPP_
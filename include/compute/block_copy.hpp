@@ -0,0 +1,112 @@
+//-------------------------------------------------------------------
+/**
+ * @file block_copy.hpp
+ * @brief Copying a matrix into a block of a bigger one, padding it with zeros.
+ *
+ * This is how augmented (concatenated) results are assembled: the
+ * output is allocated once and each input is copied into its own block
+ * of it, which can be rewritten on its own when only that input changes.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_BLOCK_COPY_HPP_
+#define INCLUDE_COMPUTE_BLOCK_COPY_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "matrix_view.hpp"
+#include "thread_pool.hpp"
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Number of elements handed to a thread at a time
+constexpr int64_t BLOCK_COPY_TASK_SIZE = int64_t(64) << 10;
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Copies the source into a rows x columns block of the destination.
+ *
+ * The part of the block the source doesn't cover (when it has fewer
+ * rows or columns than the block) is filled with zeros, the part of the
+ * source that doesn't fit in the block is left out. Groups of rows are
+ * spread over the thread pool.
+ *
+ * @param destination Pointer to element (0,0) of the block.
+ * @param destination_row_stride Distance (in elements) between destination rows.
+ */
+//-------------------------------------------------------------------
+inline void copy_into_block(const MatrixView& source,
+                            double* destination,
+                            int64_t destination_row_stride,
+                            int64_t rows,
+                            int64_t columns)
+{
+    if(rows <= 0 || columns <= 0)
+        return;
+
+    const int64_t copied_columns = std::min(columns, source.columns());
+
+    const int64_t rows_per_task = std::max(int64_t(1), BLOCK_COPY_TASK_SIZE / columns);
+    const int64_t number_of_tasks = (rows + rows_per_task - 1) / rows_per_task;
+
+    get_thread_pool().parallel_for(number_of_tasks, [&](int64_t task)
+    {
+        const int64_t first_row = task * rows_per_task;
+        const int64_t last_row = std::min(rows, first_row + rows_per_task);
+
+        for(int64_t i = first_row; i < last_row; ++i)
+        {
+            double* destination_row = destination + i * destination_row_stride;
+
+            if(i >= source.rows())
+            {
+                std::fill(destination_row, destination_row + columns, 0.0);
+                continue;
+            }
+
+            if(source.has_contiguous_rows())
+            {
+                std::memcpy(destination_row, source.row_pointer(i), copied_columns * sizeof(double));
+            }
+            else
+            {
+                for(int64_t j = 0; j < copied_columns; ++j)
+                    destination_row[j] = source(i,j);
+            }
+
+            std::fill(destination_row + copied_columns, destination_row + columns, 0.0);
+        }
+    });
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_BLOCK_COPY_HPP_
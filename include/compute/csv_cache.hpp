@@ -0,0 +1,419 @@
+//-------------------------------------------------------------------
+/**
+ * @file csv_cache.hpp
+ * @brief Binary copies of parsed CSV files, so that they're only parsed once.
+ *
+ * The first time a CSV file is parsed, its matrix is written to a
+ * matrix file (see matrix_file.hpp) in the cache directory, along with
+ * a small key file describing the CSV file it came from: its path,
+ * size, modification time and a hash of its content (sampled like the
+ * fingerprint of matrix files), the header options it was parsed with
+ * and the names of its columns. Loading the same file again maps the
+ * matrix file instead of parsing the text.
+ *
+ * There's one cache entry per CSV path and header options, a file that
+ * changed simply overwrites its entry the next time it's parsed. The
+ * modification time of a key file is the last time its entry was used,
+ * and the least recently used entries are removed when the cache grows
+ * past MAXIMUM_CSV_CACHE_SIZE.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_CSV_CACHE_HPP_
+#define INCLUDE_COMPUTE_CSV_CACHE_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "csv_parser.hpp"
+#include "matrix_file.hpp"
+#include "matrix_storage.hpp"
+#include "matrix_view.hpp"
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Size the cache directory is pruned to after an entry is written
+constexpr uint64_t MAXIMUM_CSV_CACHE_SIZE = uint64_t(4) << 30;
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief What a cached matrix has to match to stand for a CSV file.
+ */
+//-------------------------------------------------------------------
+struct CsvCacheKey
+{
+    static constexpr const char* MAGIC = "LZDCSVCACHE";
+    static constexpr int VERSION = 1;
+
+    std::string csv_filename;           // Absolute path of the CSV file
+    uint64_t file_size = 0;             // 0 if the CSV file can't be read
+    int64_t modification_time = 0;
+    uint64_t hash = 0;
+
+    bool has_column_headers = false;
+    bool has_row_headers = false;
+
+    bool operator==(const CsvCacheKey& key)const
+    {
+        return csv_filename == key.csv_filename &&
+               file_size == key.file_size &&
+               modification_time == key.modification_time &&
+               hash == key.hash &&
+               has_column_headers == key.has_column_headers &&
+               has_row_headers == key.has_row_headers;
+    }
+
+    bool operator!=(const CsvCacheKey& key)const
+    {
+        return !(*this == key);
+    }
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief The directory where parsed CSV files are cached (in the scratch directory).
+ */
+//-------------------------------------------------------------------
+inline std::filesystem::path get_csv_cache_directory()
+{
+    return StorageManager::get_scratch_directory() / "csv_cache";
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Describes a CSV file as it is now, parsed with the given header options.
+ */
+//-------------------------------------------------------------------
+inline CsvCacheKey make_csv_cache_key(const std::filesystem::path& csv_filename, const CsvOptions& options)
+{
+    CsvCacheKey key;
+
+    std::error_code error;
+    const std::filesystem::path absolute_filename = std::filesystem::absolute(csv_filename, error);
+    const auto modification_time = std::filesystem::last_write_time(csv_filename, error);
+
+    if(error)
+        return CsvCacheKey();
+
+    const MatrixFileFingerprint fingerprint = compute_matrix_file_fingerprint(csv_filename);
+
+    key.csv_filename = absolute_filename.generic_string();
+    key.file_size = fingerprint.file_size;
+    key.modification_time = int64_t(modification_time.time_since_epoch().count());
+    key.hash = fingerprint.hash;
+    key.has_column_headers = options.has_column_headers;
+    key.has_row_headers = options.has_row_headers;
+
+    return key;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief The matrix file of the cache entry of a CSV file (it may not exist).
+ */
+//-------------------------------------------------------------------
+inline std::filesystem::path get_csv_cache_filename(const CsvCacheKey& key, const std::filesystem::path& cache_directory)
+{
+    // 64-bit FNV-1a of the path and header options
+    uint64_t hash = 14695981039346656037ull;
+
+    const std::string name = key.csv_filename + (key.has_column_headers ? "|c" : "|") + (key.has_row_headers ? "r" : "");
+
+    for(char character : name)
+    {
+        hash ^= uint8_t(character);
+        hash *= 1099511628211ull;
+    }
+
+    char filename[32];
+    std::snprintf(filename, sizeof(filename), "%016llx.lzd", (unsigned long long)hash);
+
+    return cache_directory / filename;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Detail
+{
+    inline std::filesystem::path get_csv_cache_key_filename(const std::filesystem::path& matrix_filename)
+    {
+        std::filesystem::path key_filename = matrix_filename;
+        key_filename.replace_extension(".key");
+
+        return key_filename;
+    }
+
+    inline void set_csv_cache_use_time(const std::filesystem::path& key_filename)
+    {
+        std::error_code error;
+        std::filesystem::last_write_time(key_filename, std::filesystem::file_time_type::clock::now(), error);
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Looks for a cached matrix of a CSV file.
+ *
+ * @param column_headers If not nullptr, gets the names of the columns.
+ * @return The matrix file to attach, or an empty path if the CSV file
+ *         wasn't cached, changed since, or the matrix file did.
+ */
+//-------------------------------------------------------------------
+inline std::filesystem::path find_csv_cache(const CsvCacheKey& key,
+                                            const std::filesystem::path& cache_directory,
+                                            std::vector<std::string>* column_headers = nullptr)
+{
+    if(key.file_size == 0)
+        return std::filesystem::path();
+
+    const std::filesystem::path matrix_filename = get_csv_cache_filename(key, cache_directory);
+
+    const std::filesystem::path key_filename = Detail::get_csv_cache_key_filename(matrix_filename);
+
+    std::ifstream key_file(key_filename);
+
+    std::string magic;
+    int version = 0;
+    CsvCacheKey cached_key;
+    MatrixFileFingerprint matrix_fingerprint;
+    int64_t number_of_column_headers = 0;
+
+    key_file >> magic >> version;
+    key_file.ignore(1);
+    std::getline(key_file, cached_key.csv_filename);
+    key_file >> cached_key.file_size
+             >> cached_key.modification_time
+             >> cached_key.hash
+             >> cached_key.has_column_headers
+             >> cached_key.has_row_headers
+             >> matrix_fingerprint.file_size
+             >> matrix_fingerprint.hash
+             >> number_of_column_headers;
+
+    if(!key_file ||
+       magic != CsvCacheKey::MAGIC ||
+       version != CsvCacheKey::VERSION ||
+       cached_key != key ||
+       compute_matrix_file_fingerprint(matrix_filename) != matrix_fingerprint)
+    {
+        return std::filesystem::path();
+    }
+
+    if(column_headers)
+    {
+        column_headers->assign(std::max(int64_t(0), number_of_column_headers), std::string());
+        key_file.ignore(1);
+
+        for(auto& column_header : *column_headers)
+            std::getline(key_file, column_header);
+    }
+
+    key_file.close();
+    Detail::set_csv_cache_use_time(key_filename);
+
+    return matrix_filename;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Removes the least recently used entries until the cache takes maximum_size bytes or less.
+ *
+ * Entries whose matrix file can't be removed (it's mapped on some
+ * systems) are left.
+ *
+ * @param kept_matrix_filename Entry that's never removed, the one just written.
+ */
+//-------------------------------------------------------------------
+inline void prune_csv_cache(const std::filesystem::path& cache_directory,
+                            uint64_t maximum_size,
+                            const std::filesystem::path& kept_matrix_filename = std::filesystem::path())
+{
+    struct Entry
+    {
+        std::filesystem::path matrix_filename;
+        std::filesystem::file_time_type use_time;
+        uint64_t size = 0;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t cache_size = 0;
+
+    std::error_code error;
+
+    for(const auto& file : std::filesystem::directory_iterator(cache_directory, error))
+    {
+        if(file.path().extension() != ".lzd")
+            continue;
+
+        std::error_code file_error;
+
+        Entry entry;
+        entry.matrix_filename = file.path();
+        entry.size = std::filesystem::file_size(entry.matrix_filename, file_error);
+
+        if(file_error)
+            continue;
+
+        // An entry without key file is half written (or was
+        // abandoned), it's as old as its matrix file
+        const std::filesystem::path key_filename = Detail::get_csv_cache_key_filename(entry.matrix_filename);
+
+        entry.use_time = std::filesystem::last_write_time(key_filename, file_error);
+
+        if(!file_error)
+            entry.size += std::filesystem::file_size(key_filename, file_error);
+
+        if(file_error)
+            entry.use_time = std::filesystem::last_write_time(entry.matrix_filename, file_error);
+
+        cache_size += entry.size;
+        entries.push_back(entry);
+    }
+
+    if(cache_size <= maximum_size)
+        return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b)
+    {
+        return a.use_time < b.use_time;
+    });
+
+    for(const auto& entry : entries)
+    {
+        if(cache_size <= maximum_size)
+            break;
+
+        if(entry.matrix_filename == kept_matrix_filename || !std::filesystem::remove(entry.matrix_filename, error))
+            continue;
+
+        std::filesystem::remove(Detail::get_csv_cache_key_filename(entry.matrix_filename), error);
+
+        cache_size -= entry.size;
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Caches the matrix parsed from a CSV file (replacing its previous entry).
+ *
+ * The key file is written last, so an entry is never found half written.
+ * The least recently used entries are then pruned (see prune_csv_cache).
+ *
+ * @return false if the matrix is empty or the files couldn't be written.
+ */
+//-------------------------------------------------------------------
+inline bool write_csv_cache(const CsvCacheKey& key,
+                            const std::filesystem::path& cache_directory,
+                            const MatrixView& view,
+                            const std::vector<std::string>& column_headers,
+                            uint64_t maximum_cache_size = MAXIMUM_CSV_CACHE_SIZE)
+{
+    if(key.file_size == 0)
+        return false;
+
+    std::error_code error;
+    std::filesystem::create_directories(cache_directory, error);
+
+    const std::filesystem::path matrix_filename = get_csv_cache_filename(key, cache_directory);
+    const std::filesystem::path key_filename = Detail::get_csv_cache_key_filename(matrix_filename);
+
+    std::filesystem::remove(key_filename, error);
+
+    if(!write_matrix_file(view, matrix_filename))
+        return false;
+
+    const MatrixFileFingerprint matrix_fingerprint = compute_matrix_file_fingerprint(matrix_filename);
+
+    std::filesystem::path temporary_filename = key_filename;
+    temporary_filename += ".tmp";
+
+    {
+        std::ofstream key_file(temporary_filename, std::ios::trunc);
+
+        key_file << CsvCacheKey::MAGIC << " " << CsvCacheKey::VERSION << "\n"
+                 << key.csv_filename << "\n"
+                 << key.file_size << " "
+                 << key.modification_time << " "
+                 << key.hash << " "
+                 << key.has_column_headers << " "
+                 << key.has_row_headers << "\n"
+                 << matrix_fingerprint.file_size << " "
+                 << matrix_fingerprint.hash << "\n"
+                 << column_headers.size() << "\n";
+
+        // One name per line
+        for(std::string column_header : column_headers)
+        {
+            std::replace(column_header.begin(), column_header.end(), '\n', ' ');
+            key_file << column_header << "\n";
+        }
+
+        if(!key_file)
+            return false;
+    }
+
+    std::filesystem::rename(temporary_filename, key_filename, error);
+
+    if(error)
+        return false;
+
+    Detail::set_csv_cache_use_time(key_filename);
+    prune_csv_cache(cache_directory, maximum_cache_size, matrix_filename);
+
+    return true;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_CSV_CACHE_HPP_
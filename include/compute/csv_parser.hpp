@@ -0,0 +1,591 @@
+//-------------------------------------------------------------------
+/**
+ * @file csv_parser.hpp
+ * @brief Multithreaded parser turning a CSV text into a matrix of doubles.
+ *
+ * The text is cut into chunks that are parsed by the thread pool. A
+ * chunk can't tell on its own where its first row starts, since a
+ * quoted field can hold newlines, so parsing takes two passes:
+ *
+ * - index() counts the quotes and the newlines of every chunk, 64 bytes
+ *   at a time (SSE2 compares and bit masks). Newlines inside quotes are
+ *   found with a prefix xor of the quote mask, and every chunk is
+ *   counted for both quote states it could start in, so the chunks are
+ *   independent. A prefix sum then gives the quote state and the first
+ *   row of every chunk, and the size of the matrix.
+ *
+ * - parse() parses the rows starting in every chunk straight into the
+ *   output matrix, numbers are read with std::from_chars.
+ *
+ * Fields that aren't numbers are NaN, missing fields too, and fields
+ * past the number of columns of the first row are ignored.
+ *
+ * Files that are still being written can be parsed piece by piece, by
+ * leaving their last line out until its newline arrives and parsing
+ * only what was appended since (see CsvOptions).
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_CSV_PARSER_HPP_
+#define INCLUDE_COMPUTE_CSV_PARSER_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "instruction_set.hpp"
+#include "thread_pool.hpp"
+
+#if defined(LAZYDATA_X86_64)
+    #include <emmintrin.h>
+#endif
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief How a CSV text is laid out.
+ */
+//-------------------------------------------------------------------
+struct CsvOptions
+{
+    // Number of bytes parsed by a thread at a time
+    static constexpr int64_t DEFAULT_CHUNK_SIZE = int64_t(4) << 20;
+
+    bool has_column_headers = false;    // The first row holds the names of the columns
+    bool has_row_headers = false;       // The first field of every row holds its name
+
+    char delimiter = 0;                 // 0 to pick ',', ';' or '\t' from the first row
+    int64_t columns = 0;                // 0 to count the fields of the first row
+
+    bool skip_incomplete_last_line = false;   // Leave out a last line that has no newline yet
+
+    int64_t chunk_size = DEFAULT_CHUNK_SIZE;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @class CsvParser
+ * @brief Parses a CSV text (index() then parse()).
+ *
+ * The text isn't copied, it has to outlive the parser.
+ */
+//-------------------------------------------------------------------
+class CsvParser
+{
+public:
+
+    CsvParser()
+    {
+    }
+
+
+
+    /**
+     * @brief Finds the rows of the text and the size of the matrix.
+     */
+    void index(const char* text, int64_t size, const CsvOptions& options)
+    {
+        text_ = text;
+        size_ = std::max(int64_t(0), size);
+        options_ = options;
+        options_.chunk_size = std::max(int64_t(64), options_.chunk_size);
+        parsed_bytes_ = 0;
+
+        chunks_.assign((size_ + options_.chunk_size - 1) / options_.chunk_size, Chunk());
+        number_of_lines_ = 0;
+        columns_ = 0;
+        consumed_size_ = 0;
+        column_headers_.clear();
+
+        if(size_ == 0)
+            return;
+
+        get_thread_pool().parallel_for(int64_t(chunks_.size()), [this](int64_t i)
+        {
+            count_chunk(i);
+        });
+
+        // Quote state and first line of every chunk
+        bool is_in_quotes = false;
+        int64_t number_of_newlines = 0;
+
+        for(auto& chunk : chunks_)
+        {
+            chunk.starts_in_quotes = is_in_quotes;
+            chunk.first_line = number_of_newlines + 1;
+
+            number_of_newlines += chunk.newlines[is_in_quotes ? 1 : 0];
+            is_in_quotes = (is_in_quotes != chunk.has_odd_number_of_quotes);
+        }
+
+        // A newline ending the text doesn't start a line
+        number_of_lines_ = number_of_newlines + 1;
+        consumed_size_ = size_;
+
+        if(text_[size_ - 1] == '\n' && !is_in_quotes)
+        {
+            --number_of_lines_;
+        }
+        else if(options_.skip_incomplete_last_line)
+        {
+            --number_of_lines_;
+            consumed_size_ = find_end_of_last_line();
+        }
+
+        if(number_of_lines_ == 0)
+            return;
+
+        if(options_.delimiter == 0)
+            options_.delimiter = detect_delimiter();
+
+        std::vector<std::string> fields;
+        split_line(0, fields);
+
+        const int64_t number_of_header_columns = options_.has_row_headers ? 1 : 0;
+        columns_ = std::max(int64_t(0), int64_t(fields.size()) - number_of_header_columns);
+
+        if(options_.columns > 0)
+            columns_ = options_.columns;
+
+        if(options_.has_column_headers)
+            column_headers_.assign(fields.begin() + std::min(int64_t(fields.size()), number_of_header_columns), fields.end());
+    }
+
+
+
+    int64_t rows()const { return std::max(int64_t(0), number_of_lines_ - (options_.has_column_headers ? 1 : 0)); }
+    int64_t columns()const { return columns_; }
+
+    char get_delimiter()const { return options_.delimiter; }
+
+    // Bytes of the text covered by the lines that are parsed (the
+    // whole text, unless an incomplete last line is left out)
+    int64_t get_consumed_size()const { return consumed_size_; }
+    const std::vector<std::string>& get_column_headers()const { return column_headers_; }
+
+    // Fraction of the text parsed so far (can be read from any thread)
+    double get_progress()const
+    {
+        return size_ > 0 ? double(parsed_bytes_.load()) / double(size_) : 1.0;
+    }
+
+
+
+    /**
+     * @brief Parses the rows into output (rows() x columns() doubles, row after row).
+     */
+    void parse(double* output)
+    {
+        if(rows() == 0 || columns() == 0)
+        {
+            parsed_bytes_ = size_;
+            return;
+        }
+
+        get_thread_pool().parallel_for(int64_t(chunks_.size()), [this, output](int64_t i)
+        {
+            parse_chunk(i, output);
+            parsed_bytes_ += std::min(options_.chunk_size, size_ - i * options_.chunk_size);
+        });
+    }
+
+
+
+private:
+
+    struct Chunk
+    {
+        // Newlines outside quotes, if the chunk starts outside (or inside) quotes
+        int64_t newlines[2] = {0, 0};
+        bool has_odd_number_of_quotes = false;
+
+        bool starts_in_quotes = false;
+        int64_t first_line = 0;             // Line started by the first newline of the chunk
+    };
+
+
+
+    // Bit i of the masks is set if byte i of the block is a newline (or a quote)
+    static void find_newlines_and_quotes(const char* block, uint64_t& newlines, uint64_t& quotes)
+    {
+#if defined(LAZYDATA_X86_64)
+
+        const __m128i newline = _mm_set1_epi8('\n');
+        const __m128i quote = _mm_set1_epi8('"');
+
+        newlines = 0;
+        quotes = 0;
+
+        for(int i = 0; i < 4; ++i)
+        {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+
+            newlines |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)))) << (16 * i);
+            quotes |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote)))) << (16 * i);
+        }
+
+#else
+
+        newlines = 0;
+        quotes = 0;
+
+        for(int i = 0; i < 64; ++i)
+        {
+            newlines |= uint64_t(block[i] == '\n') << i;
+            quotes |= uint64_t(block[i] == '"') << i;
+        }
+
+#endif
+    }
+
+    // Bit i is set if there's an odd number of set bits up to bit i
+    // (so the bits from an opening quote up to its closing quote)
+    static uint64_t prefix_xor(uint64_t mask)
+    {
+        mask ^= mask << 1;
+        mask ^= mask << 2;
+        mask ^= mask << 4;
+        mask ^= mask << 8;
+        mask ^= mask << 16;
+        mask ^= mask << 32;
+
+        return mask;
+    }
+
+
+
+    void count_chunk(int64_t chunk_index)
+    {
+        Chunk& chunk = chunks_[chunk_index];
+
+        const int64_t begin = chunk_index * options_.chunk_size;
+        const int64_t end = std::min(size_, begin + options_.chunk_size);
+
+        // Quote state carried from block to block, assuming the chunk starts outside quotes
+        uint64_t in_quotes_carry = 0;
+
+        char padded_block[64];
+
+        for(int64_t position = begin; position < end; position += 64)
+        {
+            const char* block = text_ + position;
+
+            if(end - position < 64)
+            {
+                std::memset(padded_block, 0, sizeof(padded_block));
+                std::memcpy(padded_block, block, end - position);
+                block = padded_block;
+            }
+
+            uint64_t newlines = 0;
+            uint64_t quotes = 0;
+            find_newlines_and_quotes(block, newlines, quotes);
+
+            const uint64_t in_quotes = prefix_xor(quotes) ^ in_quotes_carry;
+            in_quotes_carry = uint64_t(0) - (in_quotes >> 63);
+
+            chunk.newlines[0] += count_set_bits(newlines & ~in_quotes);
+            chunk.newlines[1] += count_set_bits(newlines & in_quotes);
+        }
+
+        chunk.has_odd_number_of_quotes = (in_quotes_carry != 0);
+    }
+
+
+
+    // Position right after the last newline outside quotes (0 if there's none)
+    int64_t find_end_of_last_line()const
+    {
+        for(int64_t chunk_index = int64_t(chunks_.size()) - 1; chunk_index >= 0; --chunk_index)
+        {
+            const Chunk& chunk = chunks_[chunk_index];
+
+            if(chunk.newlines[chunk.starts_in_quotes ? 1 : 0] == 0)
+                continue;
+
+            const int64_t begin = chunk_index * options_.chunk_size;
+            const int64_t end = std::min(size_, begin + options_.chunk_size);
+
+            bool is_in_quotes = chunk.starts_in_quotes;
+            int64_t end_of_last_line = 0;
+
+            for(int64_t position = begin; position < end; ++position)
+            {
+                if(text_[position] == '"')
+                    is_in_quotes = !is_in_quotes;
+                else if(text_[position] == '\n' && !is_in_quotes)
+                    end_of_last_line = position + 1;
+            }
+
+            return end_of_last_line;
+        }
+
+        return 0;
+    }
+
+
+
+    char detect_delimiter()const
+    {
+        const char candidates[3] = {',', ';', '\t'};
+        int64_t counts[3] = {0, 0, 0};
+
+        bool is_in_quotes = false;
+
+        for(int64_t position = 0; position < size_ && (is_in_quotes || text_[position] != '\n'); ++position)
+        {
+            if(text_[position] == '"')
+                is_in_quotes = !is_in_quotes;
+
+            for(int i = 0; i < 3 && !is_in_quotes; ++i)
+                counts[i] += (text_[position] == candidates[i]);
+        }
+
+        return candidates[std::max_element(counts, counts + 3) - counts];
+    }
+
+    bool is_space(char character)const
+    {
+        return character == ' ' || character == '\r' || (character == '\t' && options_.delimiter != '\t');
+    }
+
+
+
+    // Skips to the delimiter (or newline) ending the field, quotes
+    // are skipped as a whole so that they agree with index()
+    // -- Returns false if anything but spaces was skipped
+    bool skip_to_end_of_field(const char*& position, const char* end)const
+    {
+        bool is_blank = true;
+        bool is_in_quotes = false;
+
+        for(; position < end; ++position)
+        {
+            const char character = *position;
+
+            if(character == '"')
+                is_in_quotes = !is_in_quotes;
+            else if(!is_in_quotes && (character == options_.delimiter || character == '\n'))
+                break;
+
+            is_blank = is_blank && !is_in_quotes && is_space(character);
+        }
+
+        return is_blank;
+    }
+
+    // Parses a number (possibly quoted) and moves to the end of the field
+    double parse_field(const char*& position, const char* end)const
+    {
+        constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+        while(position < end && is_space(*position))
+            ++position;
+
+        const char* start_of_field = position;
+
+        const bool is_quoted = (position < end && *position == '"');
+        if(is_quoted)
+            ++position;
+
+        if(position < end && *position == '+')
+            ++position;
+
+        double value = NaN;
+        const auto result = std::from_chars(position, end, value);
+
+        bool is_number = (result.ec == std::errc());
+        position = is_number ? result.ptr : position;
+
+        if(is_quoted)
+        {
+            if(is_number && position < end && *position == '"')
+            {
+                ++position;
+            }
+            else
+            {
+                // Skip the quoted text as a whole
+                is_number = false;
+                position = start_of_field;
+            }
+        }
+
+        if(!skip_to_end_of_field(position, end) || !is_number)
+            value = NaN;
+
+        return value;
+    }
+
+
+
+    // Parses the line starting at position into row (nullptr to skip it)
+    // -- Returns the position of the newline ending the line (or the size of the text)
+    int64_t parse_line(int64_t position, double* row)const
+    {
+        const char* current = text_ + position;
+        const char* end = text_ + size_;
+
+        int64_t column = options_.has_row_headers ? -1 : 0;
+
+        while(true)
+        {
+            if(column < 0 || column >= columns_ || row == nullptr)
+                skip_to_end_of_field(current, end);
+            else
+                row[column] = parse_field(current, end);
+
+            ++column;
+
+            if(current >= end || *current == '\n')
+                break;
+
+            ++current;
+        }
+
+        for(column = std::max(int64_t(0), column); row && column < columns_; ++column)
+            row[column] = std::numeric_limits<double>::quiet_NaN();
+
+        return int64_t(current - text_);
+    }
+
+    // Splits the line starting at position into its (unquoted) fields
+    void split_line(int64_t position, std::vector<std::string>& fields)const
+    {
+        fields.clear();
+        fields.emplace_back();
+
+        bool is_in_quotes = false;
+
+        for(; position < size_; ++position)
+        {
+            const char character = text_[position];
+
+            if(character == '"')
+            {
+                // Two quotes in a row are an escaped quote
+                if(is_in_quotes && position + 1 < size_ && text_[position + 1] == '"')
+                {
+                    fields.back() += '"';
+                    ++position;
+                }
+                else
+                {
+                    is_in_quotes = !is_in_quotes;
+                }
+            }
+            else if(!is_in_quotes && character == '\n')
+            {
+                break;
+            }
+            else if(!is_in_quotes && character == options_.delimiter)
+            {
+                fields.emplace_back();
+            }
+            else if(character != '\r')
+            {
+                fields.back() += character;
+            }
+        }
+    }
+
+
+
+    void parse_chunk(int64_t chunk_index, double* output)const
+    {
+        const Chunk& chunk = chunks_[chunk_index];
+
+        const int64_t begin = chunk_index * options_.chunk_size;
+        const int64_t end = std::min(size_, begin + options_.chunk_size);
+
+        int64_t position = 0;
+        int64_t line = 0;
+
+        // Lines of the chunk start right after its newlines (the first
+        // chunk also starts the first line)
+        if(chunk_index > 0)
+        {
+            bool is_in_quotes = chunk.starts_in_quotes;
+
+            for(position = begin; position < end; ++position)
+            {
+                if(text_[position] == '"')
+                    is_in_quotes = !is_in_quotes;
+                else if(text_[position] == '\n' && !is_in_quotes)
+                    break;
+            }
+
+            if(position == end)
+                return;
+
+            ++position;
+            line = chunk.first_line;
+        }
+
+        const int64_t first_row_line = options_.has_column_headers ? 1 : 0;
+
+        while(line < number_of_lines_)
+        {
+            double* row = (line >= first_row_line) ? output + (line - first_row_line) * columns_ : nullptr;
+
+            const int64_t end_of_line = parse_line(position, row);
+            ++line;
+
+            if(end_of_line >= end)
+                break;
+
+            position = end_of_line + 1;
+        }
+    }
+
+
+
+    const char* text_ = nullptr;
+    int64_t size_ = 0;
+
+    CsvOptions options_;
+
+    std::vector<Chunk> chunks_;
+    int64_t number_of_lines_ = 0;
+    int64_t columns_ = 0;
+    int64_t consumed_size_ = 0;
+
+    std::vector<std::string> column_headers_;
+
+    std::atomic<int64_t> parsed_bytes_{0};
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_CSV_PARSER_HPP_
@@ -0,0 +1,637 @@
+//-------------------------------------------------------------------
+/**
+ * @file elementwise_chain.hpp
+ * @brief Composable, single-pass description of elementwise node chains.
+ *
+ * An ElementwiseChain describes a result as "take this source view,
+ * pick these rows and columns (a region of interest or an arbitrary
+ * selection) and apply these unary operations to every element".
+ *
+ * Region selection and elementwise operations commute, so any chain of
+ * unary operator, ROI and selector nodes collapses into this single
+ * normal form. Evaluating it reads the source once and writes the
+ * destination once, no matter how many nodes contributed to it.
+ *
+ * The source can also be a virtual concatenation of other chains
+ * (stacked by rows or by columns), which is only read piece by piece
+ * while the chain is evaluated, so concatenating matrices doesn't copy
+ * them.
+ *
+ * The source can also be procedural (see matrix_generator.hpp), its
+ * elements being generated as the chain is evaluated, so a generated
+ * matrix is never stored unless something materializes it.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_ELEMENTWISE_CHAIN_HPP_
+#define INCLUDE_COMPUTE_ELEMENTWISE_CHAIN_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+
+#include "matrix_view.hpp"
+#include "elementwise_operations.hpp"
+#include "instruction_set.hpp"
+#include "matrix_generator.hpp"
+#include "thread_pool.hpp"
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @class IndexMapping
+ * @brief Maps the rows (or columns) of a result onto rows (or columns) of a source.
+ *
+ * A mapping is either a contiguous range [offset, offset + count) or an
+ * explicit list of indices. The explicit list is shared between copies
+ * so that passing chains from node to node stays cheap, and remembers
+ * where its runs of consecutive indices start so that gather() can
+ * copy them in one go.
+ */
+//-------------------------------------------------------------------
+class IndexMapping
+{
+public:
+
+    IndexMapping()
+    {
+    }
+
+    IndexMapping(int64_t offset, int64_t count)
+    : offset_(offset),
+      count_(std::max(int64_t(0), count))
+    {
+    }
+
+    int64_t size()const { return count_; }
+    int64_t offset()const { return offset_; }
+    bool is_contiguous()const { return indices_ == nullptr; }
+
+    int64_t operator[](int64_t index)const
+    {
+        return indices_ ? indices_->indices[index] : offset_ + index;
+    }
+
+
+
+    /**
+     * @brief Gathers the elements at positions [first, last) of the mapping from a strided source row.
+     *
+     * Runs of consecutive indices are copied with memcpy, scattered
+     * indices are read one by one, prefetching the ones a few elements
+     * ahead.
+     */
+    void gather(const double* source, int64_t source_stride, int64_t first, int64_t last, double* destination)const
+    {
+        if(is_contiguous())
+        {
+            if(source_stride == 1)
+            {
+                std::memcpy(destination, source + offset_ + first, (last - first) * sizeof(double));
+            }
+            else
+            {
+                for(int64_t i = first; i < last; ++i)
+                    destination[i - first] = source[(offset_ + i) * source_stride];
+            }
+
+            return;
+        }
+
+        const auto& indices = indices_->indices;
+        const auto& run_starts = indices_->run_starts;
+
+        if(source_stride == 1 && count_ >= MINIMUM_AVERAGE_RUN_SIZE * int64_t(run_starts.size()))
+        {
+            std::size_t run = std::upper_bound(run_starts.begin(), run_starts.end(), first) - run_starts.begin() - 1;
+
+            for(int64_t i = first; i < last; ++run)
+            {
+                const int64_t run_end = std::min(last, (run + 1 < run_starts.size()) ? run_starts[run + 1] : count_);
+
+                std::memcpy(destination + (i - first), source + indices[i], (run_end - i) * sizeof(double));
+
+                i = run_end;
+            }
+
+            return;
+        }
+
+        for(int64_t i = first; i < last; ++i)
+        {
+            if(i + PREFETCH_DISTANCE < last)
+                prefetch_for_reading(source + indices[i + PREFETCH_DISTANCE] * source_stride);
+
+            destination[i - first] = source[indices[i] * source_stride];
+        }
+    }
+
+
+
+    /**
+     * @brief Returns the mapping restricted to positions [first, last).
+     */
+    IndexMapping slice(int64_t first, int64_t last)const
+    {
+        first = std::max(int64_t(0), first);
+        last = std::min(count_, last);
+
+        if(last <= first)
+            return IndexMapping();
+
+        if(is_contiguous())
+            return IndexMapping(offset_ + first, last - first);
+
+        return IndexMapping(std::vector<int64_t>(indices_->indices.begin() + first, indices_->indices.begin() + last));
+    }
+
+
+
+    /**
+     * @brief Returns the mapping that picks the given positions of this mapping.
+     *
+     * Positions outside of [0, size()) are skipped.
+     */
+    IndexMapping select(const std::vector<int64_t>& positions)const
+    {
+        std::vector<int64_t> indices;
+        indices.reserve(positions.size());
+
+        for(const auto& position : positions)
+        {
+            if(position >= 0 && position < count_)
+                indices.push_back((*this)[position]);
+        }
+
+        return IndexMapping(std::move(indices));
+    }
+
+
+
+private:
+
+    // Below this many indices per run on average, gathering them one
+    // by one is faster than a memcpy per run
+    static constexpr int64_t MINIMUM_AVERAGE_RUN_SIZE = 8;
+
+    // How many elements ahead scattered indices are prefetched
+    static constexpr int64_t PREFETCH_DISTANCE = 16;
+
+    struct Indices
+    {
+        std::vector<int64_t> indices;
+        std::vector<int64_t> run_starts;   // positions where a run of consecutive indices starts
+    };
+
+    explicit IndexMapping(std::vector<int64_t>&& indices)
+    {
+        count_ = static_cast<int64_t>(indices.size());
+
+        if(count_ == 0)
+            return;
+
+        auto explicit_indices = std::make_shared<Indices>();
+        explicit_indices->run_starts.push_back(0);
+
+        for(int64_t i = 1; i < count_; ++i)
+        {
+            if(indices[i] != indices[i - 1] + 1)
+                explicit_indices->run_starts.push_back(i);
+        }
+
+        // Collapse a single run like {5,6,7,8} back into a
+        // contiguous range so the evaluation can stream it
+        if(explicit_indices->run_starts.size() == 1)
+        {
+            offset_ = indices[0];
+            return;
+        }
+
+        explicit_indices->indices = std::move(indices);
+        indices_ = std::move(explicit_indices);
+    }
+
+    int64_t offset_ = 0;
+    int64_t count_ = 0;
+    std::shared_ptr<const Indices> indices_;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// How the parts of a concatenation are stacked
+//-------------------------------------------------------------------
+enum class ConcatenationDirection : int
+{
+    Rows = 0,   // one below the other
+    Columns     // side by side
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @class ElementwiseChain
+ * @brief A source (view, concatenation or generator), a row/column mapping and a list of unary operations.
+ */
+//-------------------------------------------------------------------
+class ElementwiseChain
+{
+public:
+
+    // Number of elements processed at a time, small enough for the
+    // block to stay in L1 cache while every operation is applied to it
+    static constexpr int64_t BLOCK_SIZE = 512;
+
+    // Number of elements handed to a thread at a time when the evaluation
+    // is split across the thread pool, about the size of a core's L2 cache
+    static constexpr int64_t TASK_SIZE = int64_t(32) << 10;
+
+    ElementwiseChain()
+    {
+    }
+
+    explicit ElementwiseChain(const MatrixView& source)
+    {
+        set_source(source);
+    }
+
+
+
+    /**
+     * @brief Sets the source, resetting the row/column mapping and the operations.
+     */
+    void set_source(const MatrixView& source)
+    {
+        source_ = source;
+        concatenation_.reset();
+        generator_.reset();
+        row_mapping_ = IndexMapping(0, source.rows());
+        column_mapping_ = IndexMapping(0, source.columns());
+        operations_.clear();
+    }
+
+
+
+    /**
+     * @brief Returns a chain whose source is the concatenation of the given chains.
+     *
+     * Nothing is evaluated, the parts are only read (row segment by row
+     * segment) when the returned chain is evaluated. Parts narrower (or
+     * shorter) than the concatenation read as zeros there, and empty
+     * parts are skipped.
+     */
+    static ElementwiseChain concatenate(const std::vector<ElementwiseChain>& parts, ConcatenationDirection direction)
+    {
+        auto concatenation = std::make_shared<Concatenation>();
+        concatenation->direction = direction;
+
+        int64_t rows = 0;
+        int64_t columns = 0;
+
+        for(const auto& part : parts)
+        {
+            if(part.size() == 0)
+                continue;
+
+            if(direction == ConcatenationDirection::Rows)
+            {
+                concatenation->offsets.push_back(rows);
+                rows += part.rows();
+                columns = std::max(columns, part.columns());
+            }
+            else
+            {
+                concatenation->offsets.push_back(columns);
+                columns += part.columns();
+                rows = std::max(rows, part.rows());
+            }
+
+            concatenation->parts.push_back(part);
+        }
+
+        ElementwiseChain chain;
+        chain.row_mapping_ = IndexMapping(0, rows);
+        chain.column_mapping_ = IndexMapping(0, columns);
+
+        if(!concatenation->parts.empty())
+            chain.concatenation_ = std::move(concatenation);
+
+        return chain;
+    }
+
+    /**
+     * @brief Returns a chain whose source is a generated matrix.
+     *
+     * Nothing is generated, the elements are only computed (row segment
+     * by row segment, in parallel) when the chain is evaluated.
+     */
+    static ElementwiseChain generate(const MatrixGenerator& generator)
+    {
+        ElementwiseChain chain;
+        chain.row_mapping_ = IndexMapping(0, std::max(int64_t(0), generator.rows));
+        chain.column_mapping_ = IndexMapping(0, std::max(int64_t(0), generator.columns));
+
+        if(chain.size() > 0)
+            chain.generator_ = std::make_shared<const MatrixGenerator>(generator);
+
+        return chain;
+    }
+
+
+
+    bool is_concatenation()const { return concatenation_ != nullptr; }
+    bool is_generated()const { return generator_ != nullptr; }
+
+    const MatrixView& get_source()const { return source_; }
+    const IndexMapping& get_row_mapping()const { return row_mapping_; }
+    const IndexMapping& get_column_mapping()const { return column_mapping_; }
+    const std::vector<UnaryOperation>& get_operations()const { return operations_; }
+
+    int64_t rows()const { return columns() > 0 ? row_mapping_.size() : 0; }
+    int64_t columns()const { return row_mapping_.size() > 0 ? column_mapping_.size() : 0; }
+    int64_t size()const { return rows() * columns(); }
+
+
+
+    /**
+     * @brief True when the chain is only a rectangular window of its source view.
+     *
+     * Such a chain (no operations, contiguous row and column mappings)
+     * doesn't need to be evaluated, as_view() reads it in place.
+     */
+    bool is_strided_view()const
+    {
+        return !concatenation_ &&
+               !generator_ &&
+               operations_.empty() &&
+               row_mapping_.is_contiguous() &&
+               column_mapping_.is_contiguous() &&
+               size() > 0;
+    }
+
+    /**
+     * @brief Returns the window of the source the chain selects (see is_strided_view()).
+     */
+    MatrixView as_view()const
+    {
+        return source_.block(row_mapping_.offset(), column_mapping_.offset(), rows(), columns());
+    }
+
+
+
+    void append_operation(UnaryOperation operation)
+    {
+        operations_.push_back(operation);
+    }
+
+
+
+    /**
+     * @brief Restricts the chain to the region between two corners (inclusive).
+     *
+     * The corners can be given in any order, and the region is clamped
+     * to the current extents of the chain.
+     */
+    void select_region(int64_t row1, int64_t column1, int64_t row2, int64_t column2)
+    {
+        int64_t first_row = std::max(int64_t(0), std::min(row1, row2));
+        int64_t last_row = std::max(row1, row2) + 1;
+
+        int64_t first_column = std::max(int64_t(0), std::min(column1, column2));
+        int64_t last_column = std::max(column1, column2) + 1;
+
+        row_mapping_ = row_mapping_.slice(first_row, last_row);
+        column_mapping_ = column_mapping_.slice(first_column, last_column);
+    }
+
+
+
+    /**
+     * @brief Restricts the chain to the given rows and columns (in the given order).
+     */
+    void select_rows_and_columns(const std::vector<int64_t>& rows, const std::vector<int64_t>& columns)
+    {
+        row_mapping_ = row_mapping_.select(rows);
+        column_mapping_ = column_mapping_.select(columns);
+    }
+
+
+
+    /**
+     * @brief Evaluates the whole chain into a row-major destination.
+     *
+     * The result is split into tiles of about TASK_SIZE elements (groups
+     * of narrow rows or blocks of wide rows) that are evaluated in
+     * parallel, each thread writing its tiles straight into the
+     * destination.
+     *
+     * @param destination Pointer to element (0,0) of the destination.
+     * @param destination_row_stride Distance (in elements) between destination rows.
+     */
+    void evaluate(double* destination, int64_t destination_row_stride)const
+    {
+        const int64_t number_of_rows = rows();
+        const int64_t number_of_columns = columns();
+
+        if(number_of_rows == 0 || number_of_columns == 0)
+            return;
+
+        const int64_t columns_per_task = std::min(number_of_columns, TASK_SIZE);
+        const int64_t rows_per_task = std::max(int64_t(1), TASK_SIZE / number_of_columns);
+
+        const int64_t number_of_column_tiles = (number_of_columns + columns_per_task - 1) / columns_per_task;
+        const int64_t number_of_row_tiles = (number_of_rows + rows_per_task - 1) / rows_per_task;
+
+        get_thread_pool().parallel_for(number_of_row_tiles * number_of_column_tiles, [&](int64_t task)
+        {
+            const int64_t first_row = (task / number_of_column_tiles) * rows_per_task;
+            const int64_t first_column = (task % number_of_column_tiles) * columns_per_task;
+
+            evaluate_tile(first_row, std::min(number_of_rows, first_row + rows_per_task),
+                          first_column, std::min(number_of_columns, first_column + columns_per_task),
+                          destination, destination_row_stride);
+        });
+    }
+
+
+
+    /**
+     * @brief Evaluates rows [first_row, last_row) of the chain (on the calling thread).
+     *
+     * @param destination Pointer to element (0,0) of the destination (not of first_row).
+     * @param destination_row_stride Distance (in elements) between destination rows.
+     */
+    void evaluate_rows(int64_t first_row, int64_t last_row, double* destination, int64_t destination_row_stride)const
+    {
+        evaluate_tile(first_row, last_row, 0, columns(), destination, destination_row_stride);
+    }
+
+
+
+    /**
+     * @brief Evaluates rows [first_row, last_row) and columns [first_column, last_column) of the chain.
+     *
+     * @param destination Pointer to element (0,0) of the destination (not of the tile).
+     * @param destination_row_stride Distance (in elements) between destination rows.
+     */
+    void evaluate_tile(int64_t first_row,
+                       int64_t last_row,
+                       int64_t first_column,
+                       int64_t last_column,
+                       double* destination,
+                       int64_t destination_row_stride)const
+    {
+        last_row = std::min(last_row, rows());
+        last_column = std::min(last_column, columns());
+
+        for(int64_t row = first_row; row < last_row; ++row)
+            evaluate_row_segment(row, first_column, last_column, destination + row * destination_row_stride + first_column);
+    }
+
+
+
+    /**
+     * @brief Evaluates columns [first_column, last_column) of a row into a contiguous buffer.
+     *
+     * The row is processed in blocks: the block is gathered from the
+     * source straight into the destination and every operation is then
+     * applied to it while it is still hot in cache.
+     *
+     * @param destination Where element (row, first_column) goes.
+     */
+    void evaluate_row_segment(int64_t row, int64_t first_column, int64_t last_column, double* destination)const
+    {
+        const int64_t source_row_index = row_mapping_[row];
+
+        for(int64_t block_start = first_column; block_start < last_column; block_start += BLOCK_SIZE)
+        {
+            const int64_t block_size = std::min(BLOCK_SIZE, last_column - block_start);
+            double* block = destination + (block_start - first_column);
+
+            if(concatenation_ || generator_)
+            {
+                // Read runs of consecutive source columns at a time,
+                // so that each part streams (or generates) them
+                for(int64_t j = 0; j < block_size;)
+                {
+                    const int64_t source_column = column_mapping_[block_start + j];
+
+                    int64_t run_size = 1;
+                    while(j + run_size < block_size && column_mapping_[block_start + j + run_size] == source_column + run_size)
+                        ++run_size;
+
+                    if(generator_)
+                        generator_->generate(source_row_index, source_column, run_size, block + j);
+                    else
+                        read_concatenation(source_row_index, source_column, run_size, block + j);
+
+                    j += run_size;
+                }
+            }
+            else
+            {
+                column_mapping_.gather(source_.row_pointer(source_row_index), source_.column_stride(), block_start, block_start + block_size, block);
+            }
+
+            for(const auto& operation : operations_)
+                apply_unary_operation(operation, block, block_size);
+        }
+    }
+
+
+
+private:
+
+    struct Concatenation
+    {
+        ConcatenationDirection direction = ConcatenationDirection::Rows;
+        std::vector<ElementwiseChain> parts;
+        std::vector<int64_t> offsets;   // first row (or column) of each part
+    };
+
+
+
+    // Reads count elements of a row of the concatenation, starting at
+    // first_column, letting each part evaluate its own segment
+    void read_concatenation(int64_t row, int64_t first_column, int64_t count, double* destination)const
+    {
+        const auto& parts = concatenation_->parts;
+        const auto& offsets = concatenation_->offsets;
+
+        if(concatenation_->direction == ConcatenationDirection::Rows)
+        {
+            const std::size_t part_index = std::upper_bound(offsets.begin(), offsets.end(), row) - offsets.begin() - 1;
+            const auto& part = parts[part_index];
+
+            const int64_t available_count = std::max(int64_t(0), std::min(count, part.columns() - first_column));
+
+            if(available_count > 0)
+                part.evaluate_row_segment(row - offsets[part_index], first_column, first_column + available_count, destination);
+
+            std::fill(destination + available_count, destination + count, 0.0);
+        }
+        else
+        {
+            std::size_t part_index = std::upper_bound(offsets.begin(), offsets.end(), first_column) - offsets.begin() - 1;
+
+            for(int64_t column = first_column; column < first_column + count; ++part_index)
+            {
+                const auto& part = parts[part_index];
+
+                const int64_t part_first_column = column - offsets[part_index];
+                const int64_t segment_size = std::min(first_column + count - column, part.columns() - part_first_column);
+
+                double* segment = destination + (column - first_column);
+
+                if(row < part.rows())
+                    part.evaluate_row_segment(row, part_first_column, part_first_column + segment_size, segment);
+                else
+                    std::fill(segment, segment + segment_size, 0.0);
+
+                column += segment_size;
+            }
+        }
+    }
+
+
+
+private:
+
+    MatrixView source_;
+    std::shared_ptr<const Concatenation> concatenation_;
+    std::shared_ptr<const MatrixGenerator> generator_;
+    IndexMapping row_mapping_;
+    IndexMapping column_mapping_;
+    std::vector<UnaryOperation> operations_;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_ELEMENTWISE_CHAIN_HPP_
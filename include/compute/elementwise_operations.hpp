@@ -0,0 +1,135 @@
+//-------------------------------------------------------------------
+/**
+ * @file elementwise_operations.hpp
+ * @brief Elementwise unary operations applied in-place over contiguous buffers.
+ *
+ * These are the building blocks that the ElementwiseChain applies to
+ * each cache-sized block of a matrix.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_ELEMENTWISE_OPERATIONS_HPP_
+#define INCLUDE_COMPUTE_ELEMENTWISE_OPERATIONS_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <cmath>
+#include <cstdint>
+
+#include "instruction_set.hpp"
+#include "simd_unary_kernels.hpp"
+#include "unary_operation.hpp"
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Applies a unary operation in-place to a contiguous buffer, using
+ *        the kernel of the given instruction set.
+ *
+ * Instruction sets that the CPU doesn't support fall back to the best
+ * one it does. The scalar loops hoist the switch out of the loop so each
+ * case compiles to a tight loop.
+ */
+//-------------------------------------------------------------------
+inline void apply_unary_operation(UnaryOperation operation,
+                                  double* data,
+                                  int64_t number_of_elements,
+                                  InstructionSet instruction_set)
+{
+#if defined(LAZYDATA_X86_64)
+
+    static const InstructionSet detected_instruction_set = detect_instruction_set();
+
+    if(int(instruction_set) > int(detected_instruction_set))
+        instruction_set = detected_instruction_set;
+
+    switch(instruction_set)
+    {
+        case InstructionSet::AVX512:
+            AVX512::apply_unary_operation(operation, data, number_of_elements);
+        return;
+
+        case InstructionSet::AVX2:
+            AVX2::apply_unary_operation(operation, data, number_of_elements);
+        return;
+
+        case InstructionSet::SSE2:
+            SSE2::apply_unary_operation(operation, data, number_of_elements);
+        return;
+
+        default:
+        break;
+    }
+
+#endif
+
+    switch(operation)
+    {
+        default:
+        case UnaryOperation::Negate:
+            for(int64_t i = 0; i < number_of_elements; ++i)
+                data[i] = -data[i];
+        break;
+
+        case UnaryOperation::Sign:
+            for(int64_t i = 0; i < number_of_elements; ++i)
+                data[i] = apply_unary_operation(UnaryOperation::Sign, data[i]);
+        break;
+
+        case UnaryOperation::Abs:
+            for(int64_t i = 0; i < number_of_elements; ++i)
+                data[i] = std::abs(data[i]);
+        break;
+
+        case UnaryOperation::Sqrt:
+            for(int64_t i = 0; i < number_of_elements; ++i)
+                data[i] = std::sqrt(data[i]);
+        break;
+
+        case UnaryOperation::Exp:
+            for(int64_t i = 0; i < number_of_elements; ++i)
+                data[i] = std::exp(data[i]);
+        break;
+
+        case UnaryOperation::Exp2:
+            for(int64_t i = 0; i < number_of_elements; ++i)
+                data[i] = std::exp2(data[i]);
+        break;
+    }
+}
+
+
+
+/**
+ * @brief Applies a unary operation in-place to a contiguous buffer, using
+ *        the best instruction set available (see get_instruction_set).
+ */
+inline void apply_unary_operation(UnaryOperation operation, double* data, int64_t number_of_elements)
+{
+    apply_unary_operation(operation, data, number_of_elements, get_instruction_set());
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_ELEMENTWISE_OPERATIONS_HPP_
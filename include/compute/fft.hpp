@@ -0,0 +1,616 @@
+//-------------------------------------------------------------------
+/**
+ * @file fft.hpp
+ * @brief Multithreaded fast Fourier transforms of the rows, columns or both of a matrix.
+ *
+ * Transforms of a given length use an immutable plan that's built once
+ * and shared (see get_fft_plan):
+ * - Powers of 2 use an iterative radix-2 transform whose stages read
+ *   their twiddle factors from contiguous tables.
+ * - Other lengths use Bluestein's algorithm, which turns the transform
+ *   into a circular convolution computed with a power of 2 transform.
+ *
+ * Rows are spread over the thread pool. Columns are gathered a band at
+ * a time into contiguous lines, transformed, and scattered back, so a
+ * column transform doesn't stride through the whole matrix at every
+ * butterfly. Real inputs are transformed two lines at a time, as the
+ * real and imaginary parts of one complex line.
+ *
+ * Forward transforms aren't scaled, inverse transforms are scaled by
+ * 1/n, like numpy's fft and ifft.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_FFT_HPP_
+#define INCLUDE_COMPUTE_FFT_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "elementwise_chain.hpp"
+#include "thread_pool.hpp"
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+using Complex = std::complex<double>;
+
+// Transformed dimension(s) of a matrix
+enum class FftAxis : int
+{
+    Rows = 0,       // Each row is transformed
+    Columns,        // Each column is transformed
+    Both            // 2D transform (rows then columns)
+};
+
+// Real views of complex elements
+enum class ComplexPart : int
+{
+    Real = 0,
+    Imaginary,
+    Magnitude,
+    Phase,
+    Power           // Squared magnitude
+};
+
+// Number of columns gathered at a time by column transforms
+constexpr int64_t FFT_COLUMN_BAND_SIZE = 8;
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @class FftPlan
+ * @brief Precomputed tables of the transforms of a given length.
+ *
+ * A plan is never modified once built, so threads share it, each
+ * bringing its own scratch buffer (see get_scratch_size()).
+ */
+//-------------------------------------------------------------------
+class FftPlan
+{
+public:
+
+    explicit FftPlan(int64_t length)
+    : length_(length)
+    {
+        if(length_ <= 1)
+            return;
+
+        if(is_power_of_2(length_))
+        {
+            build_radix_2_tables();
+            return;
+        }
+
+        build_bluestein_tables();
+    }
+
+
+
+    int64_t get_length()const { return length_; }
+
+    bool uses_bluestein()const { return convolution_plan_ != nullptr; }
+
+    // Number of complex elements of scratch space transform() needs
+    int64_t get_scratch_size()const
+    {
+        return uses_bluestein() ? convolution_plan_->get_length() : 0;
+    }
+
+
+
+    /**
+     * @brief Transforms a line of get_length() contiguous elements in place.
+     *
+     * The inverse transform isn't scaled.
+     *
+     * @param scratch At least get_scratch_size() elements.
+     */
+    void transform(Complex* data, bool is_inverse, Complex* scratch)const
+    {
+        if(length_ <= 1)
+            return;
+
+        // The inverse transform is the conjugate of the forward transform of the conjugate
+        if(is_inverse)
+        {
+            for(int64_t i = 0; i < length_; ++i)
+                data[i] = std::conj(data[i]);
+        }
+
+        if(uses_bluestein())
+            transform_bluestein(data, scratch);
+        else
+            transform_radix_2(data);
+
+        if(is_inverse)
+        {
+            for(int64_t i = 0; i < length_; ++i)
+                data[i] = std::conj(data[i]);
+        }
+    }
+
+
+
+    static bool is_power_of_2(int64_t n)
+    {
+        return n > 0 && (n & (n - 1)) == 0;
+    }
+
+
+
+private:
+
+    void build_radix_2_tables()
+    {
+        int number_of_bits = 0;
+        while((int64_t(1) << number_of_bits) < length_)
+            ++number_of_bits;
+
+        bit_reversed_indices_.resize(length_);
+
+        for(int64_t i = 0; i < length_; ++i)
+        {
+            int64_t reversed = 0;
+
+            for(int bit = 0; bit < number_of_bits; ++bit)
+                reversed |= ((i >> bit) & 1) << (number_of_bits - 1 - bit);
+
+            bit_reversed_indices_[i] = reversed;
+        }
+
+        // The stage of half size h reads its h twiddles from [h - 1, 2h - 1)
+        twiddles_.resize(length_ - 1);
+
+        const double pi = std::acos(-1.0);
+
+        for(int64_t half_size = 1; half_size < length_; half_size *= 2)
+        {
+            for(int64_t k = 0; k < half_size; ++k)
+                twiddles_[half_size - 1 + k] = std::polar(1.0, -pi * double(k) / double(half_size));
+        }
+    }
+
+    void transform_radix_2(Complex* data)const
+    {
+        for(int64_t i = 0; i < length_; ++i)
+        {
+            const int64_t j = bit_reversed_indices_[i];
+
+            if(i < j)
+                std::swap(data[i], data[j]);
+        }
+
+        // First stage, whose only twiddle is 1
+        for(int64_t i = 0; i < length_; i += 2)
+        {
+            const Complex a = data[i];
+            const Complex b = data[i + 1];
+
+            data[i] = a + b;
+            data[i + 1] = a - b;
+        }
+
+        for(int64_t half_size = 2; half_size < length_; half_size *= 2)
+        {
+            const Complex* stage_twiddles = twiddles_.data() + half_size - 1;
+
+            for(int64_t start = 0; start < length_; start += 2 * half_size)
+            {
+                Complex* first = data + start;
+                Complex* second = first + half_size;
+
+                for(int64_t k = 0; k < half_size; ++k)
+                {
+                    const Complex t = multiply(stage_twiddles[k], second[k]);
+
+                    second[k] = first[k] - t;
+                    first[k] += t;
+                }
+            }
+        }
+    }
+
+
+
+    void build_bluestein_tables()
+    {
+        int64_t convolution_length = 1;
+        while(convolution_length < 2 * length_ - 1)
+            convolution_length *= 2;
+
+        convolution_plan_ = std::make_shared<FftPlan>(convolution_length);
+
+        // chirp[k] = exp(-i pi k^2 / n), with k^2 taken modulo 2n to keep the angle accurate
+        const double pi = std::acos(-1.0);
+
+        chirp_.resize(length_);
+
+        for(int64_t k = 0; k < length_; ++k)
+        {
+            const int64_t k_squared = (k * k) % (2 * length_);
+            chirp_[k] = std::polar(1.0, -pi * double(k_squared) / double(length_));
+        }
+
+        // Transform of the convolution kernel conj(chirp[|k|]), wrapped around
+        chirp_kernel_transform_.assign(convolution_length, Complex(0, 0));
+
+        chirp_kernel_transform_[0] = std::conj(chirp_[0]);
+
+        for(int64_t k = 1; k < length_; ++k)
+        {
+            chirp_kernel_transform_[k] = std::conj(chirp_[k]);
+            chirp_kernel_transform_[convolution_length - k] = std::conj(chirp_[k]);
+        }
+
+        convolution_plan_->transform(chirp_kernel_transform_.data(), false, nullptr);
+
+        // Folds in the 1/m of the convolution's inverse transform
+        for(auto& value : chirp_kernel_transform_)
+            value /= double(convolution_length);
+    }
+
+    void transform_bluestein(Complex* data, Complex* scratch)const
+    {
+        const int64_t convolution_length = convolution_plan_->get_length();
+
+        for(int64_t k = 0; k < length_; ++k)
+            scratch[k] = multiply(data[k], chirp_[k]);
+
+        std::fill(scratch + length_, scratch + convolution_length, Complex(0, 0));
+
+        convolution_plan_->transform(scratch, false, nullptr);
+
+        for(int64_t k = 0; k < convolution_length; ++k)
+            scratch[k] = multiply(scratch[k], chirp_kernel_transform_[k]);
+
+        convolution_plan_->transform(scratch, true, nullptr);
+
+        for(int64_t k = 0; k < length_; ++k)
+            data[k] = multiply(scratch[k], chirp_[k]);
+    }
+
+
+
+    // Plain complex product (std::complex's operator* checks for infinities)
+    static Complex multiply(const Complex& a, const Complex& b)
+    {
+        return Complex(a.real() * b.real() - a.imag() * b.imag(),
+                       a.real() * b.imag() + a.imag() * b.real());
+    }
+
+
+
+    int64_t length_ = 0;
+
+    // Radix-2 transforms
+    std::vector<int64_t> bit_reversed_indices_;
+    std::vector<Complex> twiddles_;
+
+    // Bluestein transforms
+    std::vector<Complex> chirp_;
+    std::vector<Complex> chirp_kernel_transform_;
+    std::shared_ptr<FftPlan> convolution_plan_;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief The shared plan of the given length (built on first use).
+ */
+//-------------------------------------------------------------------
+inline std::shared_ptr<const FftPlan> get_fft_plan(int64_t length)
+{
+    static std::mutex mutex;
+    static std::unordered_map<int64_t, std::shared_ptr<const FftPlan>> plans;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto& plan = plans[length];
+
+    if(!plan)
+        plan = std::make_shared<FftPlan>(length);
+
+    return plan;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Detail
+{
+    // Splits the transform z of x + iy, x and y being real, into the
+    // transforms of x and y, using the symmetry X[k] = conj(X[n - k])
+    inline void split_real_pair_transform(const Complex* z, int64_t n, Complex* x_transform, Complex* y_transform)
+    {
+        for(int64_t k = 0; k < n; ++k)
+        {
+            const Complex a = z[k];
+            const Complex b = std::conj(z[k == 0 ? 0 : n - k]);
+
+            x_transform[k] = 0.5 * (a + b);
+            y_transform[k] = Complex(0.0, -0.5) * (a - b);
+        }
+    }
+
+    inline void scale(Complex* data, int64_t count, double factor)
+    {
+        for(int64_t i = 0; i < count; ++i)
+            data[i] *= factor;
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Transforms each row of a row-major matrix in place.
+ *
+ * @param is_real Whether the imaginary parts are all 0, in which case
+ *                rows are transformed two at a time.
+ */
+//-------------------------------------------------------------------
+inline void transform_rows(Complex* data, int64_t rows, int64_t columns, bool is_inverse, bool is_real)
+{
+    if(rows <= 0 || columns <= 0)
+        return;
+
+    const auto plan = get_fft_plan(columns);
+
+    // An even number of rows per task, of about TASK_SIZE elements
+    int64_t rows_per_task = std::max(int64_t(1), ElementwiseChain::TASK_SIZE / columns);
+    rows_per_task += rows_per_task % 2;
+
+    const int64_t number_of_tasks = (rows + rows_per_task - 1) / rows_per_task;
+
+    get_thread_pool().parallel_for(number_of_tasks, [&](int64_t task)
+    {
+        const int64_t first_row = task * rows_per_task;
+        const int64_t last_row = std::min(rows, first_row + rows_per_task);
+
+        std::vector<Complex> scratch(plan->get_scratch_size());
+        std::vector<Complex> packed_rows(is_real ? columns : 0);
+
+        int64_t row = first_row;
+
+        if(is_real)
+        {
+            for(; row + 1 < last_row; row += 2)
+            {
+                Complex* first = data + row * columns;
+                Complex* second = first + columns;
+
+                for(int64_t j = 0; j < columns; ++j)
+                    packed_rows[j] = Complex(first[j].real(), second[j].real());
+
+                plan->transform(packed_rows.data(), is_inverse, scratch.data());
+
+                Detail::split_real_pair_transform(packed_rows.data(), columns, first, second);
+            }
+        }
+
+        for(; row < last_row; ++row)
+            plan->transform(data + row * columns, is_inverse, scratch.data());
+
+        if(is_inverse)
+            Detail::scale(data + first_row * columns, (last_row - first_row) * columns, 1.0 / double(columns));
+    });
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Transforms each column of a row-major matrix in place.
+ *
+ * Bands of FFT_COLUMN_BAND_SIZE columns are gathered into contiguous
+ * lines, transformed and scattered back, reading and writing whole
+ * cache lines of each row.
+ *
+ * @param is_real Whether the imaginary parts are all 0, in which case
+ *                columns are transformed two at a time.
+ */
+//-------------------------------------------------------------------
+inline void transform_columns(Complex* data, int64_t rows, int64_t columns, bool is_inverse, bool is_real)
+{
+    if(rows <= 0 || columns <= 0)
+        return;
+
+    const auto plan = get_fft_plan(rows);
+
+    const int64_t number_of_bands = (columns + FFT_COLUMN_BAND_SIZE - 1) / FFT_COLUMN_BAND_SIZE;
+
+    get_thread_pool().parallel_for(number_of_bands, [&](int64_t band)
+    {
+        const int64_t first_column = band * FFT_COLUMN_BAND_SIZE;
+        const int64_t band_size = std::min(FFT_COLUMN_BAND_SIZE, columns - first_column);
+
+        std::vector<Complex> scratch(plan->get_scratch_size());
+        std::vector<Complex> lines(band_size * rows);
+        std::vector<Complex> packed_line(is_real ? rows : 0);
+
+        for(int64_t i = 0; i < rows; ++i)
+        {
+            const Complex* row = data + i * columns + first_column;
+
+            for(int64_t j = 0; j < band_size; ++j)
+                lines[j * rows + i] = row[j];
+        }
+
+        int64_t j = 0;
+
+        if(is_real)
+        {
+            for(; j + 1 < band_size; j += 2)
+            {
+                Complex* first = lines.data() + j * rows;
+                Complex* second = first + rows;
+
+                for(int64_t i = 0; i < rows; ++i)
+                    packed_line[i] = Complex(first[i].real(), second[i].real());
+
+                plan->transform(packed_line.data(), is_inverse, scratch.data());
+
+                Detail::split_real_pair_transform(packed_line.data(), rows, first, second);
+            }
+        }
+
+        for(; j < band_size; ++j)
+            plan->transform(lines.data() + j * rows, is_inverse, scratch.data());
+
+        if(is_inverse)
+            Detail::scale(lines.data(), int64_t(lines.size()), 1.0 / double(rows));
+
+        for(int64_t i = 0; i < rows; ++i)
+        {
+            Complex* row = data + i * columns + first_column;
+
+            for(int64_t j = 0; j < band_size; ++j)
+                row[j] = lines[j * rows + i];
+        }
+    });
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Fourier transform of a matrix given by its real and (optional) imaginary parts.
+ *
+ * The parts are read through their chains, so deferred inputs are
+ * evaluated a row at a time into the complex result rather than being
+ * materialized first.
+ *
+ * @param imaginary_part nullptr for a real matrix, otherwise a chain
+ *                       with the real part's dimensions.
+ * @param destination rows() x columns() row-major complex elements.
+ */
+//-------------------------------------------------------------------
+inline void compute_fft(const ElementwiseChain& real_part,
+                        const ElementwiseChain* imaginary_part,
+                        FftAxis axis,
+                        bool is_inverse,
+                        Complex* destination)
+{
+    const int64_t rows = real_part.rows();
+    const int64_t columns = real_part.columns();
+
+    if(rows == 0 || columns == 0)
+        return;
+
+    const int64_t rows_per_task = std::max(int64_t(1), ElementwiseChain::TASK_SIZE / columns);
+    const int64_t number_of_tasks = (rows + rows_per_task - 1) / rows_per_task;
+
+    get_thread_pool().parallel_for(number_of_tasks, [&](int64_t task)
+    {
+        const int64_t first_row = task * rows_per_task;
+        const int64_t last_row = std::min(rows, first_row + rows_per_task);
+
+        std::vector<double> real_row(columns);
+        std::vector<double> imaginary_row(imaginary_part ? columns : 0);
+
+        for(int64_t i = first_row; i < last_row; ++i)
+        {
+            real_part.evaluate_row_segment(i, 0, columns, real_row.data());
+
+            if(imaginary_part)
+                imaginary_part->evaluate_row_segment(i, 0, columns, imaginary_row.data());
+
+            Complex* row = destination + i * columns;
+
+            for(int64_t j = 0; j < columns; ++j)
+                row[j] = Complex(real_row[j], imaginary_part ? imaginary_row[j] : 0.0);
+        }
+    });
+
+    const bool is_real = (imaginary_part == nullptr);
+
+    switch(axis)
+    {
+        default:
+        case FftAxis::Rows:
+            transform_rows(destination, rows, columns, is_inverse, is_real);
+        break;
+
+        case FftAxis::Columns:
+            transform_columns(destination, rows, columns, is_inverse, is_real);
+        break;
+
+        case FftAxis::Both:
+            transform_rows(destination, rows, columns, is_inverse, is_real);
+            transform_columns(destination, rows, columns, is_inverse, false);
+        break;
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Writes a real view (real part, magnitude...) of complex elements.
+ */
+//-------------------------------------------------------------------
+inline void extract_complex_part(const Complex* data, int64_t count, ComplexPart part, double* destination)
+{
+    const int64_t number_of_tasks = (count + ElementwiseChain::TASK_SIZE - 1) / ElementwiseChain::TASK_SIZE;
+
+    get_thread_pool().parallel_for(number_of_tasks, [&](int64_t task)
+    {
+        const int64_t first = task * ElementwiseChain::TASK_SIZE;
+        const int64_t last = std::min(count, first + ElementwiseChain::TASK_SIZE);
+
+        for(int64_t i = first; i < last; ++i)
+        {
+            switch(part)
+            {
+                default:
+                case ComplexPart::Real: destination[i] = data[i].real(); break;
+                case ComplexPart::Imaginary: destination[i] = data[i].imag(); break;
+                case ComplexPart::Magnitude: destination[i] = std::abs(data[i]); break;
+                case ComplexPart::Phase: destination[i] = std::arg(data[i]); break;
+                case ComplexPart::Power: destination[i] = std::norm(data[i]); break;
+            }
+        }
+    });
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_FFT_HPP_
@@ -0,0 +1,346 @@
+//-------------------------------------------------------------------
+/**
+ * @file gemm.hpp
+ * @brief Cache-tiled, register-blocked, multithreaded matrix multiply.
+ *
+ * C = A * B is computed the way optimized BLAS libraries do it:
+ *
+ * - B is cut in blocks of GEMM_KC x GEMM_NC that are packed into
+ *   contiguous panels GEMM_NR columns wide (the block stays in L3 cache
+ *   and each panel in L1 cache)
+ * - A is cut in blocks of GEMM_MC x GEMM_KC that are packed into
+ *   contiguous panels GEMM_MR rows tall (the block stays in L2 cache)
+ * - A micro-kernel multiplies one A panel by one B panel, keeping the
+ *   whole GEMM_MR x GEMM_NR tile of C in registers
+ *
+ * Blocks of A are spread over the thread pool. Packing reads A and B
+ * through their strides, so transposed views (A^T * B for correlations
+ * for example) are multiplied without being copied first.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_GEMM_HPP_
+#define INCLUDE_COMPUTE_GEMM_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "instruction_set.hpp"
+#include "matrix_view.hpp"
+#include "thread_pool.hpp"
+
+#if defined(LAZYDATA_X86_64)
+    #include <immintrin.h>
+#endif
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Register block (the micro-kernel keeps GEMM_MR x GEMM_NR of C in
+// registers, 8 AVX registers)
+constexpr int64_t GEMM_MR = 4;
+constexpr int64_t GEMM_NR = 8;
+
+// Cache blocks (A block of 128x256 doubles = 256 KB for L2 cache,
+// B block of 256x2048 doubles = 4 MB for L3 cache)
+constexpr int64_t GEMM_MC = 128;
+constexpr int64_t GEMM_KC = 256;
+constexpr int64_t GEMM_NC = 2048;
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Portable micro-kernel: tile = a_panel * b_panel.
+ *
+ * @param depth Number of columns of the A panel (rows of the B panel).
+ * @param a_panel GEMM_MR values per step, packed by pack_a_panel.
+ * @param b_panel GEMM_NR values per step, packed by pack_b_panel.
+ * @param tile GEMM_MR x GEMM_NR row-major result.
+ */
+//-------------------------------------------------------------------
+inline void multiply_panels(int64_t depth, const double* a_panel, const double* b_panel, double* tile)
+{
+    double accumulators[GEMM_MR][GEMM_NR] = {};
+
+    for(int64_t k = 0; k < depth; ++k)
+    {
+        for(int64_t r = 0; r < GEMM_MR; ++r)
+        {
+            const double a = a_panel[k * GEMM_MR + r];
+
+            for(int64_t c = 0; c < GEMM_NR; ++c)
+                accumulators[r][c] += a * b_panel[k * GEMM_NR + c];
+        }
+    }
+
+    for(int64_t r = 0; r < GEMM_MR; ++r)
+        for(int64_t c = 0; c < GEMM_NR; ++c)
+            tile[r * GEMM_NR + c] = accumulators[r][c];
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#if defined(LAZYDATA_X86_64)
+
+//-------------------------------------------------------------------
+// AVX2 (with FMA) micro-kernel, compiled for its own instruction set
+// (see simd_unary_kernels.hpp)
+//-------------------------------------------------------------------
+#if defined(__clang__)
+    #pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+    #pragma GCC push_options
+    #pragma GCC target("avx2,fma")
+#endif
+
+namespace Compute
+{
+namespace AVX2
+{
+
+inline void multiply_panels(int64_t depth, const double* a_panel, const double* b_panel, double* tile)
+{
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+
+    for(int64_t k = 0; k < depth; ++k)
+    {
+        const __m256d b0 = _mm256_loadu_pd(b_panel + k * GEMM_NR);
+        const __m256d b1 = _mm256_loadu_pd(b_panel + k * GEMM_NR + 4);
+
+        __m256d a = _mm256_broadcast_sd(a_panel + k * GEMM_MR);
+        c00 = _mm256_fmadd_pd(a, b0, c00);
+        c01 = _mm256_fmadd_pd(a, b1, c01);
+
+        a = _mm256_broadcast_sd(a_panel + k * GEMM_MR + 1);
+        c10 = _mm256_fmadd_pd(a, b0, c10);
+        c11 = _mm256_fmadd_pd(a, b1, c11);
+
+        a = _mm256_broadcast_sd(a_panel + k * GEMM_MR + 2);
+        c20 = _mm256_fmadd_pd(a, b0, c20);
+        c21 = _mm256_fmadd_pd(a, b1, c21);
+
+        a = _mm256_broadcast_sd(a_panel + k * GEMM_MR + 3);
+        c30 = _mm256_fmadd_pd(a, b0, c30);
+        c31 = _mm256_fmadd_pd(a, b1, c31);
+    }
+
+    _mm256_storeu_pd(tile + 0 * GEMM_NR, c00);
+    _mm256_storeu_pd(tile + 0 * GEMM_NR + 4, c01);
+    _mm256_storeu_pd(tile + 1 * GEMM_NR, c10);
+    _mm256_storeu_pd(tile + 1 * GEMM_NR + 4, c11);
+    _mm256_storeu_pd(tile + 2 * GEMM_NR, c20);
+    _mm256_storeu_pd(tile + 2 * GEMM_NR + 4, c21);
+    _mm256_storeu_pd(tile + 3 * GEMM_NR, c30);
+    _mm256_storeu_pd(tile + 3 * GEMM_NR + 4, c31);
+}
+
+} // namespace AVX2
+} // namespace Compute
+
+#if defined(__clang__)
+    #pragma clang attribute pop
+#elif defined(__GNUC__)
+    #pragma GCC pop_options
+#endif
+//-------------------------------------------------------------------
+
+#endif  // LAZYDATA_X86_64
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Packs rows [first_row, first_row + GEMM_MR) and columns
+ *        [first_column, first_column + depth) of A, padding missing rows with zeros.
+ */
+//-------------------------------------------------------------------
+inline void pack_a_panel(const MatrixView& a, int64_t first_row, int64_t first_column, int64_t depth, double* a_panel)
+{
+    const int64_t rows = std::min(GEMM_MR, a.rows() - first_row);
+
+    for(int64_t k = 0; k < depth; ++k)
+    {
+        for(int64_t r = 0; r < GEMM_MR; ++r)
+            a_panel[k * GEMM_MR + r] = (r < rows) ? a(first_row + r, first_column + k) : 0.0;
+    }
+}
+
+
+
+/**
+ * @brief Packs rows [first_row, first_row + depth) and columns
+ *        [first_column, first_column + GEMM_NR) of B, padding missing columns with zeros.
+ */
+inline void pack_b_panel(const MatrixView& b, int64_t first_row, int64_t first_column, int64_t depth, double* b_panel)
+{
+    const int64_t columns = std::min(GEMM_NR, b.columns() - first_column);
+
+    for(int64_t k = 0; k < depth; ++k)
+    {
+        for(int64_t c = 0; c < GEMM_NR; ++c)
+            b_panel[k * GEMM_NR + c] = (c < columns) ? b(first_row + k, first_column + c) : 0.0;
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Computes C = A * B into a row-major destination.
+ *
+ * @param destination Pointer to element (0,0) of C, which must hold
+ *                    a.rows() rows of b.columns() elements.
+ * @param destination_row_stride Distance (in elements) between rows of C.
+ * @param instruction_set Instruction set of the micro-kernel (capped to what the CPU supports).
+ * @return false (and nothing is written) if the matrices are empty or
+ *         a.columns() != b.rows().
+ */
+//-------------------------------------------------------------------
+inline bool multiply(const MatrixView& a,
+                     const MatrixView& b,
+                     double* destination,
+                     int64_t destination_row_stride,
+                     InstructionSet instruction_set = get_instruction_set())
+{
+    if(a.size() == 0 || b.size() == 0 || a.columns() != b.rows())
+        return false;
+
+    using MicroKernel = void(*)(int64_t, const double*, const double*, double*);
+
+    MicroKernel micro_kernel = &multiply_panels;
+
+#if defined(LAZYDATA_X86_64)
+    if(int(instruction_set) >= int(InstructionSet::AVX2) && int(detect_instruction_set()) >= int(InstructionSet::AVX2))
+        micro_kernel = &AVX2::multiply_panels;
+#else
+    (void)instruction_set;
+#endif
+
+    const int64_t m = a.rows();
+    const int64_t n = b.columns();
+    const int64_t k = a.columns();
+
+    for(int64_t i = 0; i < m; ++i)
+        std::fill(destination + i * destination_row_stride, destination + i * destination_row_stride + n, 0.0);
+
+    std::vector<double> packed_b;
+
+    const int64_t number_of_threads = get_thread_pool().get_number_of_threads();
+
+    for(int64_t first_column = 0; first_column < n; first_column += GEMM_NC)
+    {
+        const int64_t number_of_columns = std::min(GEMM_NC, n - first_column);
+        const int64_t number_of_b_panels = (number_of_columns + GEMM_NR - 1) / GEMM_NR;
+
+        for(int64_t first_k = 0; first_k < k; first_k += GEMM_KC)
+        {
+            const int64_t depth = std::min(GEMM_KC, k - first_k);
+
+            // Pack the block of B once, all threads read it
+            packed_b.resize(number_of_b_panels * depth * GEMM_NR);
+
+            get_thread_pool().parallel_for(number_of_b_panels, [&](int64_t panel)
+            {
+                pack_b_panel(b, first_k, first_column + panel * GEMM_NR, depth, packed_b.data() + panel * depth * GEMM_NR);
+            });
+
+            // Each task multiplies a block of A with a group of B panels,
+            // tall results are split by rows, wide ones by columns too
+            const int64_t number_of_row_blocks = (m + GEMM_MC - 1) / GEMM_MC;
+            const int64_t number_of_panel_groups = std::max(int64_t(1), std::min(number_of_b_panels, (2 * number_of_threads + number_of_row_blocks - 1) / number_of_row_blocks));
+            const int64_t panels_per_group = (number_of_b_panels + number_of_panel_groups - 1) / number_of_panel_groups;
+
+            get_thread_pool().parallel_for(number_of_row_blocks * number_of_panel_groups, [&](int64_t task)
+            {
+                const int64_t first_row = (task / number_of_panel_groups) * GEMM_MC;
+                const int64_t number_of_rows = std::min(GEMM_MC, m - first_row);
+                const int64_t number_of_a_panels = (number_of_rows + GEMM_MR - 1) / GEMM_MR;
+
+                const int64_t first_panel = (task % number_of_panel_groups) * panels_per_group;
+                const int64_t last_panel = std::min(number_of_b_panels, first_panel + panels_per_group);
+
+                thread_local std::vector<double> packed_a;
+                packed_a.resize(number_of_a_panels * depth * GEMM_MR);
+
+                for(int64_t panel = 0; panel < number_of_a_panels; ++panel)
+                    pack_a_panel(a, first_row + panel * GEMM_MR, first_k, depth, packed_a.data() + panel * depth * GEMM_MR);
+
+                alignas(64) double tile[GEMM_MR * GEMM_NR];
+
+                for(int64_t b_panel = first_panel; b_panel < last_panel; ++b_panel)
+                {
+                    const int64_t tile_column = first_column + b_panel * GEMM_NR;
+                    const int64_t tile_columns = std::min(GEMM_NR, n - tile_column);
+
+                    for(int64_t a_panel = 0; a_panel < number_of_a_panels; ++a_panel)
+                    {
+                        const int64_t tile_row = first_row + a_panel * GEMM_MR;
+                        const int64_t tile_rows = std::min(GEMM_MR, m - tile_row);
+
+                        micro_kernel(depth,
+                                     packed_a.data() + a_panel * depth * GEMM_MR,
+                                     packed_b.data() + b_panel * depth * GEMM_NR,
+                                     tile);
+
+                        for(int64_t r = 0; r < tile_rows; ++r)
+                        {
+                            double* destination_row = destination + (tile_row + r) * destination_row_stride + tile_column;
+
+                            for(int64_t c = 0; c < tile_columns; ++c)
+                                destination_row[c] += tile[r * GEMM_NR + c];
+                        }
+                    }
+                }
+            });
+        }
+    }
+
+    return true;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_GEMM_HPP_
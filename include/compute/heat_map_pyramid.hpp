@@ -0,0 +1,364 @@
+//-------------------------------------------------------------------
+/**
+ * @file heat_map_pyramid.hpp
+ * @brief Multi-resolution pyramid used to draw very big matrices as heat maps.
+ *
+ * A heat map drawn over a few hundred pixels can't show more than one
+ * cell per pixel, so instead of drawing every cell of the matrix we
+ * draw a level of the pyramid whose cells are about one pixel big.
+ * Each level aggregates 2x2 blocks of cells of the level below (their
+ * mean or their maximum), level 0 being the matrix itself (which is
+ * not copied). Means are weighted by the number of cells of the matrix
+ * each cell covers, so that every cell of a level is the mean of the
+ * matrix cells it covers, even along the last row and column, whose
+ * blocks can be smaller, or around NaNs.
+ *
+ * Each level is cut into tiles of TILE_SIZE x TILE_SIZE cells, and a
+ * tile is turned into an RGBA image through a color map, so a frame
+ * only draws (and colors) the few tiles that are visible.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_HEAT_MAP_PYRAMID_HPP_
+#define INCLUDE_COMPUTE_HEAT_MAP_PYRAMID_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "matrix_view.hpp"
+#include "thread_pool.hpp"
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// How the cells of a block are combined into one cell of the next level
+//-------------------------------------------------------------------
+enum class HeatMapAggregation : int
+{
+    Mean = 0,
+    Max
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @class HeatMapPyramid
+ * @brief The aggregated levels of a matrix and its range of values.
+ *
+ * Levels above 0 are stored as floats, which is plenty to pick a color.
+ */
+//-------------------------------------------------------------------
+class HeatMapPyramid
+{
+public:
+
+    // Number of cells on each side of a tile
+    static constexpr int64_t TILE_SIZE = 256;
+
+    // Number of cells in the color map look up table
+    static constexpr int64_t COLORMAP_SIZE = 256;
+
+    HeatMapPyramid()
+    {
+    }
+
+
+
+    /**
+     * @brief Builds the levels of the pyramid until one tile covers the whole matrix.
+     *
+     * The rows of each level are split across the thread pool.
+     */
+    void build(const MatrixView& view, HeatMapAggregation aggregation)
+    {
+        levels_.clear();
+        aggregation_ = aggregation;
+
+        rows_ = view.rows();
+        columns_ = view.columns();
+
+        compute_range_of_values(view);
+
+        int64_t rows = rows_;
+        int64_t columns = columns_;
+
+        // Number of cells of the matrix (NaNs left out) each cell of
+        // the last level built covers, only needed to build the next
+        std::vector<uint32_t> counts;
+        std::vector<uint32_t> previous_counts;
+
+        while(rows > TILE_SIZE || columns > TILE_SIZE)
+        {
+            rows = (rows + 1) / 2;
+            columns = (columns + 1) / 2;
+
+            Level level;
+            level.rows = rows;
+            level.columns = columns;
+            level.values.resize(rows * columns);
+
+            counts.resize(rows * columns);
+
+            if(levels_.empty())
+            {
+                build_level(level,
+                            counts,
+                            [&view](int64_t i, int64_t j){ return view(i,j); },
+                            [](int64_t, int64_t){ return uint32_t(1); },
+                            view.rows(),
+                            view.columns());
+            }
+            else
+            {
+                const Level& previous_level = levels_.back();
+
+                build_level(level,
+                            counts,
+                            [&previous_level](int64_t i, int64_t j){ return double(previous_level.values[i * previous_level.columns + j]); },
+                            [&previous_level, &previous_counts](int64_t i, int64_t j){ return previous_counts[i * previous_level.columns + j]; },
+                            previous_level.rows,
+                            previous_level.columns);
+            }
+
+            levels_.push_back(std::move(level));
+            std::swap(counts, previous_counts);
+        }
+    }
+
+
+
+    int64_t get_number_of_levels()const { return rows_ * columns_ > 0 ? int64_t(levels_.size()) + 1 : 0; }
+
+    int64_t rows(int64_t level)const { return level == 0 ? rows_ : levels_[level - 1].rows; }
+    int64_t columns(int64_t level)const { return level == 0 ? columns_ : levels_[level - 1].columns; }
+
+    // Number of rows (or columns) of the matrix covered by a cell of the level
+    static int64_t get_cell_size(int64_t level) { return int64_t(1) << level; }
+
+    double get_minimum_value()const { return minimum_value_; }
+    double get_maximum_value()const { return maximum_value_; }
+
+    /**
+     * @brief Value of a cell of a level (level 0 is read from the matrix).
+     */
+    double get_value(const MatrixView& view, int64_t level, int64_t row, int64_t column)const
+    {
+        if(level == 0)
+            return view(row, column);
+
+        return levels_[level - 1].values[row * levels_[level - 1].columns + column];
+    }
+
+
+
+    /**
+     * @brief Coarsest level whose cells still cover at most one pixel.
+     *
+     * @param visible_rows Number of rows of the matrix that are visible.
+     * @param visible_columns Number of columns of the matrix that are visible.
+     */
+    int64_t choose_level(double visible_rows, double visible_columns, double pixel_height, double pixel_width)const
+    {
+        const double cells_per_pixel = std::max(visible_rows / std::max(1.0, pixel_height),
+                                                visible_columns / std::max(1.0, pixel_width));
+
+        int64_t level = 0;
+        while(level + 1 < get_number_of_levels() && double(get_cell_size(level + 1)) <= cells_per_pixel)
+            ++level;
+
+        return level;
+    }
+
+    int64_t get_number_of_tile_rows(int64_t level)const { return (rows(level) + TILE_SIZE - 1) / TILE_SIZE; }
+    int64_t get_number_of_tile_columns(int64_t level)const { return (columns(level) + TILE_SIZE - 1) / TILE_SIZE; }
+
+
+
+    /**
+     * @brief Colors a tile of a level into an RGBA image (one uint32_t per cell, row after row).
+     *
+     * The range of values of the matrix is spread over the color map,
+     * NaNs are transparent.
+     *
+     * @param view The matrix the pyramid was built from (for level 0).
+     * @param colormap COLORMAP_SIZE colors, from the lowest value to the highest.
+     * @param image Resized to tile_rows x tile_columns cells.
+     */
+    void color_tile(const MatrixView& view,
+                    int64_t level,
+                    int64_t tile_row,
+                    int64_t tile_column,
+                    const std::vector<uint32_t>& colormap,
+                    std::vector<uint32_t>& image,
+                    int64_t& tile_rows,
+                    int64_t& tile_columns)const
+    {
+        const int64_t first_row = tile_row * TILE_SIZE;
+        const int64_t first_column = tile_column * TILE_SIZE;
+
+        tile_rows = std::max(int64_t(0), std::min(TILE_SIZE, rows(level) - first_row));
+        tile_columns = std::max(int64_t(0), std::min(TILE_SIZE, columns(level) - first_column));
+
+        image.resize(tile_rows * tile_columns);
+
+        const double range = maximum_value_ - minimum_value_;
+        const double scale = (range > 0) ? double(COLORMAP_SIZE - 1) / range : 0.0;
+
+        for(int64_t i = 0; i < tile_rows; ++i)
+        {
+            for(int64_t j = 0; j < tile_columns; ++j)
+            {
+                const double value = get_value(view, level, first_row + i, first_column + j);
+
+                if(std::isnan(value))
+                {
+                    image[i * tile_columns + j] = 0;
+                    continue;
+                }
+
+                const int64_t index = int64_t((value - minimum_value_) * scale + 0.5);
+                image[i * tile_columns + j] = colormap[std::clamp(index, int64_t(0), COLORMAP_SIZE - 1)];
+            }
+        }
+    }
+
+
+
+private:
+
+    struct Level
+    {
+        int64_t rows = 0;
+        int64_t columns = 0;
+        std::vector<float> values;
+    };
+
+
+
+    void compute_range_of_values(const MatrixView& view)
+    {
+        const int64_t number_of_rows = view.rows();
+
+        std::vector<double> minimums(number_of_rows, std::numeric_limits<double>::infinity());
+        std::vector<double> maximums(number_of_rows, -std::numeric_limits<double>::infinity());
+
+        get_thread_pool().parallel_for(number_of_rows, [&](int64_t i)
+        {
+            for(int64_t j = 0; j < view.columns(); ++j)
+            {
+                const double value = view(i,j);
+
+                // NaNs fail both comparisons
+                if(value < minimums[i])
+                    minimums[i] = value;
+                if(value > maximums[i])
+                    maximums[i] = value;
+            }
+        });
+
+        minimum_value_ = number_of_rows > 0 ? *std::min_element(minimums.begin(), minimums.end()) : 0.0;
+        maximum_value_ = number_of_rows > 0 ? *std::max_element(maximums.begin(), maximums.end()) : 0.0;
+
+        // Only NaNs (or infinities)
+        if(!std::isfinite(minimum_value_) || !std::isfinite(maximum_value_))
+        {
+            minimum_value_ = 0.0;
+            maximum_value_ = 1.0;
+        }
+    }
+
+
+
+    // Aggregates the 2x2 blocks of the level below (blocks on the
+    // last row or column can be smaller), skipping NaNs
+    // -- Means weight each cell below by its count (the number of
+    //    cells of the matrix it covers), and the counts of the new
+    //    cells are their blocks' total
+    template<typename ValueAt, typename CountAt>
+
+    void build_level(Level& level,
+                     std::vector<uint32_t>& counts,
+                     ValueAt value_at,
+                     CountAt count_at,
+                     int64_t previous_rows,
+                     int64_t previous_columns)const
+    {
+        get_thread_pool().parallel_for(level.rows, [&](int64_t i)
+        {
+            for(int64_t j = 0; j < level.columns; ++j)
+            {
+                double sum = 0.0;
+                double maximum = -std::numeric_limits<double>::infinity();
+                uint32_t count = 0;
+
+                for(int64_t k = 2 * i; k < std::min(previous_rows, 2 * i + 2); ++k)
+                {
+                    for(int64_t l = 2 * j; l < std::min(previous_columns, 2 * j + 2); ++l)
+                    {
+                        const double value = value_at(k, l);
+
+                        if(std::isnan(value))
+                            continue;
+
+                        const uint32_t cell_count = count_at(k, l);
+
+                        sum += value * double(cell_count);
+                        maximum = std::max(maximum, value);
+                        count += cell_count;
+                    }
+                }
+
+                double aggregated_value = std::numeric_limits<double>::quiet_NaN();
+
+                if(count > 0)
+                    aggregated_value = (aggregation_ == HeatMapAggregation::Mean) ? sum / double(count) : maximum;
+
+                level.values[i * level.columns + j] = float(aggregated_value);
+                counts[i * level.columns + j] = count;
+            }
+        });
+    }
+
+
+
+    int64_t rows_ = 0;
+    int64_t columns_ = 0;
+
+    HeatMapAggregation aggregation_ = HeatMapAggregation::Mean;
+
+    double minimum_value_ = 0.0;
+    double maximum_value_ = 1.0;
+
+    std::vector<Level> levels_;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_HEAT_MAP_PYRAMID_HPP_
@@ -0,0 +1,187 @@
+//-------------------------------------------------------------------
+/**
+ * @file image_conversion.hpp
+ * @brief Conversion of 8-bit rgb(a) images into matrices of doubles.
+ *
+ * Each row of the image becomes a row of the matrix holding the red,
+ * green and blue values of its pixels (alpha is dropped), either packed
+ * (r,g,b of the first pixel, then of the second...) or planar (the reds
+ * of the row, then its greens, then its blues).
+ *
+ * RGBA rows are converted 4 pixels at a time with SSE2: the channels
+ * are masked out of each pixel's 32 bits, converted to doubles and then
+ * either stored to their plane or shuffled back into r,g,b order. The
+ * rows are split across the thread pool.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_IMAGE_CONVERSION_HPP_
+#define INCLUDE_COMPUTE_IMAGE_CONVERSION_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <algorithm>
+#include <cstdint>
+
+#include "instruction_set.hpp"
+#include "thread_pool.hpp"
+
+#if defined(LAZYDATA_X86_64)
+    #include <emmintrin.h>
+#endif
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// How the channels of a row of pixels are laid out in a row of the matrix
+//-------------------------------------------------------------------
+enum class ChannelLayout : int
+{
+    Packed = 0,     // r,g,b,r,g,b...
+    Planar          // r,r,...,g,g,...,b,b,...
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Converts a row of 8-bit pixels into 3 doubles per pixel.
+ *
+ * @param pixels The pixels, pixel_size bytes each (3 for rgb, 4 for rgba).
+ * @param output 3 * number_of_pixels doubles.
+ */
+//-------------------------------------------------------------------
+inline void convert_rgb_row(const uint8_t* pixels,
+                            int64_t pixel_size,
+                            int64_t number_of_pixels,
+                            ChannelLayout layout,
+                            double* output)
+{
+    int64_t pixel = 0;
+
+    double* reds = output;
+    double* greens = output + number_of_pixels;
+    double* blues = output + 2 * number_of_pixels;
+
+#if defined(LAZYDATA_X86_64)
+
+    if(pixel_size == 4)
+    {
+        const __m128i channel_mask = _mm_set1_epi32(0xff);
+
+        for(; pixel + 4 <= number_of_pixels; pixel += 4)
+        {
+            const __m128i rgba = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + 4 * pixel));
+
+            const __m128i red = _mm_and_si128(rgba, channel_mask);
+            const __m128i green = _mm_and_si128(_mm_srli_epi32(rgba, 8), channel_mask);
+            const __m128i blue = _mm_and_si128(_mm_srli_epi32(rgba, 16), channel_mask);
+
+            // Pixels 0,1 and 2,3
+            const __m128d red_01 = _mm_cvtepi32_pd(red);
+            const __m128d red_23 = _mm_cvtepi32_pd(_mm_shuffle_epi32(red, _MM_SHUFFLE(1,0,3,2)));
+            const __m128d green_01 = _mm_cvtepi32_pd(green);
+            const __m128d green_23 = _mm_cvtepi32_pd(_mm_shuffle_epi32(green, _MM_SHUFFLE(1,0,3,2)));
+            const __m128d blue_01 = _mm_cvtepi32_pd(blue);
+            const __m128d blue_23 = _mm_cvtepi32_pd(_mm_shuffle_epi32(blue, _MM_SHUFFLE(1,0,3,2)));
+
+            if(layout == ChannelLayout::Planar)
+            {
+                _mm_storeu_pd(reds + pixel, red_01);
+                _mm_storeu_pd(reds + pixel + 2, red_23);
+                _mm_storeu_pd(greens + pixel, green_01);
+                _mm_storeu_pd(greens + pixel + 2, green_23);
+                _mm_storeu_pd(blues + pixel, blue_01);
+                _mm_storeu_pd(blues + pixel + 2, blue_23);
+            }
+            else
+            {
+                // (r0,g0) (b0,r1) (g1,b1), then the same for pixels 2,3
+                double* packed = output + 3 * pixel;
+
+                _mm_storeu_pd(packed, _mm_unpacklo_pd(red_01, green_01));
+                _mm_storeu_pd(packed + 2, _mm_shuffle_pd(blue_01, red_01, 2));
+                _mm_storeu_pd(packed + 4, _mm_unpackhi_pd(green_01, blue_01));
+                _mm_storeu_pd(packed + 6, _mm_unpacklo_pd(red_23, green_23));
+                _mm_storeu_pd(packed + 8, _mm_shuffle_pd(blue_23, red_23, 2));
+                _mm_storeu_pd(packed + 10, _mm_unpackhi_pd(green_23, blue_23));
+            }
+        }
+    }
+
+#endif
+
+    for(; pixel < number_of_pixels; ++pixel)
+    {
+        const uint8_t* rgb = pixels + pixel_size * pixel;
+
+        if(layout == ChannelLayout::Planar)
+        {
+            reds[pixel] = rgb[0];
+            greens[pixel] = rgb[1];
+            blues[pixel] = rgb[2];
+        }
+        else
+        {
+            output[3 * pixel] = rgb[0];
+            output[3 * pixel + 1] = rgb[1];
+            output[3 * pixel + 2] = rgb[2];
+        }
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Converts an image (rows of contiguous pixels) into a rows x (3 * columns) matrix.
+ *
+ * @param output Row-major, 3 * columns doubles per row.
+ */
+//-------------------------------------------------------------------
+inline void convert_rgb_image(const uint8_t* pixels,
+                              int64_t pixel_size,
+                              int64_t rows,
+                              int64_t columns,
+                              ChannelLayout layout,
+                              double* output)
+{
+    // Enough rows per task to amortize handing them out
+    const int64_t rows_per_task = std::max(int64_t(1), (int64_t(64) << 10) / std::max(int64_t(1), columns));
+    const int64_t number_of_tasks = (rows + rows_per_task - 1) / rows_per_task;
+
+    get_thread_pool().parallel_for(number_of_tasks, [&](int64_t task)
+    {
+        const int64_t first_row = task * rows_per_task;
+        const int64_t last_row = std::min(rows, first_row + rows_per_task);
+
+        for(int64_t i = first_row; i < last_row; ++i)
+            convert_rgb_row(pixels + i * columns * pixel_size, pixel_size, columns, layout, output + i * 3 * columns);
+    });
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_IMAGE_CONVERSION_HPP_
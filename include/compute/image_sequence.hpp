@@ -0,0 +1,483 @@
+//-------------------------------------------------------------------
+/**
+ * @file image_sequence.hpp
+ * @brief Sequences of image files, and a bounded ring of frames loaded ahead of time.
+ *
+ * A sequence is the set of files of a directory sharing the extension
+ * of one of them, ordered the way their names read (frame_2 before
+ * frame_10), so a numbered sequence doesn't need zero-padded names.
+ *
+ * The PrefetchRing keeps the next few frames of a sequence loading on
+ * a few worker threads while the current one is used, so that stepping
+ * through the sequence finds its frames mostly loaded already.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_IMAGE_SEQUENCE_HPP_
+#define INCLUDE_COMPUTE_IMAGE_SEQUENCE_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Compares file names the way they read: runs of digits compare as numbers.
+ */
+//-------------------------------------------------------------------
+inline bool is_natural_order_less(const std::string& a, const std::string& b)
+{
+    std::size_t i = 0;
+    std::size_t j = 0;
+
+    while(i < a.size() && j < b.size())
+    {
+        if(std::isdigit(uint8_t(a[i])) && std::isdigit(uint8_t(b[j])))
+        {
+            // Compare the runs of digits by value, ignoring leading zeros
+            std::size_t a_end = i;
+            std::size_t b_end = j;
+
+            while(a_end < a.size() && std::isdigit(uint8_t(a[a_end])))
+                ++a_end;
+            while(b_end < b.size() && std::isdigit(uint8_t(b[b_end])))
+                ++b_end;
+
+            std::size_t a_start = i;
+            std::size_t b_start = j;
+
+            while(a_start + 1 < a_end && a[a_start] == '0')
+                ++a_start;
+            while(b_start + 1 < b_end && b[b_start] == '0')
+                ++b_start;
+
+            if(a_end - a_start != b_end - b_start)
+                return a_end - a_start < b_end - b_start;
+
+            const int comparison = a.compare(a_start, a_end - a_start, b, b_start, b_end - b_start);
+
+            if(comparison != 0)
+                return comparison < 0;
+
+            i = a_end;
+            j = b_end;
+        }
+        else
+        {
+            if(a[i] != b[j])
+                return uint8_t(a[i]) < uint8_t(b[j]);
+
+            ++i;
+            ++j;
+        }
+    }
+
+    // "frame_01" and "frame_1" are equal digit-wise, fall back on the names
+    if(i == a.size() && j == b.size())
+        return a < b;
+
+    return i == a.size();
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Lists the files of the sequence a file belongs to.
+ *
+ * @return The files of its directory with the same extension (ignoring
+ *         case), in natural order, or an empty vector if the directory
+ *         can't be read.
+ */
+//-------------------------------------------------------------------
+inline std::vector<std::filesystem::path> list_image_sequence(const std::filesystem::path& filename)
+{
+    std::vector<std::filesystem::path> frames;
+
+    auto to_lower = [](std::string text)
+    {
+        std::transform(text.begin(), text.end(), text.begin(), [](char c){ return char(std::tolower(uint8_t(c))); });
+        return text;
+    };
+
+    const std::string extension = to_lower(filename.extension().string());
+
+    std::filesystem::path directory = filename.parent_path();
+    if(directory.empty())
+        directory = ".";
+
+    std::error_code error;
+
+    for(std::filesystem::directory_iterator entry(directory, error), end; !error && entry != end; entry.increment(error))
+    {
+        if(entry->is_regular_file(error) && to_lower(entry->path().extension().string()) == extension)
+            frames.push_back(entry->path());
+    }
+
+    std::sort(frames.begin(), frames.end(), [](const std::filesystem::path& a, const std::filesystem::path& b)
+    {
+        return is_natural_order_less(a.filename().string(), b.filename().string());
+    });
+
+    return frames;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief A bounded ring of frames being loaded ahead on worker threads.
+ *
+ * Frames are loaded by the loader function, on a fixed number of worker
+ * threads, so at most that many frames are ever loading. Frames wait in
+ * the ring in the order they were asked for, and the ones dropped before
+ * a worker got to them are never loaded. A frame dropped while loading
+ * is thrown away once it's loaded. Copies of a ring share its frames
+ * and workers.
+ *
+ * The workers are detached when the last copy of the ring is destroyed,
+ * so that destroying it never waits for a frame being loaded.
+ */
+//-------------------------------------------------------------------
+template<typename FrameType>
+class PrefetchRing
+{
+public:
+
+    using Loader = std::function<FrameType(int64_t)>;
+
+    explicit PrefetchRing(int64_t capacity = 4, int number_of_workers = 2)
+    : capacity_(std::max(int64_t(1), capacity)),
+      workers_(std::make_shared<Workers>(std::max(1, number_of_workers)))
+    {
+    }
+
+
+
+    // Drops all the frames, the ones loading are thrown away once loaded
+    void set_loader(const Loader& loader)
+    {
+        State& state = *workers_->state;
+
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+
+            state.slots.clear();
+            state.loader = loader;
+            ++state.loader_version;
+        }
+
+        state.frame_loaded.notify_all();
+    }
+
+    void clear()
+    {
+        State& state = *workers_->state;
+
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.slots.clear();
+        }
+
+        state.frame_loaded.notify_all();
+    }
+
+    int64_t get_capacity()const
+    {
+        return capacity_;
+    }
+
+    // Frames waiting for a worker, and frames being loaded (even dropped ones)
+    int64_t get_number_of_loading_frames()const
+    {
+        State& state = *workers_->state;
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        int64_t number_of_loading_frames = state.number_of_frames_being_loaded;
+
+        for(const auto& slot : state.slots)
+        {
+            if(slot.status == SlotStatus::Waiting)
+                ++number_of_loading_frames;
+        }
+
+        return number_of_loading_frames;
+    }
+
+
+
+    bool contains(int64_t index)const
+    {
+        State& state = *workers_->state;
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        return state.find(index) != nullptr;
+    }
+
+    bool is_ready(int64_t index)const
+    {
+        State& state = *workers_->state;
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        const Slot* slot = state.find(index);
+
+        return slot && slot->status == SlotStatus::Ready;
+    }
+
+    // Gets the frame if it's loaded, without waiting
+    bool try_get(int64_t index, FrameType& frame)const
+    {
+        State& state = *workers_->state;
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        const Slot* slot = state.find(index);
+
+        if(!slot || slot->status != SlotStatus::Ready)
+            return false;
+
+        frame = slot->frame;
+
+        return true;
+    }
+
+    // Waits for the frame if it's in the ring, loads it here if it isn't
+    FrameType get(int64_t index)
+    {
+        State& state = *workers_->state;
+        std::unique_lock<std::mutex> lock(state.mutex);
+
+        state.frame_loaded.wait(lock, [&state, index]()
+        {
+            const Slot* slot = state.find(index);
+            return !slot || slot->status == SlotStatus::Ready;
+        });
+
+        if(const Slot* slot = state.find(index))
+            return slot->frame;
+
+        const Loader loader = state.loader;
+        lock.unlock();
+
+        if(!loader)
+            return FrameType();
+
+        return loader(index);
+    }
+
+
+
+    /**
+     * @brief Keeps the ring loading the frames of indices, the first ones first.
+     *
+     * At most capacity frames are kept, the ones not in indices are
+     * dropped and the missing ones are queued for the workers.
+     */
+    void prefetch(const std::vector<int64_t>& indices)
+    {
+        State& state = *workers_->state;
+
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+
+            const std::size_t number_of_indices = std::min(indices.size(), std::size_t(capacity_));
+
+            std::vector<Slot> slots;
+
+            for(std::size_t i = 0; i < number_of_indices && state.loader; ++i)
+            {
+                if(std::any_of(slots.begin(), slots.end(), [&](const Slot& slot){ return slot.index == indices[i]; }))
+                    continue;
+
+                if(Slot* slot = state.find(indices[i]))
+                    slots.push_back(std::move(*slot));
+                else
+                    slots.push_back(Slot{indices[i], SlotStatus::Waiting, FrameType()});
+            }
+
+            state.slots = std::move(slots);
+        }
+
+        state.frame_wanted.notify_all();
+        state.frame_loaded.notify_all();
+    }
+
+    // Keeps the ring loading the frames [first_index, last_index)
+    void prefetch(int64_t first_index, int64_t last_index)
+    {
+        std::vector<int64_t> indices;
+
+        for(int64_t index = first_index; index < std::min(last_index, first_index + capacity_); ++index)
+            indices.push_back(index);
+
+        prefetch(indices);
+    }
+
+
+
+private:
+
+    enum class SlotStatus
+    {
+        Waiting,
+        Loading,
+        Ready
+    };
+
+    struct Slot
+    {
+        int64_t index = 0;
+        SlotStatus status = SlotStatus::Waiting;
+        FrameType frame;
+    };
+
+    // What the ring and its workers share
+    struct State
+    {
+        std::mutex mutex;
+        std::condition_variable frame_wanted;
+        std::condition_variable frame_loaded;
+
+        Loader loader;
+        uint64_t loader_version = 0;
+
+        std::vector<Slot> slots;
+        int64_t number_of_frames_being_loaded = 0;
+
+        bool is_stopping = false;
+
+        Slot* find(int64_t index)
+        {
+            for(auto& slot : slots)
+            {
+                if(slot.index == index)
+                    return &slot;
+            }
+
+            return nullptr;
+        }
+    };
+
+    struct Workers
+    {
+        explicit Workers(int number_of_workers) : state(std::make_shared<State>())
+        {
+            for(int i = 0; i < number_of_workers; ++i)
+                threads.emplace_back(&PrefetchRing::load_frames, state);
+        }
+
+        ~Workers()
+        {
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->is_stopping = true;
+            }
+
+            state->frame_wanted.notify_all();
+
+            for(auto& thread : threads)
+                thread.detach();
+        }
+
+        std::shared_ptr<State> state;
+        std::vector<std::thread> threads;
+    };
+
+
+
+    // Function run by the workers, loading the first waiting frames
+    static void load_frames(std::shared_ptr<State> state)
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+
+        while(true)
+        {
+            Slot* slot = nullptr;
+
+            state->frame_wanted.wait(lock, [&state, &slot]()
+            {
+                for(auto& waiting_slot : state->slots)
+                {
+                    if(waiting_slot.status == SlotStatus::Waiting)
+                    {
+                        slot = &waiting_slot;
+                        break;
+                    }
+                }
+
+                return state->is_stopping || slot != nullptr;
+            });
+
+            if(state->is_stopping)
+                return;
+
+            slot->status = SlotStatus::Loading;
+
+            const int64_t index = slot->index;
+            const uint64_t loader_version = state->loader_version;
+            const Loader loader = state->loader;
+
+            ++state->number_of_frames_being_loaded;
+            lock.unlock();
+
+            FrameType frame = loader(index);
+
+            lock.lock();
+            --state->number_of_frames_being_loaded;
+
+            // The slot may have been dropped, or dropped and asked for again
+            slot = state->find(index);
+
+            if(slot && slot->status != SlotStatus::Ready && loader_version == state->loader_version)
+            {
+                slot->frame = std::move(frame);
+                slot->status = SlotStatus::Ready;
+            }
+
+            state->frame_loaded.notify_all();
+        }
+    }
+
+
+
+    int64_t capacity_ = 4;
+
+    std::shared_ptr<Workers> workers_;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_IMAGE_SEQUENCE_HPP_
@@ -0,0 +1,247 @@
+//-------------------------------------------------------------------
+/**
+ * @file index_selection.hpp
+ * @brief A set of selected indices (rows or columns) stored as a bitset.
+ *
+ * Selecting or deselecting an index is a bit flip, and listing the
+ * selected indices (in increasing order) or the runs of consecutive
+ * ones scans 64 indices per word, so selecting millions of rows costs
+ * a few megabytes and milliseconds.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_INDEX_SELECTION_HPP_
+#define INCLUDE_COMPUTE_INDEX_SELECTION_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "instruction_set.hpp"
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @class IndexSelection
+ * @brief Which of the indices [0, size()) are selected.
+ */
+//-------------------------------------------------------------------
+class IndexSelection
+{
+public:
+
+    IndexSelection()
+    {
+    }
+
+    explicit IndexSelection(int64_t size)
+    {
+        resize(size);
+    }
+
+
+
+    int64_t size()const { return size_; }
+
+    /**
+     * @brief Changes the number of indices, indices that no longer exist are deselected.
+     */
+    void resize(int64_t size)
+    {
+        size_ = std::max(int64_t(0), size);
+        words_.resize((size_ + 63) / 64, 0);
+        clear_unused_bits();
+    }
+
+
+
+    bool is_selected(int64_t index)const
+    {
+        if(index < 0 || index >= size_)
+            return false;
+
+        return (words_[index / 64] >> (index % 64)) & 1;
+    }
+
+    /**
+     * @brief Selects (or deselects) an index, indices out of range are ignored.
+     */
+    void select(int64_t index, bool is_selected = true)
+    {
+        if(index < 0 || index >= size_)
+            return;
+
+        const uint64_t bit = uint64_t(1) << (index % 64);
+
+        if(is_selected)
+            words_[index / 64] |= bit;
+        else
+            words_[index / 64] &= ~bit;
+    }
+
+    void deselect(int64_t index)
+    {
+        select(index, false);
+    }
+
+    /**
+     * @brief Selects (or deselects) the indices [first, last).
+     */
+    void select_range(int64_t first, int64_t last, bool is_selected = true)
+    {
+        first = std::max(int64_t(0), first);
+        last = std::min(size_, last);
+
+        for(int64_t index = first; index < last;)
+        {
+            const int64_t word = index / 64;
+            const int64_t first_bit = index % 64;
+            const int64_t last_bit = std::min(int64_t(64), first_bit + (last - index));
+
+            const uint64_t mask = (last_bit == 64 ? ~uint64_t(0) : ((uint64_t(1) << last_bit) - 1)) & (~uint64_t(0) << first_bit);
+
+            if(is_selected)
+                words_[word] |= mask;
+            else
+                words_[word] &= ~mask;
+
+            index += last_bit - first_bit;
+        }
+    }
+
+    void select_all()
+    {
+        std::fill(words_.begin(), words_.end(), ~uint64_t(0));
+        clear_unused_bits();
+    }
+
+    void clear()
+    {
+        std::fill(words_.begin(), words_.end(), 0);
+    }
+
+
+
+    /**
+     * @brief Number of selected indices.
+     */
+    int64_t count()const
+    {
+        int64_t number_of_selected_indices = 0;
+
+        for(const auto& word : words_)
+            number_of_selected_indices += count_set_bits(word);
+
+        return number_of_selected_indices;
+    }
+
+    bool are_all_selected()const
+    {
+        return count() == size_;
+    }
+
+
+
+    /**
+     * @brief The selected indices, in increasing order.
+     */
+    std::vector<int64_t> to_indices()const
+    {
+        std::vector<int64_t> indices;
+        indices.reserve(count());
+
+        for(std::size_t word_index = 0; word_index < words_.size(); ++word_index)
+        {
+            uint64_t word = words_[word_index];
+
+            while(word)
+            {
+                indices.push_back(int64_t(word_index) * 64 + count_trailing_zeros(word));
+                word &= word - 1;
+            }
+        }
+
+        return indices;
+    }
+
+    /**
+     * @brief The runs [first, last) of consecutive selected indices, in increasing order.
+     */
+    std::vector<std::pair<int64_t, int64_t>> to_ranges()const
+    {
+        std::vector<std::pair<int64_t, int64_t>> ranges;
+
+        int64_t index = find_next(0, true);
+
+        while(index < size_)
+        {
+            const int64_t end = find_next(index, false);
+            ranges.emplace_back(index, end);
+            index = find_next(end, true);
+        }
+
+        return ranges;
+    }
+
+
+
+private:
+
+    // First index at or after the given one whose bit is the
+    // given value (size() if there's none)
+    int64_t find_next(int64_t index, bool value)const
+    {
+        while(index < size_)
+        {
+            const int64_t bit = index % 64;
+            uint64_t word = value ? words_[index / 64] : ~words_[index / 64];
+            word &= ~uint64_t(0) << bit;
+
+            if(word)
+                return std::min(size_, (index - bit) + count_trailing_zeros(word));
+
+            index += 64 - bit;
+        }
+
+        return size_;
+    }
+
+    void clear_unused_bits()
+    {
+        if(size_ % 64 != 0)
+            words_.back() &= (uint64_t(1) << (size_ % 64)) - 1;
+    }
+
+
+
+    int64_t size_ = 0;
+    std::vector<uint64_t> words_;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_INDEX_SELECTION_HPP_
@@ -0,0 +1,265 @@
+//-------------------------------------------------------------------
+/**
+ * @file instruction_set.hpp
+ * @brief Runtime detection of the SIMD instruction sets the CPU supports.
+ *
+ * Vectorized kernels are compiled for every instruction set up front
+ * and the best one the CPU supports is picked when the program runs,
+ * so the same binary runs everywhere.
+ *
+ * The LAZYDATA_INSTRUCTION_SET environment variable (scalar, sse2, avx2
+ * or avx512) can be used to cap the instruction set, for example to
+ * compare the kernels with each other.
+ *
+ * It also wraps the bit counting and prefetching intrinsics, which each
+ * compiler spells its own way.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_INSTRUCTION_SET_HPP_
+#define INCLUDE_COMPUTE_INSTRUCTION_SET_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define LAZYDATA_X86_64 1
+#endif
+
+#if defined(LAZYDATA_X86_64) && defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+    #include <immintrin.h>
+#endif
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Instruction sets ordered from the least to the most capable
+//-------------------------------------------------------------------
+enum class InstructionSet : int
+{
+    Scalar = 0,
+    SSE2,
+    AVX2,       // with FMA
+    AVX512      // AVX-512F
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+inline const char* get_instruction_set_name(InstructionSet instruction_set)
+{
+    switch(instruction_set)
+    {
+        default:
+        case InstructionSet::Scalar: return "scalar";
+        case InstructionSet::SSE2: return "sse2";
+        case InstructionSet::AVX2: return "avx2";
+        case InstructionSet::AVX512: return "avx512";
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief The most capable instruction set supported by the CPU (and the OS).
+ */
+//-------------------------------------------------------------------
+inline InstructionSet detect_instruction_set()
+{
+#if defined(LAZYDATA_X86_64) && (defined(__GNUC__) || defined(__clang__))
+
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("avx512f"))
+        return InstructionSet::AVX512;
+
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return InstructionSet::AVX2;
+
+    return InstructionSet::SSE2;
+
+#elif defined(LAZYDATA_X86_64) && defined(_MSC_VER)
+
+    int registers[4] = {};
+
+    __cpuid(registers, 1);
+    const bool has_fma = (registers[2] & (1 << 12)) != 0;
+    const bool has_osxsave = (registers[2] & (1 << 27)) != 0;
+
+    if(!has_osxsave)
+        return InstructionSet::SSE2;
+
+    // Check that the OS saves the ymm (and zmm) registers
+    const unsigned long long enabled_state = _xgetbv(0);
+    const bool are_ymm_registers_saved = (enabled_state & 0x6) == 0x6;
+    const bool are_zmm_registers_saved = (enabled_state & 0xe6) == 0xe6;
+
+    __cpuidex(registers, 7, 0);
+    const bool has_avx2 = (registers[1] & (1 << 5)) != 0;
+    const bool has_avx512f = (registers[1] & (1 << 16)) != 0;
+
+    if(has_avx512f && are_zmm_registers_saved)
+        return InstructionSet::AVX512;
+
+    if(has_avx2 && has_fma && are_ymm_registers_saved)
+        return InstructionSet::AVX2;
+
+    return InstructionSet::SSE2;
+
+#else
+
+    return InstructionSet::Scalar;
+
+#endif
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief The instruction set used by the kernels (detected once).
+ */
+//-------------------------------------------------------------------
+inline InstructionSet get_instruction_set()
+{
+    static const InstructionSet instruction_set = []()
+    {
+        InstructionSet detected_instruction_set = detect_instruction_set();
+
+        if(const char* cap = std::getenv("LAZYDATA_INSTRUCTION_SET"))
+        {
+            for(int i = 0; i <= int(InstructionSet::AVX512); ++i)
+            {
+                if(std::string(cap) == get_instruction_set_name(InstructionSet(i)))
+                    return InstructionSet(std::min(i, int(detected_instruction_set)));
+            }
+        }
+
+        return detected_instruction_set;
+    }();
+
+    return instruction_set;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Number of bits set in a word.
+ */
+//-------------------------------------------------------------------
+inline int count_set_bits(uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+
+    return __builtin_popcountll(word);
+
+#elif defined(LAZYDATA_X86_64) && defined(_MSC_VER)
+
+    return int(__popcnt64(word));
+
+#else
+
+    word = word - ((word >> 1) & 0x5555555555555555ull);
+    word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+    word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0full;
+
+    return int((word * 0x0101010101010101ull) >> 56);
+
+#endif
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Index of the lowest bit set in a word, which can't be 0.
+ */
+//-------------------------------------------------------------------
+inline int count_trailing_zeros(uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+
+    return __builtin_ctzll(word);
+
+#elif defined(LAZYDATA_X86_64) && defined(_MSC_VER)
+
+    unsigned long index = 0;
+    _BitScanForward64(&index, word);
+
+    return int(index);
+
+#else
+
+    int index = 0;
+
+    while((word & 1) == 0)
+    {
+        word >>= 1;
+        ++index;
+    }
+
+    return index;
+
+#endif
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Hints the CPU to start loading the cache line of an address that's about to be read.
+ */
+//-------------------------------------------------------------------
+inline void prefetch_for_reading(const void* address)
+{
+#if defined(__GNUC__) || defined(__clang__)
+
+    __builtin_prefetch(address);
+
+#elif defined(LAZYDATA_X86_64) && defined(_MSC_VER)
+
+    _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+
+#else
+
+    (void)address;
+
+#endif
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_INSTRUCTION_SET_HPP_
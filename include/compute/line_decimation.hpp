@@ -0,0 +1,357 @@
+//-------------------------------------------------------------------
+/**
+ * @file line_decimation.hpp
+ * @brief Min/max decimation pyramid used to plot very long lines.
+ *
+ * A line drawn over a few hundred pixels can't show more than a couple
+ * of points per pixel, so instead of handing millions of points to the
+ * plotting library we hand it, for each bucket of consecutive points,
+ * the bucket's minimum and maximum (in their original order). That keeps
+ * every spike visible while drawing only about two points per pixel.
+ *
+ * The buckets are precomputed once per line, for bucket sizes doubling
+ * from BASE_BUCKET_SIZE, so that any zoom level picks the level whose
+ * buckets are about one pixel wide and copies only its visible part.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_LINE_DECIMATION_HPP_
+#define INCLUDE_COMPUTE_LINE_DECIMATION_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "thread_pool.hpp"
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @class LineDecimation
+ * @brief The min/max pyramid of a line y(x), x being optional (index otherwise).
+ *
+ * The line itself is neither copied nor referenced, get_points() has to
+ * be given the same line the pyramid was built from.
+ */
+//-------------------------------------------------------------------
+class LineDecimation
+{
+public:
+
+    // Number of points in the buckets of the finest level, zooming in
+    // further than that plots the points of the line themselves
+    static constexpr int64_t BASE_BUCKET_SIZE = 64;
+
+    // The pyramid stops at the first level with at most this many buckets
+    static constexpr int64_t COARSEST_LEVEL_SIZE = 512;
+
+    // Number of buckets handed to a thread at a time
+    static constexpr int64_t TASK_SIZE = int64_t(4) << 10;
+
+    LineDecimation()
+    {
+    }
+
+
+
+    /**
+     * @brief Builds the pyramid of a line (the levels are split across the thread pool).
+     *
+     * @param x The x values (nullptr to use the index of each point).
+     * @param y The y values.
+     */
+    void build(const double* x, const double* y, int64_t number_of_points)
+    {
+        number_of_points_ = std::max(int64_t(0), number_of_points);
+        levels_.clear();
+
+        is_x_sorted_ = (x == nullptr) || std::is_sorted(x, x + number_of_points_);
+
+        if(number_of_points_ <= BASE_BUCKET_SIZE)
+            return;
+
+        levels_.push_back(build_base_level(x, y));
+
+        while(levels_.back().number_of_buckets() > COARSEST_LEVEL_SIZE)
+            levels_.push_back(build_next_level(levels_.back()));
+    }
+
+
+
+    int64_t get_number_of_points()const { return number_of_points_; }
+    int64_t get_number_of_levels()const { return int64_t(levels_.size()); }
+    bool is_x_sorted()const { return is_x_sorted_; }
+
+
+
+    /**
+     * @brief Gets the points to plot when [x_min, x_max] is shown over number_of_pixels pixels.
+     *
+     * Inside the range, about two points per pixel are returned (or the
+     * points of the line themselves when there are fewer than that). The
+     * rest of the line is covered with the coarsest level, so the plot
+     * still knows the extents of the whole line (to fit it, for example).
+     * If x isn't sorted the whole line is treated as visible.
+     */
+    void get_points(const double* x,
+                    const double* y,
+                    double x_min,
+                    double x_max,
+                    int64_t number_of_pixels,
+                    std::vector<double>& xs,
+                    std::vector<double>& ys)const
+    {
+        xs.clear();
+        ys.clear();
+
+        if(number_of_points_ == 0)
+            return;
+
+        // Visible points, plus one on each side so that the line reaches the edges
+        int64_t first = 0;
+        int64_t last = number_of_points_;
+
+        if(is_x_sorted_ && x_max >= x_min)
+        {
+            if(x)
+            {
+                first = int64_t(std::lower_bound(x, x + number_of_points_, x_min) - x) - 1;
+                last = int64_t(std::upper_bound(x, x + number_of_points_, x_max) - x) + 1;
+            }
+            else
+            {
+                first = int64_t(std::floor(std::max(-1.0, x_min))) - 1;
+                last = int64_t(std::ceil(std::min(double(number_of_points_), x_max))) + 2;
+            }
+
+            first = std::max(int64_t(0), first);
+            last = std::min(number_of_points_, last);
+
+            if(last <= first)
+            {
+                first = 0;
+                last = number_of_points_;
+            }
+        }
+
+        const int64_t points_per_pixel = (last - first) / std::max(int64_t(1), number_of_pixels);
+
+        // Finest level whose buckets hold about one pixel's worth of points
+        int64_t level_index = -1;
+        while(level_index + 1 < int64_t(levels_.size()) && levels_[level_index + 1].bucket_size <= points_per_pixel)
+            ++level_index;
+
+        if(levels_.empty())
+        {
+            append_points_of_line(x, y, first, last, xs, ys);
+            return;
+        }
+
+        // The coarsest buckets entirely before and after the visible points
+        const Level& coarsest_level = levels_.back();
+        const int64_t last_bucket_before = first / coarsest_level.bucket_size;
+        const int64_t first_bucket_after = (last + coarsest_level.bucket_size - 1) / coarsest_level.bucket_size;
+
+        append_points_of_level(coarsest_level, 0, last_bucket_before, xs, ys);
+
+        if(level_index < 0)
+        {
+            append_points_of_line(x, y, first, last, xs, ys);
+        }
+        else
+        {
+            const Level& level = levels_[level_index];
+            append_points_of_level(level, first / level.bucket_size, (last + level.bucket_size - 1) / level.bucket_size, xs, ys);
+        }
+
+        append_points_of_level(coarsest_level, first_bucket_after, coarsest_level.number_of_buckets(), xs, ys);
+    }
+
+
+
+private:
+
+    // Each bucket of a level keeps two points of the line (its
+    // minimum and its maximum, in the order they appear in it)
+    struct Level
+    {
+        int64_t bucket_size = 0;
+        std::vector<double> xs;
+        std::vector<double> ys;
+
+        int64_t number_of_buckets()const { return int64_t(ys.size()) / 2; }
+    };
+
+
+
+    static double x_at(const double* x, int64_t index)
+    {
+        return x ? x[index] : double(index);
+    }
+
+    // Comparisons that skip NaNs, unless there's nothing else
+    static bool is_lower(double value, double minimum) { return value < minimum || std::isnan(minimum); }
+    static bool is_higher(double value, double maximum) { return value > maximum || std::isnan(maximum); }
+
+
+
+    Level build_base_level(const double* x, const double* y)const
+    {
+        Level level;
+        level.bucket_size = BASE_BUCKET_SIZE;
+
+        const int64_t number_of_buckets = (number_of_points_ + BASE_BUCKET_SIZE - 1) / BASE_BUCKET_SIZE;
+        level.xs.resize(2 * number_of_buckets);
+        level.ys.resize(2 * number_of_buckets);
+
+        const int64_t number_of_tasks = (number_of_buckets + TASK_SIZE - 1) / TASK_SIZE;
+
+        get_thread_pool().parallel_for(number_of_tasks, [&](int64_t task)
+        {
+            const int64_t first_bucket = task * TASK_SIZE;
+            const int64_t last_bucket = std::min(number_of_buckets, first_bucket + TASK_SIZE);
+
+            for(int64_t bucket = first_bucket; bucket < last_bucket; ++bucket)
+            {
+                const int64_t first = bucket * BASE_BUCKET_SIZE;
+                const int64_t last = std::min(number_of_points_, first + BASE_BUCKET_SIZE);
+
+                int64_t minimum = first;
+                int64_t maximum = first;
+
+                for(int64_t i = first + 1; i < last; ++i)
+                {
+                    if(is_lower(y[i], y[minimum]))
+                        minimum = i;
+                    if(is_higher(y[i], y[maximum]))
+                        maximum = i;
+                }
+
+                const int64_t first_extreme = std::min(minimum, maximum);
+                const int64_t second_extreme = std::max(minimum, maximum);
+
+                level.xs[2 * bucket] = x_at(x, first_extreme);
+                level.ys[2 * bucket] = y[first_extreme];
+                level.xs[2 * bucket + 1] = x_at(x, second_extreme);
+                level.ys[2 * bucket + 1] = y[second_extreme];
+            }
+        });
+
+        return level;
+    }
+
+
+
+    // Merges pairs of buckets of the previous level, their four
+    // points are in order, so the merged extremes stay in order
+    static Level build_next_level(const Level& previous_level)
+    {
+        Level level;
+        level.bucket_size = 2 * previous_level.bucket_size;
+
+        const int64_t number_of_points = int64_t(previous_level.ys.size());
+        const int64_t number_of_buckets = (previous_level.number_of_buckets() + 1) / 2;
+
+        level.xs.resize(2 * number_of_buckets);
+        level.ys.resize(2 * number_of_buckets);
+
+        const int64_t number_of_tasks = (number_of_buckets + TASK_SIZE - 1) / TASK_SIZE;
+
+        get_thread_pool().parallel_for(number_of_tasks, [&](int64_t task)
+        {
+            const int64_t first_bucket = task * TASK_SIZE;
+            const int64_t last_bucket = std::min(number_of_buckets, first_bucket + TASK_SIZE);
+
+            for(int64_t bucket = first_bucket; bucket < last_bucket; ++bucket)
+            {
+                const int64_t first = 4 * bucket;
+                const int64_t last = std::min(number_of_points, first + 4);
+
+                int64_t minimum = first;
+                int64_t maximum = first;
+
+                for(int64_t i = first + 1; i < last; ++i)
+                {
+                    if(is_lower(previous_level.ys[i], previous_level.ys[minimum]))
+                        minimum = i;
+                    if(is_higher(previous_level.ys[i], previous_level.ys[maximum]))
+                        maximum = i;
+                }
+
+                const int64_t first_extreme = std::min(minimum, maximum);
+                const int64_t second_extreme = std::max(minimum, maximum);
+
+                level.xs[2 * bucket] = previous_level.xs[first_extreme];
+                level.ys[2 * bucket] = previous_level.ys[first_extreme];
+                level.xs[2 * bucket + 1] = previous_level.xs[second_extreme];
+                level.ys[2 * bucket + 1] = previous_level.ys[second_extreme];
+            }
+        });
+
+        return level;
+    }
+
+
+
+    static void append_points_of_line(const double* x,
+                                      const double* y,
+                                      int64_t first,
+                                      int64_t last,
+                                      std::vector<double>& xs,
+                                      std::vector<double>& ys)
+    {
+        for(int64_t i = first; i < last; ++i)
+        {
+            xs.push_back(x_at(x, i));
+            ys.push_back(y[i]);
+        }
+    }
+
+    static void append_points_of_level(const Level& level,
+                                       int64_t first_bucket,
+                                       int64_t last_bucket,
+                                       std::vector<double>& xs,
+                                       std::vector<double>& ys)
+    {
+        if(last_bucket <= first_bucket)
+            return;
+
+        xs.insert(xs.end(), level.xs.begin() + 2 * first_bucket, level.xs.begin() + 2 * last_bucket);
+        ys.insert(ys.end(), level.ys.begin() + 2 * first_bucket, level.ys.begin() + 2 * last_bucket);
+    }
+
+
+
+    int64_t number_of_points_ = 0;
+    bool is_x_sorted_ = true;
+
+    std::vector<Level> levels_;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_LINE_DECIMATION_HPP_
@@ -0,0 +1,217 @@
+//-------------------------------------------------------------------
+/**
+ * @file matrix_file.hpp
+ * @brief Writing results to matrix files and checking that saved files are still valid.
+ *
+ * Matrix files use the spill file format (a 64-byte header followed by
+ * the row-major doubles), so they can be mapped back with
+ * MatrixStorage::attach without copying or parsing anything.
+ *
+ * A fingerprint (file size and a hash) is recorded when a file is
+ * written. Hashing a file that holds tens of gigabytes would take about
+ * as long as recomputing it, so the hash only covers the header and a
+ * fixed number of evenly spaced blocks of the file. The modification
+ * time is left out on purpose, so that copying a study along with its
+ * results doesn't invalidate them.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_MATRIX_FILE_HPP_
+#define INCLUDE_COMPUTE_MATRIX_FILE_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "matrix_storage.hpp"
+#include "matrix_view.hpp"
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief What is checked to decide whether a saved matrix file is unchanged.
+ */
+//-------------------------------------------------------------------
+struct MatrixFileFingerprint
+{
+    // Number of blocks (and bytes per block) that are hashed
+    static constexpr int64_t NUMBER_OF_HASHED_BLOCKS = 64;
+    static constexpr int64_t HASHED_BLOCK_SIZE = int64_t(64) << 10;
+
+    uint64_t file_size = 0;
+    uint64_t hash = 0;
+
+    bool operator==(const MatrixFileFingerprint& fingerprint)const
+    {
+        return file_size == fingerprint.file_size && hash == fingerprint.hash;
+    }
+
+    bool operator!=(const MatrixFileFingerprint& fingerprint)const
+    {
+        return !(*this == fingerprint);
+    }
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Computes the fingerprint of a file.
+ *
+ * @return An empty fingerprint (file_size of 0) if the file can't be read.
+ */
+//-------------------------------------------------------------------
+inline MatrixFileFingerprint compute_matrix_file_fingerprint(const std::filesystem::path& filename)
+{
+    MatrixFileFingerprint fingerprint;
+
+    std::error_code error;
+    const uint64_t file_size = std::filesystem::file_size(filename, error);
+
+    if(error)
+        return MatrixFileFingerprint();
+
+    std::ifstream file(filename, std::ios::binary);
+
+    if(!file)
+        return MatrixFileFingerprint();
+
+    // 64-bit FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+
+    auto hash_bytes = [&hash](const char* bytes, std::streamsize number_of_bytes)
+    {
+        for(std::streamsize i = 0; i < number_of_bytes; ++i)
+        {
+            hash ^= uint8_t(bytes[i]);
+            hash *= 1099511628211ull;
+        }
+    };
+
+    const int64_t block_size = MatrixFileFingerprint::HASHED_BLOCK_SIZE;
+    const int64_t number_of_blocks = MatrixFileFingerprint::NUMBER_OF_HASHED_BLOCKS;
+
+    std::vector<char> block(block_size);
+
+    // Small files are hashed whole, big files are sampled with evenly
+    // spaced blocks, the first one covering the header
+    const int64_t stride = std::max(block_size, int64_t(file_size) / number_of_blocks);
+
+    for(int64_t offset = 0; offset < int64_t(file_size); offset += stride)
+    {
+        file.seekg(offset);
+        file.read(block.data(), block_size);
+        hash_bytes(block.data(), file.gcount());
+        file.clear();
+    }
+
+    fingerprint.file_size = file_size;
+    fingerprint.hash = hash;
+
+    return fingerprint;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Writes a matrix to a matrix file (spill file format).
+ *
+ * The file is written next to its final location and then renamed, so
+ * a previously saved file is never left half overwritten.
+ *
+ * @return false if the matrix is empty or the file couldn't be written.
+ */
+//-------------------------------------------------------------------
+inline bool write_matrix_file(const MatrixView& view, const std::filesystem::path& filename)
+{
+    if(view.size() == 0)
+        return false;
+
+    std::filesystem::path temporary_filename = filename;
+    temporary_filename += ".tmp";
+
+    {
+        std::ofstream file(temporary_filename, std::ios::binary | std::ios::trunc);
+
+        if(!file)
+            return false;
+
+        SpillFileHeader header;
+        std::memcpy(header.magic, SpillFileHeader::MAGIC, sizeof(header.magic));
+        header.rows = view.rows();
+        header.columns = view.columns();
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        std::vector<double> row(view.columns());
+
+        for(int64_t i = 0; i < view.rows(); ++i)
+        {
+            if(view.has_contiguous_rows())
+            {
+                file.write(reinterpret_cast<const char*>(view.row_pointer(i)), view.columns() * sizeof(double));
+            }
+            else
+            {
+                for(int64_t j = 0; j < view.columns(); ++j)
+                    row[j] = view(i,j);
+
+                file.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(double));
+            }
+        }
+
+        if(!file)
+        {
+            file.close();
+
+            std::error_code error;
+            std::filesystem::remove(temporary_filename, error);
+
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary_filename, filename, error);
+
+    if(error)
+    {
+        std::filesystem::remove(temporary_filename, error);
+        return false;
+    }
+
+    return true;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_MATRIX_FILE_HPP_
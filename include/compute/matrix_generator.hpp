@@ -0,0 +1,205 @@
+//-------------------------------------------------------------------
+/**
+ * @file matrix_generator.hpp
+ * @brief Procedural matrices, whose elements are computed from their position.
+ *
+ * A MatrixGenerator describes a constant, increasing (iota), random or
+ * sine wave matrix without storing it: any row segment can be generated
+ * on its own, so a generated matrix can be the source of an
+ * ElementwiseChain and is only ever computed piece by piece, by as many
+ * threads as evaluate it.
+ *
+ * Random matrices use the Philox4x32-10 counter-based generator
+ * (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3"): the
+ * random number of an element is a function of its index and the seed
+ * only, so a random matrix is the same whatever the number of threads
+ * that generate it and whatever order its pieces are generated in.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_MATRIX_GENERATOR_HPP_
+#define INCLUDE_COMPUTE_MATRIX_GENERATOR_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <array>
+#include <cmath>
+#include <cstdint>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief The Philox4x32-10 block: 4 random 32-bit numbers from a 128-bit counter and a 64-bit key.
+ */
+//-------------------------------------------------------------------
+inline std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key)
+{
+    constexpr uint64_t MULTIPLIER_0 = 0xD2511F53;
+    constexpr uint64_t MULTIPLIER_1 = 0xCD9E8D57;
+    constexpr uint32_t KEY_STEP_0 = 0x9E3779B9;
+    constexpr uint32_t KEY_STEP_1 = 0xBB67AE85;
+
+    for(int round = 0; round < 10; ++round)
+    {
+        const uint64_t product_0 = MULTIPLIER_0 * counter[0];
+        const uint64_t product_1 = MULTIPLIER_1 * counter[2];
+
+        counter = {uint32_t(product_1 >> 32) ^ counter[1] ^ key[0],
+                   uint32_t(product_1),
+                   uint32_t(product_0 >> 32) ^ counter[3] ^ key[1],
+                   uint32_t(product_0)};
+
+        key[0] += KEY_STEP_0;
+        key[1] += KEY_STEP_1;
+    }
+
+    return counter;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief A double in [0, 1) from 64 random bits (the top 53 of them).
+ */
+//-------------------------------------------------------------------
+inline double make_uniform_double(uint32_t high_bits, uint32_t low_bits)
+{
+    const uint64_t bits = (uint64_t(high_bits) << 32) | low_bits;
+
+    return double(bits >> 11) * (1.0 / 9007199254740992.0);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+enum class GeneratorType : int
+{
+    Constant = 0,
+    Iota,           // initial_value + step * (row * columns + column)
+    Random,         // uniform in [min_value, max_value)
+    SineWave        // y_offset + amplitude * sin(2 pi frequency (initial_time + row * delta_time) + phase_offset)
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @class MatrixGenerator
+ * @brief A matrix defined by a formula of the position of its elements.
+ */
+//-------------------------------------------------------------------
+struct MatrixGenerator
+{
+    GeneratorType type = GeneratorType::Constant;
+
+    int64_t rows = 0;
+    int64_t columns = 0;
+
+    double value = 0;                   // Constant
+
+    double initial_value = 0;           // Iota
+    double step = 1;
+
+    double min_value = 0;               // Random
+    double max_value = 1;
+    uint64_t seed = 0;
+
+    double amplitude = 1;               // Sine wave
+    double frequency = 1;
+    double phase_offset_in_radians = 0;
+    double y_offset = 0;
+    double delta_time = 0.1;
+    double initial_time = 0;
+
+
+
+    /**
+     * @brief Generates count elements of a row, starting at first_column.
+     */
+    void generate(int64_t row, int64_t first_column, int64_t count, double* destination)const
+    {
+        switch(type)
+        {
+            default:
+            case GeneratorType::Constant:
+                for(int64_t j = 0; j < count; ++j)
+                    destination[j] = value;
+            break;
+
+            case GeneratorType::Iota:
+            {
+                const int64_t first_index = row * columns + first_column;
+
+                for(int64_t j = 0; j < count; ++j)
+                    destination[j] = initial_value + step * double(first_index + j);
+            }
+            break;
+
+            case GeneratorType::Random:
+                generate_random(row * columns + first_column, count, destination);
+            break;
+
+            case GeneratorType::SineWave:
+            {
+                constexpr double TWO_PI = 6.283185307179586476925286766559;
+
+                const double time = initial_time + double(row) * delta_time;
+                const double element = y_offset + amplitude * std::sin(TWO_PI * frequency * time + phase_offset_in_radians);
+
+                for(int64_t j = 0; j < count; ++j)
+                    destination[j] = element;
+            }
+            break;
+        }
+    }
+
+
+
+private:
+
+    // Each Philox block gives the random numbers of two consecutive
+    // elements, the block's counter being the index of the pair
+    void generate_random(int64_t first_index, int64_t count, double* destination)const
+    {
+        const std::array<uint32_t, 2> key = {uint32_t(seed), uint32_t(seed >> 32)};
+        const double range = max_value - min_value;
+
+        for(int64_t index = first_index; index < first_index + count;)
+        {
+            const uint64_t pair_index = uint64_t(index) >> 1;
+            const auto bits = philox4x32({uint32_t(pair_index), uint32_t(pair_index >> 32), 0, 0}, key);
+
+            for(int64_t half = index & 1; half < 2 && index < first_index + count; ++half, ++index)
+                destination[index - first_index] = min_value + range * make_uniform_double(bits[2 * half], bits[2 * half + 1]);
+        }
+    }
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_MATRIX_GENERATOR_HPP_
@@ -0,0 +1,580 @@
+//-------------------------------------------------------------------
+/**
+ * @file matrix_storage.hpp
+ * @brief Tiered storage (RAM or memory-mapped scratch file) for intermediate results.
+ *
+ * Small results are kept in plain RAM. Results that are too big for the
+ * RAM tier (or that don't fit in the RAM budget anymore) are spilled to
+ * memory-mapped files in a configurable scratch directory, under their
+ * own byte budget. Spill files belong to the storage that created them
+ * and are deleted as soon as that storage is resized or destroyed.
+ *
+ * A storage can also be attached to an existing file written in the
+ * same format (for example the saved results of a study), in which case
+ * the file is mapped copy-on-write, is not counted against any budget
+ * and is left untouched when the storage is released. Files of raw
+ * doubles (a binary dump, the data of an .npy file) can be attached the
+ * same way, given where their elements start and how they're laid out.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_MATRIX_STORAGE_HPP_
+#define INCLUDE_COMPUTE_MATRIX_STORAGE_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "matrix_view.hpp"
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Settings that decide where intermediate results are stored.
+ */
+//-------------------------------------------------------------------
+struct StoragePolicy
+{
+    // Results up to this size are stored in RAM
+    int64_t ram_threshold_bytes = int64_t(4) << 20;
+
+    // Total size of all results stored in RAM, small results
+    // are spilled to scratch files once this is exceeded
+    int64_t ram_budget_bytes = int64_t(1) << 30;
+
+    // Total size of all scratch files
+    int64_t spill_budget_bytes = int64_t(16) << 30;
+
+    // Where scratch files are created (if empty, the LAZYDATA_SCRATCH_DIR
+    // environment variable or else the system temp directory is used)
+    std::filesystem::path scratch_directory;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Header written at the start of every spill file.
+ *
+ * It is padded to 64 bytes so that the data that follows it stays
+ * aligned to a cache line.
+ */
+//-------------------------------------------------------------------
+struct SpillFileHeader
+{
+    static constexpr char MAGIC[8] = {'L','Z','D','S','P','I','L','L'};
+    static constexpr uint32_t VERSION = 1;
+
+    char magic[8];
+    uint32_t version = VERSION;
+    uint32_t element_size = sizeof(double);
+    int64_t rows = 0;
+    int64_t columns = 0;
+    uint8_t reserved[32] = {};
+};
+
+static_assert(sizeof(SpillFileHeader) == 64, "Spill file header must be 64 bytes");
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @class StorageManager
+ * @brief Process-wide storage policy and accounting of the bytes in use in each tier.
+ */
+//-------------------------------------------------------------------
+class StorageManager
+{
+public:
+
+    static StoragePolicy get_policy()
+    {
+        std::lock_guard<std::mutex> lock(get_mutex());
+        return get_policy_instance();
+    }
+
+    static void set_policy(const StoragePolicy& policy)
+    {
+        std::lock_guard<std::mutex> lock(get_mutex());
+        get_policy_instance() = policy;
+    }
+
+    /**
+     * @brief Returns the scratch directory, creating it if it doesn't exist yet.
+     */
+    static std::filesystem::path get_scratch_directory()
+    {
+        std::filesystem::path scratch_directory = get_policy().scratch_directory;
+
+        if(scratch_directory.empty())
+        {
+            const char* environment_scratch_directory = std::getenv("LAZYDATA_SCRATCH_DIR");
+
+            if(environment_scratch_directory && *environment_scratch_directory)
+                scratch_directory = environment_scratch_directory;
+            else
+                scratch_directory = std::filesystem::temp_directory_path() / "lazydata_scratch";
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(scratch_directory, error);
+
+        return scratch_directory;
+    }
+
+    static int64_t get_ram_bytes_in_use() { return ram_bytes_in_use_.load(); }
+    static int64_t get_spilled_bytes_in_use() { return spilled_bytes_in_use_.load(); }
+
+
+
+private:
+
+    friend class MatrixStorage;
+
+    // Reserves bytes in a tier, fails (without reserving) if
+    // that would take the tier over its budget
+    static bool reserve(std::atomic<int64_t>& bytes_in_use, int64_t bytes, int64_t budget)
+    {
+        int64_t current = bytes_in_use.load();
+
+        do
+        {
+            if(current + bytes > budget)
+                return false;
+        }
+        while(!bytes_in_use.compare_exchange_weak(current, current + bytes));
+
+        return true;
+    }
+
+    static std::mutex& get_mutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static StoragePolicy& get_policy_instance()
+    {
+        static StoragePolicy policy;
+        return policy;
+    }
+
+    static inline std::atomic<int64_t> ram_bytes_in_use_{0};
+    static inline std::atomic<int64_t> spilled_bytes_in_use_{0};
+    static inline std::atomic<uint64_t> spill_file_counter_{0};
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @class MatrixStorage
+ * @brief Owns the elements of a row-major matrix of doubles in RAM or in a spill file.
+ */
+//-------------------------------------------------------------------
+class MatrixStorage
+{
+public:
+
+    enum class Tier : int
+    {
+        Empty = 0,
+        Ram,
+        Spilled,
+        Attached
+    };
+
+    MatrixStorage()
+    {
+    }
+
+    ~MatrixStorage()
+    {
+        release();
+    }
+
+    MatrixStorage(const MatrixStorage&) = delete;
+    MatrixStorage& operator=(const MatrixStorage&) = delete;
+
+    MatrixStorage(MatrixStorage&& storage)
+    {
+        *this = std::move(storage);
+    }
+
+    MatrixStorage& operator=(MatrixStorage&& storage)
+    {
+        if(this != &storage)
+        {
+            release();
+
+            tier_ = storage.tier_;
+            data_ = storage.data_;
+            rows_ = storage.rows_;
+            columns_ = storage.columns_;
+            bytes_ = storage.bytes_;
+            ram_data_ = std::move(storage.ram_data_);
+            spill_filename_ = std::move(storage.spill_filename_);
+            region_ = std::move(storage.region_);
+            attached_offset_ = storage.attached_offset_;
+            is_raw_attachment_ = storage.is_raw_attachment_;
+            is_column_major_ = storage.is_column_major_;
+
+            // The moved-from storage no longer owns anything
+            storage.tier_ = Tier::Empty;
+            storage.data_ = nullptr;
+            storage.rows_ = 0;
+            storage.columns_ = 0;
+            storage.bytes_ = 0;
+            storage.spill_filename_.clear();
+        }
+
+        return *this;
+    }
+
+
+
+    /**
+     * @brief Allocates storage for a rows x columns matrix (contents are undefined).
+     *
+     * @return false if neither tier could hold the matrix within its budget,
+     *         in which case the storage is left empty.
+     */
+    bool resize(int64_t rows, int64_t columns)
+    {
+        release();
+
+        if(rows <= 0 || columns <= 0)
+            return true;
+
+        const int64_t bytes = rows * columns * int64_t(sizeof(double));
+        const StoragePolicy policy = StorageManager::get_policy();
+
+        if(bytes <= policy.ram_threshold_bytes &&
+           StorageManager::reserve(StorageManager::ram_bytes_in_use_, bytes, policy.ram_budget_bytes))
+        {
+            ram_data_.resize(rows * columns);
+            data_ = ram_data_.data();
+            tier_ = Tier::Ram;
+        }
+        else if(StorageManager::reserve(StorageManager::spilled_bytes_in_use_, bytes, policy.spill_budget_bytes))
+        {
+            if(!create_spill_file(rows, columns))
+            {
+                StorageManager::spilled_bytes_in_use_ -= bytes;
+                return false;
+            }
+
+            tier_ = Tier::Spilled;
+        }
+        else
+        {
+            return false;
+        }
+
+        rows_ = rows;
+        columns_ = columns;
+        bytes_ = bytes;
+
+        return true;
+    }
+
+
+
+    /**
+     * @brief Maps an existing matrix file (spill file format) without copying it.
+     *
+     * The file is mapped copy-on-write, so writing to the storage never
+     * modifies the file.
+     *
+     * @return false if the file is missing, not a matrix file, or its size
+     *         doesn't match the size recorded in its header.
+     */
+    bool attach(const std::filesystem::path& filename)
+    {
+        namespace bip = boost::interprocess;
+
+        release();
+
+        std::error_code error;
+        const uint64_t file_size = std::filesystem::file_size(filename, error);
+
+        if(error || file_size < sizeof(SpillFileHeader))
+            return false;
+
+        SpillFileHeader header;
+
+        {
+            std::ifstream file(filename, std::ios::binary);
+
+            if(!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+                return false;
+        }
+
+        if(std::memcmp(header.magic, SpillFileHeader::MAGIC, sizeof(header.magic)) != 0 ||
+           header.version != SpillFileHeader::VERSION ||
+           header.element_size != sizeof(double) ||
+           header.rows <= 0 ||
+           header.columns <= 0 ||
+           file_size != sizeof(SpillFileHeader) + uint64_t(header.rows * header.columns) * sizeof(double))
+        {
+            return false;
+        }
+
+        try
+        {
+            bip::file_mapping mapping(filename.string().c_str(), bip::read_only);
+            region_ = std::make_unique<bip::mapped_region>(mapping, bip::copy_on_write, 0, file_size);
+        }
+        catch(...)
+        {
+            region_.reset();
+            return false;
+        }
+
+        data_ = reinterpret_cast<double*>(static_cast<char*>(region_->get_address()) + sizeof(SpillFileHeader));
+        rows_ = header.rows;
+        columns_ = header.columns;
+        bytes_ = rows_ * columns_ * int64_t(sizeof(double));
+        spill_filename_ = filename;
+        tier_ = Tier::Attached;
+
+        return true;
+    }
+
+
+
+    /**
+     * @brief Maps the raw little-endian doubles of a file without copying them.
+     *
+     * Like attach(), the file is mapped copy-on-write and left untouched.
+     *
+     * @param offset Where the elements start in the file (a multiple of 8).
+     * @param is_column_major If true, the elements are stored column by
+     *                        column and view() is strided accordingly.
+     * @return false if the file is too small for the matrix or can't be mapped.
+     */
+    bool attach_raw(const std::filesystem::path& filename,
+                    uint64_t offset,
+                    int64_t rows,
+                    int64_t columns,
+                    bool is_column_major = false)
+    {
+        namespace bip = boost::interprocess;
+
+        release();
+
+        std::error_code error;
+        const uint64_t file_size = std::filesystem::file_size(filename, error);
+        const uint64_t data_size = uint64_t(rows * columns) * sizeof(double);
+
+        if(error || rows <= 0 || columns <= 0 || offset % sizeof(double) != 0 || offset + data_size > file_size)
+            return false;
+
+        try
+        {
+            bip::file_mapping mapping(filename.string().c_str(), bip::read_only);
+            region_ = std::make_unique<bip::mapped_region>(mapping, bip::copy_on_write, 0, offset + data_size);
+        }
+        catch(...)
+        {
+            region_.reset();
+            return false;
+        }
+
+        data_ = reinterpret_cast<double*>(static_cast<char*>(region_->get_address()) + offset);
+        rows_ = rows;
+        columns_ = columns;
+        bytes_ = rows_ * columns_ * int64_t(sizeof(double));
+        spill_filename_ = filename;
+        attached_offset_ = offset;
+        is_raw_attachment_ = true;
+        is_column_major_ = is_column_major;
+        tier_ = Tier::Attached;
+
+        return true;
+    }
+
+
+
+    /**
+     * @brief Frees the storage, deleting its spill file if it had one.
+     */
+    void release()
+    {
+        if(tier_ == Tier::Ram)
+        {
+            StorageManager::ram_bytes_in_use_ -= bytes_;
+            std::vector<double>().swap(ram_data_);
+        }
+        else if(tier_ == Tier::Spilled)
+        {
+            StorageManager::spilled_bytes_in_use_ -= bytes_;
+
+            region_.reset();
+
+            std::error_code error;
+            std::filesystem::remove(spill_filename_, error);
+            spill_filename_.clear();
+        }
+        else if(tier_ == Tier::Attached)
+        {
+            // Attached files don't belong to us, so they are kept
+            region_.reset();
+            spill_filename_.clear();
+        }
+
+        attached_offset_ = 0;
+        is_raw_attachment_ = false;
+        is_column_major_ = false;
+
+        data_ = nullptr;
+        rows_ = 0;
+        columns_ = 0;
+        bytes_ = 0;
+        tier_ = Tier::Empty;
+    }
+
+
+
+    Tier get_tier()const { return tier_; }
+    const std::filesystem::path& get_spill_filename()const { return spill_filename_; }
+
+    bool is_raw_attachment()const { return is_raw_attachment_; }
+    uint64_t get_attached_offset()const { return attached_offset_; }
+
+    // Only raw attachments can be column major, data() is row major otherwise
+    bool is_column_major()const { return is_column_major_; }
+
+    int64_t rows()const { return rows_; }
+    int64_t columns()const { return columns_; }
+    int64_t size()const { return rows_ * columns_; }
+
+    double* data() { return data_; }
+    const double* data()const { return data_; }
+
+    MatrixView view()const
+    {
+        if(is_column_major_)
+            return MatrixView(data_, rows_, columns_, 1, rows_);
+
+        return MatrixView(data_, rows_, columns_, columns_);
+    }
+
+
+
+private:
+
+    bool create_spill_file(int64_t rows, int64_t columns)
+    {
+        namespace bip = boost::interprocess;
+
+        const auto scratch_directory = StorageManager::get_scratch_directory();
+        const auto timestamp = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+
+        do
+        {
+            spill_filename_ = scratch_directory / ("lazydata_" + std::to_string(timestamp) + "_" +
+                                                   std::to_string(StorageManager::spill_file_counter_++) + ".spill");
+        }
+        while(std::filesystem::exists(spill_filename_));
+
+        const uint64_t file_size = sizeof(SpillFileHeader) + uint64_t(rows * columns) * sizeof(double);
+
+        try
+        {
+            {
+                std::ofstream file(spill_filename_, std::ios::binary | std::ios::trunc);
+
+                if(!file)
+                    throw std::runtime_error("could not create spill file");
+            }
+
+            std::filesystem::resize_file(spill_filename_, file_size);
+
+            bip::file_mapping mapping(spill_filename_.string().c_str(), bip::read_write);
+            region_ = std::make_unique<bip::mapped_region>(mapping, bip::read_write, 0, file_size);
+        }
+        catch(...)
+        {
+            region_.reset();
+
+            std::error_code error;
+            std::filesystem::remove(spill_filename_, error);
+            spill_filename_.clear();
+
+            return false;
+        }
+
+        SpillFileHeader header;
+        std::memcpy(header.magic, SpillFileHeader::MAGIC, sizeof(header.magic));
+        header.rows = rows;
+        header.columns = columns;
+
+        std::memcpy(region_->get_address(), &header, sizeof(header));
+
+        data_ = reinterpret_cast<double*>(static_cast<char*>(region_->get_address()) + sizeof(SpillFileHeader));
+
+        return true;
+    }
+
+
+
+    Tier tier_ = Tier::Empty;
+
+    double* data_ = nullptr;
+    int64_t rows_ = 0;
+    int64_t columns_ = 0;
+    int64_t bytes_ = 0;
+
+    std::vector<double> ram_data_;
+
+    std::filesystem::path spill_filename_;
+    std::unique_ptr<boost::interprocess::mapped_region> region_;
+
+    // Raw attachments (see attach_raw)
+    uint64_t attached_offset_ = 0;
+    bool is_raw_attachment_ = false;
+    bool is_column_major_ = false;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_MATRIX_STORAGE_HPP_
@@ -0,0 +1,146 @@
+//-------------------------------------------------------------------
+/**
+ * @file matrix_view.hpp
+ * @brief Non-owning strided views over row-major matrix data.
+ *
+ * A MatrixView describes where the elements of a 2d matrix live in
+ * memory (base pointer plus row and column strides) without owning
+ * them. Views are what the compute kernels operate on, so the same
+ * kernel can read a memory-mapped LazyMatrix, a plain RAM buffer or a
+ * region of interest inside a bigger matrix without copying anything.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_MATRIX_VIEW_HPP_
+#define INCLUDE_COMPUTE_MATRIX_VIEW_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <cstdint>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @class MatrixView
+ * @brief Read-only strided view of a matrix of doubles.
+ *
+ * Element (row, column) lives at data[row * row_stride + column * column_stride].
+ * A default constructed view is empty (0x0).
+ */
+//-------------------------------------------------------------------
+class MatrixView
+{
+public:
+
+    MatrixView()
+    {
+    }
+
+    MatrixView(const double* data,
+               int64_t rows,
+               int64_t columns,
+               int64_t row_stride,
+               int64_t column_stride = 1)
+    : data_(data),
+      rows_(rows),
+      columns_(columns),
+      row_stride_(row_stride),
+      column_stride_(column_stride)
+    {
+        if(data_ == nullptr || rows_ <= 0 || columns_ <= 0)
+        {
+            data_ = nullptr;
+            rows_ = 0;
+            columns_ = 0;
+        }
+    }
+
+    const double* data()const { return data_; }
+    int64_t rows()const { return rows_; }
+    int64_t columns()const { return columns_; }
+    int64_t size()const { return rows_ * columns_; }
+    int64_t row_stride()const { return row_stride_; }
+    int64_t column_stride()const { return column_stride_; }
+    bool empty()const { return data_ == nullptr; }
+
+    /**
+     * @brief True when the elements of each row are adjacent in memory.
+     */
+    bool has_contiguous_rows()const { return column_stride_ == 1; }
+
+    /**
+     * @brief True when the view is a plain row-major array (rows adjacent too).
+     */
+    bool is_contiguous()const { return column_stride_ == 1 && (row_stride_ == columns_ || rows_ <= 1); }
+
+    const double* row_pointer(int64_t row)const
+    {
+        return data_ + row * row_stride_;
+    }
+
+    const double& operator()(int64_t row, int64_t column)const
+    {
+        return data_[row * row_stride_ + column * column_stride_];
+    }
+
+    /**
+     * @brief Returns a view of the rectangular block starting at (row, column).
+     *
+     * The block is clamped to the extents of this view.
+     */
+    MatrixView block(int64_t row, int64_t column, int64_t rows, int64_t columns)const
+    {
+        if(row < 0 || column < 0 || row >= rows_ || column >= columns_)
+            return MatrixView();
+
+        if(row + rows > rows_)
+            rows = rows_ - row;
+        if(column + columns > columns_)
+            columns = columns_ - column;
+
+        return MatrixView(&(*this)(row, column), rows, columns, row_stride_, column_stride_);
+    }
+
+    /**
+     * @brief Returns the transposed view (no data is moved).
+     */
+    MatrixView transposed()const
+    {
+        return MatrixView(data_, columns_, rows_, column_stride_, row_stride_);
+    }
+
+
+
+private:
+
+    const double* data_ = nullptr;
+    int64_t rows_ = 0;
+    int64_t columns_ = 0;
+    int64_t row_stride_ = 0;
+    int64_t column_stride_ = 1;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_MATRIX_VIEW_HPP_
@@ -0,0 +1,190 @@
+//-------------------------------------------------------------------
+/**
+ * @file simd_statistics_kernels.inl
+ * @brief Vectorized statistics kernels, written once for every instruction set.
+ *
+ * This file is included by statistics.hpp once per instruction set,
+ * inside the namespace of that instruction set's Isa struct (see
+ * simd_unary_kernels.inl for what it provides).
+ *
+ * NaNs are counted and otherwise left out of every statistic.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Statistics of a block small enough to stay in L1 cache.
+ *
+ * The block is read twice, once for the sums and the extrema, and once
+ * more (from cache) for the squared deviations from its mean.
+ */
+//-------------------------------------------------------------------
+inline Statistics compute_block_statistics(const double* data, int64_t count)
+{
+    const Isa::Vector zero = Isa::broadcast(0.0);
+    const Isa::Vector one = Isa::broadcast(1.0);
+
+    Isa::Vector sum = zero;
+    Isa::Vector sum_of_squares = zero;
+    Isa::Vector number_of_values = zero;
+    Isa::Vector minimum = Isa::broadcast(std::numeric_limits<double>::infinity());
+    Isa::Vector maximum = Isa::broadcast(-std::numeric_limits<double>::infinity());
+
+    int64_t i = 0;
+
+    for(; i + Isa::WIDTH <= count; i += Isa::WIDTH)
+    {
+        const Isa::Vector x = Isa::load(data + i);
+        const Isa::Mask is_nan = Isa::is_nan(x);
+        const Isa::Vector value = Isa::select(is_nan, zero, x);
+
+        sum = Isa::add(sum, value);
+        sum_of_squares = Isa::multiply_add(value, value, sum_of_squares);
+        number_of_values = Isa::add(number_of_values, Isa::select(is_nan, zero, one));
+        minimum = Isa::select(is_nan, minimum, Isa::min(minimum, x));
+        maximum = Isa::select(is_nan, maximum, Isa::max(maximum, x));
+    }
+
+    double lanes[5][Isa::WIDTH];
+
+    Isa::store(lanes[0], sum);
+    Isa::store(lanes[1], sum_of_squares);
+    Isa::store(lanes[2], number_of_values);
+    Isa::store(lanes[3], minimum);
+    Isa::store(lanes[4], maximum);
+
+    Statistics statistics;
+
+    double number_of_values_in_block = 0;
+
+    for(int64_t lane = 0; lane < Isa::WIDTH; ++lane)
+    {
+        statistics.sum += lanes[0][lane];
+        statistics.sum_of_squares += lanes[1][lane];
+        number_of_values_in_block += lanes[2][lane];
+        statistics.min = std::min(statistics.min, lanes[3][lane]);
+        statistics.max = std::max(statistics.max, lanes[4][lane]);
+    }
+
+    for(int64_t j = i; j < count; ++j)
+    {
+        const double x = data[j];
+
+        if(std::isnan(x))
+            continue;
+
+        statistics.sum += x;
+        statistics.sum_of_squares += x * x;
+        number_of_values_in_block += 1;
+        statistics.min = std::min(statistics.min, x);
+        statistics.max = std::max(statistics.max, x);
+    }
+
+    statistics.count = int64_t(number_of_values_in_block);
+    statistics.nan_count = count - statistics.count;
+
+    if(statistics.count == 0)
+        return statistics;
+
+    statistics.mean = statistics.sum / double(statistics.count);
+
+    // Squared deviations from the mean, the block being in cache by now
+    const Isa::Vector mean = Isa::broadcast(statistics.mean);
+    Isa::Vector m2 = zero;
+
+    for(i = 0; i + Isa::WIDTH <= count; i += Isa::WIDTH)
+    {
+        const Isa::Vector x = Isa::load(data + i);
+        const Isa::Vector deviation = Isa::select(Isa::is_nan(x), zero, Isa::sub(x, mean));
+
+        m2 = Isa::multiply_add(deviation, deviation, m2);
+    }
+
+    Isa::store(lanes[0], m2);
+
+    for(int64_t lane = 0; lane < Isa::WIDTH; ++lane)
+        statistics.m2 += lanes[0][lane];
+
+    for(int64_t j = i; j < count; ++j)
+    {
+        if(!std::isnan(data[j]))
+            statistics.m2 += (data[j] - statistics.mean) * (data[j] - statistics.mean);
+    }
+
+    return statistics;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Adds a segment of a row to the statistics of its columns.
+ *
+ * @param row Elements first_column to first_column + count of the row.
+ */
+//-------------------------------------------------------------------
+inline void accumulate_column_statistics(const double* row,
+                                         int64_t first_column,
+                                         int64_t count,
+                                         ColumnAccumulators& accumulators)
+{
+    const Isa::Vector zero = Isa::broadcast(0.0);
+    const Isa::Vector one = Isa::broadcast(1.0);
+
+    const double* shift = accumulators.shift.data() + first_column;
+    double* number_of_values = accumulators.count.data() + first_column;
+    double* nan_count = accumulators.nan_count.data() + first_column;
+    double* shifted_sum = accumulators.shifted_sum.data() + first_column;
+    double* shifted_sum_of_squares = accumulators.shifted_sum_of_squares.data() + first_column;
+    double* sum_of_squares = accumulators.sum_of_squares.data() + first_column;
+    double* minimum = accumulators.min.data() + first_column;
+    double* maximum = accumulators.max.data() + first_column;
+
+    int64_t j = 0;
+
+    for(; j + Isa::WIDTH <= count; j += Isa::WIDTH)
+    {
+        const Isa::Vector x = Isa::load(row + j);
+        const Isa::Mask is_nan = Isa::is_nan(x);
+        const Isa::Vector value = Isa::select(is_nan, zero, x);
+        const Isa::Vector deviation = Isa::select(is_nan, zero, Isa::sub(x, Isa::load(shift + j)));
+
+        Isa::store(number_of_values + j, Isa::add(Isa::load(number_of_values + j), Isa::select(is_nan, zero, one)));
+        Isa::store(nan_count + j, Isa::add(Isa::load(nan_count + j), Isa::select(is_nan, one, zero)));
+        Isa::store(shifted_sum + j, Isa::add(Isa::load(shifted_sum + j), deviation));
+        Isa::store(shifted_sum_of_squares + j, Isa::multiply_add(deviation, deviation, Isa::load(shifted_sum_of_squares + j)));
+        Isa::store(sum_of_squares + j, Isa::multiply_add(value, value, Isa::load(sum_of_squares + j)));
+
+        const Isa::Vector current_minimum = Isa::load(minimum + j);
+        const Isa::Vector current_maximum = Isa::load(maximum + j);
+
+        Isa::store(minimum + j, Isa::select(is_nan, current_minimum, Isa::min(current_minimum, x)));
+        Isa::store(maximum + j, Isa::select(is_nan, current_maximum, Isa::max(current_maximum, x)));
+    }
+
+    for(; j < count; ++j)
+    {
+        const double x = row[j];
+
+        if(std::isnan(x))
+        {
+            nan_count[j] += 1;
+            continue;
+        }
+
+        const double deviation = x - shift[j];
+
+        number_of_values[j] += 1;
+        shifted_sum[j] += deviation;
+        shifted_sum_of_squares[j] += deviation * deviation;
+        sum_of_squares[j] += x * x;
+        minimum[j] = std::min(minimum[j], x);
+        maximum[j] = std::max(maximum[j], x);
+    }
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,243 @@
+//-------------------------------------------------------------------
+/**
+ * @file simd_unary_kernels.hpp
+ * @brief SSE2, AVX2 and AVX-512 kernels for the elementwise unary operations.
+ *
+ * Every kernel is compiled for its own instruction set with target
+ * pragmas instead of global compiler flags, so the project keeps
+ * building for the baseline x86-64 CPU and the kernel to run is picked
+ * at runtime (see instruction_set.hpp and elementwise_operations.hpp).
+ *
+ * The kernels themselves live in simd_unary_kernels.inl, which is
+ * included once per instruction set.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_SIMD_UNARY_KERNELS_HPP_
+#define INCLUDE_COMPUTE_SIMD_UNARY_KERNELS_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <cstdint>
+
+#include "instruction_set.hpp"
+#include "unary_operation.hpp"
+
+#if defined(LAZYDATA_X86_64)
+    #include <immintrin.h>
+#endif
+//-------------------------------------------------------------------
+
+
+
+#if defined(LAZYDATA_X86_64)
+
+
+
+//-------------------------------------------------------------------
+// SSE2
+//-------------------------------------------------------------------
+#if defined(__clang__)
+    #pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#elif defined(__GNUC__)
+    #pragma GCC push_options
+    #pragma GCC target("sse2")
+#endif
+
+namespace Compute
+{
+namespace SSE2
+{
+
+struct Isa
+{
+    using Vector = __m128d;
+    using Mask = __m128d;
+
+    static constexpr int64_t WIDTH = 2;
+
+    static Vector load(const double* data) { return _mm_loadu_pd(data); }
+    static void store(double* data, Vector a) { _mm_storeu_pd(data, a); }
+    static Vector broadcast(double value) { return _mm_set1_pd(value); }
+
+    static Vector add(Vector a, Vector b) { return _mm_add_pd(a, b); }
+    static Vector sub(Vector a, Vector b) { return _mm_sub_pd(a, b); }
+    static Vector mul(Vector a, Vector b) { return _mm_mul_pd(a, b); }
+    static Vector multiply_add(Vector a, Vector b, Vector c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+    static Vector min(Vector a, Vector b) { return _mm_min_pd(a, b); }
+    static Vector max(Vector a, Vector b) { return _mm_max_pd(a, b); }
+    static Vector sqrt(Vector a) { return _mm_sqrt_pd(a); }
+    static Vector negate(Vector a) { return _mm_xor_pd(a, _mm_set1_pd(-0.0)); }
+    static Vector abs(Vector a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+
+    static Mask greater_than(Vector a, Vector b) { return _mm_cmpgt_pd(a, b); }
+    static Mask less_than(Vector a, Vector b) { return _mm_cmplt_pd(a, b); }
+    static Mask is_nan(Vector a) { return _mm_cmpunord_pd(a, a); }
+    static Vector select(Mask mask, Vector a, Vector b) { return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b)); }
+
+    // Puts k + 1023 in the low bits of the mantissa and shifts it into the exponent
+    static Vector power_of_2(Vector k)
+    {
+        Vector biased_k = _mm_add_pd(k, _mm_set1_pd(6755399441055744.0 + 1023.0));
+        return _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(biased_k), 52));
+    }
+};
+
+#include "simd_unary_kernels.inl"
+
+} // namespace SSE2
+} // namespace Compute
+
+#if defined(__clang__)
+    #pragma clang attribute pop
+#elif defined(__GNUC__)
+    #pragma GCC pop_options
+#endif
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// AVX2 (with FMA)
+//-------------------------------------------------------------------
+#if defined(__clang__)
+    #pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+    #pragma GCC push_options
+    #pragma GCC target("avx2,fma")
+#endif
+
+namespace Compute
+{
+namespace AVX2
+{
+
+struct Isa
+{
+    using Vector = __m256d;
+    using Mask = __m256d;
+
+    static constexpr int64_t WIDTH = 4;
+
+    static Vector load(const double* data) { return _mm256_loadu_pd(data); }
+    static void store(double* data, Vector a) { _mm256_storeu_pd(data, a); }
+    static Vector broadcast(double value) { return _mm256_set1_pd(value); }
+
+    static Vector add(Vector a, Vector b) { return _mm256_add_pd(a, b); }
+    static Vector sub(Vector a, Vector b) { return _mm256_sub_pd(a, b); }
+    static Vector mul(Vector a, Vector b) { return _mm256_mul_pd(a, b); }
+    static Vector multiply_add(Vector a, Vector b, Vector c) { return _mm256_fmadd_pd(a, b, c); }
+    static Vector min(Vector a, Vector b) { return _mm256_min_pd(a, b); }
+    static Vector max(Vector a, Vector b) { return _mm256_max_pd(a, b); }
+    static Vector sqrt(Vector a) { return _mm256_sqrt_pd(a); }
+    static Vector negate(Vector a) { return _mm256_xor_pd(a, _mm256_set1_pd(-0.0)); }
+    static Vector abs(Vector a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+
+    static Mask greater_than(Vector a, Vector b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+    static Mask less_than(Vector a, Vector b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    static Mask is_nan(Vector a) { return _mm256_cmp_pd(a, a, _CMP_UNORD_Q); }
+    static Vector select(Mask mask, Vector a, Vector b) { return _mm256_blendv_pd(b, a, mask); }
+
+    static Vector power_of_2(Vector k)
+    {
+        Vector biased_k = _mm256_add_pd(k, _mm256_set1_pd(6755399441055744.0 + 1023.0));
+        return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(biased_k), 52));
+    }
+};
+
+#include "simd_unary_kernels.inl"
+
+} // namespace AVX2
+} // namespace Compute
+
+#if defined(__clang__)
+    #pragma clang attribute pop
+#elif defined(__GNUC__)
+    #pragma GCC pop_options
+#endif
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// AVX-512F
+// -- AVX-512F has no and/xor for doubles, so the sign bit is
+//    handled with the 64-bit integer ones
+//-------------------------------------------------------------------
+#if defined(__clang__)
+    #pragma clang attribute push(__attribute__((target("avx512f,avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+    #pragma GCC push_options
+    #pragma GCC target("avx512f,avx2,fma")
+#endif
+
+namespace Compute
+{
+namespace AVX512
+{
+
+struct Isa
+{
+    using Vector = __m512d;
+    using Mask = __mmask8;
+
+    static constexpr int64_t WIDTH = 8;
+
+    static Vector load(const double* data) { return _mm512_loadu_pd(data); }
+    static void store(double* data, Vector a) { _mm512_storeu_pd(data, a); }
+    static Vector broadcast(double value) { return _mm512_set1_pd(value); }
+
+    static Vector add(Vector a, Vector b) { return _mm512_add_pd(a, b); }
+    static Vector sub(Vector a, Vector b) { return _mm512_sub_pd(a, b); }
+    static Vector mul(Vector a, Vector b) { return _mm512_mul_pd(a, b); }
+    static Vector multiply_add(Vector a, Vector b, Vector c) { return _mm512_fmadd_pd(a, b, c); }
+    static Vector min(Vector a, Vector b) { return _mm512_min_pd(a, b); }
+    static Vector max(Vector a, Vector b) { return _mm512_max_pd(a, b); }
+    static Vector sqrt(Vector a) { return _mm512_sqrt_pd(a); }
+
+    static Vector negate(Vector a)
+    {
+        return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a), _mm512_set1_epi64(int64_t(1) << 63)));
+    }
+
+    static Vector abs(Vector a)
+    {
+        return _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(a), _mm512_set1_epi64(~(int64_t(1) << 63))));
+    }
+
+    static Mask greater_than(Vector a, Vector b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+    static Mask less_than(Vector a, Vector b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+    static Mask is_nan(Vector a) { return _mm512_cmp_pd_mask(a, a, _CMP_UNORD_Q); }
+    static Vector select(Mask mask, Vector a, Vector b) { return _mm512_mask_blend_pd(mask, b, a); }
+
+    static Vector power_of_2(Vector k)
+    {
+        Vector biased_k = _mm512_add_pd(k, _mm512_set1_pd(6755399441055744.0 + 1023.0));
+        return _mm512_castsi512_pd(_mm512_slli_epi64(_mm512_castpd_si512(biased_k), 52));
+    }
+};
+
+#include "simd_unary_kernels.inl"
+
+} // namespace AVX512
+} // namespace Compute
+
+#if defined(__clang__)
+    #pragma clang attribute pop
+#elif defined(__GNUC__)
+    #pragma GCC pop_options
+#endif
+//-------------------------------------------------------------------
+
+
+
+#endif  // LAZYDATA_X86_64
+
+
+
+#endif  // INCLUDE_COMPUTE_SIMD_UNARY_KERNELS_HPP_
@@ -0,0 +1,219 @@
+//-------------------------------------------------------------------
+/**
+ * @file simd_unary_kernels.inl
+ * @brief Vectorized unary kernels, written once for every instruction set.
+ *
+ * This file is included by simd_unary_kernels.hpp once per instruction
+ * set, inside a namespace that defines a struct named Isa wrapping that
+ * instruction set's intrinsics:
+ *
+ * - Vector, Mask, WIDTH (number of doubles per vector)
+ * - load, store, broadcast
+ * - add, sub, mul, multiply_add (a * b + c), min, max, sqrt, negate, abs
+ * - greater_than, less_than, is_nan, select (mask ? a : b)
+ * - power_of_2 (2^k for an integer valued k in [-1022, 1023])
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Constants used by exp/exp2
+// -- LN2_HI has its 21 low bits set to zero so that n * LN2_HI
+//    is exact for the n's that we deal with (|n| < 1100)
+//-------------------------------------------------------------------
+constexpr double LOG2_E = 1.4426950408889634074;
+constexpr double LN2 = 0.69314718055994530942;
+constexpr double LN2_HI = 6.93147180369123816490e-01;
+constexpr double LN2_LO = 1.90821492927058770002e-10;
+
+// Adding and subtracting 1.5 * 2^52 rounds to the nearest integer
+constexpr double ROUNDING_MAGIC_NUMBER = 6755399441055744.0;
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+inline Isa::Vector round_to_integer(Isa::Vector value)
+{
+    const Isa::Vector magic_number = Isa::broadcast(ROUNDING_MAGIC_NUMBER);
+
+    return Isa::sub(Isa::add(value, magic_number), magic_number);
+}
+
+
+
+// exp(r) for |r| <= ln(2)/2 using its Taylor series up to r^13,
+// the first term that is left out is below 5e-18
+inline Isa::Vector exp_of_reduced_argument(Isa::Vector r)
+{
+    Isa::Vector result = Isa::broadcast(1.0 / 6227020800.0);
+
+    result = Isa::multiply_add(result, r, Isa::broadcast(1.0 / 479001600.0));
+    result = Isa::multiply_add(result, r, Isa::broadcast(1.0 / 39916800.0));
+    result = Isa::multiply_add(result, r, Isa::broadcast(1.0 / 3628800.0));
+    result = Isa::multiply_add(result, r, Isa::broadcast(1.0 / 362880.0));
+    result = Isa::multiply_add(result, r, Isa::broadcast(1.0 / 40320.0));
+    result = Isa::multiply_add(result, r, Isa::broadcast(1.0 / 5040.0));
+    result = Isa::multiply_add(result, r, Isa::broadcast(1.0 / 720.0));
+    result = Isa::multiply_add(result, r, Isa::broadcast(1.0 / 120.0));
+    result = Isa::multiply_add(result, r, Isa::broadcast(1.0 / 24.0));
+    result = Isa::multiply_add(result, r, Isa::broadcast(1.0 / 6.0));
+    result = Isa::multiply_add(result, r, Isa::broadcast(0.5));
+    result = Isa::multiply_add(result, r, Isa::broadcast(1.0));
+    result = Isa::multiply_add(result, r, Isa::broadcast(1.0));
+
+    return result;
+}
+
+
+
+// value * 2^n, with n split in two halves so that results that
+// overflow or are subnormal are still rounded correctly
+inline Isa::Vector scale_by_power_of_2(Isa::Vector value, Isa::Vector n)
+{
+    Isa::Vector first_half = round_to_integer(Isa::mul(n, Isa::broadcast(0.5)));
+    Isa::Vector second_half = Isa::sub(n, first_half);
+
+    return Isa::mul(Isa::mul(value, Isa::power_of_2(first_half)), Isa::power_of_2(second_half));
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// exp(x) = 2^n * exp(r), with n = round(x / ln2) and r = x - n * ln2
+//-------------------------------------------------------------------
+inline Isa::Vector vector_exp(Isa::Vector x)
+{
+    // Outside of this range exp(x) is 0 or infinity anyways
+    Isa::Vector clamped_x = Isa::min(Isa::max(x, Isa::broadcast(-746.0)), Isa::broadcast(710.0));
+
+    Isa::Vector n = round_to_integer(Isa::mul(clamped_x, Isa::broadcast(LOG2_E)));
+
+    Isa::Vector r = Isa::sub(clamped_x, Isa::mul(n, Isa::broadcast(LN2_HI)));
+    r = Isa::sub(r, Isa::mul(n, Isa::broadcast(LN2_LO)));
+
+    Isa::Vector result = scale_by_power_of_2(exp_of_reduced_argument(r), n);
+
+    return Isa::select(Isa::is_nan(x), x, result);
+}
+
+
+
+//-------------------------------------------------------------------
+// exp2(x) = 2^n * exp((x - n) * ln2), with n = round(x)
+//-------------------------------------------------------------------
+inline Isa::Vector vector_exp2(Isa::Vector x)
+{
+    Isa::Vector clamped_x = Isa::min(Isa::max(x, Isa::broadcast(-1076.0)), Isa::broadcast(1025.0));
+
+    Isa::Vector n = round_to_integer(clamped_x);
+
+    Isa::Vector r = Isa::mul(Isa::sub(clamped_x, n), Isa::broadcast(LN2));
+
+    Isa::Vector result = scale_by_power_of_2(exp_of_reduced_argument(r), n);
+
+    return Isa::select(Isa::is_nan(x), x, result);
+}
+
+
+
+//-------------------------------------------------------------------
+// sign(x) is 1 or -1, and x itself for zeros and NaNs
+//-------------------------------------------------------------------
+inline Isa::Vector vector_sign(Isa::Vector x)
+{
+    const Isa::Vector zero = Isa::broadcast(0.0);
+
+    return Isa::select(Isa::greater_than(x, zero),
+                       Isa::broadcast(1.0),
+                       Isa::select(Isa::less_than(x, zero), Isa::broadcast(-1.0), x));
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+template<UnaryOperation Operation>
+
+inline Isa::Vector apply_to_vector(Isa::Vector x)
+{
+    if constexpr(Operation == UnaryOperation::Negate)
+        return Isa::negate(x);
+    else if constexpr(Operation == UnaryOperation::Sign)
+        return vector_sign(x);
+    else if constexpr(Operation == UnaryOperation::Abs)
+        return Isa::abs(x);
+    else if constexpr(Operation == UnaryOperation::Sqrt)
+        return Isa::sqrt(x);
+    else if constexpr(Operation == UnaryOperation::Exp)
+        return vector_exp(x);
+    else
+        return vector_exp2(x);
+}
+
+
+
+// The last few elements that don't fill a whole vector go through
+// a padded copy, so they are computed exactly like all the others
+template<UnaryOperation Operation>
+
+inline void apply_to_buffer(double* data, int64_t number_of_elements)
+{
+    int64_t i = 0;
+
+    for(; i + Isa::WIDTH <= number_of_elements; i += Isa::WIDTH)
+        Isa::store(data + i, apply_to_vector<Operation>(Isa::load(data + i)));
+
+    if(i < number_of_elements)
+    {
+        alignas(64) double padded_elements[Isa::WIDTH] = {};
+
+        for(int64_t j = i; j < number_of_elements; ++j)
+            padded_elements[j - i] = data[j];
+
+        Isa::store(padded_elements, apply_to_vector<Operation>(Isa::load(padded_elements)));
+
+        for(int64_t j = i; j < number_of_elements; ++j)
+            data[j] = padded_elements[j - i];
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+inline void apply_unary_operation(UnaryOperation operation, double* data, int64_t number_of_elements)
+{
+    switch(operation)
+    {
+        default:
+        case UnaryOperation::Negate:
+            apply_to_buffer<UnaryOperation::Negate>(data, number_of_elements);
+        break;
+
+        case UnaryOperation::Sign:
+            apply_to_buffer<UnaryOperation::Sign>(data, number_of_elements);
+        break;
+
+        case UnaryOperation::Abs:
+            apply_to_buffer<UnaryOperation::Abs>(data, number_of_elements);
+        break;
+
+        case UnaryOperation::Sqrt:
+            apply_to_buffer<UnaryOperation::Sqrt>(data, number_of_elements);
+        break;
+
+        case UnaryOperation::Exp:
+            apply_to_buffer<UnaryOperation::Exp>(data, number_of_elements);
+        break;
+
+        case UnaryOperation::Exp2:
+            apply_to_buffer<UnaryOperation::Exp2>(data, number_of_elements);
+        break;
+    }
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,671 @@
+//-------------------------------------------------------------------
+/**
+ * @file statistics.hpp
+ * @brief Sum, mean, variance, extrema, NaN count and L2 norm of a matrix in one pass.
+ *
+ * Statistics are computed for the whole matrix, for each of its rows or
+ * for each of its columns, from an ElementwiseChain, so a deferred
+ * result is summarized while it's being evaluated, block by block,
+ * without ever being stored.
+ *
+ * Every block of a row is summarized by a SIMD kernel while it's in L1
+ * cache (its sums, extrema, and the squared deviations from its own
+ * mean), and the summaries are merged with Chan's parallel formulas,
+ * the sums being compensated (Neumaier), so the results stay accurate
+ * on long rows and big matrices. Column statistics accumulate the rows
+ * of a band shifted by the band's first row, then merge the bands the
+ * same way. The matrix is split into a number of tasks that only
+ * depends on its size, so the results don't depend on the number of
+ * threads.
+ *
+ * NaNs are counted and otherwise left out of every statistic.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_STATISTICS_HPP_
+#define INCLUDE_COMPUTE_STATISTICS_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "elementwise_chain.hpp"
+#include "instruction_set.hpp"
+#include "simd_unary_kernels.hpp"
+#include "thread_pool.hpp"
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// The statistics reported for a matrix, row or column (in this order)
+//-------------------------------------------------------------------
+enum class Statistic : int
+{
+    Sum = 0,
+    Mean,
+    Variance,   // population variance
+    Min,
+    Max,
+    NanCount,
+    L2Norm
+};
+
+constexpr int NUMBER_OF_STATISTICS = 7;
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Adds a value to a sum, keeping the rounding error in a compensation (Neumaier).
+ */
+//-------------------------------------------------------------------
+inline void add_compensated(double& sum, double& compensation, double value)
+{
+    const double new_sum = sum + value;
+
+    if(std::abs(sum) >= std::abs(value))
+        compensation += (sum - new_sum) + value;
+    else
+        compensation += (value - new_sum) + sum;
+
+    sum = new_sum;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @class Statistics
+ * @brief Mergeable summary of a set of values.
+ */
+//-------------------------------------------------------------------
+struct Statistics
+{
+    int64_t count = 0;                  // Values that aren't NaN
+    int64_t nan_count = 0;
+
+    double sum = 0;
+    double sum_compensation = 0;
+
+    double mean = 0;
+    double m2 = 0;                      // Sum of the squared deviations from the mean
+
+    double sum_of_squares = 0;
+    double sum_of_squares_compensation = 0;
+
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+
+
+    /**
+     * @brief Adds the values summarized by another Statistics (Chan et al.).
+     */
+    void merge(const Statistics& statistics)
+    {
+        nan_count += statistics.nan_count;
+
+        if(statistics.count == 0)
+            return;
+
+        const double delta = statistics.mean - mean;
+        const int64_t merged_count = count + statistics.count;
+
+        mean += delta * double(statistics.count) / double(merged_count);
+        m2 += statistics.m2 + delta * delta * double(count) * double(statistics.count) / double(merged_count);
+        count = merged_count;
+
+        add_compensated(sum, sum_compensation, statistics.sum);
+        sum_compensation += statistics.sum_compensation;
+
+        add_compensated(sum_of_squares, sum_of_squares_compensation, statistics.sum_of_squares);
+        sum_of_squares_compensation += statistics.sum_of_squares_compensation;
+
+        min = std::min(min, statistics.min);
+        max = std::max(max, statistics.max);
+    }
+
+
+
+    double get_sum()const
+    {
+        return sum + sum_compensation;
+    }
+
+    // The statistics of no values (all NaNs) are NaN, except their sum, NaN count and L2 norm
+    double get(Statistic statistic)const
+    {
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+
+        switch(statistic)
+        {
+            default:
+            case Statistic::Sum: return get_sum();
+            case Statistic::Mean: return count > 0 ? mean : nan;
+            case Statistic::Variance: return count > 0 ? m2 / double(count) : nan;
+            case Statistic::Min: return count > 0 ? min : nan;
+            case Statistic::Max: return count > 0 ? max : nan;
+            case Statistic::NanCount: return double(nan_count);
+            case Statistic::L2Norm: return std::sqrt(sum_of_squares + sum_of_squares_compensation);
+        }
+    }
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Running sums of the columns of a band of rows.
+ *
+ * The values are accumulated shifted by the band's first row, which
+ * keeps their sum of squares from cancelling out when the variance is
+ * computed from it.
+ */
+//-------------------------------------------------------------------
+struct ColumnAccumulators
+{
+    explicit ColumnAccumulators(int64_t columns)
+    : shift(columns, 0.0),
+      count(columns, 0.0),
+      nan_count(columns, 0.0),
+      shifted_sum(columns, 0.0),
+      shifted_sum_of_squares(columns, 0.0),
+      sum_of_squares(columns, 0.0),
+      min(columns, std::numeric_limits<double>::infinity()),
+      max(columns, -std::numeric_limits<double>::infinity())
+    {
+    }
+
+    Statistics get_statistics(int64_t column)const
+    {
+        Statistics statistics;
+        statistics.count = int64_t(count[column]);
+        statistics.nan_count = int64_t(nan_count[column]);
+
+        if(statistics.count == 0)
+            return statistics;
+
+        const double n = count[column];
+
+        statistics.sum = shift[column] * n + shifted_sum[column];
+        statistics.mean = shift[column] + shifted_sum[column] / n;
+        statistics.m2 = std::max(0.0, shifted_sum_of_squares[column] - shifted_sum[column] * shifted_sum[column] / n);
+        statistics.sum_of_squares = sum_of_squares[column];
+        statistics.min = min[column];
+        statistics.max = max[column];
+
+        return statistics;
+    }
+
+    std::vector<double> shift;
+    std::vector<double> count;
+    std::vector<double> nan_count;
+    std::vector<double> shifted_sum;
+    std::vector<double> shifted_sum_of_squares;
+    std::vector<double> sum_of_squares;
+    std::vector<double> min;
+    std::vector<double> max;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#if defined(LAZYDATA_X86_64)
+
+
+
+//-------------------------------------------------------------------
+// SSE2
+//-------------------------------------------------------------------
+#if defined(__clang__)
+    #pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#elif defined(__GNUC__)
+    #pragma GCC push_options
+    #pragma GCC target("sse2")
+#endif
+
+namespace Compute
+{
+namespace SSE2
+{
+#include "simd_statistics_kernels.inl"
+} // namespace SSE2
+} // namespace Compute
+
+#if defined(__clang__)
+    #pragma clang attribute pop
+#elif defined(__GNUC__)
+    #pragma GCC pop_options
+#endif
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// AVX2 (with FMA)
+//-------------------------------------------------------------------
+#if defined(__clang__)
+    #pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+    #pragma GCC push_options
+    #pragma GCC target("avx2,fma")
+#endif
+
+namespace Compute
+{
+namespace AVX2
+{
+#include "simd_statistics_kernels.inl"
+} // namespace AVX2
+} // namespace Compute
+
+#if defined(__clang__)
+    #pragma clang attribute pop
+#elif defined(__GNUC__)
+    #pragma GCC pop_options
+#endif
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// AVX-512F
+//-------------------------------------------------------------------
+#if defined(__clang__)
+    #pragma clang attribute push(__attribute__((target("avx512f,avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+    #pragma GCC push_options
+    #pragma GCC target("avx512f,avx2,fma")
+#endif
+
+namespace Compute
+{
+namespace AVX512
+{
+#include "simd_statistics_kernels.inl"
+} // namespace AVX512
+} // namespace Compute
+
+#if defined(__clang__)
+    #pragma clang attribute pop
+#elif defined(__GNUC__)
+    #pragma GCC pop_options
+#endif
+//-------------------------------------------------------------------
+
+
+
+#endif  // LAZYDATA_X86_64
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Statistics of a contiguous block, using the kernel of the given instruction set.
+ */
+//-------------------------------------------------------------------
+inline Statistics compute_block_statistics(const double* data, int64_t count, InstructionSet instruction_set)
+{
+#if defined(LAZYDATA_X86_64)
+
+    static const InstructionSet detected_instruction_set = detect_instruction_set();
+
+    if(int(instruction_set) > int(detected_instruction_set))
+        instruction_set = detected_instruction_set;
+
+    switch(instruction_set)
+    {
+        case InstructionSet::AVX512: return AVX512::compute_block_statistics(data, count);
+        case InstructionSet::AVX2: return AVX2::compute_block_statistics(data, count);
+        case InstructionSet::SSE2: return SSE2::compute_block_statistics(data, count);
+        default: break;
+    }
+
+#endif
+
+    Statistics statistics;
+
+    for(int64_t i = 0; i < count; ++i)
+    {
+        const double x = data[i];
+
+        if(std::isnan(x))
+        {
+            ++statistics.nan_count;
+            continue;
+        }
+
+        // Welford's update
+        ++statistics.count;
+
+        const double delta = x - statistics.mean;
+        statistics.mean += delta / double(statistics.count);
+        statistics.m2 += delta * (x - statistics.mean);
+
+        statistics.sum += x;
+        statistics.sum_of_squares += x * x;
+        statistics.min = std::min(statistics.min, x);
+        statistics.max = std::max(statistics.max, x);
+    }
+
+    return statistics;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Adds a segment of a row to the statistics of its columns (see ColumnAccumulators).
+ */
+//-------------------------------------------------------------------
+inline void accumulate_column_statistics(const double* row,
+                                         int64_t first_column,
+                                         int64_t count,
+                                         ColumnAccumulators& accumulators,
+                                         InstructionSet instruction_set)
+{
+#if defined(LAZYDATA_X86_64)
+
+    static const InstructionSet detected_instruction_set = detect_instruction_set();
+
+    if(int(instruction_set) > int(detected_instruction_set))
+        instruction_set = detected_instruction_set;
+
+    switch(instruction_set)
+    {
+        case InstructionSet::AVX512: AVX512::accumulate_column_statistics(row, first_column, count, accumulators); return;
+        case InstructionSet::AVX2: AVX2::accumulate_column_statistics(row, first_column, count, accumulators); return;
+        case InstructionSet::SSE2: SSE2::accumulate_column_statistics(row, first_column, count, accumulators); return;
+        default: break;
+    }
+
+#endif
+
+    for(int64_t j = 0; j < count; ++j)
+    {
+        const int64_t column = first_column + j;
+        const double x = row[j];
+
+        if(std::isnan(x))
+        {
+            accumulators.nan_count[column] += 1;
+            continue;
+        }
+
+        const double deviation = x - accumulators.shift[column];
+
+        accumulators.count[column] += 1;
+        accumulators.shifted_sum[column] += deviation;
+        accumulators.shifted_sum_of_squares[column] += deviation * deviation;
+        accumulators.sum_of_squares[column] += x * x;
+        accumulators.min[column] = std::min(accumulators.min[column], x);
+        accumulators.max[column] = std::max(accumulators.max[column], x);
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Detail
+{
+    // Reads a segment of a row of the chain, in place when the chain is
+    // a window of contiguous rows, evaluated into the buffer otherwise
+    inline const double* read_row_segment(const ElementwiseChain& chain,
+                                          const MatrixView& contiguous_view,
+                                          int64_t row,
+                                          int64_t first_column,
+                                          int64_t last_column,
+                                          double* buffer)
+    {
+        if(contiguous_view.size() > 0)
+            return contiguous_view.row_pointer(row) + first_column;
+
+        chain.evaluate_row_segment(row, first_column, last_column, buffer);
+
+        return buffer;
+    }
+
+    inline MatrixView get_contiguous_view(const ElementwiseChain& chain)
+    {
+        if(chain.is_strided_view() && chain.as_view().column_stride() == 1)
+            return chain.as_view();
+
+        return MatrixView();
+    }
+
+    // Statistics of rows [first_row, last_row) and columns [first_column, last_column)
+    inline Statistics compute_tile_statistics(const ElementwiseChain& chain,
+                                              const MatrixView& contiguous_view,
+                                              int64_t first_row,
+                                              int64_t last_row,
+                                              int64_t first_column,
+                                              int64_t last_column,
+                                              InstructionSet instruction_set)
+    {
+        double buffer[ElementwiseChain::BLOCK_SIZE];
+
+        Statistics statistics;
+
+        for(int64_t row = first_row; row < last_row; ++row)
+        {
+            for(int64_t block_start = first_column; block_start < last_column; block_start += ElementwiseChain::BLOCK_SIZE)
+            {
+                const int64_t block_end = std::min(last_column, block_start + ElementwiseChain::BLOCK_SIZE);
+                const double* block = read_row_segment(chain, contiguous_view, row, block_start, block_end, buffer);
+
+                statistics.merge(compute_block_statistics(block, block_end - block_start, instruction_set));
+            }
+        }
+
+        return statistics;
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Statistics of all the elements of a chain.
+ */
+//-------------------------------------------------------------------
+inline Statistics compute_statistics(const ElementwiseChain& chain, InstructionSet instruction_set = get_instruction_set())
+{
+    const int64_t number_of_rows = chain.rows();
+    const int64_t number_of_columns = chain.columns();
+
+    if(number_of_rows == 0 || number_of_columns == 0)
+        return Statistics();
+
+    const MatrixView contiguous_view = Detail::get_contiguous_view(chain);
+
+    // Tiles of about TASK_SIZE elements, like ElementwiseChain::evaluate
+    const int64_t columns_per_task = std::min(number_of_columns, ElementwiseChain::TASK_SIZE);
+    const int64_t rows_per_task = std::max(int64_t(1), ElementwiseChain::TASK_SIZE / number_of_columns);
+
+    const int64_t number_of_column_tiles = (number_of_columns + columns_per_task - 1) / columns_per_task;
+    const int64_t number_of_row_tiles = (number_of_rows + rows_per_task - 1) / rows_per_task;
+
+    std::vector<Statistics> tile_statistics(number_of_row_tiles * number_of_column_tiles);
+
+    get_thread_pool().parallel_for(int64_t(tile_statistics.size()), [&](int64_t task)
+    {
+        const int64_t first_row = (task / number_of_column_tiles) * rows_per_task;
+        const int64_t first_column = (task % number_of_column_tiles) * columns_per_task;
+
+        tile_statistics[task] = Detail::compute_tile_statistics(chain,
+                                                                contiguous_view,
+                                                                first_row,
+                                                                std::min(number_of_rows, first_row + rows_per_task),
+                                                                first_column,
+                                                                std::min(number_of_columns, first_column + columns_per_task),
+                                                                instruction_set);
+    });
+
+    // Merged in order, so the result doesn't depend on the threads
+    Statistics statistics;
+
+    for(const auto& tile : tile_statistics)
+        statistics.merge(tile);
+
+    return statistics;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Statistics of each row of a chain.
+ */
+//-------------------------------------------------------------------
+inline std::vector<Statistics> compute_row_statistics(const ElementwiseChain& chain, InstructionSet instruction_set = get_instruction_set())
+{
+    const int64_t number_of_rows = chain.rows();
+    const int64_t number_of_columns = chain.columns();
+
+    std::vector<Statistics> row_statistics(number_of_rows);
+
+    if(number_of_rows == 0 || number_of_columns == 0)
+        return row_statistics;
+
+    const MatrixView contiguous_view = Detail::get_contiguous_view(chain);
+
+    const int64_t rows_per_task = std::max(int64_t(1), ElementwiseChain::TASK_SIZE / number_of_columns);
+    const int64_t number_of_tasks = (number_of_rows + rows_per_task - 1) / rows_per_task;
+
+    get_thread_pool().parallel_for(number_of_tasks, [&](int64_t task)
+    {
+        const int64_t first_row = task * rows_per_task;
+        const int64_t last_row = std::min(number_of_rows, first_row + rows_per_task);
+
+        for(int64_t row = first_row; row < last_row; ++row)
+            row_statistics[row] = Detail::compute_tile_statistics(chain, contiguous_view, row, row + 1, 0, number_of_columns, instruction_set);
+    });
+
+    return row_statistics;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Statistics of each column of a chain.
+ *
+ * The rows are read in bands, each band accumulating its columns (see
+ * ColumnAccumulators) while streaming its rows once, and the bands are
+ * then merged in order.
+ */
+//-------------------------------------------------------------------
+inline std::vector<Statistics> compute_column_statistics(const ElementwiseChain& chain, InstructionSet instruction_set = get_instruction_set())
+{
+    // Enough bands to keep the threads busy, few enough for their
+    // accumulators not to take more memory than the matrix
+    constexpr int64_t MAX_NUMBER_OF_BANDS = 64;
+
+    const int64_t number_of_rows = chain.rows();
+    const int64_t number_of_columns = chain.columns();
+
+    std::vector<Statistics> column_statistics(number_of_columns);
+
+    if(number_of_rows == 0 || number_of_columns == 0)
+        return column_statistics;
+
+    const MatrixView contiguous_view = Detail::get_contiguous_view(chain);
+
+    const int64_t rows_per_band = std::max({int64_t(1),
+                                            ElementwiseChain::TASK_SIZE / number_of_columns,
+                                            (number_of_rows + MAX_NUMBER_OF_BANDS - 1) / MAX_NUMBER_OF_BANDS});
+
+    const int64_t number_of_bands = (number_of_rows + rows_per_band - 1) / rows_per_band;
+
+    std::vector<std::vector<Statistics>> band_statistics(number_of_bands);
+
+    get_thread_pool().parallel_for(number_of_bands, [&](int64_t band)
+    {
+        const int64_t first_row = band * rows_per_band;
+        const int64_t last_row = std::min(number_of_rows, first_row + rows_per_band);
+
+        double buffer[ElementwiseChain::BLOCK_SIZE];
+
+        ColumnAccumulators accumulators(number_of_columns);
+
+        for(int64_t row = first_row; row < last_row; ++row)
+        {
+            for(int64_t block_start = 0; block_start < number_of_columns; block_start += ElementwiseChain::BLOCK_SIZE)
+            {
+                const int64_t block_end = std::min(number_of_columns, block_start + ElementwiseChain::BLOCK_SIZE);
+                const double* block = Detail::read_row_segment(chain, contiguous_view, row, block_start, block_end, buffer);
+
+                // The band's first row is its shift
+                if(row == first_row)
+                {
+                    for(int64_t j = block_start; j < block_end; ++j)
+                        accumulators.shift[j] = std::isnan(block[j - block_start]) ? 0.0 : block[j - block_start];
+                }
+
+                accumulate_column_statistics(block, block_start, block_end - block_start, accumulators, instruction_set);
+            }
+        }
+
+        band_statistics[band].resize(number_of_columns);
+
+        for(int64_t column = 0; column < number_of_columns; ++column)
+            band_statistics[band][column] = accumulators.get_statistics(column);
+    });
+
+    for(const auto& band : band_statistics)
+    {
+        for(int64_t column = 0; column < number_of_columns; ++column)
+            column_statistics[column].merge(band[column]);
+    }
+
+    return column_statistics;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_STATISTICS_HPP_
@@ -0,0 +1,257 @@
+//-------------------------------------------------------------------
+/**
+ * @file thread_pool.hpp
+ * @brief A fixed pool of worker threads used to split computations into tasks.
+ *
+ * Computations are handed to the pool as a number of independent tasks
+ * through parallel_for. The calling thread works on the tasks alongside
+ * the workers, so a parallel_for issued from within a task (or while
+ * every worker is busy) still makes progress instead of deadlocking.
+ *
+ * A task that throws doesn't stop the others from being waited for, the
+ * first exception thrown is rethrown by parallel_for once they're done.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_THREAD_POOL_HPP_
+#define INCLUDE_COMPUTE_THREAD_POOL_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @class ThreadPool
+ * @brief Runs the tasks of parallel_for calls on a fixed set of threads.
+ */
+//-------------------------------------------------------------------
+class ThreadPool
+{
+public:
+
+    /**
+     * @param number_of_threads Total number of threads working on each
+     *                          parallel_for, counting the calling thread
+     *                          (0 uses one per hardware thread).
+     */
+    explicit ThreadPool(int number_of_threads = 0)
+    {
+        if(number_of_threads <= 0)
+            number_of_threads = std::max(1, int(std::thread::hardware_concurrency()));
+
+        for(int i = 1; i < number_of_threads; ++i)
+            workers_.emplace_back(&ThreadPool::worker_function, this);
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            is_stopping_ = true;
+        }
+
+        job_is_available_.notify_all();
+
+        for(auto& worker : workers_)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+
+
+    int get_number_of_threads()const
+    {
+        return int(workers_.size()) + 1;
+    }
+
+
+
+    /**
+     * @brief Calls task(i) for every i in [0, number_of_tasks) and waits for all of them.
+     *
+     * Tasks are handed out one at a time, so tasks that take longer than
+     * the others don't hold the rest of the threads back.
+     *
+     * If a task throws, the tasks that haven't started yet are skipped and
+     * the first exception thrown is rethrown here.
+     */
+    void parallel_for(int64_t number_of_tasks, const std::function<void(int64_t)>& task)
+    {
+        if(number_of_tasks <= 0)
+            return;
+
+        if(number_of_tasks == 1 || workers_.empty())
+        {
+            for(int64_t i = 0; i < number_of_tasks; ++i)
+                task(i);
+
+            return;
+        }
+
+        auto job = std::make_shared<Job>();
+        job->task = &task;
+        job->number_of_tasks = number_of_tasks;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.push_back(job);
+        }
+
+        job_is_available_.notify_all();
+
+        run_tasks(*job);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        job_is_done_.wait(lock, [&job](){ return job->number_of_finished_tasks == job->number_of_tasks; });
+
+        // Workers drop exhausted jobs lazily, so it may still be queued
+        auto job_position = std::find(jobs_.begin(), jobs_.end(), job);
+
+        if(job_position != jobs_.end())
+            jobs_.erase(job_position);
+
+        if(job->exception)
+            std::rethrow_exception(job->exception);
+    }
+
+
+
+private:
+
+    struct Job
+    {
+        const std::function<void(int64_t)>* task = nullptr;
+        int64_t number_of_tasks = 0;
+        std::atomic<int64_t> next_task{0};
+        std::atomic<int64_t> number_of_finished_tasks{0};
+
+        std::atomic<bool> has_failed{false};
+        std::exception_ptr exception;       // First one thrown, set under the pool's mutex
+    };
+
+
+
+    void run_tasks(Job& job)
+    {
+        for(int64_t i = job.next_task++; i < job.number_of_tasks; i = job.next_task++)
+        {
+            // A failed task still counts as finished, so the
+            // calling thread isn't left waiting for it
+            if(!job.has_failed)
+            {
+                try
+                {
+                    (*job.task)(i);
+                }
+                catch(...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+
+                    if(!job.exception)
+                        job.exception = std::current_exception();
+
+                    job.has_failed = true;
+                }
+            }
+
+            if(++job.number_of_finished_tasks == job.number_of_tasks)
+            {
+                // Taking the lock makes sure the waiting thread is either
+                // not checking yet or already waiting when notified
+                std::lock_guard<std::mutex> lock(mutex_);
+                job_is_done_.notify_all();
+            }
+        }
+    }
+
+
+
+    void worker_function()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        while(true)
+        {
+            job_is_available_.wait(lock, [this](){ return is_stopping_ || !jobs_.empty(); });
+
+            if(is_stopping_)
+                return;
+
+            std::shared_ptr<Job> job = jobs_.front();
+
+            if(job->next_task >= job->number_of_tasks)
+            {
+                jobs_.pop_front();
+                continue;
+            }
+
+            lock.unlock();
+            run_tasks(*job);
+            lock.lock();
+        }
+    }
+
+
+
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable job_is_available_;
+    std::condition_variable job_is_done_;
+    std::deque<std::shared_ptr<Job>> jobs_;
+    bool is_stopping_ = false;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief The pool shared by every computation (created on first use).
+ */
+//-------------------------------------------------------------------
+inline ThreadPool& get_thread_pool()
+{
+    static ThreadPool thread_pool;
+    return thread_pool;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_THREAD_POOL_HPP_
@@ -0,0 +1,193 @@
+//-------------------------------------------------------------------
+/**
+ * @file transpose.hpp
+ * @brief Cache-blocked, multithreaded matrix transposes.
+ *
+ * A naive transpose reads rows and writes columns, so every write lands
+ * on a different cache line (and on big matrices a different page).
+ * These transposes work on small square tiles that fit in L1 cache, so
+ * both the reads and the writes of a tile reuse the cache lines (and TLB
+ * entries) they touch. Groups of tiles are spread over the thread pool.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_TRANSPOSE_HPP_
+#define INCLUDE_COMPUTE_TRANSPOSE_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "matrix_view.hpp"
+#include "thread_pool.hpp"
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Side of the tiles (32x32 doubles = 8 KB, so a source tile and a
+// destination tile fit in L1 cache together)
+constexpr int64_t TRANSPOSE_TILE_SIZE = 32;
+
+// Side of the groups of tiles handed to a thread at a time
+constexpr int64_t TRANSPOSE_TASK_SIZE = 256;
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Writes row i of the destination from column columns[i] of the source.
+ *
+ * This is the transpose of the source restricted to the given columns,
+ * which is what plots need to turn selected columns into contiguous
+ * lines.
+ *
+ * @param columns The source columns to transpose (nullptr for all of them).
+ * @param number_of_columns Number of entries of columns (ignored if columns is nullptr).
+ * @param destination Pointer to element (0,0) of the destination.
+ * @param destination_row_stride Distance (in elements) between destination rows.
+ */
+//-------------------------------------------------------------------
+inline void transpose_columns(const MatrixView& source,
+                              const int64_t* columns,
+                              int64_t number_of_columns,
+                              double* destination,
+                              int64_t destination_row_stride)
+{
+    const int64_t number_of_rows = source.rows();
+
+    if(columns == nullptr)
+        number_of_columns = source.columns();
+
+    if(number_of_rows == 0 || number_of_columns <= 0)
+        return;
+
+    const int64_t number_of_row_tasks = (number_of_rows + TRANSPOSE_TASK_SIZE - 1) / TRANSPOSE_TASK_SIZE;
+    const int64_t number_of_column_tasks = (number_of_columns + TRANSPOSE_TASK_SIZE - 1) / TRANSPOSE_TASK_SIZE;
+
+    get_thread_pool().parallel_for(number_of_row_tasks * number_of_column_tasks, [&](int64_t task)
+    {
+        const int64_t task_first_row = (task / number_of_column_tasks) * TRANSPOSE_TASK_SIZE;
+        const int64_t task_first_column = (task % number_of_column_tasks) * TRANSPOSE_TASK_SIZE;
+
+        const int64_t task_last_row = std::min(number_of_rows, task_first_row + TRANSPOSE_TASK_SIZE);
+        const int64_t task_last_column = std::min(number_of_columns, task_first_column + TRANSPOSE_TASK_SIZE);
+
+        for(int64_t first_row = task_first_row; first_row < task_last_row; first_row += TRANSPOSE_TILE_SIZE)
+        {
+            const int64_t last_row = std::min(task_last_row, first_row + TRANSPOSE_TILE_SIZE);
+
+            for(int64_t first_column = task_first_column; first_column < task_last_column; first_column += TRANSPOSE_TILE_SIZE)
+            {
+                const int64_t last_column = std::min(task_last_column, first_column + TRANSPOSE_TILE_SIZE);
+
+                for(int64_t j = first_column; j < last_column; ++j)
+                {
+                    const int64_t source_column = columns ? columns[j] : j;
+                    double* destination_row = destination + j * destination_row_stride;
+
+                    for(int64_t i = first_row; i < last_row; ++i)
+                        destination_row[i] = source(i, source_column);
+                }
+            }
+        }
+    });
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Transposes a square matrix onto itself.
+ *
+ * Tile (I,J) is swapped with tile (J,I), each being transposed on the
+ * way, and the tiles on the diagonal are transposed onto themselves.
+ * Each thread handles a whole row of tiles at a time.
+ *
+ * @param data Pointer to element (0,0).
+ * @param size Number of rows (and columns).
+ * @param row_stride Distance (in elements) between rows.
+ */
+//-------------------------------------------------------------------
+inline void transpose_in_place(double* data, int64_t size, int64_t row_stride)
+{
+    if(data == nullptr || size <= 1)
+        return;
+
+    const int64_t number_of_tiles = (size + TRANSPOSE_TILE_SIZE - 1) / TRANSPOSE_TILE_SIZE;
+
+    get_thread_pool().parallel_for(number_of_tiles, [&](int64_t tile_row)
+    {
+        const int64_t first_row = tile_row * TRANSPOSE_TILE_SIZE;
+        const int64_t last_row = std::min(size, first_row + TRANSPOSE_TILE_SIZE);
+
+        for(int64_t tile_column = tile_row; tile_column < number_of_tiles; ++tile_column)
+        {
+            const int64_t first_column = tile_column * TRANSPOSE_TILE_SIZE;
+            const int64_t last_column = std::min(size, first_column + TRANSPOSE_TILE_SIZE);
+
+            for(int64_t i = first_row; i < last_row; ++i)
+            {
+                // On the diagonal only the upper half is swapped
+                const int64_t start_column = (tile_row == tile_column) ? i + 1 : first_column;
+
+                for(int64_t j = start_column; j < last_column; ++j)
+                    std::swap(data[i * row_stride + j], data[j * row_stride + i]);
+            }
+        }
+    });
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Writes the transpose of the source into the destination.
+ *
+ * The destination must hold source.columns() rows of source.rows()
+ * elements and must not overlap the source, except for square matrices
+ * transposed onto themselves (see transpose_in_place).
+ */
+//-------------------------------------------------------------------
+inline void transpose(const MatrixView& source, double* destination, int64_t destination_row_stride)
+{
+    if(source.rows() == source.columns() &&
+       source.data() == destination &&
+       source.has_contiguous_rows() &&
+       source.row_stride() == destination_row_stride)
+    {
+        transpose_in_place(destination, source.rows(), destination_row_stride);
+        return;
+    }
+
+    transpose_columns(source, nullptr, 0, destination, destination_row_stride);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_TRANSPOSE_HPP_
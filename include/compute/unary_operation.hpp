@@ -0,0 +1,85 @@
+//-------------------------------------------------------------------
+/**
+ * @file unary_operation.hpp
+ * @brief The elementwise unary operations and their scalar definitions.
+ *
+ * The scalar definitions are the reference that the vectorized
+ * kernels (see simd_unary_kernels.hpp) are tested against.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+#ifndef INCLUDE_COMPUTE_UNARY_OPERATION_HPP_
+#define INCLUDE_COMPUTE_UNARY_OPERATION_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <cmath>
+#include <cstdint>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace Compute
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Unary operations that map each element independently of the others
+//-------------------------------------------------------------------
+enum class UnaryOperation : int
+{
+    Negate = 0,
+    Sign,
+    Abs,
+    Sqrt,
+    Exp,
+    Exp2
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+inline double apply_unary_operation(UnaryOperation operation, double value)
+{
+    switch(operation)
+    {
+        default:
+        case UnaryOperation::Negate:
+            return -value;
+
+        case UnaryOperation::Sign:
+            return (value > 0.0) ? 1.0 : ((value < 0.0) ? -1.0 : value);
+
+        case UnaryOperation::Abs:
+            return std::abs(value);
+
+        case UnaryOperation::Sqrt:
+            return std::sqrt(value);
+
+        case UnaryOperation::Exp:
+            return std::exp(value);
+
+        case UnaryOperation::Exp2:
+            return std::exp2(value);
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace Compute
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_COMPUTE_UNARY_OPERATION_HPP_
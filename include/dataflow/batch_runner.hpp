@@ -0,0 +1,277 @@
+#ifndef INCLUDE_BATCH_RUNNER_HPP_
+#define INCLUDE_BATCH_RUNNER_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "node_manager.hpp"
+#include "link_manager.hpp"
+#include "node_profiler.hpp"
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Define every thing within the namespace DataFlow
+//-------------------------------------------------------------------
+namespace DataFlow
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Functions used to write a node's results to a file
+//-------------------------------------------------------------------
+inline bool write_matrix_as_csv(const Compute::MatrixView& view, const std::filesystem::path& filename)
+{
+    std::ofstream file(filename);
+
+    if(!file)
+        return false;
+
+    file << std::setprecision(17);
+
+    for(int64_t i = 0; i < view.rows(); ++i)
+    {
+        for(int64_t j = 0; j < view.columns(); ++j)
+        {
+            if(j > 0)
+                file << ',';
+
+            file << view(i,j);
+        }
+
+        file << '\n';
+    }
+
+    return bool(file);
+}
+
+
+
+// Writes the matrix as a NumPy (.npy version 1.0) file, which is
+// the raw row-major doubles preceded by a small text header
+inline bool write_matrix_as_npy(const Compute::MatrixView& view, const std::filesystem::path& filename)
+{
+    std::ofstream file(filename, std::ios::binary);
+
+    if(!file)
+        return false;
+
+    std::string header = std::string("{'descr': '<f8', 'fortran_order': False, 'shape': (") +
+                         std::to_string(view.rows()) + ", " + std::to_string(view.columns()) + "), }";
+
+    // The magic string, version and header length take 10 bytes and
+    // the header is padded with spaces so the data is 64-byte aligned
+    std::size_t header_length = header.size() + 1;
+    header.append((64 - (10 + header_length) % 64) % 64, ' ');
+    header += '\n';
+
+    uint16_t header_size = uint16_t(header.size());
+
+    file.write("\x93NUMPY\x01\x00", 8);
+    file.put(char(header_size & 0xff));
+    file.put(char(header_size >> 8));
+    file.write(header.data(), header.size());
+
+    std::vector<double> row(view.columns());
+
+    for(int64_t i = 0; i < view.rows(); ++i)
+    {
+        if(view.has_contiguous_rows())
+        {
+            file.write(reinterpret_cast<const char*>(view.row_pointer(i)), view.columns() * sizeof(double));
+        }
+        else
+        {
+            for(int64_t j = 0; j < view.columns(); ++j)
+                row[j] = view(i,j);
+
+            file.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(double));
+        }
+    }
+
+    return bool(file);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Class used to run a saved study without a window
+// -- Loads the nodes and links of a study saved by the editor,
+//    computes all the nodes and writes the results of the
+//    selected nodes to files
+// -- Like the editor, results saved with the study that are still
+//    valid are attached back instead of being computed
+//-------------------------------------------------------------------
+class BatchRunner
+{
+public:
+
+    BatchRunner()
+    {
+    }
+
+
+
+    bool load_study(const std::filesystem::path& study_filename)
+    {
+        std::ifstream file(study_filename);
+
+        if(!file)
+            return false;
+
+        nlohmann::json json_file = nlohmann::json::parse(file, nullptr, false);
+
+        if(json_file.is_discarded())
+            return false;
+
+        bool were_nodes_loaded = node_manager_.load_from_json(json_file, std::bind(&LinkManager::remove_link_that_belongs_to_pin, &link_manager_, std::placeholders::_1));
+        bool were_links_loaded = false;
+
+        // Connecting the links doesn't compute anything, the
+        // nodes are computed once by run()
+        {
+            PinNotifications::ScopedSuspension suspension;
+            were_links_loaded = link_manager_.load_from_json(node_manager_, json_file);
+        }
+
+        study_directory_ = study_filename.parent_path();
+        study_json_ = std::move(json_file);
+
+        return were_nodes_loaded && were_links_loaded;
+    }
+
+
+
+    // Computes every node once, from the data sources downstream
+    // (see NodeManager::restore_results), timing each one of them
+    void run()
+    {
+        NodeProfiler::reset();
+        node_manager_.restore_results(study_directory_, study_json_);
+    }
+
+
+
+    std::vector<int> get_node_ids()
+    {
+        return node_manager_.get_node_ids();
+    }
+
+    std::string get_node_title(int node_id)
+    {
+        NodeVariantType* node = node_manager_.find_node_using_id(node_id);
+
+        return node ? std::visit(GetNodeTitle{}, *node) : std::string();
+    }
+
+    Pin<MatrixType>* get_node_output_pin(int node_id)
+    {
+        NodeVariantType* node = node_manager_.find_node_using_id(node_id);
+
+        return node ? std::visit(GetNodeOutputPin{}, *node) : nullptr;
+    }
+
+
+
+    // Nodes whose results aren't used by any other node
+    std::vector<int> get_terminal_node_ids()
+    {
+        std::vector<int> terminal_node_ids;
+
+        for(int node_id : get_node_ids())
+        {
+            Pin<MatrixType>* output_pin = get_node_output_pin(node_id);
+
+            if(output_pin && !output_pin->is_connected())
+                terminal_node_ids.push_back(node_id);
+        }
+
+        return terminal_node_ids;
+    }
+
+
+
+    // Writes the node's result as a csv file if the filename ends
+    // in ".csv", otherwise as a NumPy (.npy) binary file
+    bool write_node_output(int node_id, const std::filesystem::path& filename)
+    {
+        Pin<MatrixType>* output_pin = get_node_output_pin(node_id);
+
+        if(!output_pin)
+            return false;
+
+        Compute::MatrixView view = output_pin->get_view();
+
+        if(filename.extension() == ".csv")
+            return write_matrix_as_csv(view, filename);
+        else
+            return write_matrix_as_npy(view, filename);
+    }
+
+
+
+    void print_timings(std::ostream& output)
+    {
+        const auto& timings = NodeProfiler::get_timings();
+
+        std::chrono::duration<double> total_time(0);
+
+        output << std::left << std::setw(12) << "node id"
+               << std::setw(32) << "title"
+               << std::right << std::setw(14) << "computations"
+               << std::setw(16) << "time (ms)" << '\n';
+
+        for(int node_id : get_node_ids())
+        {
+            auto timing = timings.find(node_id);
+
+            if(timing == timings.end())
+                continue;
+
+            total_time += timing->second.exclusive_time;
+
+            output << std::left << std::setw(12) << node_id
+                   << std::setw(32) << get_node_title(node_id)
+                   << std::right << std::setw(14) << timing->second.number_of_computations
+                   << std::setw(16) << std::fixed << std::setprecision(3) << timing->second.exclusive_time.count() * 1000.0 << '\n';
+        }
+
+        output << "total: " << std::fixed << std::setprecision(3) << total_time.count() * 1000.0 << " ms\n";
+    }
+
+
+
+private:
+
+    // The link manager is declared first so that it outlives the
+    // nodes, which remove their links when they are destroyed
+    LinkManager link_manager_;
+    NodeManager node_manager_;
+
+    std::filesystem::path study_directory_;
+    nlohmann::json study_json_;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace DataFlow
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_BATCH_RUNNER_HPP_
@@ -86,8 +86,13 @@ class Node;
 
 class MatrixSourceNode;
 class ImageLoaderNode;
+class ImageSequenceNode;
 class CsvLoaderNode;
+class BinaryLoaderNode;
 class UnaryOperatorNode;
+class BinaryOperatorNode;
+class StatisticsNode;
+class FftNode;
 class AugmentNode;
 class TableNode;
 class PlotNode;
@@ -192,6 +197,12 @@ inline std::string get_node_type_name<ImageLoaderNode>()
 {
     return "IMAGE_LOADER_NODE";
 }
+
+template<>
+inline std::string get_node_type_name<ImageSequenceNode>()
+{
+    return "IMAGE_SEQUENCE_NODE";
+}
     
 
 template<>
@@ -200,12 +211,36 @@ inline std::string get_node_type_name<CsvLoaderNode>()
     return "CSV_LOADER_NODE";
 }
 
+template<>
+inline std::string get_node_type_name<BinaryLoaderNode>()
+{
+    return "BINARY_LOADER_NODE";
+}
+
 template<>
 inline std::string get_node_type_name<UnaryOperatorNode>()
 {
     return "UNARY_OPERATOR_NODE";
 }
 
+template<>
+inline std::string get_node_type_name<BinaryOperatorNode>()
+{
+    return "BINARY_OPERATOR_NODE";
+}
+
+template<>
+inline std::string get_node_type_name<StatisticsNode>()
+{
+    return "STATISTICS_NODE";
+}
+
+template<>
+inline std::string get_node_type_name<FftNode>()
+{
+    return "FFT_NODE";
+}
+
 template<>
 inline std::string get_node_type_name<AugmentNode>()
 {
@@ -27,6 +27,9 @@
 // Study
 #include "study.hpp"
 
+// Running saved studies without a window
+#include "batch_runner.hpp"
+
 // Node menus
 #include "menus/menus.hpp"
 //-------------------------------------------------------------------
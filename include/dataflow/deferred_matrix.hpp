@@ -0,0 +1,430 @@
+#ifndef INCLUDE_DEFERRED_MATRIX_HPP_
+#define INCLUDE_DEFERRED_MATRIX_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <cstring>
+#include <chrono>
+
+#include <compute/elementwise_chain.hpp>
+#include <compute/matrix_storage.hpp>
+
+#include "constants_and_defaults.hpp"
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Define every thing within the namespace DataFlow
+//-------------------------------------------------------------------
+namespace DataFlow
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Function used to view the data of a matrix without copying it
+//-------------------------------------------------------------------
+inline Compute::MatrixView make_matrix_view(MatrixType& matrix)
+{
+    if(matrix.size() == 0)
+        return Compute::MatrixView();
+
+    return Compute::MatrixView(&matrix(0,0), matrix.rows(), matrix.columns(), matrix.columns());
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Class representing the not-yet-computed result of an elementwise
+// node (unary operator, roi, selector)
+// -- Instead of computing its result, a node stores the chain of
+//    operations that would produce it and publishes it through its
+//    output pin
+// -- The next elementwise node downstream extends that chain instead
+//    of reading the result, so a whole chain of such nodes collapses
+//    into one pass over the original data
+// -- The result is only computed when someone actually asks for it:
+//    -- get_view() computes it into a Compute::MatrixStorage (RAM for
+//       small results, a scratch file for big ones), unless the chain
+//       is only a window of its source (an roi), which is then viewed
+//       in place with strides, so nothing is copied
+//    -- materialize() is for consumers that need a LazyMatrix, it
+//       fills the node's matrix (the "mirror") from the storage, or
+//       straight from the chain if nobody asked for a view before
+// -- A result saved with a study can be attached back from its file,
+//    in which case it is neither copied nor recomputed
+// -- A source node can also compute its result straight into a
+//    Compute::MatrixStorage and hand it over (see adopt())
+//-------------------------------------------------------------------
+class DeferredMatrix
+{
+public:
+
+    DeferredMatrix(MatrixType* matrix)
+    : matrix_(matrix)
+    {
+    }
+
+    // Nodes get copy constructed by the node manager when it erases a
+    // node before a node of another type (the later node's variant is
+    // constructed again in the erased node's place). A copy can't know
+    // the matrix of the node it's part of, so it doesn't mirror any
+    // matrix until that node rebinds it (see rebind_matrix())
+    // -- Assigning keeps the matrix, since assigned nodes keep theirs
+    // -- The storage is not copied, it is re-evaluated from the
+    //    chain the next time someone asks for a view (or attached
+    //    again if it was an attached file), except for an adopted
+    //    storage which has no chain to be re-evaluated from
+    DeferredMatrix(const DeferredMatrix& deferred_matrix)
+    : matrix_(nullptr)
+    {
+        *this = deferred_matrix;
+    }
+
+    DeferredMatrix& operator=(const DeferredMatrix& deferred_matrix)
+    {
+        if(this != &deferred_matrix)
+        {
+            chain_ = deferred_matrix.chain_;
+            storage_.release();
+
+            is_evaluated_ = deferred_matrix.is_mirrored_;
+            is_mirrored_ = deferred_matrix.is_mirrored_;
+            is_adopted_ = false;
+
+            if(deferred_matrix.is_attached() && deferred_matrix.storage_.is_raw_attachment())
+            {
+                attach_raw(deferred_matrix.storage_.get_spill_filename(),
+                           deferred_matrix.storage_.get_attached_offset(),
+                           deferred_matrix.storage_.rows(),
+                           deferred_matrix.storage_.columns(),
+                           deferred_matrix.storage_.is_column_major());
+            }
+            else if(deferred_matrix.is_attached())
+            {
+                attach(deferred_matrix.storage_.get_spill_filename());
+            }
+            else if(deferred_matrix.is_adopted_)
+            {
+                Compute::MatrixStorage storage;
+
+                if(storage.resize(deferred_matrix.rows(), deferred_matrix.columns()))
+                {
+                    if(storage.size() > 0)
+                        std::memcpy(storage.data(), deferred_matrix.storage_.data(), storage.size() * sizeof(double));
+
+                    adopt(std::move(storage));
+                }
+                else
+                {
+                    mirror_matrix();
+                }
+            }
+        }
+
+        return *this;
+    }
+
+
+
+    // Function used by a copy constructed node to point its deferred
+    // matrix at its own matrix
+    void rebind_matrix(MatrixType* matrix)
+    {
+        matrix_ = matrix;
+    }
+
+
+
+    void set_chain(const Compute::ElementwiseChain& chain)
+    {
+        chain_ = chain;
+        storage_.release();
+
+        is_evaluated_ = false;
+        is_mirrored_ = false;
+        is_adopted_ = false;
+    }
+
+    // Function used to go back to simply mirroring the node's
+    // matrix, for nodes that computed a new result in it
+    void mirror_matrix()
+    {
+        chain_ = Compute::ElementwiseChain();
+        storage_.release();
+
+        is_evaluated_ = true;
+        is_mirrored_ = true;
+        is_adopted_ = false;
+    }
+
+
+
+    // Function used to attach a result saved in a matrix file (see
+    // Compute::write_matrix_file) without copying or recomputing it
+    // -- An attached result can't be evicted, since there's no chain
+    //    to recompute it from until the node computes a new result
+    bool attach(const std::filesystem::path& filename)
+    {
+        Compute::MatrixStorage storage;
+
+        if(!storage.attach(filename))
+            return false;
+
+        storage_ = std::move(storage);
+        chain_ = Compute::ElementwiseChain(storage_.view());
+
+        is_evaluated_ = true;
+        is_mirrored_ = false;
+        is_adopted_ = false;
+
+        return true;
+    }
+
+    // Function used to attach the raw doubles of a binary file (see
+    // Compute::MatrixStorage::attach_raw) without copying them
+    // -- A column major file is read through a strided view, so it
+    //    is only copied (transposed) if someone materializes it
+    bool attach_raw(const std::filesystem::path& filename,
+                    uint64_t offset,
+                    int64_t rows,
+                    int64_t columns,
+                    bool is_column_major)
+    {
+        Compute::MatrixStorage storage;
+
+        if(!storage.attach_raw(filename, offset, rows, columns, is_column_major))
+            return false;
+
+        storage_ = std::move(storage);
+        chain_ = Compute::ElementwiseChain(storage_.view());
+
+        is_evaluated_ = !is_column_major;
+        is_mirrored_ = false;
+        is_adopted_ = false;
+
+        return true;
+    }
+
+    // Function used to publish a result a node computed straight into
+    // a storage (a big file parsed into a spill file for example), so
+    // that it doesn't have to be copied into the node's matrix
+    // -- Only its first rows are the result, the others are spare
+    //    capacity for rows the node appends later (see take_storage())
+    // -- Like an attached result, it can't be evicted
+    void adopt(Compute::MatrixStorage&& storage, int64_t rows = -1)
+    {
+        storage_ = std::move(storage);
+
+        if(rows < 0 || rows > storage_.rows())
+            rows = storage_.rows();
+
+        chain_ = Compute::ElementwiseChain(Compute::MatrixView(storage_.data(), rows, storage_.columns(), storage_.columns()));
+
+        is_evaluated_ = true;
+        is_mirrored_ = false;
+        is_adopted_ = true;
+    }
+
+    // Function used to take an adopted storage back, to write new rows
+    // in its spare capacity before adopting it again
+    // -- Until then, the node's matrix is mirrored
+    Compute::MatrixStorage take_storage()
+    {
+        Compute::MatrixStorage storage = std::move(storage_);
+        mirror_matrix();
+
+        return storage;
+    }
+
+
+
+    bool is_attached()const
+    {
+        return storage_.get_tier() == Compute::MatrixStorage::Tier::Attached;
+    }
+
+    bool is_adopted()const
+    {
+        return is_adopted_;
+    }
+
+    // Attached and adopted results have no chain to be recomputed from
+    bool is_evictable()const
+    {
+        return !is_attached() && !is_adopted_;
+    }
+
+
+
+    MatrixType* get_matrix()const
+    {
+        return matrix_;
+    }
+
+    const Compute::ElementwiseChain& get_chain()const
+    {
+        return chain_;
+    }
+
+    bool is_materialized()const
+    {
+        return is_evaluated_;
+    }
+
+    const Compute::MatrixStorage& get_storage()const
+    {
+        return storage_;
+    }
+
+    std::chrono::steady_clock::time_point get_last_access_time()const
+    {
+        return last_access_time_;
+    }
+
+    // Bytes held by the computed result (storage and node's matrix)
+    int64_t get_number_of_bytes()const
+    {
+        return int64_t(storage_.size() + matrix_->size()) * int64_t(sizeof(double));
+    }
+
+    int64_t rows()const
+    {
+        return chain_.rows();
+    }
+
+    int64_t columns()const
+    {
+        return chain_.columns();
+    }
+
+
+
+    // Function used to get the result without going through a LazyMatrix
+    // -- The view can be strided (see Compute::MatrixView)
+    Compute::MatrixView get_view()
+    {
+        last_access_time_ = std::chrono::steady_clock::now();
+
+        if(!is_evaluated_ && chain_.is_strided_view())
+            return chain_.as_view();
+
+        if(!is_evaluated_)
+        {
+            if(storage_.resize(chain_.rows(), chain_.columns()))
+            {
+                chain_.evaluate(storage_.data(), chain_.columns());
+                is_evaluated_ = true;
+            }
+            else
+            {
+                // Neither tier had room for it, so fall back
+                // to computing it into the node's matrix
+                materialize();
+            }
+        }
+
+        if(is_mirrored_ && storage_.size() == 0)
+            return make_matrix_view(*matrix_);
+
+        if(is_adopted_)
+            return Compute::MatrixView(storage_.data(), chain_.rows(), chain_.columns(), chain_.columns());
+
+        return storage_.view();
+    }
+
+
+
+    // Function used to compute the result into the
+    // node's matrix (only done once per chain)
+    MatrixType* materialize()
+    {
+        last_access_time_ = std::chrono::steady_clock::now();
+
+        if(!is_mirrored_)
+        {
+            matrix_->resize(chain_.rows(), chain_.columns());
+
+            if(chain_.size() > 0)
+            {
+                if(is_evaluated_ && storage_.size() > 0)
+                    std::memcpy(&(*matrix_)(0,0), storage_.data(), chain_.size() * sizeof(double));
+                else
+                    chain_.evaluate(&(*matrix_)(0,0), chain_.columns());
+            }
+
+            is_evaluated_ = true;
+            is_mirrored_ = true;
+        }
+
+        return matrix_;
+    }
+
+
+
+    // Function used to free the computed result, it is
+    // computed again from the chain the next time it's needed
+    void evict()
+    {
+        if(!is_evictable())
+            return;
+
+        storage_.release();
+        matrix_->resize(0,0);
+
+        is_evaluated_ = false;
+        is_mirrored_ = false;
+    }
+
+
+
+private:
+
+    MatrixType* matrix_ = nullptr;
+    Compute::ElementwiseChain chain_;
+    Compute::MatrixStorage storage_;
+
+    bool is_evaluated_ = true;
+    bool is_mirrored_ = true;
+    bool is_adopted_ = false;
+
+    std::chrono::steady_clock::time_point last_access_time_;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Function used by elementwise nodes to start their chain from
+// the data linked to their input pin
+// -- If the input is itself a deferred result, the node extends
+//    that chain (fusion), otherwise it starts a new chain that
+//    reads the input matrix directly
+// -- We extend the chain even if the input was already computed,
+//    so that the input's result can be evicted at any time
+//-------------------------------------------------------------------
+inline Compute::ElementwiseChain make_elementwise_chain(MatrixType* data, DeferredMatrix* deferred_matrix)
+{
+    if(deferred_matrix)
+        return deferred_matrix->get_chain();
+
+    if(data)
+        return Compute::ElementwiseChain(make_matrix_view(*data));
+
+    return Compute::ElementwiseChain();
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace DataFlow
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_DEFERRED_MATRIX_HPP_
@@ -48,7 +48,7 @@ public:
         output_pin_->add_output_link(this);
         input_pin_->set_input_link(this);
         
-        output_pin_updated_data(output_pin->get_data());
+        output_pin_updated_data(output_pin->get_data_pointer(), output_pin->get_deferred_matrix());
     }
 
     // This function disconnects the connected pins
@@ -86,9 +86,9 @@ public:
     // Function used to notify the connected input
     // pin that the linked output pin's data has been
     // updated/changed
-    void output_pin_updated_data(DataType* data)
+    void output_pin_updated_data(DataType* data, DeferredMatrix* deferred_matrix = nullptr)
     {
-        input_pin_->update_data(data);
+        input_pin_->update_data(data, deferred_matrix);
     }
 
 
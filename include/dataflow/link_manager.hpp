@@ -184,6 +184,43 @@ public:
         return json_file;
     }
 
+    // Reconnects the links saved by save_to_json, the nodes
+    // (and therefore their pins) have to be loaded first
+    // -- Returns false if some of the links could not be reconnected
+    bool load_from_json(NodeManager& node_manager, const nlohmann::json& json_file)
+    {
+        if(!json_file.contains("links"))
+            return true;
+
+        bool were_all_links_loaded = true;
+
+        for(int link_id : json_file["links"].value("link IDs", std::vector<int>()))
+        {
+            std::string link_name = std::string("link ") + std::to_string(link_id);
+
+            if(!json_file["links"].contains(link_name))
+            {
+                were_all_links_loaded = false;
+                continue;
+            }
+
+            const auto& link_json = json_file["links"][link_name];
+
+            Pin<MatrixType>* output_pin = node_manager.find_pin_using_id(link_json.value("output pin", 0));
+            Pin<MatrixType>* input_pin = node_manager.find_pin_using_id(link_json.value("input pin", 0));
+
+            if(!output_pin || !input_pin || !input_pin->can_pin_be_connected())
+            {
+                were_all_links_loaded = false;
+                continue;
+            }
+
+            add_link(output_pin, input_pin);
+        }
+
+        return were_all_links_loaded;
+    }
+
 
 
 private:
@@ -5,7 +5,19 @@
 
 //-------------------------------------------------------------------
 #include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <compute/elementwise_chain.hpp>
+
 #include "constants_and_defaults.hpp"
+#include "table_cell_cache.hpp"
 //-------------------------------------------------------------------
 
 
@@ -18,26 +30,304 @@ namespace DataFlow
 
 
 
+//-------------------------------------------------------------------
+/**
+ * @brief What a matrix table keeps from one frame to the next.
+ *
+ * Formatting every visible cell every frame (and allocating a string
+ * for each of them) adds up quickly for wide pages, so the text of the
+ * cells is kept in a TableCellCache. It's refreshed when the visible
+ * rows leave the cached ones, when another page or matrix is shown, or
+ * after invalidate(), which the owner of the table calls when the
+ * values of its matrix change.
+ *
+ * Only the cell being edited is drawn as an input, typing into a
+ * buffer that's reused from one edit to the next.
+ */
+//-------------------------------------------------------------------
+class MatrixTableState
+{
+public:
+
+    int page_index = 0;
+
+    // Height of the rows measured by the clipper, so that it isn't measured every frame
+    float row_height = -1.0f;
+
+    void invalidate()
+    {
+        cell_cache_.invalidate();
+    }
+
+
+
+    /**
+     * @brief Makes sure the text of table rows [first_row, last_row) and columns [first_column, last_column) is cached.
+     *
+     * @param data Identifies the matrix shown (it is only compared).
+     * @param format_cell Called as format_cell(row, column, text) to append the text of a cell to text.
+     */
+    template<typename FormatCell>
+
+    void cache_cells(const void* data,
+                     int64_t number_of_rows,
+                     int64_t first_row,
+                     int64_t last_row,
+                     int64_t first_column,
+                     int64_t last_column,
+                     FormatCell format_cell)
+    {
+        cell_cache_.cache_cells(data, page_index, number_of_rows, first_row, last_row, first_column, last_column, format_cell);
+    }
+
+    // Text of a cell, which has to be cached
+    std::string_view get_cell_text(int64_t row, int64_t column)const
+    {
+        return cell_cache_.get_cell_text(row, column);
+    }
+
+
+
+    bool is_editing(int64_t row, int64_t column)const
+    {
+        return row == edited_row_ && column == edited_column_;
+    }
+
+    void start_editing(int64_t row, int64_t column, std::string_view text)
+    {
+        edited_row_ = row;
+        edited_column_ = column;
+
+        const std::size_t length = std::min(text.size(), edit_buffer_.size() - 1);
+        std::memcpy(edit_buffer_.data(), text.data(), length);
+        edit_buffer_[length] = '\0';
+
+        should_focus_edit_buffer_ = true;
+    }
+
+    void stop_editing()
+    {
+        edited_row_ = -1;
+        edited_column_ = -1;
+    }
+
+    char* get_edit_buffer() { return edit_buffer_.data(); }
+    std::size_t get_edit_buffer_size()const { return edit_buffer_.size(); }
+
+    // True once after start_editing(), to give the input the keyboard focus
+    bool should_focus_edit_buffer()
+    {
+        return std::exchange(should_focus_edit_buffer_, false);
+    }
+
+
+
+private:
+
+    TableCellCache cell_cache_;
+
+    int64_t edited_row_ = -1;
+    int64_t edited_column_ = -1;
+    std::array<char, 256> edit_buffer_{};
+    bool should_focus_edit_buffer_ = false;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Function used to draw a cached cell, or the input of the cell being edited.
+ *
+ * Double clicking an editable cell starts editing it.
+ *
+ * @return true If an edit was entered, its text is then in the edit buffer of the table state.
+ */
+//-------------------------------------------------------------------
+inline bool draw_table_cell(MatrixTableState& table_state, int64_t row, int64_t column, bool is_editable)
+{
+    if(table_state.is_editing(row, column))
+    {
+        ImGui::PushItemWidth(60);
+        ImGui::PushID(int(row));
+        ImGui::PushID(int(column));
+
+        if(table_state.should_focus_edit_buffer())
+            ImGui::SetKeyboardFocusHere();
+
+        const bool was_edit_entered = ImGui::InputText("##edit", table_state.get_edit_buffer(), table_state.get_edit_buffer_size(), ImGuiInputTextFlags_EnterReturnsTrue);
+
+        if(was_edit_entered || ImGui::IsItemDeactivated())
+            table_state.stop_editing();
+
+        ImGui::PopID();
+        ImGui::PopID();
+        ImGui::PopItemWidth();
+
+        return was_edit_entered;
+    }
+
+    std::string_view text = table_state.get_cell_text(row, column);
+    ImGui::TextUnformatted(text.data(), text.data() + text.size());
+
+    if(is_editable && ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(0))
+        table_state.start_editing(row, column, text);
+
+    return false;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Function used to draw the pages and rows of a table of values.
+ *
+ * @param data Identifies the values shown (see MatrixTableState::cache_cells).
+ * @param get_value Called as get_value(row, column), in row-major order over
+ *                  the cells being cached, to get the values to format.
+ * @param set_value Called as set_value(row, column, value) when an edit is entered.
+ * @return true If any entry was edited.
+ */
+//-------------------------------------------------------------------
+template<typename GetValue, typename SetValue>
+
+inline bool draw_matrix_values_table(const void* data,
+                                     int64_t number_of_rows,
+                                     int64_t number_of_columns,
+                                     MatrixTableState& table_state,
+                                     const ImVec2& table_size,
+                                     bool are_entries_editable,
+                                     GetValue get_value,
+                                     SetValue set_value)
+{
+    bool were_entries_edited = false; // Track if any entries were edited
+
+    if(number_of_rows <= 0 || number_of_columns <= 0)
+        return false;
+
+    ImGui::BeginGroup();
+    {
+        // The first column of the table shows the row indices
+        const int64_t number_of_columns_per_page = std::min(number_of_columns, int64_t(IMGUI_TABLE_MAX_COLUMNS - 3));
+        const int max_number_of_pages = int((number_of_columns - 1) / number_of_columns_per_page);
+
+        // Page control if the table has multiple pages
+        if(max_number_of_pages > 0)
+        {
+            ImGui::SliderInt("", &table_state.page_index, 0, max_number_of_pages);
+            ImGui::SameLine();
+            ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "page: %i of %i", table_state.page_index, max_number_of_pages);
+        }
+        else
+        {
+            table_state.page_index = 0; // Reset to first page if only one page
+        }
+
+        table_state.page_index = std::clamp(table_state.page_index, 0, max_number_of_pages);
+
+        const int64_t first_data_column = table_state.page_index * number_of_columns_per_page;
+        const int64_t number_of_table_columns = std::min(number_of_columns_per_page, number_of_columns - first_data_column) + 1;
+
+        auto format_cell = [&get_value, first_data_column](int64_t row, int64_t column, std::string& text)
+        {
+            char buffer[400];
+            int length = 0;
+
+            if(row == 0 && column > 0)
+                length = std::snprintf(buffer, sizeof(buffer), "col: %lli", (long long)(first_data_column + column - 1));
+            else if(row > 0 && column == 0)
+                length = std::snprintf(buffer, sizeof(buffer), "row: %lli", (long long)(row - 1));
+            else if(row > 0)
+                length = std::snprintf(buffer, sizeof(buffer), "%lf", get_value(row - 1, first_data_column + column - 1));
+
+            text.append(buffer, std::clamp(length, 0, int(sizeof(buffer)) - 1));
+        };
+
+        // Begin the table
+        if(ImGui::BeginTable("Data", int(number_of_table_columns), ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollX | ImGuiTableFlags_ScrollY, table_size))
+        {
+            ImGui::TableSetupScrollFreeze(1, 1); // Freeze the first row and column
+
+            // Use the vertical clipper for large tables
+            ImGuiListClipper clipper;
+            clipper.Begin(int(number_of_rows + 1), table_state.row_height);
+
+            while(clipper.Step())
+            {
+                table_state.cache_cells(data,
+                                        number_of_rows + 1,
+                                        clipper.DisplayStart,
+                                        clipper.DisplayEnd,
+                                        0,
+                                        number_of_table_columns,
+                                        format_cell);
+
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+                {
+                    ImGui::TableNextRow();
+
+                    for(int column = 0; column < number_of_table_columns; ++column)
+                    {
+                        if(ImGui::TableNextColumn())
+                        {
+                            if(row == 0 || column == 0)
+                            {
+                                std::string_view text = table_state.get_cell_text(row, column);
+
+                                ImGui::PushStyleColor(ImGuiCol_Text, (row == 0) ? ImVec4(1.0, 1.0, 0.0, 1.0) : ImVec4(0.0, 1.0, 1.0, 1.0));
+                                ImGui::TextUnformatted(text.data(), text.data() + text.size());
+                                ImGui::PopStyleColor();
+                            }
+                            else if(draw_table_cell(table_state, row, column, are_entries_editable))
+                            {
+                                char* end = nullptr;
+                                const double value = std::strtod(table_state.get_edit_buffer(), &end);
+
+                                if(end != table_state.get_edit_buffer())
+                                {
+                                    set_value(row - 1, first_data_column + column - 1, value);
+                                    table_state.invalidate();
+                                    were_entries_edited = true;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+
+            table_state.row_height = clipper.ItemsHeight;
+            clipper.End();
+            ImGui::EndTable();
+        }
+    }
+
+    ImGui::EndGroup();
+
+    return were_entries_edited;
+}
+//-------------------------------------------------------------------
+
+
+
 //-------------------------------------------------------------------
 /**
  * @brief Function for drawing an ImGui table showing the values of a matrix.
  * 
  * This function creates a table in the ImGui context to display the contents
  * of a given matrix. It supports pagination for large matrices and editable
- * entries if enabled.
+ * entries if enabled (double click a value to edit it).
  * 
  * @param matrix_data The matrix data to be displayed in the table.
- * @param page_index The current page index for displaying the matrix.
+ * @param table_state The page shown and the cells cached between frames.
  * @param table_size The size of the table to be drawn.
  * @param are_entries_editable Flag to determine if the matrix entries are editable.
  * @return true If any matrix entry was edited.
  * @return false If no matrix entries were edited.
  */
 //-------------------------------------------------------------------
-inline bool draw_matrix_table(MatrixType& matrix_data, int& page_index, const ImVec2& table_size, bool are_entries_editable)
+inline bool draw_matrix_table(MatrixType& matrix_data, MatrixTableState& table_state, const ImVec2& table_size, bool are_entries_editable)
 {
-    bool were_entries_edited = false; // Track if any entries were edited
-
     // Display matrix overall information
     ImGui::BeginGroup();
     {
@@ -58,83 +348,110 @@ inline bool draw_matrix_table(MatrixType& matrix_data, int& page_index, const Im
     ImGui::EndGroup();
 
     // Draw the matrix table if it contains data
-    if(matrix_data.size() > 0)
-    {
-        ImGui::BeginGroup();
-        {
-            const int number_of_visible_columns = std::min(matrix_data.columns(), uintptr_t(IMGUI_TABLE_MAX_COLUMNS - 3)) + 1;
-            const int max_number_of_pages = matrix_data.columns() / number_of_visible_columns;
+    if(matrix_data.size() == 0)
+        return false;
+
+    return draw_matrix_values_table(&matrix_data(0,0),
+                                    int64_t(matrix_data.rows()),
+                                    int64_t(matrix_data.columns()),
+                                    table_state,
+                                    table_size,
+                                    are_entries_editable,
+                                    [&matrix_data](int64_t row, int64_t column){ return matrix_data(row, column); },
+                                    [&matrix_data](int64_t row, int64_t column, double value){ matrix_data(row, column) = value; });
+}
+//-------------------------------------------------------------------
 
-            // Page control if the table has multiple pages
-            if(max_number_of_pages > 0)
-            {
-                ImGui::SliderInt("", &page_index, 0, max_number_of_pages);
-                ImGui::SameLine();
-                ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "page: %i of %i", page_index, max_number_of_pages);
-            }
-            else
-            {
-                page_index = 0; // Reset to first page if only one page
-            }
 
-            // Begin the table
-            if(ImGui::BeginTable("Data", number_of_visible_columns + 1, ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollX | ImGuiTableFlags_ScrollY, table_size))
-            {
-                ImGui::TableSetupScrollFreeze(1, 1); // Freeze the first row and column
 
-                // Use the vertical clipper for large tables
-                ImGuiListClipper clipper;
-                clipper.Begin(matrix_data.rows() + 1);
+//-------------------------------------------------------------------
+/**
+ * @brief Function for drawing a table of a deferred, attached or generated matrix.
+ *
+ * Only the cells being cached are evaluated from the chain, a row
+ * segment at a time, so the matrix is neither materialized nor copied.
+ *
+ * @param data Identifies the matrix shown (for example its DeferredMatrix),
+ *             the owner of the table calls invalidate() when its values change.
+ * @param set_value Called as set_value(row, column, value) when an edit is entered,
+ *                  the chain is still read afterwards while the table is drawn.
+ * @return true If any entry was edited.
+ */
+//-------------------------------------------------------------------
+template<typename SetValue>
+
+inline bool draw_matrix_table(const Compute::ElementwiseChain& chain,
+                              const void* data,
+                              MatrixTableState& table_state,
+                              const ImVec2& table_size,
+                              bool are_entries_editable,
+                              SetValue set_value)
+{
+    ImGui::BeginGroup();
+    {
+        ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "Matrix size:");
+        ImGui::SameLine();
+        ImGui::Text(are_entries_editable ? "(%lldx%lld)" : "(%lldx%lld) read only", (long long)chain.rows(), (long long)chain.columns());
 
-                while(clipper.Step())
-                {
-                    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
-                    {
-                        ImGui::TableNextRow();
+        ImGui::Dummy(ImVec2(0, 15));
+    }
+    ImGui::EndGroup();
 
-                        for(int column = 0, actual_column = page_index * (number_of_visible_columns - 1);
-                            column < number_of_visible_columns && actual_column < matrix_data.columns();
-                            ++column, ++actual_column)
-                        {
-                            if(ImGui::TableNextColumn())
-                            {
-                                if(row == 0 && column == 0)
-                                    ImGui::Text("");
-                                else if(row == 0)
-                                    ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "col: %i", actual_column);
-                                else if(column == 0)
-                                    ImGui::TextColored(ImVec4(0.0, 1.0, 1.0, 1.0), "row: %i", row - 1);
-                                else if(are_entries_editable)
-                                {
-                                    ImGui::PushItemWidth(60);
-                                    ImGui::PushID(row * matrix_data.columns() + actual_column);
-                                    if(ImGui::InputDouble("",&matrix_data(row - 1, actual_column), 0.0, 0.0, "%lf", ImGuiInputTextFlags_EnterReturnsTrue))
-                                        were_entries_edited = true;
-                                    if(ImGui::IsItemHovered())
-                                    {
-                                        ImGui::BeginTooltip();
-                                        ImGui::Text("%lf", matrix_data(row - 1, actual_column));
-                                        ImGui::EndTooltip();
-                                    }
-                                    ImGui::PopID();
-                                    ImGui::PopItemWidth();
-                                }
-                                else
-                                    ImGui::Text("%lf", matrix_data(row - 1, actual_column));
-                            }
-                        }
-                    }
-                }
+    // Values of the row segment last evaluated
+    std::vector<double> segment;
+    int64_t segment_row = -1;
+    int64_t segment_first_column = 0;
 
-                clipper.End();
-                ImGui::EndTable();
-            }
+    auto get_value = [&](int64_t row, int64_t column)
+    {
+        if(row != segment_row || column < segment_first_column || column >= segment_first_column + int64_t(segment.size()))
+        {
+            const int64_t last_column = std::min(chain.columns(), column + int64_t(IMGUI_TABLE_MAX_COLUMNS));
+
+            segment.resize(last_column - column);
+            chain.evaluate_row_segment(row, column, last_column, segment.data());
+
+            segment_row = row;
+            segment_first_column = column;
         }
 
-        ImGui::EndGroup();
-    }
+        return segment[column - segment_first_column];
+    };
+
+    return draw_matrix_values_table(data,
+                                    chain.rows(),
+                                    chain.columns(),
+                                    table_state,
+                                    table_size,
+                                    are_entries_editable,
+                                    get_value,
+                                    set_value);
+}
 
-    return were_entries_edited;
+inline void draw_matrix_table(const Compute::ElementwiseChain& chain, const void* data, MatrixTableState& table_state, const ImVec2& table_size)
+{
+    draw_matrix_table(chain, data, table_state, table_size, false, [](int64_t, int64_t, double){});
+}
+
+template<typename SetValue>
+
+inline bool draw_matrix_table(const Compute::MatrixView& view,
+                              MatrixTableState& table_state,
+                              const ImVec2& table_size,
+                              bool are_entries_editable,
+                              SetValue set_value)
+{
+    return draw_matrix_table(Compute::ElementwiseChain(view),
+                             view.size() > 0 ? view.row_pointer(0) : nullptr,
+                             table_state,
+                             table_size,
+                             are_entries_editable,
+                             set_value);
+}
+
+inline void draw_matrix_table(const Compute::MatrixView& view, MatrixTableState& table_state, const ImVec2& table_size)
+{
+    draw_matrix_table(view, table_state, table_size, false, [](int64_t, int64_t, double){});
 }
 //-------------------------------------------------------------------
 
@@ -145,7 +462,7 @@ inline bool draw_matrix_table(MatrixType& matrix_data, int& page_index, const Im
  * Draws an ImGui table for a CSVMatrix, allowing text display and editing with constraints.
  *
  * @param matrix_data Reference to the CSVMatrix.
- * @param page_index Current page index for displaying the matrix.
+ * @param table_state The page shown and the cells cached between frames.
  * @param table_size Size of the ImGui table.
  * @param are_entries_editable Whether the matrix entries are editable.
  * @return true If any matrix entry was edited, false otherwise.
@@ -154,7 +471,7 @@ inline bool draw_matrix_table(MatrixType& matrix_data, int& page_index, const Im
 template<typename DataType>
 
 inline bool draw_matrix_text_table(LazyMatrix::CSVMatrix<DataType>& matrix_data, 
-                                   int& page_index, 
+                                   MatrixTableState& table_state, 
                                    const ImVec2& table_size, 
                                    bool are_entries_editable,
                                    bool has_column_headers,
@@ -171,15 +488,34 @@ inline bool draw_matrix_text_table(LazyMatrix::CSVMatrix<DataType>& matrix_data,
 
             if(max_number_of_pages > 0)
             {
-                ImGui::SliderInt("Page", &page_index, 0, max_number_of_pages);
+                ImGui::SliderInt("Page", &table_state.page_index, 0, max_number_of_pages);
                 ImGui::SameLine();
-                ImGui::Text("Page: %i of %i", page_index, max_number_of_pages);
+                ImGui::Text("Page: %i of %i", table_state.page_index, max_number_of_pages);
             }
             else
             {
-                page_index = 0;
+                table_state.page_index = 0;
             }
 
+            // Headers take a row and a column of the table
+            const int64_t number_of_table_rows = int64_t(matrix_data.rows()) + (has_column_headers ? 1 : 0);
+            const int64_t number_of_table_columns = int64_t(matrix_data.columns()) + (has_row_headers ? 1 : 0);
+
+            const int64_t first_column = int64_t(table_state.page_index) * (number_of_visible_columns - 1);
+            const int64_t last_column = std::min(number_of_table_columns, first_column + number_of_visible_columns);
+
+            auto format_cell = [&matrix_data, has_column_headers, has_row_headers](int64_t row, int64_t column, std::string& text)
+            {
+                if(row == 0 && column == 0 && (has_column_headers || has_row_headers))
+                    return; // Top-left corner cell
+                else if(row == 0 && has_column_headers)
+                    text += matrix_data.get_column_header(column - (has_row_headers ? 1 : 0));
+                else if(column == 0 && has_row_headers)
+                    text += matrix_data.get_row_header(row - (has_column_headers ? 1 : 0));
+                else
+                    text += matrix_data.string_at(row - (has_column_headers ? 1 : 0), column - (has_row_headers ? 1 : 0));
+            };
+
             if(ImGui::BeginTable("Matrix Data", number_of_visible_columns + 1, ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollX | ImGuiTableFlags_ScrollY, table_size))
             {
                 // Adjust scroll freeze based on header presence
@@ -194,72 +530,47 @@ inline bool draw_matrix_text_table(LazyMatrix::CSVMatrix<DataType>& matrix_data,
                 }
 
                 ImGuiListClipper clipper;
-                clipper.Begin(matrix_data.rows() + 1);
+                clipper.Begin(int(number_of_table_rows), table_state.row_height);
 
                 while(clipper.Step())
                 {
+                    table_state.cache_cells(&matrix_data,
+                                            number_of_table_rows,
+                                            clipper.DisplayStart,
+                                            clipper.DisplayEnd,
+                                            first_column,
+                                            last_column,
+                                            format_cell);
+
                     for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
                     {
                         ImGui::TableNextRow();
 
-                        for(int column = 0, actual_column = page_index * (number_of_visible_columns - 1);
-                            column < number_of_visible_columns && actual_column < matrix_data.columns();
-                            ++column, ++actual_column)
+                        for(int64_t column = first_column; column < last_column; ++column)
                         {
                             if(ImGui::TableNextColumn())
                             {
-                                if(row == 0 && column == 0 && (has_column_headers || has_row_headers)) 
-                                {
-                                    ImGui::Text(""); // Top-left corner cell
-                                }
-                                else if(row == 0 && has_column_headers) 
-                                {
-                                    ImGui::Text("%s", matrix_data.get_column_header(actual_column).c_str());
-                                }
-                                else if(column == 0 && has_row_headers) 
-                                {
-                                    ImGui::Text("%s", matrix_data.get_row_header(row - 1).c_str());
-                                }
-                                else
+                                const bool is_header = (row == 0 && has_column_headers) || (column == 0 && has_row_headers);
+
+                                if(draw_table_cell(table_state, row, column, are_entries_editable && !is_header))
                                 {
-                                    int cell_row = row - (has_column_headers ? 1 : 0);
-                                    int cell_column = actual_column - (has_row_headers ? 1 : 0);
-
-                                    // Cell editing
-                                    std::string_view currentContent = matrix_data.string_at(cell_row, cell_column);
-                                    std::string buffer(currentContent.data(), currentContent.size());
-                                    buffer.resize(currentContent.size() + 1, '\0'); // Resize buffer for null-termination
-                                    
-                                    ImGui::PushItemWidth(60);
-                                    ImGui::PushID(row * matrix_data.columns() + actual_column);
-                                    
-                                    if(are_entries_editable && ImGui::InputText("##edit", buffer.data(), buffer.size(), ImGuiInputTextFlags_EnterReturnsTrue))
+                                    // Update cell if new content is not larger than current
+                                    if(std::strlen(table_state.get_edit_buffer()) <= table_state.get_cell_text(row, column).size())
                                     {
-                                        std::string newContent(buffer);
-                                        if(newContent.length() <= currentContent.length())
-                                        {
-                                            // Update cell if new content is not larger than current
-                                            // matrix_data.set_cell_value_from_string(cell_row, cell_column, newContent);
-                                            were_entries_edited = true;
-                                        }
-                                        else
-                                        {
-                                            // Display warning: Input too long
-                                        }
+                                        // matrix_data.set_cell_value_from_string(cell_row, cell_column, newContent);
+                                        were_entries_edited = true;
                                     }
                                     else
                                     {
-                                        ImGui::Text("%.*s", static_cast<int>(currentContent.size()), currentContent.data());
+                                        // Display warning: Input too long
                                     }
-                                    
-                                    ImGui::PopID();
-                                    ImGui::PopItemWidth();
                                 }
                             }
                         }
                     }
                 }
 
+                table_state.row_height = clipper.ItemsHeight;
                 clipper.End();
                 ImGui::EndTable();
             }
@@ -35,6 +35,9 @@ public:
     void initialize_button_hovered_states()
     {
         this->is_button_hovered_[get_node_type_name<UnaryOperatorNode>()] = false;
+        this->is_button_hovered_[get_node_type_name<BinaryOperatorNode>()] = false;
+        this->is_button_hovered_[get_node_type_name<StatisticsNode>()] = false;
+        this->is_button_hovered_[get_node_type_name<FftNode>()] = false;
     }
 
 
@@ -49,6 +52,9 @@ public:
 
         // Load the textures used to draw the "add node" buttons
         unary_operator_texture_.loadFromFile(resources_path + std::string("unary_operator.png"));
+        binary_operator_texture_.loadFromFile(resources_path + std::string("binary_operator.png"));
+        statistics_texture_.loadFromFile(resources_path + std::string("unary_operator.png"));
+        fft_texture_.loadFromFile(resources_path + std::string("unary_operator.png"));
     }
 
 
@@ -61,6 +67,12 @@ public:
             ImGui::Separator();
             this->draw_button_to_add_node<UnaryOperatorNode>(unary_operator_texture_);
             ImGui::Separator();
+            this->draw_button_to_add_node<BinaryOperatorNode>(binary_operator_texture_);
+            ImGui::Separator();
+            this->draw_button_to_add_node<StatisticsNode>(statistics_texture_);
+            ImGui::Separator();
+            this->draw_button_to_add_node<FftNode>(fft_texture_);
+            ImGui::Separator();
         }
 
         if(ImGui::IsItemHovered())
@@ -78,6 +90,9 @@ private: // Private variables
 
     // All the button textures
     sf::Texture unary_operator_texture_;
+    sf::Texture binary_operator_texture_;
+    sf::Texture statistics_texture_;
+    sf::Texture fft_texture_;
 };
 //-------------------------------------------------------------------
 
@@ -36,7 +36,9 @@ public:
     {
         this->is_button_hovered_[get_node_type_name<MatrixSourceNode>()] = false;
         this->is_button_hovered_[get_node_type_name<ImageLoaderNode>()] = false;
+        this->is_button_hovered_[get_node_type_name<ImageSequenceNode>()] = false;
         this->is_button_hovered_[get_node_type_name<CsvLoaderNode>()] = false;
+        this->is_button_hovered_[get_node_type_name<BinaryLoaderNode>()] = false;
     }
 
 
@@ -52,7 +54,9 @@ public:
         // Load the textures used to draw the "add node" buttons
         matrix_source_texture_.loadFromFile(resources_path + std::string("matrix_source.png"));
         image_loader_texture_.loadFromFile(resources_path + std::string("load_image.png"));
+        image_sequence_texture_.loadFromFile(resources_path + std::string("load_image.png"));
         csv_loader_texture_.loadFromFile(resources_path + std::string("csv_file.png"));
+        binary_loader_texture_.loadFromFile(resources_path + std::string("csv_file.png"));
     }
 
 
@@ -69,9 +73,15 @@ public:
             this->draw_button_to_add_node<ImageLoaderNode>(image_loader_texture_);
             ImGui::Text("Load Image");
             ImGui::Separator();
+            this->draw_button_to_add_node<ImageSequenceNode>(image_sequence_texture_);
+            ImGui::Text("Load Image Sequence");
+            ImGui::Separator();
             this->draw_button_to_add_node<CsvLoaderNode>(csv_loader_texture_);
             ImGui::Text("Load csv file");
             ImGui::Separator();
+            this->draw_button_to_add_node<BinaryLoaderNode>(binary_loader_texture_);
+            ImGui::Text("Load binary file (raw/.npy)");
+            ImGui::Separator();
         }
 
         if(ImGui::IsItemHovered())
@@ -90,7 +100,9 @@ private: // Private variables
     // All the button textures
     sf::Texture matrix_source_texture_;
     sf::Texture image_loader_texture_;
+    sf::Texture image_sequence_texture_;
     sf::Texture csv_loader_texture_;
+    sf::Texture binary_loader_texture_;
 };
 //-------------------------------------------------------------------
 
@@ -4,7 +4,12 @@
 
 
 //-------------------------------------------------------------------
+#include <filesystem>
+#include <vector>
+
 #include <nlohmann/json.hpp>
+#include <compute/matrix_file.hpp>
+
 #include "pin.hpp"
 #include "node_styling.hpp"
 #include <app/imgui_helpers.hpp>
@@ -37,7 +42,13 @@ namespace DataFlow
  * - void draw_node_content()
  * - void draw_input_pins()
  * - void draw_output_pins()
+ * - void compute_internal()
+ * - Pin<MatrixType>* get_output_pin()
  * - void save_to_json_internal(const std::string& node_name, nlohmann::json* json_file)
+ * - void load_from_json_internal(const std::string& node_name, const nlohmann::json& json_file)
+ * 
+ * Computations must not depend on the drawing functions, so that a study
+ * can be run without a window (see BatchRunner).
  * 
  * @tparam NodeType The derived type that inherits from this class.
  */
@@ -80,6 +91,73 @@ public:
 
 
 
+    /**
+     * @brief Number of bytes held by the node's own results.
+     * 
+     * Nodes that only pass their input through (tables, heat maps)
+     * don't hold anything. Nodes that own results hide this function
+     * with their own version.
+     */
+    int64_t get_output_bytes()const { return 0; }
+
+    /**
+     * @brief The node's result that is cheap to recompute and can therefore
+     *        be evicted when memory is tight (nullptr if there is none).
+     * 
+     * Nodes that publish deferred results hide this function with their own version.
+     */
+    DeferredMatrix* get_evictable_output() { return nullptr; }
+
+    /**
+     * @brief The deferred matrix holding the node's own result, used to save
+     *        the result with a study and to attach it back when loading
+     *        (nullptr if the node doesn't own a result).
+     * 
+     * Nodes that own results hide this function with their own version.
+     */
+    DeferredMatrix* get_reattachable_output() { return nullptr; }
+
+    /**
+     * @brief The files a source node computes its result from, a saved
+     *        result is only attached back if they didn't change since.
+     * 
+     * Nodes that load files hide this function with their own version.
+     */
+    std::vector<std::filesystem::path> get_source_files()const { return {}; }
+
+    /**
+     * @brief Points the node's deferred matrices back at the node's own
+     *        matrices, after the node was copy constructed.
+     * 
+     * Nodes that own deferred matrices hide this function with their own version.
+     */
+    void rebind_deferred_matrices() {}
+
+
+
+    /**
+     * @brief Recomputes the node's results from its current inputs/settings
+     *        and pushes them through the node's output links.
+     * 
+     * Source nodes generate/load their data, all other nodes recompute
+     * from their inputs. The time spent is recorded in the NodeProfiler.
+     */
+    void compute()
+    {
+        NodeProfiler::ScopedTimer timer(id_);
+        underlying().compute_internal();
+    }
+
+    /**
+     * @brief The node's output pin (nullptr if the node has none).
+     */
+    Pin<MatrixType>* get_output_pin()
+    {
+        return underlying().get_output_pin();
+    }
+
+
+
     /**
      * @brief Find a pin in the node using its ID.
      * 
@@ -291,13 +369,147 @@ public:
         (*json_file)["nodes"][node_name]["x_pos"] = ImNodes::GetNodeGridSpacePos(id_).x;
         (*json_file)["nodes"][node_name]["y_pos"] = ImNodes::GetNodeGridSpacePos(id_).y;
 
+        (*json_file)["nodes"][node_name]["type name"] = get_node_type_name<NodeType>();
+
         underlying().save_to_json_internal(node_name, json_file);
     }
 
 
 
+    /**
+     * @brief Saves the node's result in a matrix file and records it in the JSON object.
+     * 
+     * @param study_directory Directory of the study's JSON file.
+     * @param results_directory Directory (relative to the study's directory)
+     *                          where the result files are stored.
+     * @param json_file The JSON object the study is being saved into.
+     */
+    void save_result(const std::filesystem::path& study_directory,
+                     const std::filesystem::path& results_directory,
+                     nlohmann::json* json_file)
+    {
+        DeferredMatrix* result = underlying().get_reattachable_output();
+        Pin<MatrixType>* output_pin = underlying().get_output_pin();
+
+        if(!result || !output_pin)
+            return;
+
+        std::string node_name = std::string("node ") + std::to_string(id_);
+        std::filesystem::path relative_filename = results_directory / (std::string("node_") + std::to_string(id_) + ".lzd");
+        std::filesystem::path filename = study_directory / relative_filename;
+
+        // A result that was attached from this very file is already saved
+        if(!result->is_attached() || result->get_storage().get_spill_filename() != filename)
+        {
+            if(!Compute::write_matrix_file(output_pin->get_view(), filename))
+                return;
+        }
+
+        Compute::MatrixFileFingerprint fingerprint = Compute::compute_matrix_file_fingerprint(filename);
+
+        (*json_file)["nodes"][node_name]["result file"]["filename"] = relative_filename.generic_string();
+        (*json_file)["nodes"][node_name]["result file"]["file size"] = fingerprint.file_size;
+        (*json_file)["nodes"][node_name]["result file"]["hash"] = fingerprint.hash;
+        (*json_file)["nodes"][node_name]["result file"]["source files"] = make_source_files_json();
+    }
+
+    /**
+     * @brief Attaches the result saved by save_result and publishes it through
+     *        the node's output pin, instead of recomputing it.
+     * 
+     * @param study_directory Directory of the study's JSON file.
+     * @param json_file The JSON object holding the saved study.
+     * @return false if there is no saved result, the file changed since it
+     *         was saved (different size or hash) or so did the files the node
+     *         loads its result from, in which case the node has to be computed.
+     */
+    bool reattach_result(const std::filesystem::path& study_directory, const nlohmann::json& json_file)
+    {
+        DeferredMatrix* result = underlying().get_reattachable_output();
+        Pin<MatrixType>* output_pin = underlying().get_output_pin();
+
+        std::string node_name = std::string("node ") + std::to_string(id_);
+
+        if(!result || !output_pin || !json_file["nodes"][node_name].contains("result file"))
+            return false;
+
+        const auto& result_file_json = json_file["nodes"][node_name]["result file"];
+
+        std::filesystem::path filename = study_directory / result_file_json.value("filename", std::string());
+
+        Compute::MatrixFileFingerprint saved_fingerprint;
+        saved_fingerprint.file_size = result_file_json.value("file size", uint64_t(0));
+        saved_fingerprint.hash = result_file_json.value("hash", uint64_t(0));
+
+        if(saved_fingerprint.file_size == 0 || Compute::compute_matrix_file_fingerprint(filename) != saved_fingerprint)
+            return false;
+
+        if(result_file_json.value("source files", nlohmann::json::array()) != make_source_files_json())
+            return false;
+
+        if(!result->attach(filename))
+            return false;
+
+        output_pin->update_data(result->get_matrix(), result);
+
+        return true;
+    }
+
+
+
+    /**
+     * @brief Restores the Node's state (ids, title and settings) from a JSON object.
+     * 
+     * Only the state is restored, the node's results are not computed, that
+     * is left to the caller once the links between the nodes are restored.
+     * 
+     * @param node_name Name of the node's entry in the JSON object ("node <id>").
+     * @param json_file The JSON object holding the saved study.
+     */
+    void load_from_json(const std::string& node_name, const nlohmann::json& json_file)
+    {
+        const auto& node_json = json_file["nodes"][node_name];
+
+        id_ = std::stoi(node_name.substr(node_name.find(' ') + 1));
+        this->set_title(node_json.value("title", std::string()));
+
+        underlying().load_from_json_internal(node_name, json_file);
+    }
+
+
+
 private:
 
+    /**
+     * @brief Describes the node's source files as they are now (path, size,
+     *        modification time and sampled hash, like a csv cache key).
+     */
+    nlohmann::json make_source_files_json()const
+    {
+        nlohmann::json source_files_json = nlohmann::json::array();
+
+        for(const auto& source_file : underlying().get_source_files())
+        {
+            std::error_code error;
+            const std::filesystem::path absolute_filename = std::filesystem::absolute(source_file, error);
+            const auto modification_time = std::filesystem::last_write_time(source_file, error);
+
+            const Compute::MatrixFileFingerprint fingerprint = Compute::compute_matrix_file_fingerprint(source_file);
+
+            nlohmann::json source_file_json;
+            source_file_json["filename"] = absolute_filename.generic_string();
+            source_file_json["file size"] = fingerprint.file_size;
+            source_file_json["modification time"] = error ? int64_t(0) : int64_t(modification_time.time_since_epoch().count());
+            source_file_json["hash"] = fingerprint.hash;
+
+            source_files_json.push_back(source_file_json);
+        }
+
+        return source_files_json;
+    }
+
+
+
     /**
      * @brief Construct a new node 
      * 
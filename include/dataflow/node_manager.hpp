@@ -6,8 +6,13 @@
 //-------------------------------------------------------------------
 #include <deque>
 #include <variant>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <unordered_map>
 
 #include "node.hpp"
+#include "link.hpp"
 
 #include "specialized_nodes/specialized_nodes.hpp"
 //-------------------------------------------------------------------
@@ -29,9 +34,14 @@ namespace DataFlow
 using NodeVariantType = std::variant<
                                      AugmentNode,
                                      UnaryOperatorNode,
+                                     BinaryOperatorNode,
+                                     StatisticsNode,
+                                     FftNode,
                                      MatrixSourceNode,
                                      ImageLoaderNode,
+                                     ImageSequenceNode,
                                      CsvLoaderNode,
+                                     BinaryLoaderNode,
                                      TableNode,
                                      PlotNode,
                                      HeatMapNode,
@@ -93,6 +103,105 @@ struct HandleNodeHovering
 
 
 
+struct GetNodeOutputBytes
+{
+    template<typename NodeType>
+
+    int64_t operator()(NodeType& node)
+    {
+        return node.get_output_bytes();
+    }
+};
+
+
+
+struct GetNodeEvictableOutput
+{
+    template<typename NodeType>
+
+    DeferredMatrix* operator()(NodeType& node)
+    {
+        return node.get_evictable_output();
+    }
+};
+
+
+
+struct RebindNodeDeferredMatrices
+{
+    template<typename NodeType>
+
+    void operator()(NodeType& node)
+    {
+        node.rebind_deferred_matrices();
+    }
+};
+
+
+
+struct ComputeNode
+{
+    template<typename NodeType>
+
+    void operator()(NodeType& node)
+    {
+        node.compute();
+    }
+};
+
+
+
+struct GetNodeOutputPin
+{
+    template<typename NodeType>
+
+    Pin<MatrixType>* operator()(NodeType& node)
+    {
+        return node.get_output_pin();
+    }
+};
+
+
+
+struct GetNodeTitle
+{
+    template<typename NodeType>
+
+    std::string operator()(NodeType& node)
+    {
+        return node.get_title().c_str();
+    }
+};
+
+
+
+struct SaveNodeResult
+{
+    template<typename NodeType>
+
+    void operator()(NodeType& node,
+                    const std::filesystem::path& study_directory,
+                    const std::filesystem::path& results_directory,
+                    nlohmann::json* json_file)
+    {
+        node.save_result(study_directory, results_directory, json_file);
+    }
+};
+
+
+
+struct ReattachNodeResult
+{
+    template<typename NodeType>
+
+    bool operator()(NodeType& node, const std::filesystem::path& study_directory, const nlohmann::json* json_file)
+    {
+        return node.reattach_result(study_directory, *json_file);
+    }
+};
+
+
+
 struct SaveNodeToJson
 {
     template<typename NodeType>
@@ -147,6 +256,33 @@ public:
 
 
 
+    // Constructs a node given its type name (see get_node_type_name)
+    // -- Returns nullptr if the type name is not a known node type
+    template<std::size_t VariantIndex = 0>
+
+    NodeVariantType* construct_and_add_node_using_type_name(const std::string& node_type_name,
+                                                            const std::function<void(Pin<MatrixType>*)>& pin_deleted_link_manager_callback)
+    {
+        if constexpr(VariantIndex < std::variant_size_v<NodeVariantType>)
+        {
+            using NodeType = std::variant_alternative_t<VariantIndex, NodeVariantType>;
+
+            if(get_node_type_name<NodeType>() == node_type_name)
+            {
+                construct_and_add_node<NodeType>(pin_deleted_link_manager_callback);
+                return &nodes_.back();
+            }
+
+            return construct_and_add_node_using_type_name<VariantIndex + 1>(node_type_name, pin_deleted_link_manager_callback);
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+
+
+
     void draw()
     {
         for(auto& node : nodes_)
@@ -164,6 +300,12 @@ public:
             if(std::visit(GetNodeID{}, *iter) == node_id)
             {
                 nodes_.erase(iter);
+
+                // The nodes after it may have been copy constructed
+                // into the places of the nodes before them
+                for(auto& node : nodes_)
+                    std::visit(RebindNodeDeferredMatrices(), node);
+
                 return;
             }
         }
@@ -171,6 +313,13 @@ public:
 
 
 
+    void remove_all_nodes()
+    {
+        nodes_.clear();
+    }
+
+
+
     void handle_hovering()
     {
         int hovered_node_id = 0;
@@ -209,17 +358,224 @@ public:
     nlohmann::json* save_to_json(nlohmann::json* json_file)
     {
         (*json_file)["nodes"]["number_of_nodes"] = nodes_.size();
+        (*json_file)["nodes"]["node IDs"] = get_node_ids();
+
+        for(auto& node : nodes_)
+            std::visit(SaveNodeToJson{}, node, std::variant<nlohmann::json*>(json_file));
 
+        return json_file;
+    }
+
+
+
+    // Restores the nodes saved by save_to_json (their ids, titles and
+    // settings), the nodes' results are not computed
+    // -- Returns false if some of the nodes could not be restored
+    bool load_from_json(const nlohmann::json& json_file,
+                        const std::function<void(Pin<MatrixType>*)>& pin_deleted_link_manager_callback)
+    {
+        if(!json_file.contains("nodes"))
+            return false;
+
+        bool were_all_nodes_loaded = true;
+
+        for(int node_id : json_file["nodes"].value("node IDs", std::vector<int>()))
+        {
+            std::string node_name = std::string("node ") + std::to_string(node_id);
+
+            if(!json_file["nodes"].contains(node_name))
+            {
+                were_all_nodes_loaded = false;
+                continue;
+            }
+
+            NodeVariantType* node = construct_and_add_node_using_type_name(json_file["nodes"][node_name].value("type name", std::string()),
+                                                                           pin_deleted_link_manager_callback);
+
+            if(!node)
+            {
+                were_all_nodes_loaded = false;
+                continue;
+            }
+
+            std::visit([&](auto& loaded_node){ loaded_node.load_from_json(node_name, json_file); }, *node);
+        }
+
+        return were_all_nodes_loaded;
+    }
+
+
+
+    // Saves the results of the nodes into matrix files in the
+    // results directory (relative to the study's directory)
+    // -- Returns false if the results directory couldn't be created
+    bool save_results(const std::filesystem::path& study_directory,
+                      const std::filesystem::path& results_directory,
+                      nlohmann::json* json_file)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(study_directory / results_directory, error);
+
+        if(error)
+            return false;
+
+        for(auto& node : nodes_)
+            std::visit(SaveNodeResult{},
+                       node,
+                       std::variant<std::filesystem::path>(study_directory),
+                       std::variant<std::filesystem::path>(results_directory),
+                       std::variant<nlohmann::json*>(json_file));
+
+        return true;
+    }
+
+
+
+    // Restores the results of all the nodes once the nodes and links
+    // are loaded, in order from the data sources downstream
+    // -- Results saved in matrix files that are still valid are
+    //    attached back, only the other nodes are computed
+    // -- Input pins don't notify their nodes while this happens,
+    //    so a node is never computed more than once
+    void restore_results(const std::filesystem::path& study_directory, const nlohmann::json& json_file)
+    {
+        PinNotifications::ScopedSuspension suspension;
+
+        for(int node_id : get_node_ids_in_topological_order())
+        {
+            NodeVariantType* node = find_node_using_id(node_id);
+
+            bool was_result_reattached = std::visit(ReattachNodeResult{},
+                                                    *node,
+                                                    std::variant<std::filesystem::path>(study_directory),
+                                                    std::variant<const nlohmann::json*>(&json_file));
+
+            if(!was_result_reattached)
+                std::visit(ComputeNode{}, *node);
+        }
+    }
+
+
+
+    // Node IDs ordered so that every node comes after
+    // the nodes linked to its input pins
+    std::vector<int> get_node_ids_in_topological_order()
+    {
+        std::unordered_map<int, std::vector<int>> downstream_node_ids;
+        std::unordered_map<int, int> number_of_upstream_nodes;
+
+        for(auto& node : nodes_)
+        {
+            int node_id = std::visit(GetNodeID{}, node);
+            number_of_upstream_nodes[node_id];
+
+            Pin<MatrixType>* output_pin = std::visit(GetNodeOutputPin{}, node);
+
+            if(!output_pin)
+                continue;
+
+            for(auto& link : output_pin->get_output_links())
+            {
+                int downstream_node_id = link->get_input_pin()->get_parent_node_id();
+
+                downstream_node_ids[node_id].push_back(downstream_node_id);
+                ++number_of_upstream_nodes[downstream_node_id];
+            }
+        }
+
+        std::vector<int> ordered_node_ids;
+
+        for(int node_id : get_node_ids())
+        {
+            if(number_of_upstream_nodes[node_id] == 0)
+                ordered_node_ids.push_back(node_id);
+        }
+
+        for(std::size_t i = 0; i < ordered_node_ids.size(); ++i)
+        {
+            for(int downstream_node_id : downstream_node_ids[ordered_node_ids[i]])
+            {
+                if(--number_of_upstream_nodes[downstream_node_id] == 0)
+                    ordered_node_ids.push_back(downstream_node_id);
+            }
+        }
+
+        return ordered_node_ids;
+    }
+
+
+
+    std::vector<int> get_node_ids()
+    {
         std::vector<int> node_ids;
+
         for(auto& node : nodes_)
             node_ids.push_back(std::visit(GetNodeID{}, node));
 
-        (*json_file)["nodes"]["node IDs"] = node_ids;
+        return node_ids;
+    }
 
+    NodeVariantType* find_node_using_id(int node_id)
+    {
         for(auto& node : nodes_)
-            std::visit(SaveNodeToJson{}, node, std::variant<nlohmann::json*>(json_file));
+        {
+            if(std::visit(GetNodeID{}, node) == node_id)
+                return &node;
+        }
 
-        return json_file;
+        return nullptr;
+    }
+
+
+
+    // Total number of bytes held by the results of all the nodes
+    int64_t get_output_bytes()
+    {
+        int64_t number_of_bytes = 0;
+
+        for(auto& node : nodes_)
+            number_of_bytes += std::visit(GetNodeOutputBytes{}, node);
+
+        return number_of_bytes;
+    }
+
+
+
+    // Function used to evict the least recently viewed results that
+    // are cheap to recompute, until the results fit in the budget
+    // -- Results viewed after "protected_since" (for example during
+    //    the current frame) are not evicted, so that we don't end up
+    //    recomputing them over and over again
+    void enforce_memory_budget(int64_t budget_in_bytes, std::chrono::steady_clock::time_point protected_since)
+    {
+        int64_t number_of_bytes = get_output_bytes();
+
+        if(number_of_bytes <= budget_in_bytes)
+            return;
+
+        std::vector<DeferredMatrix*> evictable_outputs;
+
+        for(auto& node : nodes_)
+        {
+            DeferredMatrix* output = std::visit(GetNodeEvictableOutput{}, node);
+
+            if(output && output->is_evictable() && output->get_number_of_bytes() > 0 && output->get_last_access_time() < protected_since)
+                evictable_outputs.push_back(output);
+        }
+
+        std::sort(evictable_outputs.begin(), evictable_outputs.end(), [](DeferredMatrix* a, DeferredMatrix* b)
+        {
+            return a->get_last_access_time() < b->get_last_access_time();
+        });
+
+        for(auto& output : evictable_outputs)
+        {
+            if(number_of_bytes <= budget_in_bytes)
+                break;
+
+            number_of_bytes -= output->get_number_of_bytes();
+            output->evict();
+        }
     }
 
 
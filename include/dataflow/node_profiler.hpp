@@ -0,0 +1,119 @@
+#ifndef INCLUDE_NODE_PROFILER_HPP_
+#define INCLUDE_NODE_PROFILER_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Define every thing within the namespace DataFlow
+//-------------------------------------------------------------------
+namespace DataFlow
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Class used to measure how long each node spends computing
+// -- Computations are pushed through links, so computing one node
+//   usually computes all the nodes downstream of it as well
+// -- Timers are kept in a stack so that the time spent in a nested
+//    (downstream) node is subtracted from the node that triggered
+//    it, giving each node its "exclusive" time
+//-------------------------------------------------------------------
+class NodeProfiler
+{
+public:
+
+    struct NodeTiming
+    {
+        int64_t number_of_computations = 0;
+        std::chrono::duration<double> exclusive_time = std::chrono::duration<double>(0);
+    };
+
+
+
+    // Times the scope it lives in and attributes it to a node
+    class ScopedTimer
+    {
+    public:
+
+        ScopedTimer(int node_id)
+        {
+            get_stack().push_back({node_id, std::chrono::steady_clock::now(), std::chrono::duration<double>(0)});
+        }
+
+        ~ScopedTimer()
+        {
+            auto& stack = get_stack();
+
+            auto frame = stack.back();
+            stack.pop_back();
+
+            std::chrono::duration<double> elapsed_time = std::chrono::steady_clock::now() - frame.start_time;
+
+            auto& timing = get_timings_instance()[frame.node_id];
+            timing.number_of_computations += 1;
+            timing.exclusive_time += elapsed_time - frame.time_spent_in_nested_nodes;
+
+            if(!stack.empty())
+                stack.back().time_spent_in_nested_nodes += elapsed_time;
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+    };
+
+
+
+    static const std::unordered_map<int, NodeTiming>& get_timings()
+    {
+        return get_timings_instance();
+    }
+
+    static void reset()
+    {
+        get_timings_instance().clear();
+    }
+
+
+
+private:
+
+    struct Frame
+    {
+        int node_id;
+        std::chrono::steady_clock::time_point start_time;
+        std::chrono::duration<double> time_spent_in_nested_nodes;
+    };
+
+    static std::vector<Frame>& get_stack()
+    {
+        thread_local std::vector<Frame> stack;
+        return stack;
+    }
+
+    static std::unordered_map<int, NodeTiming>& get_timings_instance()
+    {
+        thread_local std::unordered_map<int, NodeTiming> timings;
+        return timings;
+    }
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace DataFlow
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_NODE_PROFILER_HPP_
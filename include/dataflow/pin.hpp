@@ -9,6 +9,8 @@
 #include <memory>
 
 #include "constants_and_defaults.hpp"
+#include "deferred_matrix.hpp"
+#include "node_profiler.hpp"
 #include <app/toggle_button.hpp>
 //-------------------------------------------------------------------
 
@@ -21,6 +23,41 @@ namespace DataFlow
 
 
 
+//-------------------------------------------------------------------
+/**
+ * @brief Used to stop input pins from notifying their nodes.
+ * 
+ * While a study is restored, data is handed to the input pins without
+ * the nodes recomputing anything, the study decides which nodes have
+ * to be computed once everything is connected.
+ */
+//-------------------------------------------------------------------
+class PinNotifications
+{
+public:
+
+    // Suspends the notifications for as long as it lives
+    class ScopedSuspension
+    {
+    public:
+
+        ScopedSuspension() { ++suspension_count_; }
+        ~ScopedSuspension() { --suspension_count_; }
+
+        ScopedSuspension(const ScopedSuspension&) = delete;
+        ScopedSuspension& operator=(const ScopedSuspension&) = delete;
+    };
+
+    static bool are_suspended() { return suspension_count_ > 0; }
+
+private:
+
+    static inline int suspension_count_ = 0;
+};
+//-------------------------------------------------------------------
+
+
+
 //-------------------------------------------------------------------
 /**
  * @brief Represents a Pin in a data flow node editor.
@@ -42,7 +79,6 @@ public:
      */
     Pin()
     {
-        this->initialize_toggle_button();
         output_links_.reserve(10);
     }
 
@@ -102,25 +138,79 @@ public:
      * @brief Update the data associated with this pin and notify connected nodes.
      * 
      * @param data New data to associate with this pin.
+     * @param deferred_matrix If not null, the data has not been computed yet and
+     *                        will be materialized on the first call to get_data().
      */
-    void update_data(DataType* data)
+    void update_data(DataType* data, DeferredMatrix* deferred_matrix = nullptr)
     {
         data_ = data;
-        if (pin_type_ == PinType::Input && notify_parent_node_callback_)
+        deferred_matrix_ = data ? deferred_matrix : nullptr;
+
+        if (pin_type_ == PinType::Input)
         {
-            notify_parent_node_callback_();
+            if (notify_parent_node_callback_ && !PinNotifications::are_suspended())
+            {
+                NodeProfiler::ScopedTimer timer(parent_node_id_);
+                notify_parent_node_callback_();
+            }
         }
         else
         {
             for (auto& link : output_links_)
             {
-                link->output_pin_updated_data(data_);
+                link->output_pin_updated_data(data_, deferred_matrix_);
             }
         }
     }
 
-    DataType* get_data() { return data_; }
+    /**
+     * @brief Get the data, computing it first if it was deferred.
+     */
+    DataType* get_data()
+    {
+        if (deferred_matrix_)
+            deferred_matrix_->materialize();
+
+        return data_;
+    }
+
+    /**
+     * @brief Get a read-only view of the data.
+     *
+     * Deferred data is computed into its RAM/scratch storage instead of
+     * a LazyMatrix, so prefer this over get_data() when only reading.
+     */
+    Compute::MatrixView get_view()
+    {
+        if (deferred_matrix_)
+            return deferred_matrix_->get_view();
+
+        return data_ ? make_matrix_view(*data_) : Compute::MatrixView();
+    }
+
+    /**
+     * @brief Get the data pointer without computing deferred data.
+     */
+    DataType* get_data_pointer() const { return data_; }
+    DeferredMatrix* get_deferred_matrix() const { return deferred_matrix_; }
+
+    int64_t get_number_of_rows() const
+    {
+        if (deferred_matrix_)
+            return deferred_matrix_->rows();
+
+        return data_ ? data_->rows() : 0;
+    }
 
+    int64_t get_number_of_columns() const
+    {
+        if (deferred_matrix_)
+            return deferred_matrix_->columns();
+
+        return data_ ? data_->columns() : 0;
+    }
+
+    const std::vector<Link<DataType>*>& get_output_links() const { return output_links_; }
     void add_output_link(Link<DataType>* output_link) { output_links_.push_back(output_link); }
     void set_input_link(Link<DataType>* input_link) { input_link_ = input_link; }
     void remove_input_link() { input_link_ = nullptr; update_data(nullptr); }
@@ -147,10 +237,7 @@ public:
         {
             ImNodes::BeginInputAttribute(id_, pick_pin_shape<DataType>(is_connected()));
 
-            if(data_)
-                ImGui::TextColored(ImVec4(1.0,1.0,0.0,1.0), "(%ix%i)", data_->rows(), data_->columns());
-            else
-                ImGui::TextColored(ImVec4(1.0,1.0,0.0,1.0), "(%ix%i)", 0, 0);
+            ImGui::TextColored(ImVec4(1.0,1.0,0.0,1.0), "(%ix%i)", int(get_number_of_rows()), int(get_number_of_columns()));
             
             ImNodes::EndInputAttribute();
         }
@@ -163,12 +250,17 @@ public:
             if(data_)
             {
                 pin_data_size = "(";
-                pin_data_size += std::to_string(data_->rows());
+                pin_data_size += std::to_string(get_number_of_rows());
                 pin_data_size += "x";
-                pin_data_size += std::to_string(data_->columns());
+                pin_data_size += std::to_string(get_number_of_columns());
                 pin_data_size += ")";
             }
 
+            // The toggle button's textures are only loaded once the pin is
+            // drawn, so that pins can be used without any graphics context
+            if(!toggle_button_)
+                this->initialize_toggle_button();
+
             toggle_button_->draw(&should_linked_pins_be_updated_if_data_changes_, pin_data_size);
 
             ImNodes::EndOutputAttribute();
@@ -204,6 +296,7 @@ private:
     PinType pin_type_ = PinType::Output;
 
     DataType* data_ = nullptr;
+    DeferredMatrix* deferred_matrix_ = nullptr;
     std::function<void(void)> notify_parent_node_callback_;
 
     bool should_linked_pins_be_updated_if_data_changes_ = true;
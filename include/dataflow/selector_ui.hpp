@@ -5,10 +5,12 @@
 
 //-------------------------------------------------------------------
 #include <vector>
-#include <unordered_map>
+#include <algorithm>
 
 #include <nlohmann/json.hpp>
 
+#include <compute/index_selection.hpp>
+
 #include "constants_and_defaults.hpp"
 //-------------------------------------------------------------------
 
@@ -42,36 +44,72 @@ public:
               bool can_user_select_multiple,
               const std::string& rows_selection_title = "Select rows",
               const std::string& columns_selection_title = "Select columns")
+    {
+        return draw(matrix.rows(),
+                    matrix.columns(),
+                    are_we_selecting_rows,
+                    are_we_selecting_columns,
+                    can_user_select_multiple,
+                    rows_selection_title,
+                    columns_selection_title);
+    }
+
+
+
+    // Same as above, but only needs the size of the matrix, so
+    // that deferred matrices don't have to be computed to be drawn
+    bool draw(int64_t number_of_rows,
+              int64_t number_of_columns,
+              bool are_we_selecting_rows,
+              bool are_we_selecting_columns,
+              bool can_user_select_multiple,
+              const std::string& rows_selection_title = "Select rows",
+              const std::string& columns_selection_title = "Select columns")
     {
         bool was_data_selected_or_deselected = false;
 
         if(are_we_selecting_rows)
-            was_data_selected_or_deselected = draw_row_selection(matrix, rows_selection_title, can_user_select_multiple);
+            was_data_selected_or_deselected = draw_row_selection(number_of_rows, rows_selection_title, can_user_select_multiple);
 
         if(are_we_selecting_columns)
         {
             ImGui::SameLine();
-            was_data_selected_or_deselected = was_data_selected_or_deselected || draw_column_selection(matrix, columns_selection_title, can_user_select_multiple);
+            was_data_selected_or_deselected = draw_column_selection(number_of_columns, columns_selection_title, can_user_select_multiple) || was_data_selected_or_deselected;
         }
 
-        previous_number_of_rows_ = matrix.rows();
-        previous_number_of_columns_ = matrix.columns();
-
         return was_data_selected_or_deselected;
     }
 
 
 
-    const std::unordered_map<std::string, int64_t>& get_selected_rows()const
+    // Drops the selected rows/columns that are out of range for a
+    // matrix of the given size, without drawing anything
+    // -- If all rows/columns were selected, all of them stay selected
+    // -- Returns true if the selection changed
+    bool fit_to_size(int64_t number_of_rows, int64_t number_of_columns)
+    {
+        bool did_selection_change = fit_selection_to_size(selected_rows_, are_all_rows_selected_, number_of_rows);
+        did_selection_change = fit_selection_to_size(selected_columns_, are_all_columns_selected_, number_of_columns) || did_selection_change;
+
+        if(did_selection_change)
+            update_selected_vectors();
+
+        return did_selection_change;
+    }
+
+
+
+    const Compute::IndexSelection& get_selected_rows()const
     {
         return selected_rows_;
     }
 
-    const std::unordered_map<std::string, int64_t>& get_selected_columns()const
+    const Compute::IndexSelection& get_selected_columns()const
     {
         return selected_columns_;
     }
 
+    // The selected rows/columns in increasing order
     const std::vector<int64_t>& get_selected_rows_vector()const
     {
         return selected_rows_vector_;
@@ -84,204 +122,167 @@ public:
 
 
 
+    // The selections are saved as runs [first, last) of
+    // consecutive indices, which stays small for big selections
     void save_to_json_internal(const std::string& node_name, const std::string& selector_ui_name, nlohmann::json* json_file)
     {
-        (*json_file)["nodes"][node_name][selector_ui_name]["selected rows"] = selected_rows_vector_;
-        (*json_file)["nodes"][node_name][selector_ui_name]["selected columns"] = selected_columns_vector_;
+        (*json_file)["nodes"][node_name][selector_ui_name]["selected row ranges"] = selected_rows_.to_ranges();
+        (*json_file)["nodes"][node_name][selector_ui_name]["selected column ranges"] = selected_columns_.to_ranges();
 
         (*json_file)["nodes"][node_name][selector_ui_name]["are all rows selected"] = are_all_rows_selected_;
         (*json_file)["nodes"][node_name][selector_ui_name]["are all columns selected"] = are_all_columns_selected_;
     }
 
+    void load_from_json_internal(const std::string& node_name, const std::string& selector_ui_name, const nlohmann::json& json_file)
+    {
+        const auto& selector_json = json_file["nodes"][node_name][selector_ui_name];
+
+        load_selection_from_json(selector_json, "selected row ranges", "selected rows", selected_rows_);
+        load_selection_from_json(selector_json, "selected column ranges", "selected columns", selected_columns_);
+
+        are_all_rows_selected_ = selector_json.value("are all rows selected", false);
+        are_all_columns_selected_ = selector_json.value("are all columns selected", false);
+
+        update_selected_vectors();
+    }
+
 
 
 private: // Private functions
 
-    bool draw_row_selection(MatrixType& matrix,
-                            const std::string& rows_selection_title,
-                            bool can_user_select_multiple)
+    // Loads a selection saved as ranges, or as a list of
+    // indices (the way older studies saved it)
+    static void load_selection_from_json(const nlohmann::json& selector_json,
+                                         const std::string& ranges_name,
+                                         const std::string& indices_name,
+                                         Compute::IndexSelection& selection)
     {
-        bool were_rows_selected_or_deselected = false;
+        auto ranges = selector_json.value(ranges_name, std::vector<std::pair<int64_t, int64_t>>());
 
-        // Check if matrix size has shrunk since last time
-        // and unselect the rows that are no longer there
-        if(matrix.rows() < previous_number_of_rows_)
-        {
-            for(int i = matrix.rows() - 1; i < previous_number_of_rows_; ++i)
-                selected_rows_.erase(std::to_string(i));
+        for(int64_t index : selector_json.value(indices_name, std::vector<int64_t>()))
+            ranges.emplace_back(index, index + 1);
 
-                were_rows_selected_or_deselected = true;
-        }
-        
-        ImGui::BeginGroup();
+        int64_t size = 0;
+        for(const auto& range : ranges)
+            size = std::max(size, range.second);
 
-            bool is_row_selected = false;
-                
-            ImGui::Text("%s", rows_selection_title.c_str());
+        selection = Compute::IndexSelection(size);
 
-            std::string list_box_title = std::string("##") + rows_selection_title;
-            
-            if(ImGui::BeginListBox(list_box_title.c_str()))
-            {
-                for(int row_index = 0; row_index < matrix.rows(); ++row_index)
-                {
-                    if(selected_rows_.find(std::to_string(row_index)) != selected_rows_.end())
-                    {
-                        is_row_selected = true;
-                    }
+        for(const auto& range : ranges)
+            selection.select_range(range.first, range.second);
+    }
 
-                    if(ImGui::Checkbox((std::string("##") + std::to_string(row_index)).c_str(), &is_row_selected))
-                    {
-                        if(is_row_selected)
-                        {
-                            if(!can_user_select_multiple)
-                                selected_rows_.clear();
 
-                            selected_rows_[std::to_string(row_index)] = row_index;
-                            were_rows_selected_or_deselected = true;
-                        }
-                        else
-                        {
-                            selected_rows_.erase(std::to_string(row_index));
-                            are_all_rows_selected_ = false;
-                            were_rows_selected_or_deselected = true;
-                        }
-                    }
 
-                    ImGui::SameLine();
+    static bool fit_selection_to_size(Compute::IndexSelection& selection,
+                                      bool are_all_selected,
+                                      int64_t size)
+    {
+        if(selection.size() == size)
+            return false;
 
-                    if(ImGui::Selectable((std::string("row ") + std::to_string(row_index)).c_str(), &is_row_selected))
-                    {
-                        if(is_row_selected)
-                        {
-                            if(!can_user_select_multiple)
-                                selected_rows_.clear();
+        const int64_t previous_count = selection.count();
 
-                            selected_rows_[std::to_string(row_index)] = row_index;
-                            were_rows_selected_or_deselected = true;
-                        }
-                        else
-                        {
-                            selected_rows_.erase(std::to_string(row_index));
-                            are_all_rows_selected_ = false;
-                            were_rows_selected_or_deselected = true;
-                        }
-                    }
+        selection.resize(size);
 
-                    is_row_selected = false;
-                }
+        if(are_all_selected)
+            selection.select_all();
 
-                ImGui::EndListBox();
-            }
+        return selection.count() != previous_count;
+    }
 
-            if(can_user_select_multiple)
-            {
-                if(ImGui::Checkbox("Select all##rows", &are_all_rows_selected_))
-                {
-                    if(are_all_rows_selected_)
-                    {
-                        for(int i = 0; i < matrix.rows(); ++i)
-                            selected_rows_[std::to_string(i)] = i;
 
-                        were_rows_selected_or_deselected = true;
-                    }
-                    else
-                    {
-                        selected_rows_.clear();
-                        were_rows_selected_or_deselected = true;
-                    }
-                }
-            }
 
-            if(were_rows_selected_or_deselected)
-            {
-                selected_rows_vector_.clear();
+    void update_selected_vectors()
+    {
+        selected_rows_vector_ = selected_rows_.to_indices();
+        selected_columns_vector_ = selected_columns_.to_indices();
+    }
 
-                for(const auto& row : selected_rows_)
-                    selected_rows_vector_.push_back(row.second);
-                
-                std::sort(selected_rows_vector_.begin(), selected_rows_vector_.end());
-            }
 
-        ImGui::EndGroup();
 
-        return were_rows_selected_or_deselected;
+    bool draw_row_selection(int64_t number_of_rows,
+                            const std::string& rows_selection_title,
+                            bool can_user_select_multiple)
+    {
+        return draw_selection(selected_rows_,
+                              are_all_rows_selected_,
+                              selected_rows_vector_,
+                              number_of_rows,
+                              rows_selection_title,
+                              "row ",
+                              "Select all##rows",
+                              can_user_select_multiple);
     }
 
 
 
-    bool draw_column_selection(MatrixType& matrix,
+    bool draw_column_selection(int64_t number_of_columns,
                                const std::string& columns_selection_title,
                                bool can_user_select_multiple)
     {
-        bool were_columns_selected_or_deselected = false;
+        return draw_selection(selected_columns_,
+                              are_all_columns_selected_,
+                              selected_columns_vector_,
+                              number_of_columns,
+                              columns_selection_title,
+                              "col ",
+                              "Select all##columns",
+                              can_user_select_multiple);
+    }
 
-        // Check if matrix size has shrunk since last time
-        // and unselect the rows that are no longer there
-        if(matrix.columns() < previous_number_of_columns_)
-        {
-            for(int i = matrix.columns() - 1; i < previous_number_of_columns_; ++i)
-                selected_columns_.erase(std::to_string(i));
 
-            were_columns_selected_or_deselected = true;
-        }
-        
+
+    // Draws the list of rows (or columns) to select from
+    // -- Only the visible items of the list are drawn
+    bool draw_selection(Compute::IndexSelection& selection,
+                        bool& are_all_selected,
+                        std::vector<int64_t>& selected_vector,
+                        int64_t number_of_indices,
+                        const std::string& selection_title,
+                        const std::string& item_label,
+                        const char* select_all_label,
+                        bool can_user_select_multiple)
+    {
+        // Unselect the indices that are no longer
+        // there if the matrix size has shrunk
+        bool were_indices_selected_or_deselected = fit_selection_to_size(selection, are_all_selected, number_of_indices);
+
         ImGui::BeginGroup();
 
-            bool is_column_selected = false;
-                
-            ImGui::Text("%s", columns_selection_title.c_str());
-            
-            std::string list_box_title = std::string("##") + columns_selection_title;
-            
+            ImGui::Text("%s", selection_title.c_str());
+
+            std::string list_box_title = std::string("##") + selection_title;
+
             if(ImGui::BeginListBox(list_box_title.c_str()))
             {
-                for(int column_index = 0; column_index < matrix.columns(); ++column_index)
+                ImGuiListClipper clipper;
+                clipper.Begin(int(number_of_indices));
+
+                while(clipper.Step())
                 {
-                    if(selected_columns_.find(std::to_string(column_index)) != selected_columns_.end())
+                    for(int index = clipper.DisplayStart; index < clipper.DisplayEnd; ++index)
                     {
-                        is_column_selected = true;
-                    }
+                        bool is_selected = selection.is_selected(index);
 
-                    if(ImGui::Checkbox((std::string("##") + std::to_string(column_index)).c_str(), &is_column_selected))
-                    {
-                        if(is_column_selected)
-                        {
-                            if(!can_user_select_multiple)
-                                selected_columns_.clear();
-                                
-                            selected_columns_[std::to_string(column_index)] = column_index;
-                            were_columns_selected_or_deselected = true;
-                        }
-                        else
-                        {
-                            selected_columns_.erase(std::to_string(column_index));
-                            are_all_columns_selected_ = false;
-                            were_columns_selected_or_deselected = true;
-                        }
-                    }
+                        bool was_clicked = ImGui::Checkbox((std::string("##") + std::to_string(index)).c_str(), &is_selected);
 
-                    ImGui::SameLine();
+                        ImGui::SameLine();
 
-                    if(ImGui::Selectable((std::string("col ") + std::to_string(column_index)).c_str(), &is_column_selected))
-                    {
-                        if(is_column_selected)
-                        {
-                            if(!can_user_select_multiple)
-                                selected_columns_.clear();
+                        was_clicked = ImGui::Selectable((item_label + std::to_string(index)).c_str(), &is_selected) || was_clicked;
 
-                            selected_columns_[std::to_string(column_index)] = column_index;
-                            were_columns_selected_or_deselected = true;
-                        }
-                        else
+                        if(was_clicked)
                         {
-                            selected_columns_.erase(std::to_string(column_index));
-                            are_all_columns_selected_ = false;
-                            were_columns_selected_or_deselected = true;
+                            if(is_selected && !can_user_select_multiple)
+                                selection.clear();
+
+                            if(!is_selected)
+                                are_all_selected = false;
+
+                            selection.select(index, is_selected);
+                            were_indices_selected_or_deselected = true;
                         }
                     }
-
-                    is_column_selected = false;
                 }
 
                 ImGui::EndListBox();
@@ -289,53 +290,37 @@ private: // Private functions
 
             if(can_user_select_multiple)
             {
-                if(ImGui::Checkbox("Select all##columns", &are_all_columns_selected_))
+                if(ImGui::Checkbox(select_all_label, &are_all_selected))
                 {
-                    if(are_all_columns_selected_)
-                    {
-                        for(int i = 0; i < matrix.columns(); ++i)
-                            selected_columns_[std::to_string(i)] = i;
-
-                        were_columns_selected_or_deselected = true;
-                    }
+                    if(are_all_selected)
+                        selection.select_all();
                     else
-                    {
-                        selected_columns_.clear();
-                        were_columns_selected_or_deselected = true;
-                    }
+                        selection.clear();
+
+                    were_indices_selected_or_deselected = true;
                 }
             }
 
-            if(were_columns_selected_or_deselected)
-            {
-                selected_columns_vector_.clear();
-
-                for(const auto& column : selected_columns_)
-                    selected_columns_vector_.push_back(column.second);
-                
-                std::sort(selected_columns_vector_.begin(), selected_columns_vector_.end());
-            }
+            if(were_indices_selected_or_deselected)
+                selected_vector = selection.to_indices();
 
         ImGui::EndGroup();
 
-        return were_columns_selected_or_deselected;
+        return were_indices_selected_or_deselected;
     }
 
 
 
 private: // Private variables
 
-    std::unordered_map<std::string, int64_t> selected_rows_;
-    std::unordered_map<std::string, int64_t> selected_columns_;
+    Compute::IndexSelection selected_rows_;
+    Compute::IndexSelection selected_columns_;
 
     bool are_all_rows_selected_ = false;
     bool are_all_columns_selected_ = false;
 
     std::vector<int64_t> selected_rows_vector_;
     std::vector<int64_t> selected_columns_vector_;
-
-    int previous_number_of_rows_ = 0;
-    int previous_number_of_columns_ = 0;
 };
 //-------------------------------------------------------------------
 
@@ -6,6 +6,8 @@
 //-------------------------------------------------------------------
 #include <vector>
 
+#include <compute/block_copy.hpp>
+
 #include "../node_styling.hpp"
 #include "../node.hpp"
 //-------------------------------------------------------------------
@@ -33,6 +35,10 @@ const NodeStyling DEFAULT_AUGMENT_NODE_STYLING(ImVec4(135,167,220,255),
 
 //-------------------------------------------------------------------
 // This Node allows a user to augment multiple matrices together
+// -- In virtual mode nothing is copied, the result is a deferred
+//    concatenation of the inputs (see ElementwiseChain::concatenate)
+//    that downstream nodes read (or extend) piece by piece, so it
+//    takes no memory or disk space until someone needs it contiguous
 //-------------------------------------------------------------------
 class AugmentNode : public Node<AugmentNode>
 {
@@ -97,17 +103,23 @@ public:
 
     void add_input_pin()
     {
+        const int pin_index = int(input_pins_.size());
+
         input_pins_.emplace_back();
         input_pins_.back().set_pin_type(PinType::Input);
-        input_pins_.back().set_name(std::to_string(input_pins_.size() - 1));
+        input_pins_.back().set_name(std::to_string(pin_index));
         input_pins_.back().set_parent_node_id(this->get_id());
-        input_pins_.back().set_notify_parent_node_callback(std::bind(&AugmentNode::input_data_has_been_updated_callback, this));
+        input_pins_.back().set_notify_parent_node_callback(std::bind(&AugmentNode::input_pin_data_has_been_updated_callback, this, pin_index));
+
+        slices_.clear();
     }
 
     void remove_last_input_pin()
     {
         if(input_pins_.size() > 0)
         {
+            slices_.clear();
+
             this->pin_deleted_link_manager_callback_(&input_pins_.back());
             input_pins_.erase(input_pins_.end() - 1);
         }
@@ -120,32 +132,105 @@ public:
 
 
 
+    Pin<MatrixType>* get_output_pin()
+    {
+        return &output_pin_;
+    }
+
+    void compute_internal()
+    {
+        input_data_has_been_updated_callback();
+    }
+
+
+
+    // Function used to compute the whole result
+    // -- The size of the result is computed first, so the result is
+    //    allocated once and each input is copied into its own slice
+    //    of it (in parallel)
+    // -- Inputs narrower (or shorter) than the result are padded with zeros
     void input_data_has_been_updated_callback()
     {
-        resulting_matrix_.resize(0,0);
-        
-        for(auto& pin : input_pins_)
+        if(is_virtual_)
         {
-            if(pin.get_data())
+            compute_virtual_result();
+            return;
+        }
+
+        deferred_matrix_.mirror_matrix();
+
+        std::vector<Compute::MatrixView> views(input_pins_.size());
+
+        for(std::size_t i = 0; i < input_pins_.size(); ++i)
+            views[i] = input_pins_[i].get_view();
+
+        slices_.assign(input_pins_.size(), Slice());
+        augmentation_type_of_slices_ = selected_augmentation_type_;
+
+        int64_t rows = 0;
+        int64_t columns = 0;
+
+        for(std::size_t i = 0; i < views.size(); ++i)
+        {
+            slices_[i].rows = views[i].rows();
+            slices_[i].columns = views[i].columns();
+
+            if(selected_augmentation_type_ == 0)
             {
-                if(selected_augmentation_type_ == 0)
-                {
-                    MatrixType new_result = LazyMatrix::augment_by_rows(resulting_matrix_, *pin.get_data());
-                    resulting_matrix_ = new_result;
-                }
-                else
-                {
-                    MatrixType new_result = LazyMatrix::augment_by_columns(resulting_matrix_, *pin.get_data());
-                    resulting_matrix_ = new_result;
-                }
+                slices_[i].offset = rows;
+                rows += views[i].rows();
+                columns = std::max(columns, views[i].columns());
+            }
+            else
+            {
+                slices_[i].offset = columns;
+                columns += views[i].columns();
+                rows = std::max(rows, views[i].rows());
             }
         }
-        
+
+        resulting_matrix_.resize(rows, columns);
+
+        if(resulting_matrix_.size() > 0)
+        {
+            Compute::get_thread_pool().parallel_for(int64_t(views.size()), [&](int64_t i)
+            {
+                write_slice(i, views[i]);
+            });
+        }
+
+        output_pin_.update_data(&resulting_matrix_);
+    }
+
+    // Function called when the data of one input changed
+    // -- If its size didn't change, only its slice is rewritten
+    void input_pin_data_has_been_updated_callback(int pin_index)
+    {
+        if(slices_.size() != input_pins_.size() ||
+           pin_index >= int(slices_.size()) ||
+           augmentation_type_of_slices_ != selected_augmentation_type_ ||
+           is_virtual_ ||
+           deferred_matrix_.is_attached())
+        {
+            input_data_has_been_updated_callback();
+            return;
+        }
+
+        Compute::MatrixView view = input_pins_[pin_index].get_view();
+
+        if(view.rows() != slices_[pin_index].rows || view.columns() != slices_[pin_index].columns)
+        {
+            input_data_has_been_updated_callback();
+            return;
+        }
+
+        write_slice(pin_index, view);
+
         output_pin_.update_data(&resulting_matrix_);
     }
-    
-    
-    
+
+
+
     void draw_input_pins()
     {
         for(auto& pin : input_pins_)
@@ -191,6 +276,9 @@ public:
                         input_data_has_been_updated_callback();
                     }
                 }
+
+                if(ImGui::Checkbox("Virtual (no copy)", &is_virtual_))
+                    input_data_has_been_updated_callback();
             ImGui::EndGroup();
 
         ImGui::EndGroup();
@@ -198,13 +286,37 @@ public:
 
 
 
+    int64_t get_output_bytes()const
+    {
+        return deferred_matrix_.get_number_of_bytes();
+    }
+
+    DeferredMatrix* get_evictable_output()
+    {
+        return output_pin_.get_deferred_matrix();
+    }
+
+    DeferredMatrix* get_reattachable_output()
+    {
+        return &deferred_matrix_;
+    }
+
+    void rebind_deferred_matrices()
+    {
+        deferred_matrix_.rebind_matrix(&resulting_matrix_);
+    }
+
+
+
     void save_to_json_internal(const std::string& node_name, nlohmann::json* json_file)
     {
         (*json_file)["nodes"][node_name]["type"] = node_type.c_str();
 
+        deferred_matrix_.materialize();
         (*json_file)["nodes"][node_name]["resulting matrix"] = resulting_matrix_.get_filename_of_memory_mapped_file();
 
         (*json_file)["nodes"][node_name]["selected augmentation type"] = selected_augmentation_type_;
+        (*json_file)["nodes"][node_name]["virtual"] = is_virtual_;
 
         (*json_file)["nodes"][node_name]["number of input pins"] = input_pins_.size();
 
@@ -212,19 +324,103 @@ public:
         {
             (*json_file)["nodes"][node_name][std::string("input_pin ") + std::to_string(i)]["id"] = input_pins_[i].get_id();
         }
+
+        (*json_file)["nodes"][node_name]["output pin id"] = output_pin_.get_id();
+    }
+
+    void load_from_json_internal(const std::string& node_name, const nlohmann::json& json_file)
+    {
+        const auto& node_json = json_file["nodes"][node_name];
+
+        selected_augmentation_type_ = node_json.value("selected augmentation type", selected_augmentation_type_);
+        previously_selected_augmentation_type_ = selected_augmentation_type_;
+
+        is_virtual_ = node_json.value("virtual", is_virtual_);
+
+        int number_of_input_pins = node_json.value("number of input pins", this->get_number_of_input_pins());
+
+        while(this->get_number_of_input_pins() < number_of_input_pins)
+            add_input_pin();
+
+        while(this->get_number_of_input_pins() > number_of_input_pins)
+            remove_last_input_pin();
+
+        for(int i = 0; i < input_pins_.size(); ++i)
+        {
+            std::string pin_name = std::string("input_pin ") + std::to_string(i);
+
+            if(node_json.contains(pin_name))
+                input_pins_[i].set_id(node_json[pin_name].value("id", input_pins_[i].get_id()));
+
+            input_pins_[i].set_parent_node_id(this->get_id());
+        }
+
+        output_pin_.set_id(node_json.value("output pin id", output_pin_.get_id()));
+        output_pin_.set_parent_node_id(this->get_id());
     }
 
 
 
 private:
 
+    // Where an input goes in the result (first row when augmenting
+    // rows, first column when augmenting columns) and its size
+    struct Slice
+    {
+        int64_t offset = 0;
+        int64_t rows = 0;
+        int64_t columns = 0;
+    };
+
+    // Function used to publish the concatenation of the inputs without
+    // computing it, the chains of deferred inputs are concatenated as
+    // they are, so fused operations upstream stay fused
+    void compute_virtual_result()
+    {
+        std::vector<Compute::ElementwiseChain> parts;
+        parts.reserve(input_pins_.size());
+
+        for(auto& pin : input_pins_)
+            parts.push_back(make_elementwise_chain(pin.get_data_pointer(), pin.get_deferred_matrix()));
+
+        const auto direction = (selected_augmentation_type_ == 0) ? Compute::ConcatenationDirection::Rows : Compute::ConcatenationDirection::Columns;
+
+        resulting_matrix_.resize(0,0);
+        slices_.clear();
+
+        deferred_matrix_.set_chain(Compute::ElementwiseChain::concatenate(parts, direction));
+        output_pin_.update_data(&resulting_matrix_, &deferred_matrix_);
+    }
+
+    // Function used to copy an input into its slice of the result
+    void write_slice(int64_t pin_index, const Compute::MatrixView& view)
+    {
+        const Slice& slice = slices_[pin_index];
+
+        if(slice.rows == 0 || slice.columns == 0 || resulting_matrix_.size() == 0)
+            return;
+
+        if(augmentation_type_of_slices_ == 0)
+            Compute::copy_into_block(view, &resulting_matrix_(slice.offset, 0), resulting_matrix_.columns(), slice.rows, resulting_matrix_.columns());
+        else
+            Compute::copy_into_block(view, &resulting_matrix_(0, slice.offset), resulting_matrix_.columns(), resulting_matrix_.rows(), slice.columns);
+    }
+
+
+
     int add_input_pins_button_id_ = LazyApp::UniqueID::generate_uuid_hash();
     int remove_input_pins_button_id_ = LazyApp::UniqueID::generate_uuid_hash();
 
     int selected_augmentation_type_ = 0;
     int previously_selected_augmentation_type_ = 0;
 
+    bool is_virtual_ = false;
+
     MatrixType resulting_matrix_;
+    DeferredMatrix deferred_matrix_{&resulting_matrix_};
+
+    std::vector<Slice> slices_;
+    int augmentation_type_of_slices_ = 0;
 
     std::vector< Pin<MatrixType> > input_pins_;
     Pin<MatrixType> output_pin_;
@@ -0,0 +1,349 @@
+#ifndef INCLUDE_BINARY_LOADER_NODE_HPP_
+#define INCLUDE_BINARY_LOADER_NODE_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <chrono>
+#include <filesystem>
+#include <memory>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <imfilebrowser.h>
+
+#include <compute/binary_matrix_file.hpp>
+
+#include "../node_styling.hpp"
+#include "../node.hpp"
+#include "../matrix_table_ui.hpp"
+
+#include <utils/file_browser.hpp>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Define every thing within the namespace DataFlow
+//-------------------------------------------------------------------
+namespace DataFlow
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// This Node loads a matrix dumped as a binary file
+// -- .npy files describe their own layout, other files are read as
+//    raw little-endian elements of the selected type, the selected
+//    number of columns per row, after the selected header size
+// -- Files of doubles are mapped as they are (see
+//    DeferredMatrix::attach_raw), so they're neither parsed nor
+//    copied, other element types are converted by the thread pool
+//-------------------------------------------------------------------
+class BinaryLoaderNode : public Node<BinaryLoaderNode>
+{
+public:
+
+    BinaryLoaderNode(std::function<void(Pin<MatrixType>*)> pin_deleted_link_manager_callback)
+    : Node<BinaryLoaderNode>(pin_deleted_link_manager_callback)
+    {
+        this->set_node_styling(DEFAULT_MATRIX_SOURCE_NODE_STYLING);
+
+        output_pin_.update_data(&matrix_data_);
+        output_pin_.set_name("out");
+        output_pin_.set_pin_type(PinType::Output);
+        output_pin_.set_parent_node_id(this->get_id());
+    }
+
+    ~BinaryLoaderNode()
+    {
+        this->pin_deleted_link_manager_callback_(&output_pin_);
+    }
+
+    const std::string& get_node_type()const
+    {
+        return node_type;
+    }
+
+
+
+    Pin<MatrixType>* find_pin_using_id(int pin_id)
+    {
+        if(output_pin_.get_id() == pin_id)
+            return &output_pin_;
+
+        return nullptr;
+    }
+
+    int get_number_of_input_pins()const
+    {
+        return 0;
+    }
+
+    int get_number_of_output_pins()const
+    {
+        return 1;
+    }
+
+
+
+    void draw_input_pins()
+    {
+    }
+
+    void draw_output_pins()
+    {
+        output_pin_.draw();
+    }
+
+    void draw_node_content()
+    {
+        if(ImGui::Button("Load binary file"))
+        {
+            LazyApp::FileBrowserManager::open_file_browser(this->get_id(),
+            { ".npy", ".bin", ".raw", ".dat" });
+        }
+
+        std::string selected_filename = LazyApp::FileBrowserManager::has_selected(this->get_id());
+
+        if(!selected_filename.empty())
+        {
+            filename_ = selected_filename;
+            this->compute();
+        }
+
+        ImGui::Dummy(ImVec2(0,30));
+
+        // The layout of .npy files is read from their header
+        if(!is_npy_file())
+        {
+            ImGui::PushItemWidth(200);
+
+            bool has_layout_changed = ImGui::Combo("Element type", &selected_element_type_, element_types.data(), element_types.size());
+            has_layout_changed |= ImGui::InputInt("Columns", &columns_, 1, 10, ImGuiInputTextFlags_CharsDecimal);
+            has_layout_changed |= ImGui::InputInt("Header bytes", &header_size_, 1, 64, ImGuiInputTextFlags_CharsDecimal);
+
+            ImGui::PopItemWidth();
+
+            columns_ = std::max(1, columns_);
+            header_size_ = std::max(0, header_size_);
+
+            if(has_layout_changed)
+                this->compute();
+        }
+
+        if(deferred_matrix_.is_attached())
+        {
+            ImGui::Text("Mapped in %.3f s (%lli x %lli)",
+                        loading_time_in_seconds_,
+                        (long long)deferred_matrix_.rows(),
+                        (long long)deferred_matrix_.columns());
+        }
+        else if(loading_time_in_seconds_ > 0)
+        {
+            ImGui::Text("Converted in %.2f s", loading_time_in_seconds_);
+        }
+
+        if(!error_message_.empty())
+            ImGui::TextColored(ImVec4(1.0, 0.3, 0.3, 1.0), "%s", error_message_.c_str());
+
+        // A mapped file is viewed in place (strided if it's column
+        // major), it's neither copied nor edited for the table
+        if(deferred_matrix_.is_attached())
+            draw_matrix_table(deferred_matrix_.get_view(), table_state_, this->get_node_size());
+        else
+            draw_matrix_table(matrix_data_, table_state_, this->get_node_size(), are_entries_editable_);
+    }
+
+
+
+    Pin<MatrixType>* get_output_pin()
+    {
+        return &output_pin_;
+    }
+
+    void compute_internal()
+    {
+        deferred_matrix_.mirror_matrix();
+        load_binary_file(filename_);
+        table_state_.invalidate();
+
+        if(deferred_matrix_.is_attached())
+            output_pin_.update_data(&matrix_data_, &deferred_matrix_);
+        else
+            output_pin_.update_data(&matrix_data_);
+    }
+
+    void load_binary_file(const std::string& filename)
+    {
+        namespace bip = boost::interprocess;
+
+        error_message_.clear();
+        loading_time_in_seconds_ = 0;
+        matrix_data_.resize(0,0);
+
+        if(filename.empty())
+            return;
+
+        const auto start_time = std::chrono::steady_clock::now();
+
+        Compute::BinaryMatrixLayout layout;
+
+        if(!read_layout(filename, layout))
+            return;
+
+        if(layout.can_be_mapped() &&
+           deferred_matrix_.attach_raw(filename, layout.offset, layout.rows, layout.columns, layout.is_column_major))
+        {
+            loading_time_in_seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+            return;
+        }
+
+        if(layout.size() == 0)
+            return;
+
+        std::unique_ptr<bip::mapped_region> region;
+
+        try
+        {
+            bip::file_mapping mapping(filename.c_str(), bip::read_only);
+            region = std::make_unique<bip::mapped_region>(mapping, bip::read_only, layout.offset, layout.get_data_size());
+        }
+        catch(...)
+        {
+            error_message_ = "Could not map the file";
+            return;
+        }
+
+        matrix_data_.resize(layout.rows, layout.columns);
+
+        Compute::convert_binary_matrix(static_cast<const char*>(region->get_address()), layout, &matrix_data_(0,0));
+
+        loading_time_in_seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    }
+
+
+
+    // Mapped files aren't counted, their pages belong to the system's file cache
+    int64_t get_output_bytes()const
+    {
+        return int64_t(matrix_data_.size()) * int64_t(sizeof(double));
+    }
+
+    void rebind_deferred_matrices()
+    {
+        deferred_matrix_.rebind_matrix(&matrix_data_);
+    }
+
+
+
+    void save_to_json_internal(const std::string& node_name, nlohmann::json* json_file)
+    {
+        (*json_file)["nodes"][node_name]["type"] = node_type.c_str();
+
+        (*json_file)["nodes"][node_name]["filename"] = filename_;
+        (*json_file)["nodes"][node_name]["selected element type"] = selected_element_type_;
+        (*json_file)["nodes"][node_name]["columns"] = columns_;
+        (*json_file)["nodes"][node_name]["header bytes"] = header_size_;
+        (*json_file)["nodes"][node_name]["matrix data"] = matrix_data_.get_filename_of_memory_mapped_file();
+
+        (*json_file)["nodes"][node_name]["output pin id"] = output_pin_.get_id();
+    }
+
+    void load_from_json_internal(const std::string& node_name, const nlohmann::json& json_file)
+    {
+        const auto& node_json = json_file["nodes"][node_name];
+
+        filename_ = node_json.value("filename", filename_);
+        selected_element_type_ = node_json.value("selected element type", selected_element_type_);
+        columns_ = node_json.value("columns", columns_);
+        header_size_ = node_json.value("header bytes", header_size_);
+
+        output_pin_.set_id(node_json.value("output pin id", output_pin_.get_id()));
+        output_pin_.set_parent_node_id(this->get_id());
+    }
+
+
+
+private:
+
+    bool is_npy_file()const
+    {
+        return std::filesystem::path(filename_).extension() == ".npy";
+    }
+
+    bool read_layout(const std::string& filename, Compute::BinaryMatrixLayout& layout)
+    {
+        if(is_npy_file())
+        {
+            if(!Compute::read_npy_layout(filename, layout))
+            {
+                error_message_ = "Not an .npy file of numbers";
+                return false;
+            }
+
+            return true;
+        }
+
+        std::error_code error;
+        const uint64_t file_size = std::filesystem::file_size(filename, error);
+
+        if(error)
+        {
+            error_message_ = "Could not read the file";
+            return false;
+        }
+
+        layout = Compute::make_raw_matrix_layout(file_size,
+                                                 Compute::BinaryElementType(selected_element_type_),
+                                                 columns_,
+                                                 uint64_t(header_size_));
+
+        return true;
+    }
+
+
+
+    Pin<MatrixType> output_pin_;
+
+    MatrixType matrix_data_;
+    DeferredMatrix deferred_matrix_{&matrix_data_};
+
+    MatrixTableState table_state_;
+
+    bool are_entries_editable_ = true;
+
+    std::string filename_;
+
+    // Layout of raw files
+    int selected_element_type_ = 0;     // Compute::BinaryElementType
+    static std::vector<const char*> element_types;
+
+    int columns_ = 1;
+    int header_size_ = 0;
+
+    double loading_time_in_seconds_ = 0;
+    std::string error_message_;
+
+    static std::string node_type;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+std::string BinaryLoaderNode::node_type = "Binary Loader Node";
+std::vector<const char*> BinaryLoaderNode::element_types = {"float64", "float32", "int8", "uint8", "int16", "uint16", "int32", "uint32", "int64", "uint64"};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace DataFlow
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_BINARY_LOADER_NODE_HPP_
@@ -0,0 +1,293 @@
+#ifndef INCLUDE_BINARY_OPERATOR_NODE_HPP_
+#define INCLUDE_BINARY_OPERATOR_NODE_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <vector>
+
+#include <compute/binary_operations.hpp>
+#include <compute/gemm.hpp>
+
+#include "../node_styling.hpp"
+#include "../node.hpp"
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Define every thing within the namespace DataFlow
+//-------------------------------------------------------------------
+namespace DataFlow
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+const NodeStyling DEFAULT_BINARY_OPERATOR_NODE_STYLING(ImVec4(220,190,135,255),
+                                                       ImVec4(250, 220, 165, 255),
+                                                       ImVec4(250, 220, 165, 255),
+                                                       ImVec4(250, 220, 165, 255),
+                                                       ImVec2(150.0f,100.0f));
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// This Node combines two matrices a and b
+// -- add, subtract, multiply and divide work elementwise, and
+//    broadcast a single row or column of one matrix over the other
+//    (see Compute::are_broadcastable)
+// -- matrix multiply computes a * b (see Compute::multiply)
+//-------------------------------------------------------------------
+class BinaryOperatorNode : public Node<BinaryOperatorNode>
+{
+public:
+
+    BinaryOperatorNode(std::function<void(Pin<MatrixType>*)> pin_deleted_link_manager_callback)
+    : Node<BinaryOperatorNode>(pin_deleted_link_manager_callback)
+    {
+        this->set_node_styling(DEFAULT_BINARY_OPERATOR_NODE_STYLING);
+
+        output_pin_.update_data(&resulting_matrix_);
+        output_pin_.set_name("out");
+        output_pin_.set_pin_type(PinType::Output);
+        output_pin_.set_parent_node_id(this->get_id());
+
+        first_input_pin_.set_name("a");
+        first_input_pin_.set_pin_type(PinType::Input);
+        first_input_pin_.set_parent_node_id(this->get_id());
+        first_input_pin_.set_notify_parent_node_callback(std::bind(&BinaryOperatorNode::input_data_has_been_updated_callback, this));
+
+        second_input_pin_.set_name("b");
+        second_input_pin_.set_pin_type(PinType::Input);
+        second_input_pin_.set_parent_node_id(this->get_id());
+        second_input_pin_.set_notify_parent_node_callback(std::bind(&BinaryOperatorNode::input_data_has_been_updated_callback, this));
+    }
+
+    ~BinaryOperatorNode()
+    {
+        this->pin_deleted_link_manager_callback_(&first_input_pin_);
+        this->pin_deleted_link_manager_callback_(&second_input_pin_);
+        this->pin_deleted_link_manager_callback_(&output_pin_);
+    }
+
+    const std::string& get_node_type()const
+    {
+        return node_type;
+    }
+
+
+
+    Pin<MatrixType>* find_pin_using_id(int pin_id)
+    {
+        if(first_input_pin_.get_id() == pin_id)
+            return &first_input_pin_;
+
+        if(second_input_pin_.get_id() == pin_id)
+            return &second_input_pin_;
+
+        if(output_pin_.get_id() == pin_id)
+            return &output_pin_;
+
+        return nullptr;
+    }
+
+    int get_number_of_input_pins()const
+    {
+        return 2;
+    }
+
+    int get_number_of_output_pins()const
+    {
+        return 1;
+    }
+
+
+
+    Pin<MatrixType>* get_output_pin()
+    {
+        return &output_pin_;
+    }
+
+    void compute_internal()
+    {
+        input_data_has_been_updated_callback();
+    }
+
+
+
+    void input_data_has_been_updated_callback()
+    {
+        deferred_matrix_.mirror_matrix();
+        resulting_matrix_.resize(0,0);
+        error_message_.clear();
+
+        if(first_input_pin_.get_data_pointer() && second_input_pin_.get_data_pointer())
+        {
+            // The inputs are read through views, so deferred inputs are
+            // computed into their storage instead of being materialized
+            Compute::MatrixView a = first_input_pin_.get_view();
+            Compute::MatrixView b = second_input_pin_.get_view();
+
+            if(selected_operation_type_ == MATRIX_MULTIPLY_OPERATION_TYPE)
+            {
+                if(a.size() > 0 && b.size() > 0 && a.columns() == b.rows())
+                {
+                    resulting_matrix_.resize(a.rows(), b.columns());
+                    Compute::multiply(a, b, &resulting_matrix_(0,0), b.columns());
+                }
+                else
+                {
+                    error_message_ = "columns of a must match rows of b";
+                }
+            }
+            else
+            {
+                if(Compute::are_broadcastable(a, b))
+                {
+                    resulting_matrix_.resize(std::max(a.rows(), b.rows()), std::max(a.columns(), b.columns()));
+
+                    Compute::evaluate_binary_operation(static_cast<Compute::BinaryOperation>(selected_operation_type_),
+                                                       a,
+                                                       b,
+                                                       &resulting_matrix_(0,0),
+                                                       resulting_matrix_.columns());
+                }
+                else
+                {
+                    error_message_ = "sizes of a and b don't match";
+                }
+            }
+        }
+
+        output_pin_.update_data(&resulting_matrix_);
+    }
+
+
+
+    void draw_input_pins()
+    {
+        first_input_pin_.draw();
+        second_input_pin_.draw();
+    }
+
+    void draw_output_pins()
+    {
+        output_pin_.draw();
+    }
+
+    void draw_node_content()
+    {
+        ImGui::BeginGroup();
+
+            // Type of operation selector
+            ImGui::BeginGroup();
+                ImGui::Text("Select operator type");
+                if(ImGui::Combo("", &selected_operation_type_, operator_types.data(), operator_types.size()))
+                {
+                    if(selected_operation_type_ != previously_selected_operation_type_)
+                    {
+                        previously_selected_operation_type_ = selected_operation_type_;
+                        input_data_has_been_updated_callback();
+                    }
+                }
+
+                if(!error_message_.empty())
+                    ImGui::TextColored(ImVec4(1.0,0.4,0.4,1.0), "%s", error_message_.c_str());
+            ImGui::EndGroup();
+
+        ImGui::EndGroup();
+    }
+
+
+
+    int64_t get_output_bytes()const
+    {
+        return deferred_matrix_.get_number_of_bytes();
+    }
+
+    DeferredMatrix* get_reattachable_output()
+    {
+        return &deferred_matrix_;
+    }
+
+    void rebind_deferred_matrices()
+    {
+        deferred_matrix_.rebind_matrix(&resulting_matrix_);
+    }
+
+
+
+    void save_to_json_internal(const std::string& node_name, nlohmann::json* json_file)
+    {
+        (*json_file)["nodes"][node_name]["type"] = node_type.c_str();
+
+        (*json_file)["nodes"][node_name]["selected operation type"] = selected_operation_type_;
+
+        (*json_file)["nodes"][node_name]["resulting matrix"] = resulting_matrix_.get_filename_of_memory_mapped_file();
+
+        (*json_file)["nodes"][node_name]["first input pin id"] = first_input_pin_.get_id();
+        (*json_file)["nodes"][node_name]["second input pin id"] = second_input_pin_.get_id();
+        (*json_file)["nodes"][node_name]["output pin id"] = output_pin_.get_id();
+    }
+
+    void load_from_json_internal(const std::string& node_name, const nlohmann::json& json_file)
+    {
+        const auto& node_json = json_file["nodes"][node_name];
+
+        selected_operation_type_ = node_json.value("selected operation type", selected_operation_type_);
+        previously_selected_operation_type_ = selected_operation_type_;
+
+        first_input_pin_.set_id(node_json.value("first input pin id", first_input_pin_.get_id()));
+        first_input_pin_.set_parent_node_id(this->get_id());
+
+        second_input_pin_.set_id(node_json.value("second input pin id", second_input_pin_.get_id()));
+        second_input_pin_.set_parent_node_id(this->get_id());
+
+        output_pin_.set_id(node_json.value("output pin id", output_pin_.get_id()));
+        output_pin_.set_parent_node_id(this->get_id());
+    }
+
+
+
+private:
+
+    // Index of "matrix multiply" in operator_types, the ones
+    // before it match the values of Compute::BinaryOperation
+    static constexpr int MATRIX_MULTIPLY_OPERATION_TYPE = 4;
+
+    int selected_operation_type_ = 0;
+    int previously_selected_operation_type_ = 0;
+
+    std::string error_message_;
+
+    MatrixType resulting_matrix_;
+    DeferredMatrix deferred_matrix_{&resulting_matrix_};
+
+    Pin<MatrixType> first_input_pin_;
+    Pin<MatrixType> second_input_pin_;
+    Pin<MatrixType> output_pin_;
+
+    static std::string node_type;
+    static std::vector<const char*> operator_types;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+std::string BinaryOperatorNode::node_type = "Binary Operator Node";
+std::vector<const char*> BinaryOperatorNode::operator_types = {"add", "subtract", "multiply", "divide", "matrix multiply"};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace DataFlow
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_BINARY_OPERATOR_NODE_HPP_
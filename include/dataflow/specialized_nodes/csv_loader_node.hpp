@@ -4,8 +4,25 @@
 
 
 //-------------------------------------------------------------------
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
 #include <imfilebrowser.h>
 
+#include <compute/csv_cache.hpp>
+#include <compute/csv_parser.hpp>
+
 #include "../node_styling.hpp"
 #include "../node.hpp"
 #include "../matrix_table_ui.hpp"
@@ -34,7 +51,17 @@ const NodeStyling DEFAULT_CSV_SOURCE_NODE_STYLING(ImVec4(135,100,167,255),
 
 
 //-------------------------------------------------------------------
-// This class represents a Node in a data flow node editor
+// This Node loads the numbers of a csv file
+// -- The file is memory mapped and parsed by the thread pool (see
+//    Compute::CsvParser) from a worker thread, and the node computes
+//    once it's parsed, so the editor doesn't freeze meanwhile
+// -- It's parsed straight into a Compute::MatrixStorage (a spill file
+//    for a big file), which the node adopts rather than copies
+// -- The parsed matrix is cached (see Compute::write_csv_cache), so
+//    loading the same file again maps the cached matrix instead
+// -- In follow mode, the file is polled and only the rows appended
+//    to it are parsed, into the spare rows of the storage, which
+//    grows geometrically so that appending stays cheap
 //-------------------------------------------------------------------
 class CsvLoaderNode : public Node<CsvLoaderNode>
 {
@@ -104,100 +131,550 @@ public:
 
         if(!selected_filename.empty())
         {
-            csv_matrix_.load(selected_filename, true, false);
+            filename_ = selected_filename;
+            start_loading();
+        }
+
+        if(csv_loaded_.valid())
+        {
+            if(csv_loaded_.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                this->compute();
+            else if(!csv_loading_->is_indexed)
+                ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "Indexing csv file...");
+            else
+                ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "Parsing csv file... %.0f%%", 100.0 * csv_loading_->parser.get_progress());
+        }
+
+        ImGui::Dummy(ImVec2(0,30));
+
+        // Headers are skipped when parsing, so the file is parsed again
+        if(ImGui::Checkbox("Includes Row Headers", &does_csv_file_have_row_headers_))
+            start_loading();
+        if(ImGui::Checkbox("Includes Column Headers", &does_csv_file_have_column_headers_))
+            start_loading();
+
+        // Follow mode reparses the file so that its last line is left
+        // out if it's incomplete, then polls it for appended rows
+        if(ImGui::Checkbox("Follow appended rows", &is_following_file_))
+            start_loading();
+
+        if(is_following_file_ && !filename_.empty() &&
+           std::chrono::steady_clock::now() - last_follow_time_ > FOLLOW_POLLING_INTERVAL)
+        {
+            last_follow_time_ = std::chrono::steady_clock::now();
+            parse_appended_rows();
+        }
+
+        if(!loading_error_.empty())
+        {
+            ImGui::TextColored(ImVec4(1.0, 0.0, 0.0, 1.0), "%s", loading_error_.c_str());
+        }
+        else if(was_loaded_from_cache_)
+        {
+            ImGui::Text("Loaded from cache in %.2f s (%lli x %lli)",
+                        loading_time_in_seconds_,
+                        (long long)get_number_of_rows(),
+                        (long long)get_number_of_columns());
+        }
+        else if(loading_time_in_seconds_ > 0)
+        {
+            ImGui::Text("Parsed in %.2f s", loading_time_in_seconds_);
+        }
+
+        // A cached or adopted matrix isn't the node's matrix, it's only
+        // copied into it once an entry gets edited (see apply_entry_edits)
+        if(has_stored_matrix())
+        {
+            std::vector<EntryEdit> entry_edits;
+
+            draw_matrix_table(deferred_matrix_.get_view(), table_state_, this->get_node_size(), are_entries_editable_,
+                              [&entry_edits](int64_t row, int64_t column, double value){ entry_edits.push_back({row, column, value}); });
+
+            apply_entry_edits(entry_edits);
+        }
+        else
+        {
+            draw_matrix_table(matrix_data_, table_state_, this->get_node_size(), are_entries_editable_);
+        }
+    }
+
+
+
+    Pin<MatrixType>* get_output_pin()
+    {
+        return &output_pin_;
+    }
+
+    void compute_internal()
+    {
+        deferred_matrix_.mirror_matrix();
+        load_csv_file(filename_);
+        table_state_.invalidate();
+
+        if(has_stored_matrix())
+            output_pin_.update_data(&matrix_data_, &deferred_matrix_);
+        else
+            output_pin_.update_data(&matrix_data_);
+    }
+
+    // Function used to load the file, from its cached matrix if it
+    // was parsed before, otherwise from what the worker thread parsed
+    // -- Parses it here if no worker thread was started for it (a
+    //    study being loaded for example)
+    void load_csv_file(const std::string& filename)
+    {
+        parsed_file_size_ = 0;
+        was_loaded_from_cache_ = false;
+        loading_error_.clear();
+
+        if(filename.empty())
+            return;
 
-            matrix_data_.resize(csv_matrix_.rows(), csv_matrix_.columns());
+        std::shared_ptr<CsvLoading> csv_loading = take_csv_loading(filename);
+
+        if(!csv_loading)
+        {
+            const auto start_time = std::chrono::steady_clock::now();
 
-            for(int i = 0; i < csv_matrix_.rows(); ++i)
+            csv_loading = make_csv_loading(filename);
+
+            if(find_and_attach_csv_cache(csv_loading->cache_key))
             {
-                for(int j = 0, k = 0; j < csv_matrix_.columns(); ++j, k+=3)
-                {
-                    matrix_data_(i,j) = csv_matrix_(i,j);
-                }
+                loading_time_in_seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+                return;
             }
 
-            output_pin_.update_data(&matrix_data_);
+            load_whole_csv_file(*csv_loading);
         }
 
-        ImGui::Dummy(ImVec2(0,30));
+        loading_time_in_seconds_ = csv_loading->loading_time_in_seconds;
+        column_headers_ = csv_loading->column_headers;
 
-        ImGui::Checkbox("Includes Row Headers", &does_csv_file_have_row_headers_);
-        ImGui::Checkbox("Includes Column Headers", &does_csv_file_have_column_headers_);
-        
-        draw_matrix_text_table(csv_matrix_,
-                               page_index_,
-                               this->get_node_size(),
-                               are_entries_editable_,
-                               does_csv_file_have_column_headers_,
-                               does_csv_file_have_row_headers_);
+        if(!csv_loading->error_message.empty())
+        {
+            loading_error_ = csv_loading->error_message;
+            matrix_data_.resize(0,0);
+            return;
+        }
+
+        // The matrix the worker thread parsed is adopted rather than copied
+        if(csv_loading->storage.size() > 0)
+        {
+            deferred_matrix_.adopt(std::move(csv_loading->storage));
+            matrix_data_.resize(0,0);
+        }
+
+        parsed_file_size_ = csv_loading->parsed_file_size;
+        delimiter_ = csv_loading->delimiter;
     }
 
+    // Function used (in follow mode) to parse the rows appended to
+    // the file since it was last parsed, and publish them downstream
+    // -- A file that shrank was rewritten, so it's loaded again
+    void parse_appended_rows()
+    {
+        std::error_code error;
+        const int64_t file_size = int64_t(std::filesystem::file_size(filename_, error));
 
+        if(error || file_size == parsed_file_size_ || csv_loaded_.valid())
+            return;
 
-    void save_to_json_internal(const std::string& node_name, nlohmann::json* json_file)
+        if(file_size < parsed_file_size_ || parsed_file_size_ == 0)
+        {
+            start_loading();
+            return;
+        }
+
+        const int64_t number_of_rows = get_number_of_rows();
+
+        if(!parse_appended_csv_rows(filename_))
+        {
+            start_loading();
+            return;
+        }
+
+        if(get_number_of_rows() != number_of_rows)
+        {
+            table_state_.invalidate();
+            output_pin_.update_data(&matrix_data_, &deferred_matrix_);
+        }
+    }
+
+
+
+    int64_t get_output_bytes()const
     {
-        (*json_file)["nodes"][node_name]["type"] = node_type.c_str();
+        return deferred_matrix_.get_number_of_bytes();
+    }
 
-        (*json_file)["nodes"][node_name]["selected matrix generator type"] = selected_matrix_generator_type_;
-        (*json_file)["nodes"][node_name]["rows"] = rows_;
-        (*json_file)["nodes"][node_name]["columns"] = columns_;
+    DeferredMatrix* get_reattachable_output()
+    {
+        return &deferred_matrix_;
+    }
 
-        (*json_file)["nodes"][node_name]["constant generator initial value"] = constant_generator_initial_value_;
+    std::vector<std::filesystem::path> get_source_files()const
+    {
+        if(filename_.empty())
+            return {};
+
+        return {filename_};
+    }
 
-        (*json_file)["nodes"][node_name]["iota generator initial value"] = iota_generator_initial_value_;
-        (*json_file)["nodes"][node_name]["iota generator step value"] = iota_generator_step_value_;
+    void rebind_deferred_matrices()
+    {
+        deferred_matrix_.rebind_matrix(&matrix_data_);
+    }
 
-        (*json_file)["nodes"][node_name]["random generator min value"] = random_generator_min_value_;
-        (*json_file)["nodes"][node_name]["random generator max value"] = random_generator_max_value_;
 
-        (*json_file)["nodes"][node_name]["sine wave amplitude"] = sine_wave_amplitude_;
-        (*json_file)["nodes"][node_name]["sine wave frequency"] = sine_wave_frequency_;
-        (*json_file)["nodes"][node_name]["sine wave phase offset in radians"] = sine_wave_phase_offset_in_radians_;
-        (*json_file)["nodes"][node_name]["sine wave y offset"] = sine_wave_y_offset_;
-        (*json_file)["nodes"][node_name]["sine wave delta time"] = sine_wave_delta_time_;
-        (*json_file)["nodes"][node_name]["sine wave initial time"] = sine_wave_initial_time_;
 
+    void save_to_json_internal(const std::string& node_name, nlohmann::json* json_file)
+    {
+        (*json_file)["nodes"][node_name]["type"] = node_type.c_str();
+
+        (*json_file)["nodes"][node_name]["filename"] = filename_;
+        (*json_file)["nodes"][node_name]["includes row headers"] = does_csv_file_have_row_headers_;
+        (*json_file)["nodes"][node_name]["includes column headers"] = does_csv_file_have_column_headers_;
+        (*json_file)["nodes"][node_name]["follow appended rows"] = is_following_file_;
         (*json_file)["nodes"][node_name]["matrix data"] = matrix_data_.get_filename_of_memory_mapped_file();
+
+        (*json_file)["nodes"][node_name]["output pin id"] = output_pin_.get_id();
+    }
+
+    void load_from_json_internal(const std::string& node_name, const nlohmann::json& json_file)
+    {
+        const auto& node_json = json_file["nodes"][node_name];
+
+        filename_ = node_json.value("filename", filename_);
+        does_csv_file_have_row_headers_ = node_json.value("includes row headers", does_csv_file_have_row_headers_);
+        does_csv_file_have_column_headers_ = node_json.value("includes column headers", does_csv_file_have_column_headers_);
+        is_following_file_ = node_json.value("follow appended rows", is_following_file_);
+
+        output_pin_.set_id(node_json.value("output pin id", output_pin_.get_id()));
+        output_pin_.set_parent_node_id(this->get_id());
     }
 
 
 
 private:
 
+    // What's loaded from a whole file on a worker thread
+    // -- The editor reads the parser's progress meanwhile
+    struct CsvLoading
+    {
+        std::string filename;
+        Compute::CsvOptions options;
+        Compute::CsvCacheKey cache_key;     // Empty for followed files, which keep changing
+
+        Compute::CsvParser parser;
+        std::atomic<bool> is_indexed{false};
+
+        Compute::MatrixStorage storage;
+        std::vector<std::string> column_headers;
+        int64_t parsed_file_size = 0;
+        char delimiter = 0;
+
+        double loading_time_in_seconds = 0;
+        std::string error_message;          // Why the file couldn't be loaded, if it couldn't
+    };
+
+
+
+    std::shared_ptr<CsvLoading> make_csv_loading(const std::string& filename)const
+    {
+        auto csv_loading = std::make_shared<CsvLoading>();
+
+        csv_loading->filename = filename;
+        csv_loading->options.has_column_headers = does_csv_file_have_column_headers_;
+        csv_loading->options.has_row_headers = does_csv_file_have_row_headers_;
+        csv_loading->options.skip_incomplete_last_line = is_following_file_;
+
+        if(!is_following_file_)
+            csv_loading->cache_key = Compute::make_csv_cache_key(filename, csv_loading->options);
+
+        return csv_loading;
+    }
+
+    // The future is shared, so that copies of the node (the node
+    // manager copies nodes around) all see the same loading
+    // -- A file parsed before is mapped right away from its cache
+    void start_loading()
+    {
+        csv_loading_.reset();
+        csv_loaded_ = std::shared_future<void>();
+
+        if(filename_.empty())
+            return;
+
+        auto csv_loading = make_csv_loading(filename_);
+
+        if(Compute::find_csv_cache(csv_loading->cache_key, Compute::get_csv_cache_directory()).empty())
+        {
+            csv_loading_ = csv_loading;
+            csv_loaded_ = std::async(std::launch::async, [csv_loading](){ load_whole_csv_file(*csv_loading); }).share();
+        }
+        else
+        {
+            this->compute();
+        }
+    }
+
+    // The loading the worker thread finished (waiting for it if
+    // needed), if it's the one of this file with the current options
+    std::shared_ptr<CsvLoading> take_csv_loading(const std::string& filename)
+    {
+        std::shared_ptr<CsvLoading> csv_loading = std::move(csv_loading_);
+
+        if(csv_loaded_.valid())
+            csv_loaded_.wait();
+
+        csv_loading_.reset();
+        csv_loaded_ = std::shared_future<void>();
+
+        if(!csv_loading ||
+           csv_loading->filename != filename ||
+           csv_loading->options.has_column_headers != does_csv_file_have_column_headers_ ||
+           csv_loading->options.has_row_headers != does_csv_file_have_row_headers_ ||
+           csv_loading->options.skip_incomplete_last_line != is_following_file_)
+        {
+            return nullptr;
+        }
+
+        return csv_loading;
+    }
+
+    struct EntryEdit
+    {
+        int64_t row = 0;
+        int64_t column = 0;
+        double value = 0;
+    };
+
+    // Function used to copy a cached or adopted matrix into the node's
+    // matrix, so that it can be edited, and publish it downstream
+    // -- It's done once the table is drawn, since drawing it reads
+    //    the storage that's released here
+    void apply_entry_edits(const std::vector<EntryEdit>& entry_edits)
+    {
+        if(entry_edits.empty())
+            return;
+
+        deferred_matrix_.materialize();
+        deferred_matrix_.mirror_matrix();
+
+        for(const auto& entry_edit : entry_edits)
+            matrix_data_(entry_edit.row, entry_edit.column) = entry_edit.value;
+
+        table_state_.invalidate();
+        output_pin_.update_data(&matrix_data_);
+    }
+
+    bool has_stored_matrix()const
+    {
+        return deferred_matrix_.is_attached() || deferred_matrix_.is_adopted();
+    }
+
+    int64_t get_number_of_rows()const
+    {
+        return has_stored_matrix() ? deferred_matrix_.rows() : int64_t(matrix_data_.rows());
+    }
+
+    int64_t get_number_of_columns()const
+    {
+        return has_stored_matrix() ? deferred_matrix_.columns() : int64_t(matrix_data_.columns());
+    }
+
+    bool find_and_attach_csv_cache(const Compute::CsvCacheKey& cache_key)
+    {
+        const std::filesystem::path cache_filename = Compute::find_csv_cache(cache_key, Compute::get_csv_cache_directory(), &column_headers_);
+
+        if(cache_filename.empty() || !deferred_matrix_.attach(cache_filename))
+            return false;
+
+        matrix_data_.resize(0,0);
+        was_loaded_from_cache_ = true;
+
+        return true;
+    }
+
+
+
+    static std::unique_ptr<boost::interprocess::mapped_region> map_csv_file(const std::string& filename, int64_t offset, int64_t size)
+    {
+        namespace bip = boost::interprocess;
+
+        try
+        {
+            bip::file_mapping mapping(filename.c_str(), bip::read_only);
+            return std::make_unique<bip::mapped_region>(mapping, bip::read_only, offset, size);
+        }
+        catch(...)
+        {
+            return nullptr;
+        }
+    }
+
+    // Function used (on the worker thread) to parse a whole file, and
+    // cache its matrix unless it's followed
+    // -- Nothing waits on the worker thread's future for an exception,
+    //    so a failure (running out of memory for a big file) is caught
+    //    here and reported through the loading
+    static void load_whole_csv_file(CsvLoading& csv_loading)
+    {
+        const auto start_time = std::chrono::steady_clock::now();
+
+        try
+        {
+            parse_whole_csv_file(csv_loading);
+        }
+        catch(const std::exception& exception)
+        {
+            csv_loading.storage.release();
+            csv_loading.error_message = std::string("Could not load csv file: ") + exception.what();
+        }
+
+        csv_loading.is_indexed = true;
+        csv_loading.loading_time_in_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    }
+
+    static void parse_whole_csv_file(CsvLoading& csv_loading)
+    {
+
+        std::error_code error;
+        const int64_t file_size = int64_t(std::filesystem::file_size(csv_loading.filename, error));
+
+        std::unique_ptr<boost::interprocess::mapped_region> region;
+
+        if(!error && file_size > 0)
+            region = map_csv_file(csv_loading.filename, 0, file_size);
+
+        if(region)
+        {
+            Compute::CsvParser& parser = csv_loading.parser;
+            parser.index(static_cast<const char*>(region->get_address()), file_size, csv_loading.options);
+            csv_loading.is_indexed = true;
+
+            csv_loading.parsed_file_size = parser.get_consumed_size();
+            csv_loading.delimiter = parser.get_delimiter();
+            csv_loading.column_headers = parser.get_column_headers();
+
+            if(parser.rows() > 0 && parser.columns() > 0)
+            {
+                if(!csv_loading.storage.resize(parser.rows(), parser.columns()))
+                    throw std::runtime_error("not enough memory or scratch space for its matrix");
+
+                parser.parse(csv_loading.storage.data());
+
+                Compute::write_csv_cache(csv_loading.cache_key,
+                                         Compute::get_csv_cache_directory(),
+                                         csv_loading.storage.view(),
+                                         csv_loading.column_headers);
+            }
+        }
+    }
+
+    // Function used (in follow mode) to parse the file from where it
+    // was last parsed into the rows after the matrix's
+    // -- The last line is left for later if the file's writer hasn't
+    //    written its newline yet
+    // -- The rows are parsed into the spare rows of the adopted storage,
+    //    which is only reallocated (doubling its rows) once it's full
+    // -- Returns false if the file couldn't be parsed or the storage
+    //    couldn't grow
+    bool parse_appended_csv_rows(const std::string& filename)
+    {
+        std::error_code error;
+        const int64_t file_size = int64_t(std::filesystem::file_size(filename, error));
+
+        if(error)
+            return false;
+
+        const int64_t offset = parsed_file_size_;
+        const int64_t first_row = get_number_of_rows();
+
+        if(file_size <= offset)
+            return true;
+
+        auto region = map_csv_file(filename, offset, file_size - offset);
+
+        if(!region)
+            return false;
+
+        Compute::CsvOptions options;
+        options.has_row_headers = does_csv_file_have_row_headers_;
+        options.skip_incomplete_last_line = true;
+        options.delimiter = delimiter_;
+        options.columns = get_number_of_columns();
+
+        Compute::CsvParser parser;
+        parser.index(static_cast<const char*>(region->get_address()), file_size - offset, options);
+
+        if(parser.rows() == 0 || parser.columns() == 0)
+        {
+            parsed_file_size_ = offset + parser.get_consumed_size();
+            return true;
+        }
+
+        const int64_t columns = parser.columns();
+        const int64_t number_of_rows = first_row + parser.rows();
+
+        // The matrix is mirrored if it was edited (or empty)
+        if(!deferred_matrix_.is_adopted() || deferred_matrix_.get_storage().rows() < number_of_rows)
+        {
+            Compute::MatrixStorage storage;
+
+            if(!storage.resize(std::max(number_of_rows, 2 * first_row), columns))
+                return false;
+
+            const Compute::MatrixView rows = deferred_matrix_.get_view();
+
+            for(int64_t row = 0; row < first_row; ++row)
+                std::memcpy(storage.data() + row * columns, rows.row_pointer(row), columns * sizeof(double));
+
+            deferred_matrix_.adopt(std::move(storage), first_row);
+            matrix_data_.resize(0,0);
+        }
+
+        Compute::MatrixStorage storage = deferred_matrix_.take_storage();
+        parser.parse(storage.data() + first_row * columns);
+        deferred_matrix_.adopt(std::move(storage), number_of_rows);
+
+        parsed_file_size_ = offset + parser.get_consumed_size();
+
+        return true;
+    }
+
+
+
     Pin<MatrixType> output_pin_;
 
     MatrixType matrix_data_;
+    DeferredMatrix deferred_matrix_{&matrix_data_};
     
     bool does_csv_file_have_row_headers_ = false;
     bool does_csv_file_have_column_headers_ = false;
 
-    LazyMatrix::CSVMatrix<double> csv_matrix_;
-    LazyMatrix::CSVMatrix<std::string> csv_string_matrix_;
+    double loading_time_in_seconds_ = 0;
+    bool was_loaded_from_cache_ = false;
+    std::string loading_error_;
 
-    int page_index_ = 0;
+    std::vector<std::string> column_headers_;
 
-    bool are_entries_editable_ = true;
-
-    int selected_matrix_generator_type_ = 0;
-    static std::vector<const char*> matrix_generator_types;
+    // Follow mode
+    static constexpr std::chrono::milliseconds FOLLOW_POLLING_INTERVAL{250};
 
-    int rows_ = 0;
-    int columns_ = 0;
+    bool is_following_file_ = false;
+    int64_t parsed_file_size_ = 0;      // Bytes of the file parsed so far
+    char delimiter_ = 0;
+    std::chrono::steady_clock::time_point last_follow_time_;
 
-    double constant_generator_initial_value_ = 0;
+    MatrixTableState table_state_;
 
-    double iota_generator_initial_value_ = 0;
-    double iota_generator_step_value_ = 1;
+    bool are_entries_editable_ = true;
 
-    double random_generator_min_value_ = 0;
-    double random_generator_max_value_ = 1;
+    std::string filename_;
 
-    double sine_wave_amplitude_ = 1;
-    double sine_wave_frequency_ = 1;
-    double sine_wave_phase_offset_in_radians_ = 0;
-    double sine_wave_y_offset_ = 0;
-    double sine_wave_delta_time_ = 0.1;
-    double sine_wave_initial_time_ = 0;
+    std::shared_ptr<CsvLoading> csv_loading_;
+    std::shared_future<void> csv_loaded_;
 
     static std::string node_type;
 };
@@ -206,8 +683,7 @@ private:
 
 
 //-------------------------------------------------------------------
-std::string CsvLoaderNode::node_type = "Matrix Source Node";
-std::vector<const char*> CsvLoaderNode::matrix_generator_types = {"Constant", "Iota", "Random", "Sine-Wave"};
+std::string CsvLoaderNode::node_type = "Csv Loader Node";
 //-------------------------------------------------------------------
 
 
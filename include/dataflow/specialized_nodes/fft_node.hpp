@@ -0,0 +1,303 @@
+#ifndef INCLUDE_FFT_NODE_HPP_
+#define INCLUDE_FFT_NODE_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <vector>
+
+#include <compute/fft.hpp>
+
+#include "../node_styling.hpp"
+#include "../node.hpp"
+#include "../matrix_table_ui.hpp"
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Define every thing within the namespace DataFlow
+//-------------------------------------------------------------------
+namespace DataFlow
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// This Node computes the Fourier transform (or its inverse) of each
+// row, each column, or the whole of a matrix
+// -- The input is given by its real part ("re") and optionally its
+//    imaginary part ("im", same size), read through their chains, so
+//    deferred inputs aren't materialized first
+// -- The transform is kept complex (ComplexMatrixType), and pins only
+//    carry real matrices, so the output is the selected part of it
+//    (real, imaginary, magnitude, phase or power), which is extracted
+//    again without recomputing the transform when another is selected
+//-------------------------------------------------------------------
+class FftNode : public Node<FftNode>
+{
+public:
+
+    FftNode(std::function<void(Pin<MatrixType>*)> pin_deleted_link_manager_callback)
+    : Node<FftNode>(pin_deleted_link_manager_callback)
+    {
+        this->set_node_styling(DEFAULT_UNARY_OPERATOR_NODE_STYLING);
+
+        output_pin_.update_data(&resulting_matrix_);
+        output_pin_.set_name("out");
+        output_pin_.set_pin_type(PinType::Output);
+        output_pin_.set_parent_node_id(this->get_id());
+
+        real_input_pin_.set_name("re");
+        real_input_pin_.set_pin_type(PinType::Input);
+        real_input_pin_.set_parent_node_id(this->get_id());
+        real_input_pin_.set_notify_parent_node_callback(std::bind(&FftNode::input_data_has_been_updated_callback, this));
+
+        imaginary_input_pin_.set_name("im");
+        imaginary_input_pin_.set_pin_type(PinType::Input);
+        imaginary_input_pin_.set_parent_node_id(this->get_id());
+        imaginary_input_pin_.set_notify_parent_node_callback(std::bind(&FftNode::input_data_has_been_updated_callback, this));
+    }
+
+    ~FftNode()
+    {
+        this->pin_deleted_link_manager_callback_(&real_input_pin_);
+        this->pin_deleted_link_manager_callback_(&imaginary_input_pin_);
+        this->pin_deleted_link_manager_callback_(&output_pin_);
+    }
+
+    const std::string& get_node_type()const
+    {
+        return node_type;
+    }
+
+
+
+    Pin<MatrixType>* find_pin_using_id(int pin_id)
+    {
+        if(real_input_pin_.get_id() == pin_id)
+            return &real_input_pin_;
+
+        if(imaginary_input_pin_.get_id() == pin_id)
+            return &imaginary_input_pin_;
+
+        if(output_pin_.get_id() == pin_id)
+            return &output_pin_;
+
+        return nullptr;
+    }
+
+    int get_number_of_input_pins()const
+    {
+        return 2;
+    }
+
+    int get_number_of_output_pins()const
+    {
+        return 1;
+    }
+
+
+
+    Pin<MatrixType>* get_output_pin()
+    {
+        return &output_pin_;
+    }
+
+    void compute_internal()
+    {
+        input_data_has_been_updated_callback();
+    }
+
+
+
+    void input_data_has_been_updated_callback()
+    {
+        spectrum_.resize(0,0);
+        error_message_.clear();
+
+        if(real_input_pin_.get_data_pointer())
+        {
+            const auto real_part = make_elementwise_chain(real_input_pin_.get_data_pointer(), real_input_pin_.get_deferred_matrix());
+
+            Compute::ElementwiseChain imaginary_part;
+            const bool has_imaginary_part = (imaginary_input_pin_.get_data_pointer() != nullptr);
+
+            if(has_imaginary_part)
+                imaginary_part = make_elementwise_chain(imaginary_input_pin_.get_data_pointer(), imaginary_input_pin_.get_deferred_matrix());
+
+            if(has_imaginary_part && (imaginary_part.rows() != real_part.rows() || imaginary_part.columns() != real_part.columns()))
+            {
+                error_message_ = "sizes of re and im don't match";
+            }
+            else if(real_part.size() > 0)
+            {
+                spectrum_.resize(real_part.rows(), real_part.columns());
+
+                Compute::compute_fft(real_part,
+                                     has_imaginary_part ? &imaginary_part : nullptr,
+                                     static_cast<Compute::FftAxis>(selected_axis_),
+                                     selected_direction_ == 1,
+                                     &spectrum_(0,0));
+            }
+        }
+
+        update_output();
+    }
+
+    // Publishes the selected part of the transform
+    void update_output()
+    {
+        deferred_matrix_.mirror_matrix();
+        table_state_.invalidate();
+
+        resulting_matrix_.resize(spectrum_.rows(), spectrum_.columns());
+
+        if(spectrum_.rows() > 0 && spectrum_.columns() > 0)
+        {
+            Compute::extract_complex_part(&spectrum_(0,0),
+                                          int64_t(spectrum_.rows()) * int64_t(spectrum_.columns()),
+                                          static_cast<Compute::ComplexPart>(selected_part_),
+                                          &resulting_matrix_(0,0));
+        }
+
+        output_pin_.update_data(&resulting_matrix_);
+    }
+
+
+
+    void draw_input_pins()
+    {
+        real_input_pin_.draw();
+        imaginary_input_pin_.draw();
+    }
+
+    void draw_output_pins()
+    {
+        output_pin_.draw();
+    }
+
+    void draw_node_content()
+    {
+        ImGui::PushItemWidth(200);
+
+        bool has_transform_changed = ImGui::Combo("Direction", &selected_direction_, directions.data(), directions.size());
+        has_transform_changed |= ImGui::Combo("Transform", &selected_axis_, axes.data(), axes.size());
+
+        const bool has_part_changed = ImGui::Combo("Output", &selected_part_, parts.data(), parts.size());
+
+        ImGui::PopItemWidth();
+
+        if(has_transform_changed)
+            input_data_has_been_updated_callback();
+        else if(has_part_changed)
+            update_output();
+
+        if(!error_message_.empty())
+            ImGui::TextColored(ImVec4(1.0,0.4,0.4,1.0), "%s", error_message_.c_str());
+
+        draw_matrix_table(resulting_matrix_, table_state_, this->get_node_size(), are_entries_editable_);
+    }
+
+
+
+    // The complex transform is counted along with its published part
+    int64_t get_output_bytes()const
+    {
+        return deferred_matrix_.get_number_of_bytes() +
+               int64_t(spectrum_.rows()) * int64_t(spectrum_.columns()) * int64_t(sizeof(Compute::Complex));
+    }
+
+    DeferredMatrix* get_reattachable_output()
+    {
+        return &deferred_matrix_;
+    }
+
+    void rebind_deferred_matrices()
+    {
+        deferred_matrix_.rebind_matrix(&resulting_matrix_);
+    }
+
+
+
+    void save_to_json_internal(const std::string& node_name, nlohmann::json* json_file)
+    {
+        (*json_file)["nodes"][node_name]["type"] = node_type.c_str();
+
+        (*json_file)["nodes"][node_name]["selected direction"] = selected_direction_;
+        (*json_file)["nodes"][node_name]["selected axis"] = selected_axis_;
+        (*json_file)["nodes"][node_name]["selected part"] = selected_part_;
+        (*json_file)["nodes"][node_name]["resulting matrix"] = resulting_matrix_.get_filename_of_memory_mapped_file();
+
+        (*json_file)["nodes"][node_name]["real input pin id"] = real_input_pin_.get_id();
+        (*json_file)["nodes"][node_name]["imaginary input pin id"] = imaginary_input_pin_.get_id();
+        (*json_file)["nodes"][node_name]["output pin id"] = output_pin_.get_id();
+    }
+
+    void load_from_json_internal(const std::string& node_name, const nlohmann::json& json_file)
+    {
+        const auto& node_json = json_file["nodes"][node_name];
+
+        selected_direction_ = node_json.value("selected direction", selected_direction_);
+        selected_axis_ = node_json.value("selected axis", selected_axis_);
+        selected_part_ = node_json.value("selected part", selected_part_);
+
+        real_input_pin_.set_id(node_json.value("real input pin id", real_input_pin_.get_id()));
+        real_input_pin_.set_parent_node_id(this->get_id());
+
+        imaginary_input_pin_.set_id(node_json.value("imaginary input pin id", imaginary_input_pin_.get_id()));
+        imaginary_input_pin_.set_parent_node_id(this->get_id());
+
+        output_pin_.set_id(node_json.value("output pin id", output_pin_.get_id()));
+        output_pin_.set_parent_node_id(this->get_id());
+    }
+
+
+
+private:
+
+    int selected_direction_ = 0;        // Forward or inverse
+    int selected_axis_ = 0;             // Compute::FftAxis
+    int selected_part_ = 2;             // Compute::ComplexPart (magnitude)
+
+    std::string error_message_;
+
+    ComplexMatrixType spectrum_;
+
+    MatrixType resulting_matrix_;
+    DeferredMatrix deferred_matrix_{&resulting_matrix_};
+
+    MatrixTableState table_state_;
+
+    bool are_entries_editable_ = false;
+
+    Pin<MatrixType> real_input_pin_;
+    Pin<MatrixType> imaginary_input_pin_;
+    Pin<MatrixType> output_pin_;
+
+    static std::string node_type;
+    static std::vector<const char*> directions;
+    static std::vector<const char*> axes;
+    static std::vector<const char*> parts;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+std::string FftNode::node_type = "FFT Node";
+std::vector<const char*> FftNode::directions = {"forward", "inverse"};
+std::vector<const char*> FftNode::axes = {"each row", "each column", "2D"};
+std::vector<const char*> FftNode::parts = {"real", "imaginary", "magnitude", "phase", "power"};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace DataFlow
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_FFT_NODE_HPP_
@@ -4,11 +4,16 @@
 
 
 //-------------------------------------------------------------------
+#include <algorithm>
+#include <utility>
 #include <vector>
 #include <unordered_map>
 
+#include <SFML/Graphics.hpp>
 #include <implot.h>
 
+#include <compute/heat_map_pyramid.hpp>
+
 #include "../node_styling.hpp"
 #include "../node.hpp"
 //-------------------------------------------------------------------
@@ -35,7 +40,12 @@ const NodeStyling DEFAULT_HEAT_MAP_NODE_STYLING(ImVec4(220,  70, 170, 255),
 
 
 //-------------------------------------------------------------------
-// This Node allows a user to augment multiple matrices together
+// This Node allows a user to view a matrix as a heat map
+// -- When the data changes, an aggregated pyramid of it is built
+//    (see Compute::HeatMapPyramid), and each frame only draws the
+//    visible tiles of the level whose cells are about one pixel big
+// -- Tiles are colored into textures the first time they're shown,
+//    and kept until the data changes
 //-------------------------------------------------------------------
 class HeatMapNode : public Node<HeatMapNode>
 {
@@ -92,23 +102,28 @@ public:
 
 
 
+    Pin<MatrixType>* get_output_pin()
+    {
+        return &output_pin_;
+    }
+
+    void compute_internal()
+    {
+        input_data_has_been_updated_callback();
+    }
+
+
+
     void input_data_has_been_updated_callback()
     {
-        output_pin_.update_data(input_pin_.get_data());
+        output_pin_.update_data(input_pin_.get_data_pointer(), input_pin_.get_deferred_matrix());
 
-        if(input_pin_.get_data())
+        if(input_pin_.get_data_pointer())
             output_pin_.set_name("out");
         else
             output_pin_.set_name("out (0x0)");
 
-        // if(input_pin_.get_data())
-        // {
-        //     x_axis_selector_ui_.draw(*input_pin_.get_data(), false, true, false, "", "pick one x-axis");
-        //     y_axes_selector_ui_.draw(*input_pin_.get_data(), false, true, true, "", "pick y-axes");
-            
-        //     x_axis_ = LazyMatrix::transpose( LazyMatrix::select_columns(*input_pin_.get_data(), x_axis_selector_ui_.get_selected_columns_vector()) );
-        //     y_axes_ = LazyMatrix::transpose( LazyMatrix::select_columns(*input_pin_.get_data(), y_axes_selector_ui_.get_selected_columns_vector()) );
-        // }
+        build_pyramid();
     }
     
     
@@ -125,19 +140,32 @@ public:
 
     void draw_node_content()
     {        
-        if(input_pin_.get_data())
+        Compute::MatrixView view = input_pin_.get_view();
+
+        ImGui::BeginGroup();
+            ImGui::Text("Aggregate cells with");
+            if(ImGui::Combo("##aggregation", &selected_aggregation_type_, aggregation_types.data(), aggregation_types.size()))
+                build_pyramid();
+        ImGui::EndGroup();
+
+        if(view.size() == 0 || view.rows() != pyramid_.rows(0) || view.columns() != pyramid_.columns(0))
+            return;
+
+        // The plot uses one unit per cell, with row 0 at the top
+        if(ImPlot::BeginPlot("##Heatmap2", ImVec2(-80,-1)))
         {
-            if(input_pin_.get_data()->size() > 0)
-            {
-                if(ImPlot::BeginPlot("##Heatmap2", ImVec2(-1,-1))) /*ImVec2(this->node_styling_.get_node_maximum_width(), this->node_styling_.get_node_maximum_width())))*/
-                {
-                    ImPlot::SetupAxes(NULL, NULL, ImPlotAxisFlags_NoDecorations, ImPlotAxisFlags_NoDecorations);
-                    ImPlot::SetupAxesLimits(-1,1,-1,1);
-                    ImPlot::PlotHeatmap("heat1",&(*input_pin_.get_data())(0,0), input_pin_.get_data()->rows(), input_pin_.get_data()->columns(), 0, 1, NULL);
-                    ImPlot::EndPlot();
-                }
-            }
+            ImPlot::SetupAxes(NULL, NULL, ImPlotAxisFlags_NoDecorations, ImPlotAxisFlags_NoDecorations);
+            ImPlot::SetupAxesLimits(0, double(view.columns()), 0, double(view.rows()), ImPlotCond_Once);
+
+            draw_visible_tiles(view);
+
+            plotting_rect_limits_ = ImPlot::GetPlotLimits();
+
+            ImPlot::EndPlot();
         }
+
+        ImGui::SameLine();
+        ImPlot::ColormapScale("##scale", pyramid_.get_minimum_value(), pyramid_.get_maximum_value(), ImVec2(0,-1));
     }
 
 
@@ -145,16 +173,186 @@ public:
     void save_to_json_internal(const std::string& node_name, nlohmann::json* json_file)
     {
         (*json_file)["nodes"][node_name]["type"] = node_type.c_str();
+
+        (*json_file)["nodes"][node_name]["selected aggregation type"] = selected_aggregation_type_;
+
+        (*json_file)["nodes"][node_name]["input pin id"] = input_pin_.get_id();
+        (*json_file)["nodes"][node_name]["output pin id"] = output_pin_.get_id();
+    }
+
+    void load_from_json_internal(const std::string& node_name, const nlohmann::json& json_file)
+    {
+        const auto& node_json = json_file["nodes"][node_name];
+
+        selected_aggregation_type_ = node_json.value("selected aggregation type", selected_aggregation_type_);
+
+        input_pin_.set_id(node_json.value("input pin id", input_pin_.get_id()));
+        input_pin_.set_parent_node_id(this->get_id());
+
+        output_pin_.set_id(node_json.value("output pin id", output_pin_.get_id()));
+        output_pin_.set_parent_node_id(this->get_id());
     }
 
 
 
 private:
 
+    // Tiles colored so far are dropped, least recently drawn first, past this many
+    static constexpr std::size_t MAXIMUM_NUMBER_OF_CACHED_TILES = 256;
+
+    struct TileTexture
+    {
+        sf::Texture texture;
+        uint64_t last_drawn_frame = 0;
+    };
+
+
+
+    void build_pyramid()
+    {
+        pyramid_.build(input_pin_.get_view(), static_cast<Compute::HeatMapAggregation>(selected_aggregation_type_));
+        tile_textures_.clear();
+    }
+
+
+
+    // Function used to draw the tiles of the level that has about one
+    // cell per pixel, for the part of the matrix visible last frame
+    void draw_visible_tiles(const Compute::MatrixView& view)
+    {
+        if(colormap_.empty())
+        {
+            colormap_.resize(Compute::HeatMapPyramid::COLORMAP_SIZE);
+
+            for(int64_t i = 0; i < Compute::HeatMapPyramid::COLORMAP_SIZE; ++i)
+            {
+                const ImVec4 color = ImPlot::SampleColormap(float(i) / float(Compute::HeatMapPyramid::COLORMAP_SIZE - 1));
+
+                colormap_[i] = uint32_t(color.x * 255.0f + 0.5f) |
+                               (uint32_t(color.y * 255.0f + 0.5f) << 8) |
+                               (uint32_t(color.z * 255.0f + 0.5f) << 16) |
+                               (uint32_t(255) << 24);
+            }
+        }
+
+        const double rows = double(view.rows());
+        const double columns = double(view.columns());
+
+        double first_row = std::max(0.0, rows - plotting_rect_limits_.Y.Max);
+        double last_row = std::min(rows, rows - plotting_rect_limits_.Y.Min);
+        double first_column = std::max(0.0, plotting_rect_limits_.X.Min);
+        double last_column = std::min(columns, plotting_rect_limits_.X.Max);
+
+        if(last_row <= first_row || last_column <= first_column)
+        {
+            first_row = first_column = 0.0;
+            last_row = rows;
+            last_column = columns;
+        }
+
+        const ImVec2 plot_size = ImPlot::GetPlotSize();
+        const int64_t level = pyramid_.choose_level(last_row - first_row, last_column - first_column, plot_size.y, plot_size.x);
+
+        // Number of rows (or columns) of the matrix a tile covers
+        const int64_t tile_span = Compute::HeatMapPyramid::TILE_SIZE * Compute::HeatMapPyramid::get_cell_size(level);
+
+        const int64_t first_tile_row = int64_t(first_row) / tile_span;
+        const int64_t last_tile_row = std::min(pyramid_.get_number_of_tile_rows(level), (int64_t(std::ceil(last_row)) + tile_span - 1) / tile_span);
+        const int64_t first_tile_column = int64_t(first_column) / tile_span;
+        const int64_t last_tile_column = std::min(pyramid_.get_number_of_tile_columns(level), (int64_t(std::ceil(last_column)) + tile_span - 1) / tile_span);
+
+        // Textures are only dropped before this frame's tiles are plotted,
+        // since ImPlot only draws the plotted textures at the end of the frame
+        ++frame_index_;
+        evict_tile_textures();
+
+        for(int64_t tile_row = first_tile_row; tile_row < last_tile_row; ++tile_row)
+        {
+            for(int64_t tile_column = first_tile_column; tile_column < last_tile_column; ++tile_column)
+            {
+                const sf::Texture& texture = get_tile_texture(view, level, tile_row, tile_column);
+                ImTextureID texture_id = reinterpret_cast<ImTextureID>(static_cast<uintptr_t>(texture.getNativeHandle()));
+
+                const double tile_first_row = double(tile_row * tile_span);
+                const double tile_last_row = std::min(rows, double((tile_row + 1) * tile_span));
+                const double tile_first_column = double(tile_column * tile_span);
+                const double tile_last_column = std::min(columns, double((tile_column + 1) * tile_span));
+
+                ImPlot::PlotImage("##tile",
+                                  texture_id,
+                                  ImPlotPoint(tile_first_column, rows - tile_last_row),
+                                  ImPlotPoint(tile_last_column, rows - tile_first_row));
+            }
+        }
+    }
+
+
+
+    const sf::Texture& get_tile_texture(const Compute::MatrixView& view, int64_t level, int64_t tile_row, int64_t tile_column)
+    {
+        const int64_t key = (level << 48) | (tile_row << 24) | tile_column;
+
+        auto tile_texture = tile_textures_.find(key);
+        if(tile_texture != tile_textures_.end())
+        {
+            tile_texture->second.last_drawn_frame = frame_index_;
+            return tile_texture->second.texture;
+        }
+
+        int64_t tile_rows = 0;
+        int64_t tile_columns = 0;
+        pyramid_.color_tile(view, level, tile_row, tile_column, colormap_, tile_image_, tile_rows, tile_columns);
+
+        TileTexture& new_tile_texture = tile_textures_[key];
+        new_tile_texture.last_drawn_frame = frame_index_;
+
+        sf::Texture& texture = new_tile_texture.texture;
+
+        if(tile_rows > 0 && tile_columns > 0 && texture.create(unsigned(tile_columns), unsigned(tile_rows)))
+            texture.update(reinterpret_cast<const sf::Uint8*>(tile_image_.data()));
+
+        return texture;
+    }
+
+    // Function used to drop the least recently drawn tiles past the
+    // maximum number of cached tiles
+    void evict_tile_textures()
+    {
+        if(tile_textures_.size() <= MAXIMUM_NUMBER_OF_CACHED_TILES)
+            return;
+
+        std::vector<std::pair<uint64_t, int64_t>> tiles;
+        tiles.reserve(tile_textures_.size());
+
+        for(const auto& tile_texture : tile_textures_)
+            tiles.emplace_back(tile_texture.second.last_drawn_frame, tile_texture.first);
+
+        const std::size_t number_of_evicted_tiles = tiles.size() - MAXIMUM_NUMBER_OF_CACHED_TILES;
+
+        std::nth_element(tiles.begin(), tiles.begin() + number_of_evicted_tiles, tiles.end());
+
+        for(std::size_t i = 0; i < number_of_evicted_tiles; ++i)
+            tile_textures_.erase(tiles[i].second);
+    }
+
+
+
+    int selected_aggregation_type_ = 0;
+
+    Compute::HeatMapPyramid pyramid_;
+
+    std::vector<uint32_t> colormap_;
+    std::vector<uint32_t> tile_image_;
+    std::unordered_map<int64_t, TileTexture> tile_textures_;
+    uint64_t frame_index_ = 0;
+
+    ImPlotRect plotting_rect_limits_;
+
     Pin<MatrixType> input_pin_;
     Pin<MatrixType> output_pin_;
 
     static std::string node_type;
+    static std::vector<const char*> aggregation_types;
 };
 //-------------------------------------------------------------------
 
@@ -162,6 +360,7 @@ private:
 
 //-------------------------------------------------------------------
 std::string HeatMapNode::node_type = "Heat Map Node";
+std::vector<const char*> HeatMapNode::aggregation_types = {"mean", "max"};
 //-------------------------------------------------------------------
 
 
@@ -4,7 +4,14 @@
 
 
 //-------------------------------------------------------------------
+#include <chrono>
+#include <future>
+#include <memory>
+
 #include <imfilebrowser.h>
+#include <SFML/Graphics.hpp>
+
+#include <compute/image_conversion.hpp>
 
 #include "../node_styling.hpp"
 #include "../node.hpp"
@@ -34,7 +41,12 @@ const NodeStyling DEFAULT_IMAGE_SOURCE_NODE_STYLING(ImVec4(135,100,167,255),
 
 
 //-------------------------------------------------------------------
-// This class represents a Node in a data flow node editor
+// This Node loads an rgb image as a matrix with 3 columns per pixel
+// -- The image is decoded into 8-bit rgba pixels, which are converted
+//    into the matrix by the thread pool (see Compute::convert_rgb_image)
+// -- An image picked with the file browser is decoded on a worker
+//    thread, and the node computes once it's decoded, so the editor
+//    doesn't freeze while big images are being decoded
 //-------------------------------------------------------------------
 class ImageLoaderNode : public Node<ImageLoaderNode>
 {
@@ -104,88 +116,171 @@ public:
 
         if(!selected_filename.empty())
         {
-            LazyMatrix::ImageMatrix<dlib::rgb_pixel> loaded_image(selected_filename);
+            filename_ = selected_filename;
+            start_decoding(filename_);
+        }
+
+        if(decoded_image_.valid())
+        {
+            if(decoded_image_.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                this->compute();
+            else
+                ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "Decoding image...");
+        }
+
+        ImGui::PushItemWidth(200);
+        if(ImGui::Combo("Channel layout", &selected_channel_layout_, "packed (r,g,b per pixel)\0planar (reds, greens, blues)\0\0") && !filename_.empty())
+            start_decoding(filename_);
+        ImGui::PopItemWidth();
+
+        ImGui::Dummy(ImVec2(0,30));
+
+        draw_matrix_table(matrix_data_, table_state_, this->get_node_size(), are_entries_editable_);
+    }
+
 
-            matrix_data_.resize(loaded_image.rows(), loaded_image.columns() * 3);    
 
-            for(int i = 0; i < loaded_image.rows(); ++i)
-            {
-                for(int j = 0, k = 0; j < loaded_image.columns(); ++j, k+=3)
-                {
-                    matrix_data_(i,k) = loaded_image(i,j).red;
-                    matrix_data_(i,k+1) = loaded_image(i,j).green;
-                    matrix_data_(i,k+2) = loaded_image(i,j).blue;
-                }
-            }
+    Pin<MatrixType>* get_output_pin()
+    {
+        return &output_pin_;
+    }
 
-            output_pin_.update_data(&matrix_data_);
+    void compute_internal()
+    {
+        deferred_matrix_.mirror_matrix();
+        load_image(filename_);
+        table_state_.invalidate();
+        output_pin_.update_data(&matrix_data_);
+    }
+
+    // Loads an rgb image as a matrix with 3 columns (r,g,b) per pixel
+    // -- Uses the image decoded on the worker thread if it's this one,
+    //    otherwise (a study being loaded for example) decodes it here
+    void load_image(const std::string& filename)
+    {
+        if(filename.empty())
+            return;
+
+        std::shared_ptr<sf::Image> image;
+
+        if(decoded_image_.valid() && decoded_filename_ == filename)
+            image = decoded_image_.get();
+        else
+            image = decode_image(filename);
+
+        // The decoded pixels aren't needed once converted
+        decoded_image_ = std::shared_future<std::shared_ptr<sf::Image>>();
+
+        if(!image)
+        {
+            matrix_data_.resize(0,0);
+            return;
         }
 
-        ImGui::Dummy(ImVec2(0,30));
+        const int64_t rows = image->getSize().y;
+        const int64_t columns = image->getSize().x;
+
+        matrix_data_.resize(rows, columns * 3);
 
-        draw_matrix_table(matrix_data_, page_index_, this->get_node_size(), are_entries_editable_);
+        if(matrix_data_.size() > 0)
+        {
+            Compute::convert_rgb_image(image->getPixelsPtr(),
+                                       4,
+                                       rows,
+                                       columns,
+                                       Compute::ChannelLayout(selected_channel_layout_),
+                                       &matrix_data_(0,0));
+        }
     }
 
 
 
-    void save_to_json_internal(const std::string& node_name, nlohmann::json* json_file)
+    int64_t get_output_bytes()const
     {
-        (*json_file)["nodes"][node_name]["type"] = node_type.c_str();
+        return deferred_matrix_.get_number_of_bytes();
+    }
 
-        (*json_file)["nodes"][node_name]["selected matrix generator type"] = selected_matrix_generator_type_;
-        (*json_file)["nodes"][node_name]["rows"] = rows_;
-        (*json_file)["nodes"][node_name]["columns"] = columns_;
+    DeferredMatrix* get_reattachable_output()
+    {
+        return &deferred_matrix_;
+    }
+
+    std::vector<std::filesystem::path> get_source_files()const
+    {
+        if(filename_.empty())
+            return {};
 
-        (*json_file)["nodes"][node_name]["constant generator initial value"] = constant_generator_initial_value_;
+        return {filename_};
+    }
+
+    void rebind_deferred_matrices()
+    {
+        deferred_matrix_.rebind_matrix(&matrix_data_);
+    }
 
-        (*json_file)["nodes"][node_name]["iota generator initial value"] = iota_generator_initial_value_;
-        (*json_file)["nodes"][node_name]["iota generator step value"] = iota_generator_step_value_;
 
-        (*json_file)["nodes"][node_name]["random generator min value"] = random_generator_min_value_;
-        (*json_file)["nodes"][node_name]["random generator max value"] = random_generator_max_value_;
 
-        (*json_file)["nodes"][node_name]["sine wave amplitude"] = sine_wave_amplitude_;
-        (*json_file)["nodes"][node_name]["sine wave frequency"] = sine_wave_frequency_;
-        (*json_file)["nodes"][node_name]["sine wave phase offset in radians"] = sine_wave_phase_offset_in_radians_;
-        (*json_file)["nodes"][node_name]["sine wave y offset"] = sine_wave_y_offset_;
-        (*json_file)["nodes"][node_name]["sine wave delta time"] = sine_wave_delta_time_;
-        (*json_file)["nodes"][node_name]["sine wave initial time"] = sine_wave_initial_time_;
+    void save_to_json_internal(const std::string& node_name, nlohmann::json* json_file)
+    {
+        (*json_file)["nodes"][node_name]["type"] = node_type.c_str();
 
+        (*json_file)["nodes"][node_name]["filename"] = filename_;
+        (*json_file)["nodes"][node_name]["selected channel layout"] = selected_channel_layout_;
         (*json_file)["nodes"][node_name]["matrix data"] = matrix_data_.get_filename_of_memory_mapped_file();
+
+        (*json_file)["nodes"][node_name]["output pin id"] = output_pin_.get_id();
+    }
+
+    void load_from_json_internal(const std::string& node_name, const nlohmann::json& json_file)
+    {
+        const auto& node_json = json_file["nodes"][node_name];
+
+        filename_ = node_json.value("filename", filename_);
+        selected_channel_layout_ = node_json.value("selected channel layout", selected_channel_layout_);
+
+        output_pin_.set_id(node_json.value("output pin id", output_pin_.get_id()));
+        output_pin_.set_parent_node_id(this->get_id());
     }
 
 
 
 private:
 
-    Pin<MatrixType> output_pin_;
+    static std::shared_ptr<sf::Image> decode_image(const std::string& filename)
+    {
+        auto image = std::make_shared<sf::Image>();
 
-    MatrixType matrix_data_;
+        if(!image->loadFromFile(filename))
+            image.reset();
 
-    int page_index_ = 0;
+        return image;
+    }
+
+    // The future is shared, so that copies of the node (the node
+    // manager copies nodes around) all see the same decoding
+    void start_decoding(const std::string& filename)
+    {
+        decoded_filename_ = filename;
+        decoded_image_ = std::async(std::launch::async, &ImageLoaderNode::decode_image, filename).share();
+    }
 
-    bool are_entries_editable_ = true;
 
-    int selected_matrix_generator_type_ = 0;
-    static std::vector<const char*> matrix_generator_types;
 
-    int rows_ = 0;
-    int columns_ = 0;
+    Pin<MatrixType> output_pin_;
 
-    double constant_generator_initial_value_ = 0;
+    MatrixType matrix_data_;
+    DeferredMatrix deferred_matrix_{&matrix_data_};
+
+    MatrixTableState table_state_;
+
+    bool are_entries_editable_ = true;
 
-    double iota_generator_initial_value_ = 0;
-    double iota_generator_step_value_ = 1;
+    std::string filename_;
 
-    double random_generator_min_value_ = 0;
-    double random_generator_max_value_ = 1;
+    int selected_channel_layout_ = 0;   // Compute::ChannelLayout
 
-    double sine_wave_amplitude_ = 1;
-    double sine_wave_frequency_ = 1;
-    double sine_wave_phase_offset_in_radians_ = 0;
-    double sine_wave_y_offset_ = 0;
-    double sine_wave_delta_time_ = 0.1;
-    double sine_wave_initial_time_ = 0;
+    std::string decoded_filename_;
+    std::shared_future<std::shared_ptr<sf::Image>> decoded_image_;
 
     static std::string node_type;
 };
@@ -194,8 +289,7 @@ private:
 
 
 //-------------------------------------------------------------------
-std::string ImageLoaderNode::node_type = "Matrix Source Node";
-std::vector<const char*> ImageLoaderNode::matrix_generator_types = {"Constant", "Iota", "Random", "Sine-Wave"};
+std::string ImageLoaderNode::node_type = "Image Loader Node";
 //-------------------------------------------------------------------
 
 
@@ -0,0 +1,441 @@
+#ifndef INCLUDE_IMAGE_SEQUENCE_NODE_HPP_
+#define INCLUDE_IMAGE_SEQUENCE_NODE_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <imfilebrowser.h>
+#include <SFML/Graphics.hpp>
+
+#include <compute/image_conversion.hpp>
+#include <compute/image_sequence.hpp>
+
+#include "../node_styling.hpp"
+#include "../node.hpp"
+#include "../matrix_table_ui.hpp"
+
+#include <utils/file_browser.hpp>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Define every thing within the namespace DataFlow
+//-------------------------------------------------------------------
+namespace DataFlow
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// This Node steps through a sequence of images, one frame at a time
+// -- The sequence is every image of the picked image's directory with
+//    the same extension, in natural order (frame_2 before frame_10)
+// -- The current frame is output as a matrix with 3 columns per pixel,
+//    like the ImageLoaderNode does
+// -- The current and next frames are decoded ahead on a few worker
+//    threads into a bounded ring (see Compute::PrefetchRing), so
+//    playing the sequence mostly finds its frames already decoded
+// -- Frames are never decoded on the editor's thread, the previous
+//    frame is output until the one asked for is decoded
+//-------------------------------------------------------------------
+class ImageSequenceNode : public Node<ImageSequenceNode>
+{
+public:
+
+    // How many frames are decoded ahead of the current one
+    static constexpr int64_t NUMBER_OF_PREFETCHED_FRAMES = 4;
+
+    ImageSequenceNode(std::function<void(Pin<MatrixType>*)> pin_deleted_link_manager_callback)
+    : Node<ImageSequenceNode>(pin_deleted_link_manager_callback)
+    {
+        this->set_node_styling(DEFAULT_MATRIX_SOURCE_NODE_STYLING);
+
+        output_pin_.update_data(&matrix_data_);
+        output_pin_.set_name("out");
+        output_pin_.set_pin_type(PinType::Output);
+        output_pin_.set_parent_node_id(this->get_id());
+    }
+
+    ~ImageSequenceNode()
+    {
+        this->pin_deleted_link_manager_callback_(&output_pin_);
+    }
+
+    const std::string& get_node_type()const
+    {
+        return node_type;
+    }
+
+
+
+    Pin<MatrixType>* find_pin_using_id(int pin_id)
+    {
+        if(output_pin_.get_id() == pin_id)
+            return &output_pin_;
+
+        return nullptr;
+    }
+
+    int get_number_of_input_pins()const
+    {
+        return 0;
+    }
+
+    int get_number_of_output_pins()const
+    {
+        return 1;
+    }
+
+
+
+    void draw_input_pins()
+    {
+    }
+
+    void draw_output_pins()
+    {
+        output_pin_.draw();
+    }
+
+    void draw_node_content()
+    {
+        if(ImGui::Button("Load Image Sequence"))
+        {
+            LazyApp::FileBrowserManager::open_file_browser(this->get_id(),
+            { ".png", ".jpg", ".jpeg", ".bmp", ".tiff", ".tif", ".gif", ".svg" });
+        }
+
+        std::string selected_filename = LazyApp::FileBrowserManager::has_selected(this->get_id());
+
+        if(!selected_filename.empty())
+        {
+            filename_ = selected_filename;
+            list_frames();
+            this->compute();
+        }
+
+        const int64_t number_of_frames = int64_t(frame_filenames_.size());
+
+        if(number_of_frames == 0)
+        {
+            ImGui::Text("Pick any image of the sequence");
+            return;
+        }
+
+        ImGui::PushItemWidth(200);
+
+        if(ImGui::Button("<"))
+            go_to_frame(frame_index_ - 1);
+        ImGui::SameLine();
+        if(ImGui::Button(">"))
+            go_to_frame(frame_index_ + 1);
+        ImGui::SameLine();
+        ImGui::Checkbox("Play", &is_playing_);
+        ImGui::SameLine();
+        ImGui::Checkbox("Loop", &is_looping_);
+
+        int frame_index = int(frame_index_);
+        if(ImGui::SliderInt("Frame", &frame_index, 0, int(number_of_frames - 1)))
+            go_to_frame(frame_index);
+
+        if(ImGui::Combo("Channel layout", &selected_channel_layout_, "packed (r,g,b per pixel)\0planar (reds, greens, blues)\0\0"))
+            this->compute();
+
+        ImGui::PopItemWidth();
+
+        // Only move on once the next frame is decoded, so playing never
+        // stalls the editor on a frame that's still being decoded
+        if(is_playing_)
+        {
+            const int64_t next_frame_index = get_next_frame_index();
+
+            if(next_frame_index < 0)
+                is_playing_ = false;
+            else if(prefetch_ring_.is_ready(next_frame_index))
+                go_to_frame(next_frame_index);
+        }
+
+        // Output the frame asked for once it's decoded
+        if(displayed_frame_index_ != frame_index_)
+        {
+            if(prefetch_ring_.is_ready(frame_index_))
+                this->compute();
+            else if(!prefetch_ring_.contains(frame_index_))
+                prefetch_frames();
+        }
+
+        ImGui::Text("%s", std::filesystem::path(frame_filenames_[frame_index_]).filename().string().c_str());
+
+        if(displayed_frame_index_ != frame_index_)
+        {
+            ImGui::SameLine();
+            ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "(decoding frame...)");
+        }
+        else if(prefetch_ring_.get_number_of_loading_frames() > 0)
+        {
+            ImGui::SameLine();
+            ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "(decoding ahead...)");
+        }
+
+        ImGui::Dummy(ImVec2(0,30));
+
+        draw_matrix_table(matrix_data_, table_state_, this->get_node_size(), are_entries_editable_);
+    }
+
+
+
+    Pin<MatrixType>* get_output_pin()
+    {
+        return &output_pin_;
+    }
+
+    void compute_internal()
+    {
+        deferred_matrix_.mirror_matrix();
+        load_frame();
+        table_state_.invalidate();
+        output_pin_.update_data(&matrix_data_);
+    }
+
+
+
+    int64_t get_output_bytes()const
+    {
+        return deferred_matrix_.get_number_of_bytes();
+    }
+
+    DeferredMatrix* get_reattachable_output()
+    {
+        return &deferred_matrix_;
+    }
+
+    std::vector<std::filesystem::path> get_source_files()const
+    {
+        if(filename_.empty())
+            return {};
+
+        return {filename_};
+    }
+
+    void rebind_deferred_matrices()
+    {
+        deferred_matrix_.rebind_matrix(&matrix_data_);
+    }
+
+
+
+    void save_to_json_internal(const std::string& node_name, nlohmann::json* json_file)
+    {
+        (*json_file)["nodes"][node_name]["type"] = node_type.c_str();
+
+        (*json_file)["nodes"][node_name]["filename"] = filename_;
+        (*json_file)["nodes"][node_name]["frame index"] = frame_index_;
+        (*json_file)["nodes"][node_name]["loop"] = is_looping_;
+        (*json_file)["nodes"][node_name]["selected channel layout"] = selected_channel_layout_;
+        (*json_file)["nodes"][node_name]["matrix data"] = matrix_data_.get_filename_of_memory_mapped_file();
+
+        (*json_file)["nodes"][node_name]["output pin id"] = output_pin_.get_id();
+    }
+
+    void load_from_json_internal(const std::string& node_name, const nlohmann::json& json_file)
+    {
+        const auto& node_json = json_file["nodes"][node_name];
+
+        filename_ = node_json.value("filename", filename_);
+        is_looping_ = node_json.value("loop", is_looping_);
+        selected_channel_layout_ = node_json.value("selected channel layout", selected_channel_layout_);
+
+        list_frames();
+
+        if(!frame_filenames_.empty())
+            frame_index_ = std::clamp(node_json.value("frame index", frame_index_), int64_t(0), int64_t(frame_filenames_.size()) - 1);
+
+        output_pin_.set_id(node_json.value("output pin id", output_pin_.get_id()));
+        output_pin_.set_parent_node_id(this->get_id());
+    }
+
+
+
+private:
+
+    static std::shared_ptr<sf::Image> decode_image(const std::string& filename)
+    {
+        auto image = std::make_shared<sf::Image>();
+
+        if(!image->loadFromFile(filename))
+            image.reset();
+
+        return image;
+    }
+
+    // Lists the sequence of the picked image and starts on it
+    void list_frames()
+    {
+        frame_filenames_.clear();
+        frame_index_ = 0;
+        displayed_frame_index_ = -1;
+
+        for(const auto& frame_filename : Compute::list_image_sequence(filename_))
+        {
+            if(frame_filename == std::filesystem::path(filename_))
+                frame_index_ = int64_t(frame_filenames_.size());
+
+            frame_filenames_.push_back(frame_filename.string());
+        }
+
+        // The loader copies the filenames, so copies of the node (the
+        // node manager copies nodes around) can share the ring
+        prefetch_ring_.set_loader([frame_filenames = frame_filenames_](int64_t index)
+        {
+            if(index < 0 || index >= int64_t(frame_filenames.size()))
+                return std::shared_ptr<sf::Image>();
+
+            return decode_image(frame_filenames[index]);
+        });
+    }
+
+    // The frame played after the current one, -1 at the end of a sequence that doesn't loop
+    int64_t get_next_frame_index()const
+    {
+        const int64_t number_of_frames = int64_t(frame_filenames_.size());
+
+        if(frame_index_ + 1 < number_of_frames)
+            return frame_index_ + 1;
+
+        return (is_looping_ && number_of_frames > 0) ? 0 : -1;
+    }
+
+    void go_to_frame(int64_t frame_index)
+    {
+        if(frame_filenames_.empty())
+            return;
+
+        frame_index = std::clamp(frame_index, int64_t(0), int64_t(frame_filenames_.size()) - 1);
+
+        if(frame_index == frame_index_)
+            return;
+
+        frame_index_ = frame_index;
+        prefetch_frames();
+
+        // Otherwise the node computes once the frame is decoded
+        if(prefetch_ring_.is_ready(frame_index_))
+            this->compute();
+    }
+
+    // Keeps the ring decoding the current frame and the ones played after it
+    void prefetch_frames()
+    {
+        const int64_t number_of_frames = int64_t(frame_filenames_.size());
+
+        std::vector<int64_t> frame_indices = {frame_index_};
+
+        for(int64_t i = 1; i <= NUMBER_OF_PREFETCHED_FRAMES && i < number_of_frames; ++i)
+        {
+            int64_t frame_index = frame_index_ + i;
+
+            if(frame_index >= number_of_frames)
+            {
+                if(!is_looping_)
+                    break;
+
+                frame_index -= number_of_frames;
+            }
+
+            frame_indices.push_back(frame_index);
+        }
+
+        prefetch_ring_.prefetch(frame_indices);
+    }
+
+    // Converts the current frame into the matrix if it's decoded,
+    // otherwise the previous one stays until it is
+    void load_frame()
+    {
+        if(frame_filenames_.empty())
+        {
+            matrix_data_.resize(0,0);
+            displayed_frame_index_ = -1;
+            return;
+        }
+
+        prefetch_frames();
+
+        std::shared_ptr<sf::Image> image;
+
+        if(!prefetch_ring_.try_get(frame_index_, image))
+            return;
+
+        displayed_frame_index_ = frame_index_;
+
+        if(!image)
+        {
+            matrix_data_.resize(0,0);
+            return;
+        }
+
+        const int64_t rows = image->getSize().y;
+        const int64_t columns = image->getSize().x;
+
+        matrix_data_.resize(rows, columns * 3);
+
+        if(matrix_data_.size() > 0)
+        {
+            Compute::convert_rgb_image(image->getPixelsPtr(),
+                                       4,
+                                       rows,
+                                       columns,
+                                       Compute::ChannelLayout(selected_channel_layout_),
+                                       &matrix_data_(0,0));
+        }
+    }
+
+
+
+    Pin<MatrixType> output_pin_;
+
+    MatrixType matrix_data_;
+    DeferredMatrix deferred_matrix_{&matrix_data_};
+
+    MatrixTableState table_state_;
+
+    bool are_entries_editable_ = true;
+
+    std::string filename_;                      // The picked image of the sequence
+    std::vector<std::string> frame_filenames_;
+    int64_t frame_index_ = 0;
+    int64_t displayed_frame_index_ = -1;       // Frame in the matrix, -1 if none
+
+    bool is_playing_ = false;
+    bool is_looping_ = false;
+
+    int selected_channel_layout_ = 0;           // Compute::ChannelLayout
+
+    Compute::PrefetchRing<std::shared_ptr<sf::Image>> prefetch_ring_{NUMBER_OF_PREFETCHED_FRAMES + 1};
+
+    static std::string node_type;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+std::string ImageSequenceNode::node_type = "Image Sequence Node";
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace DataFlow
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_IMAGE_SEQUENCE_NODE_HPP_
@@ -4,6 +4,8 @@
 
 
 //-------------------------------------------------------------------
+#include <compute/matrix_generator.hpp>
+
 #include "../node_styling.hpp"
 #include "../node.hpp"
 #include "../matrix_table_ui.hpp"
@@ -34,11 +36,19 @@ const NodeStyling DEFAULT_MATRIX_SOURCE_NODE_STYLING(
 
 //-------------------------------------------------------------------
 // This class represents a Node in a data flow node editor
+// -- The generated matrix is published as a procedural chain (see
+//    Compute::MatrixGenerator), so nothing is stored until something
+//    downstream materializes it, which fills it in parallel
+// -- Random matrices are reproducible: their elements only depend on
+//    their position and the seed, not on how many threads fill them
 //-------------------------------------------------------------------
 class MatrixSourceNode : public Node<MatrixSourceNode>
 {
 public:
 
+    // Generated matrices up to this many elements are shown in the table
+    static constexpr int64_t MAX_NUMBER_OF_PREVIEWED_ELEMENTS = int64_t(1) << 20;
+
     MatrixSourceNode(std::function<void(Pin<MatrixType>*)> pin_deleted_link_manager_callback)
     : Node<MatrixSourceNode>(pin_deleted_link_manager_callback)
     {
@@ -122,6 +132,7 @@ public:
             case 2: // Random Matrix
                 ImGui::InputDouble("Min Value", &random_generator_min_value_, 0.0, 0.0, "%lf", ImGuiInputTextFlags_CharsDecimal);
                 ImGui::InputDouble("Max Value", &random_generator_max_value_, 0.0, 0.0, "%lf", ImGuiInputTextFlags_CharsDecimal);
+                ImGui::InputInt("Seed", &random_generator_seed_);
             break;
 
             case 3: // Sine wave Matrix
@@ -136,32 +147,108 @@ public:
         
         if(ImGui::Button("Generate Matrix"))
         {
-            switch(selected_matrix_generator_type_)
-            {
-                default:
-                case 0: // Constant Matrix
-                    matrix_data_.create_matrix(rows_, columns_, constant_generator_initial_value_);
-                break;
-
-                case 1: // Increasing/Descreasing Matrix
-                    matrix_data_ = LazyMatrix::Iota<double>(rows_, columns_, iota_generator_initial_value_, iota_generator_step_value_);
-                break;
-
-                case 2: // Random Matrix
-                    matrix_data_ = LazyMatrix::RandomMatrix<double>(rows_, columns_, random_generator_min_value_, random_generator_max_value_);
-                break;
-
-                case 3: // Sine wave Matrix
-                    matrix_data_ = LazyMatrix::SineWaveMatrix<double>(rows_, sine_wave_amplitude_, sine_wave_frequency_, sine_wave_phase_offset_in_radians_, sine_wave_y_offset_, sine_wave_delta_time_, sine_wave_initial_time_);
-                break;
-            }
-            
-            output_pin_.update_data(&matrix_data_);
+            this->compute();
         }
 
         ImGui::Dummy(ImVec2(0,30));
 
-        draw_matrix_table(matrix_data_, page_index_, this->get_node_size(), are_entries_editable_);
+        // Small matrices are generated to be shown, big ones only when
+        // something downstream asks for them
+        const int64_t number_of_elements = deferred_matrix_.get_chain().size();
+
+        if(int64_t(matrix_data_.size()) != number_of_elements && number_of_elements <= MAX_NUMBER_OF_PREVIEWED_ELEMENTS)
+        {
+            deferred_matrix_.materialize();
+            table_state_.invalidate();
+        }
+
+        if(int64_t(matrix_data_.size()) == number_of_elements)
+        {
+            draw_matrix_table(matrix_data_, table_state_, this->get_node_size(), are_entries_editable_);
+        }
+        else
+        {
+            ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "Generated on demand:");
+            ImGui::SameLine();
+            ImGui::Text("(%lldx%lld)", (long long)deferred_matrix_.rows(), (long long)deferred_matrix_.columns());
+        }
+    }
+
+
+
+    Pin<MatrixType>* get_output_pin()
+    {
+        return &output_pin_;
+    }
+
+    void compute_internal()
+    {
+        matrix_data_.resize(0,0);
+        deferred_matrix_.set_chain(Compute::ElementwiseChain::generate(make_matrix_generator()));
+        table_state_.invalidate();
+        output_pin_.update_data(&matrix_data_, &deferred_matrix_);
+    }
+
+    // Describes the selected matrix, without generating it
+    Compute::MatrixGenerator make_matrix_generator()const
+    {
+        Compute::MatrixGenerator generator;
+        generator.rows = rows_;
+        generator.columns = columns_;
+
+        switch(selected_matrix_generator_type_)
+        {
+            default:
+            case 0: // Constant Matrix
+                generator.type = Compute::GeneratorType::Constant;
+                generator.value = constant_generator_initial_value_;
+            break;
+
+            case 1: // Increasing/Descreasing Matrix
+                generator.type = Compute::GeneratorType::Iota;
+                generator.initial_value = iota_generator_initial_value_;
+                generator.step = iota_generator_step_value_;
+            break;
+
+            case 2: // Random Matrix
+                generator.type = Compute::GeneratorType::Random;
+                generator.min_value = random_generator_min_value_;
+                generator.max_value = random_generator_max_value_;
+                generator.seed = uint64_t(uint32_t(random_generator_seed_));
+            break;
+
+            case 3: // Sine wave Matrix (a single column)
+                generator.type = Compute::GeneratorType::SineWave;
+                generator.columns = 1;
+                generator.amplitude = sine_wave_amplitude_;
+                generator.frequency = sine_wave_frequency_;
+                generator.phase_offset_in_radians = sine_wave_phase_offset_in_radians_;
+                generator.y_offset = sine_wave_y_offset_;
+                generator.delta_time = sine_wave_delta_time_;
+                generator.initial_time = sine_wave_initial_time_;
+            break;
+        }
+
+        return generator;
+    }
+
+
+
+    int64_t get_output_bytes()const
+    {
+        return deferred_matrix_.get_number_of_bytes();
+    }
+
+    // A generated matrix is cheaper to generate again than to save with
+    // a study or keep around, so it's evictable rather than reattachable
+    DeferredMatrix* get_evictable_output()
+    {
+        return &deferred_matrix_;
+    }
+
+    void rebind_deferred_matrices()
+    {
+        deferred_matrix_.rebind_matrix(&matrix_data_);
     }
 
 
@@ -181,6 +268,7 @@ public:
 
         (*json_file)["nodes"][node_name]["random generator min value"] = random_generator_min_value_;
         (*json_file)["nodes"][node_name]["random generator max value"] = random_generator_max_value_;
+        (*json_file)["nodes"][node_name]["random generator seed"] = random_generator_seed_;
 
         (*json_file)["nodes"][node_name]["sine wave amplitude"] = sine_wave_amplitude_;
         (*json_file)["nodes"][node_name]["sine wave frequency"] = sine_wave_frequency_;
@@ -190,6 +278,36 @@ public:
         (*json_file)["nodes"][node_name]["sine wave initial time"] = sine_wave_initial_time_;
 
         (*json_file)["nodes"][node_name]["matrix data"] = matrix_data_.get_filename_of_memory_mapped_file();
+
+        (*json_file)["nodes"][node_name]["output pin id"] = output_pin_.get_id();
+    }
+
+    void load_from_json_internal(const std::string& node_name, const nlohmann::json& json_file)
+    {
+        const auto& node_json = json_file["nodes"][node_name];
+
+        selected_matrix_generator_type_ = node_json.value("selected matrix generator type", selected_matrix_generator_type_);
+        rows_ = node_json.value("rows", rows_);
+        columns_ = node_json.value("columns", columns_);
+
+        constant_generator_initial_value_ = node_json.value("constant generator initial value", constant_generator_initial_value_);
+
+        iota_generator_initial_value_ = node_json.value("iota generator initial value", iota_generator_initial_value_);
+        iota_generator_step_value_ = node_json.value("iota generator step value", iota_generator_step_value_);
+
+        random_generator_min_value_ = node_json.value("random generator min value", random_generator_min_value_);
+        random_generator_max_value_ = node_json.value("random generator max value", random_generator_max_value_);
+        random_generator_seed_ = node_json.value("random generator seed", random_generator_seed_);
+
+        sine_wave_amplitude_ = node_json.value("sine wave amplitude", sine_wave_amplitude_);
+        sine_wave_frequency_ = node_json.value("sine wave frequency", sine_wave_frequency_);
+        sine_wave_phase_offset_in_radians_ = node_json.value("sine wave phase offset in radians", sine_wave_phase_offset_in_radians_);
+        sine_wave_y_offset_ = node_json.value("sine wave y offset", sine_wave_y_offset_);
+        sine_wave_delta_time_ = node_json.value("sine wave delta time", sine_wave_delta_time_);
+        sine_wave_initial_time_ = node_json.value("sine wave initial time", sine_wave_initial_time_);
+
+        output_pin_.set_id(node_json.value("output pin id", output_pin_.get_id()));
+        output_pin_.set_parent_node_id(this->get_id());
     }
 
 
@@ -199,8 +317,9 @@ private:
     Pin<MatrixType> output_pin_;
 
     MatrixType matrix_data_;
+    DeferredMatrix deferred_matrix_{&matrix_data_};
 
-    int page_index_ = 0;
+    MatrixTableState table_state_;
 
     bool are_entries_editable_ = true;
 
@@ -217,6 +336,7 @@ private:
 
     double random_generator_min_value_ = 0;
     double random_generator_max_value_ = 1;
+    int random_generator_seed_ = 0;
 
     double sine_wave_amplitude_ = 1;
     double sine_wave_frequency_ = 1;
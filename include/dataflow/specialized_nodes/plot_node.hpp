@@ -4,11 +4,19 @@
 
 
 //-------------------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <future>
+#include <memory>
 #include <vector>
 #include <unordered_map>
 
 #include <implot.h>
 
+#include <compute/line_decimation.hpp>
+#include <compute/transpose.hpp>
+
 #include "../node_styling.hpp"
 #include "../node.hpp"
 //-------------------------------------------------------------------
@@ -35,7 +43,13 @@ const NodeStyling DEFAULT_PLOT_NODE_STYLING(ImVec4(220,20,50,255),
 
 
 //-------------------------------------------------------------------
-// This Node allows a user to augment multiple matrices together
+// This Node allows a user to plot columns of a matrix against another
+// -- Long lines are not plotted point by point, each line gets a
+//    min/max decimation pyramid (see Compute::LineDecimation) when
+//    the data changes, and each frame only plots about two points
+//    per pixel of the part of the lines that is visible
+// -- The pyramids are built on a worker thread, from a copy of the
+//    picked columns, and the previous lines are plotted meanwhile
 //-------------------------------------------------------------------
 class PlotNode : public Node<PlotNode>
 {
@@ -92,22 +106,35 @@ public:
 
 
 
+    Pin<MatrixType>* get_output_pin()
+    {
+        return &output_pin_;
+    }
+
+    void compute_internal()
+    {
+        input_data_has_been_updated_callback();
+    }
+
+
+
     void input_data_has_been_updated_callback()
     {
-        output_pin_.update_data(input_pin_.get_data());
+        output_pin_.update_data(input_pin_.get_data_pointer(), input_pin_.get_deferred_matrix());
 
-        if(input_pin_.get_data())
+        if(input_pin_.get_data_pointer())
             output_pin_.set_name("out");
         else
             output_pin_.set_name("out (0x0)");
 
-        if(input_pin_.get_data())
+        if(input_pin_.get_data_pointer())
         {
-            x_axis_selector_ui_.draw(*input_pin_.get_data(), false, true, false, "", "pick one x-axis");
-            y_axes_selector_ui_.draw(*input_pin_.get_data(), false, true, true, "", "pick y-axes");
+            // Drop selections that no longer fit the data without drawing
+            // anything, so that the plot can be computed without a window
+            x_axis_selector_ui_.fit_to_size(input_pin_.get_number_of_rows(), input_pin_.get_number_of_columns());
+            y_axes_selector_ui_.fit_to_size(input_pin_.get_number_of_rows(), input_pin_.get_number_of_columns());
             
-            x_axis_ = LazyMatrix::transpose( LazyMatrix::select_columns(*input_pin_.get_data(), x_axis_selector_ui_.get_selected_columns_vector()) );
-            y_axes_ = LazyMatrix::transpose( LazyMatrix::select_columns(*input_pin_.get_data(), y_axes_selector_ui_.get_selected_columns_vector()) );
+            build_plotted_lines();
         }
     }
     
@@ -124,26 +151,37 @@ public:
     }
 
     void draw_node_content()
-    {        
-        if(input_pin_.get_data())
+    {
+        if(lines_built_.valid() && lines_built_.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            plotted_lines_ = std::move(building_lines_);
+            building_lines_.reset();
+            lines_built_ = std::shared_future<void>();
+
+            if(are_plotted_lines_outdated_)
+                build_plotted_lines();
+        }
+
+        if(input_pin_.get_data_pointer())
         {
-            if(input_pin_.get_data()->size() > 0)
+            // Only the size of the input is needed to draw the selectors,
+            // so a deferred input isn't materialized every frame
+            const int64_t number_of_rows = input_pin_.get_number_of_rows();
+            const int64_t number_of_columns = input_pin_.get_number_of_columns();
+
+            if(number_of_rows > 0 && number_of_columns > 0)
             {
                 ImGui::Dummy(ImVec2(0,30));
 
                     ImGui::BeginGroup();
 
-                    if(x_axis_selector_ui_.draw(*input_pin_.get_data(), false, true, false, "", "pick one x-axis"))
-                    {
-                        x_axis_ = LazyMatrix::transpose( LazyMatrix::select_columns(*input_pin_.get_data(), x_axis_selector_ui_.get_selected_columns_vector()) );
-                    }
+                    if(x_axis_selector_ui_.draw(number_of_rows, number_of_columns, false, true, false, "", "pick one x-axis"))
+                        build_plotted_lines();
                     
                     ImGui::Spacing();
 
-                    if(y_axes_selector_ui_.draw(*input_pin_.get_data(), false, true, true, "", "pick y-axes"))
-                    {
-                        y_axes_ = LazyMatrix::transpose( LazyMatrix::select_columns(*input_pin_.get_data(), y_axes_selector_ui_.get_selected_columns_vector()) );
-                    }
+                    if(y_axes_selector_ui_.draw(number_of_rows, number_of_columns, false, true, true, "", "pick y-axes"))
+                        build_plotted_lines();
 
                     ImGui::EndGroup();
 
@@ -159,24 +197,26 @@ public:
                     ImPlot::SetupAxes("x","f(x)");
                     ImPlot::SetNextMarkerStyle(ImPlotMarker_Circle);
 
-                    if(y_axes_.size() > 0)
+                    // The lines are decimated for the x-range and width the
+                    // plot had last frame, it's only off while zooming
+                    const int64_t number_of_pixels = int64_t(ImPlot::GetPlotSize().x);
+
+                    const std::size_t number_of_lines = plotted_lines_ ? plotted_lines_->line_decimations.size() : 0;
+
+                    for(std::size_t i = 0; i < number_of_lines; ++i)
                     {
-                        for(int i = 0; i < y_axes_.rows(); ++i)
-                        {
-                            if(x_axis_.size() > 0)
-                            {
-                                ImPlot::PlotLine((std::string("line: ") + std::to_string(i)).c_str(),
-                                                 &x_axis_(0,0),
-                                                 &y_axes_(i,0),
-                                                 y_axes_.columns());
-                            }
-                            else
-                            {
-                                ImPlot::PlotLine((std::string("line: ") + std::to_string(i)).c_str(),
-                                                 &y_axes_(i,0),
-                                                 y_axes_.columns());
-                            }
-                        }
+                        plotted_lines_->line_decimations[i].get_points(plotted_lines_->get_x_axis_data(),
+                                                                       plotted_lines_->get_y_axis_data(int64_t(i)),
+                                                                       plotting_rect_limits_.X.Min,
+                                                                       plotting_rect_limits_.X.Max,
+                                                                       number_of_pixels,
+                                                                       plotted_xs_,
+                                                                       plotted_ys_);
+
+                        ImPlot::PlotLine((std::string("line: ") + std::to_string(i)).c_str(),
+                                         plotted_xs_.data(),
+                                         plotted_ys_.data(),
+                                         int(plotted_ys_.size()));
                     }
 
                     // Get the current plot limits
@@ -191,23 +231,163 @@ public:
 
 
 
+    int64_t get_output_bytes()const
+    {
+        int64_t bytes = int64_t(plotting_matrix_.size() * sizeof(double));
+
+        if(plotted_lines_)
+            bytes += plotted_lines_->get_number_of_bytes();
+
+        if(building_lines_)
+            bytes += building_lines_->get_number_of_bytes();
+
+        return bytes;
+    }
+
+
+
     void save_to_json_internal(const std::string& node_name, nlohmann::json* json_file)
     {
         (*json_file)["nodes"][node_name]["type"] = node_type.c_str();
 
         x_axis_selector_ui_.save_to_json_internal(node_name, "x axis selector ui", json_file);
         y_axes_selector_ui_.save_to_json_internal(node_name, "y axis selector ui", json_file);
+
+        (*json_file)["nodes"][node_name]["input pin id"] = input_pin_.get_id();
+        (*json_file)["nodes"][node_name]["output pin id"] = output_pin_.get_id();
+    }
+
+    void load_from_json_internal(const std::string& node_name, const nlohmann::json& json_file)
+    {
+        const auto& node_json = json_file["nodes"][node_name];
+
+        x_axis_selector_ui_.load_from_json_internal(node_name, "x axis selector ui", json_file);
+        y_axes_selector_ui_.load_from_json_internal(node_name, "y axis selector ui", json_file);
+
+        input_pin_.set_id(node_json.value("input pin id", input_pin_.get_id()));
+        input_pin_.set_parent_node_id(this->get_id());
+
+        output_pin_.set_id(node_json.value("output pin id", output_pin_.get_id()));
+        output_pin_.set_parent_node_id(this->get_id());
     }
 
 
 
 private:
 
-    MatrixType x_axis_;
-    MatrixType y_axes_;
+    // The lines plotted, copied from the input so that their pyramids
+    // can be built on a worker thread while the input changes
+    struct PlottedLines
+    {
+        std::vector<double> x_axis;         // Empty to plot the lines against their index
+        std::vector<double> y_axes;         // One line after the other
+        int64_t number_of_points = 0;
+
+        std::vector<Compute::LineDecimation> line_decimations;
+
+        const double* get_x_axis_data()const
+        {
+            return x_axis.empty() ? nullptr : x_axis.data();
+        }
+
+        const double* get_y_axis_data(int64_t line)const
+        {
+            return y_axes.data() + line * number_of_points;
+        }
+
+        // The pyramid of a line takes about one byte per point
+        int64_t get_number_of_bytes()const
+        {
+            return int64_t((x_axis.size() + y_axes.size()) * sizeof(double)) +
+                   int64_t(line_decimations.size()) * number_of_points;
+        }
+
+        // Function used (on the worker thread) to build the decimation pyramid of each line
+        void build_line_decimations()
+        {
+            line_decimations.assign(number_of_points > 0 ? y_axes.size() / number_of_points : 0, Compute::LineDecimation());
+
+            for(int64_t i = 0; i < int64_t(line_decimations.size()); ++i)
+                line_decimations[i].build(get_x_axis_data(), get_y_axis_data(i), number_of_points);
+        }
+    };
+
+
+
+    // Function used to copy the columns picked with a selector into
+    // axes (one contiguous line per column)
+    void extract_axes(const SelectorUI& selector_ui, std::vector<double>& axes)
+    {
+        Compute::MatrixView input_view = input_pin_.get_view();
+
+        std::vector<int64_t> columns;
+        for(int64_t column : selector_ui.get_selected_columns_vector())
+        {
+            if(column >= 0 && column < input_view.columns())
+                columns.push_back(column);
+        }
+
+        axes.resize(columns.size() * input_view.rows());
+
+        if(!axes.empty())
+            Compute::transpose_columns(input_view, columns.data(), int64_t(columns.size()), axes.data(), input_view.rows());
+    }
+
+
+
+    // Function used to copy the picked lines and build their pyramids
+    // on a worker thread
+    // -- If lines are already being built, they're copied and built
+    //    again once those are done, so that builds don't pile up
+    void build_plotted_lines()
+    {
+        if(lines_built_.valid())
+        {
+            are_plotted_lines_outdated_ = true;
+            return;
+        }
+
+        are_plotted_lines_outdated_ = false;
+
+        if(!input_pin_.get_data_pointer())
+            return;
+
+        auto lines = std::make_shared<PlottedLines>();
+        lines->number_of_points = input_pin_.get_number_of_rows();
+
+        // Only the first x-axis picked is used
+        extract_axes(x_axis_selector_ui_, lines->x_axis);
+        lines->x_axis.resize(std::min(lines->x_axis.size(), std::size_t(lines->number_of_points)));
+
+        extract_axes(y_axes_selector_ui_, lines->y_axes);
+
+        building_lines_ = lines;
+        lines_built_ = std::async(std::launch::async, [lines]()
+        {
+            try
+            {
+                lines->build_line_decimations();
+            }
+            catch(const std::exception&)
+            {
+                // The lines are left out of the plot rather than ending the editor
+                lines->line_decimations.clear();
+            }
+        }).share();
+    }
+
+
+
+    std::vector<double> plotted_xs_;
+    std::vector<double> plotted_ys_;
 
     MatrixType plotting_matrix_;
 
+    std::shared_ptr<const PlottedLines> plotted_lines_;
+    std::shared_ptr<PlottedLines> building_lines_;
+    std::shared_future<void> lines_built_;
+    bool are_plotted_lines_outdated_ = false;
+
     ImPlotRect plotting_rect_limits_;
 
     SelectorUI x_axis_selector_ui_;
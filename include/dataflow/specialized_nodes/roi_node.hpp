@@ -34,6 +34,9 @@ const NodeStyling DEFAULT_ROI_NODE_STYLING(ImVec4(30,220,50,255),
 //-------------------------------------------------------------------
 // This Node allows a user to grab a Region Of Interest from an
 // input matrix
+// -- The region is never copied, moving it only changes the chain
+//    published downstream, and readers of the output view it in
+//    place in the input's memory (see DeferredMatrix::get_view)
 //-------------------------------------------------------------------
 class ROINode : public Node<ROINode>
 {
@@ -91,21 +94,25 @@ public:
 
 
 
+    Pin<MatrixType>* get_output_pin()
+    {
+        return &output_pin_;
+    }
+
+    void compute_internal()
+    {
+        input_data_has_been_updated_callback();
+    }
+
+
+
     void input_data_has_been_updated_callback()
     {
-        if(input_pin_.get_data())
-        {
-            if(input_pin_.get_data()->size() > 0)
-                resulting_matrix_ = LazyMatrix::roi(*input_pin_.get_data(), row1_, column1_, row2_, column2_);
-            else
-                resulting_matrix_.resize(0,0);
-        }
-        else
-        {
-            resulting_matrix_.resize(0,0);
-        }
-        
-        output_pin_.update_data(&resulting_matrix_);
+        auto chain = make_elementwise_chain(input_pin_.get_data_pointer(), input_pin_.get_deferred_matrix());
+        chain.select_region(row1_, column1_, row2_, column2_);
+
+        deferred_matrix_.set_chain(chain);
+        output_pin_.update_data(&resulting_matrix_, &deferred_matrix_);
     }
     
     
@@ -142,7 +149,7 @@ public:
 
             ImGui::Dummy(ImVec2(0,20));
 
-            if(input_pin_.get_data())
+            if(input_pin_.get_data_pointer())
             {
                 if(ImGui::Button("Grab Region Of Interest (ROI)"))
                 {
@@ -156,9 +163,7 @@ public:
                         previous_row2_ = row2_;
                         previous_column2_ = column2_;
 
-                        resulting_matrix_ = LazyMatrix::roi(*input_pin_.get_data(), row1_, column1_, row2_, column2_);
-
-                        output_pin_.update_data(&resulting_matrix_);
+                        input_data_has_been_updated_callback();
                     }
                 }
             }
@@ -168,6 +173,28 @@ public:
 
 
 
+    int64_t get_output_bytes()const
+    {
+        return deferred_matrix_.get_number_of_bytes();
+    }
+
+    DeferredMatrix* get_evictable_output()
+    {
+        return output_pin_.get_deferred_matrix();
+    }
+
+    DeferredMatrix* get_reattachable_output()
+    {
+        return &deferred_matrix_;
+    }
+
+    void rebind_deferred_matrices()
+    {
+        deferred_matrix_.rebind_matrix(&resulting_matrix_);
+    }
+
+
+
     void save_to_json_internal(const std::string& node_name, nlohmann::json* json_file)
     {
         (*json_file)["nodes"][node_name]["type"] = node_type.c_str();
@@ -178,7 +205,27 @@ public:
         (*json_file)["nodes"][node_name]["row2"] = row2_;
         (*json_file)["nodes"][node_name]["column2"] = column2_;
 
+        deferred_matrix_.materialize();
         (*json_file)["nodes"][node_name]["resulting matrix"] = resulting_matrix_.get_filename_of_memory_mapped_file();
+
+        (*json_file)["nodes"][node_name]["input pin id"] = input_pin_.get_id();
+        (*json_file)["nodes"][node_name]["output pin id"] = output_pin_.get_id();
+    }
+
+    void load_from_json_internal(const std::string& node_name, const nlohmann::json& json_file)
+    {
+        const auto& node_json = json_file["nodes"][node_name];
+
+        row1_ = previous_row1_ = node_json.value("row1", row1_);
+        column1_ = previous_column1_ = node_json.value("column1", column1_);
+        row2_ = previous_row2_ = node_json.value("row2", row2_);
+        column2_ = previous_column2_ = node_json.value("column2", column2_);
+
+        input_pin_.set_id(node_json.value("input pin id", input_pin_.get_id()));
+        input_pin_.set_parent_node_id(this->get_id());
+
+        output_pin_.set_id(node_json.value("output pin id", output_pin_.get_id()));
+        output_pin_.set_parent_node_id(this->get_id());
     }
 
 
@@ -201,6 +248,7 @@ private:
     int previous_column2_ = 0;
 
     MatrixType resulting_matrix_;
+    DeferredMatrix deferred_matrix_{&resulting_matrix_};
 
     Pin<MatrixType> input_pin_;
     Pin<MatrixType> output_pin_;
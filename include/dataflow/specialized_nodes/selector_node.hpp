@@ -92,27 +92,26 @@ public:
 
 
 
-    void input_data_has_been_updated_callback()
+    Pin<MatrixType>* get_output_pin()
     {
-        if(!input_pin_.get_data())
-            resulting_matrix_.resize(0,0);
+        return &output_pin_;
+    }
 
-        else if(input_pin_.get_data()->size() == 0)
-            resulting_matrix_.resize(0,0);
+    void compute_internal()
+    {
+        input_data_has_been_updated_callback();
+    }
 
-        else if(selector_ui_.get_selected_rows_vector().size() == 0 ||
-                selector_ui_.get_selected_columns_vector().size() == 0)
-        {
-            resulting_matrix_.resize(0,0);
-        }
-        else
-        {
-            resulting_matrix_ = LazyMatrix::select_rows_and_columns(*input_pin_.get_data(),
-                                                                    selector_ui_.get_selected_rows_vector(),
-                                                                    selector_ui_.get_selected_columns_vector());
-        }
-        
-        output_pin_.update_data(&resulting_matrix_);
+
+
+    void input_data_has_been_updated_callback()
+    {
+        auto chain = make_elementwise_chain(input_pin_.get_data_pointer(), input_pin_.get_deferred_matrix());
+        chain.select_rows_and_columns(selector_ui_.get_selected_rows_vector(),
+                                      selector_ui_.get_selected_columns_vector());
+
+        deferred_matrix_.set_chain(chain);
+        output_pin_.update_data(&resulting_matrix_, &deferred_matrix_);
     }
     
     
@@ -129,34 +128,58 @@ public:
 
     void draw_node_content()
     {        
-        if(input_pin_.get_data())
+        if(input_pin_.get_number_of_rows() > 0 && input_pin_.get_number_of_columns() > 0)
         {
-            if(input_pin_.get_data()->size() > 0)
-            {
-                if(selector_ui_.draw(*input_pin_.get_data(), true, true, true))
-                {
-                    if(selector_ui_.get_selected_rows_vector().size() == 0 || selector_ui_.get_selected_columns_vector().size() == 0)
-                    {
-                        resulting_matrix_.resize(0,0);
-                    }
-                    else
-                    {
-                        resulting_matrix_ = LazyMatrix::select_rows_and_columns(*input_pin_.get_data(),
-                                                                                selector_ui_.get_selected_rows_vector(),
-                                                                                selector_ui_.get_selected_columns_vector());
-                    }
-                }
-            }
+            if(selector_ui_.draw(input_pin_.get_number_of_rows(), input_pin_.get_number_of_columns(), true, true, true))
+                input_data_has_been_updated_callback();
         }
     }
 
 
 
+    int64_t get_output_bytes()const
+    {
+        return deferred_matrix_.get_number_of_bytes();
+    }
+
+    DeferredMatrix* get_evictable_output()
+    {
+        return output_pin_.get_deferred_matrix();
+    }
+
+    DeferredMatrix* get_reattachable_output()
+    {
+        return &deferred_matrix_;
+    }
+
+    void rebind_deferred_matrices()
+    {
+        deferred_matrix_.rebind_matrix(&resulting_matrix_);
+    }
+
+
+
     void save_to_json_internal(const std::string& node_name, nlohmann::json* json_file)
     {
         (*json_file)["nodes"][node_name]["type"] = node_type.c_str();
 
         selector_ui_.save_to_json_internal(node_name, "selector ui", json_file);
+
+        (*json_file)["nodes"][node_name]["input pin id"] = input_pin_.get_id();
+        (*json_file)["nodes"][node_name]["output pin id"] = output_pin_.get_id();
+    }
+
+    void load_from_json_internal(const std::string& node_name, const nlohmann::json& json_file)
+    {
+        const auto& node_json = json_file["nodes"][node_name];
+
+        selector_ui_.load_from_json_internal(node_name, "selector ui", json_file);
+
+        input_pin_.set_id(node_json.value("input pin id", input_pin_.get_id()));
+        input_pin_.set_parent_node_id(this->get_id());
+
+        output_pin_.set_id(node_json.value("output pin id", output_pin_.get_id()));
+        output_pin_.set_parent_node_id(this->get_id());
     }
 
 
@@ -164,6 +187,7 @@ public:
 private:
 
     MatrixType resulting_matrix_;
+    DeferredMatrix deferred_matrix_{&resulting_matrix_};
 
     SelectorUI selector_ui_;
 
@@ -7,7 +7,9 @@
 // Data Sources Nodes
 #include "matrix_source_node.hpp"
 #include "image_loader_node.hpp"
+#include "image_sequence_node.hpp"
 #include "csv_loader_node.hpp"
+#include "binary_loader_node.hpp"
 
 // Data Augmenting Nodes
 #include "augment_node.hpp"
@@ -18,6 +20,9 @@
 
 // Data Matrix Operation Nodes
 #include "unary_operator_node.hpp"
+#include "binary_operator_node.hpp"
+#include "statistics_node.hpp"
+#include "fft_node.hpp"
 
 // Data Visualization Nodes
 #include "table_node.hpp"
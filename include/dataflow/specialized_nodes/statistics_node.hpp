@@ -0,0 +1,246 @@
+#ifndef INCLUDE_STATISTICS_NODE_HPP_
+#define INCLUDE_STATISTICS_NODE_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <vector>
+
+#include <compute/statistics.hpp>
+
+#include "../node_styling.hpp"
+#include "../node.hpp"
+#include "../matrix_table_ui.hpp"
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Define every thing within the namespace DataFlow
+//-------------------------------------------------------------------
+namespace DataFlow
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// This Node summarizes its input matrix
+// -- The sum, mean, variance, min, max, NaN count and L2 norm of the
+//    whole matrix, of each row or of each column, one row of the
+//    output per summarized unit, one column per statistic (in the
+//    order of Compute::Statistic)
+// -- The input is read through its elementwise chain, so a deferred
+//    input is evaluated block by block while it's summarized, and a
+//    mapped one is streamed once, without being copied
+//-------------------------------------------------------------------
+class StatisticsNode : public Node<StatisticsNode>
+{
+public:
+
+    StatisticsNode(std::function<void(Pin<MatrixType>*)> pin_deleted_link_manager_callback)
+    : Node<StatisticsNode>(pin_deleted_link_manager_callback)
+    {
+        this->set_node_styling(DEFAULT_UNARY_OPERATOR_NODE_STYLING);
+
+        output_pin_.update_data(&resulting_matrix_);
+        output_pin_.set_name("out");
+        output_pin_.set_pin_type(PinType::Output);
+        output_pin_.set_parent_node_id(this->get_id());
+
+        input_pin_.set_name("in");
+        input_pin_.set_pin_type(PinType::Input);
+        input_pin_.set_parent_node_id(this->get_id());
+        input_pin_.set_notify_parent_node_callback(std::bind(&StatisticsNode::input_data_has_been_updated_callback, this));
+    }
+
+    ~StatisticsNode()
+    {
+        this->pin_deleted_link_manager_callback_(&input_pin_);
+        this->pin_deleted_link_manager_callback_(&output_pin_);
+    }
+
+    const std::string& get_node_type()const
+    {
+        return node_type;
+    }
+
+
+
+    Pin<MatrixType>* find_pin_using_id(int pin_id)
+    {
+        if(input_pin_.get_id() == pin_id)
+            return &input_pin_;
+
+        if(output_pin_.get_id() == pin_id)
+            return &output_pin_;
+
+        return nullptr;
+    }
+
+    int get_number_of_input_pins()const
+    {
+        return 1;
+    }
+
+    int get_number_of_output_pins()const
+    {
+        return 1;
+    }
+
+
+
+    Pin<MatrixType>* get_output_pin()
+    {
+        return &output_pin_;
+    }
+
+    void compute_internal()
+    {
+        input_data_has_been_updated_callback();
+    }
+
+
+
+    void input_data_has_been_updated_callback()
+    {
+        deferred_matrix_.mirror_matrix();
+        table_state_.invalidate();
+
+        const auto chain = make_elementwise_chain(input_pin_.get_data_pointer(), input_pin_.get_deferred_matrix());
+
+        std::vector<Compute::Statistics> statistics;
+
+        if(chain.size() > 0)
+        {
+            switch(selected_axis_)
+            {
+                default:
+                case 0: statistics.push_back(Compute::compute_statistics(chain)); break;
+                case 1: statistics = Compute::compute_row_statistics(chain); break;
+                case 2: statistics = Compute::compute_column_statistics(chain); break;
+            }
+        }
+
+        resulting_matrix_.resize(statistics.size(), statistics.empty() ? 0 : Compute::NUMBER_OF_STATISTICS);
+
+        for(std::size_t i = 0; i < statistics.size(); ++i)
+        {
+            for(int j = 0; j < Compute::NUMBER_OF_STATISTICS; ++j)
+                resulting_matrix_(i, j) = statistics[i].get(Compute::Statistic(j));
+        }
+
+        output_pin_.update_data(&resulting_matrix_);
+    }
+
+
+
+    void draw_input_pins()
+    {
+        input_pin_.draw();
+    }
+
+    void draw_output_pins()
+    {
+        output_pin_.draw();
+    }
+
+    void draw_node_content()
+    {
+        ImGui::PushItemWidth(200);
+
+        if(ImGui::Combo("Statistics of", &selected_axis_, axes.data(), axes.size()))
+            input_data_has_been_updated_callback();
+
+        ImGui::PopItemWidth();
+
+        ImGui::Text("Columns: sum, mean, variance, min, max, NaN count, L2 norm");
+
+        draw_matrix_table(resulting_matrix_, table_state_, this->get_node_size(), are_entries_editable_);
+    }
+
+
+
+    int64_t get_output_bytes()const
+    {
+        return deferred_matrix_.get_number_of_bytes();
+    }
+
+    DeferredMatrix* get_evictable_output()
+    {
+        return output_pin_.get_deferred_matrix();
+    }
+
+    DeferredMatrix* get_reattachable_output()
+    {
+        return &deferred_matrix_;
+    }
+
+    void rebind_deferred_matrices()
+    {
+        deferred_matrix_.rebind_matrix(&resulting_matrix_);
+    }
+
+
+
+    void save_to_json_internal(const std::string& node_name, nlohmann::json* json_file)
+    {
+        (*json_file)["nodes"][node_name]["type"] = node_type.c_str();
+
+        (*json_file)["nodes"][node_name]["selected axis"] = selected_axis_;
+        (*json_file)["nodes"][node_name]["resulting matrix"] = resulting_matrix_.get_filename_of_memory_mapped_file();
+
+        (*json_file)["nodes"][node_name]["input pin id"] = input_pin_.get_id();
+        (*json_file)["nodes"][node_name]["output pin id"] = output_pin_.get_id();
+    }
+
+    void load_from_json_internal(const std::string& node_name, const nlohmann::json& json_file)
+    {
+        const auto& node_json = json_file["nodes"][node_name];
+
+        selected_axis_ = node_json.value("selected axis", selected_axis_);
+
+        input_pin_.set_id(node_json.value("input pin id", input_pin_.get_id()));
+        input_pin_.set_parent_node_id(this->get_id());
+
+        output_pin_.set_id(node_json.value("output pin id", output_pin_.get_id()));
+        output_pin_.set_parent_node_id(this->get_id());
+    }
+
+
+
+private:
+
+    int selected_axis_ = 0;             // Whole matrix, rows or columns
+
+    MatrixType resulting_matrix_;
+    DeferredMatrix deferred_matrix_{&resulting_matrix_};
+
+    MatrixTableState table_state_;
+
+    bool are_entries_editable_ = false;
+
+    Pin<MatrixType> input_pin_;
+    Pin<MatrixType> output_pin_;
+
+    static std::string node_type;
+    static std::vector<const char*> axes;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+std::string StatisticsNode::node_type = "Statistics Node";
+std::vector<const char*> StatisticsNode::axes = {"whole matrix", "each row", "each column"};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace DataFlow
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_STATISTICS_NODE_HPP_
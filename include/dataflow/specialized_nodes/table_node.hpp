@@ -92,9 +92,22 @@ public:
 
 
 
+    Pin<MatrixType>* get_output_pin()
+    {
+        return &output_pin_;
+    }
+
+    void compute_internal()
+    {
+        input_data_has_been_updated_callback();
+    }
+
+
+
     void input_data_has_been_updated_callback()
     {
-        output_pin_.update_data(input_pin_.get_data());
+        output_pin_.update_data(input_pin_.get_data_pointer(), input_pin_.get_deferred_matrix());
+        table_state_.invalidate();
     }
     
     
@@ -111,10 +124,18 @@ public:
 
     void draw_node_content()
     {
-        if(input_pin_.get_data())
+        if(input_pin_.get_deferred_matrix())
         {
+            // A deferred (fused, generated or mapped) input is shown from
+            // its chain, and read only, edits would land in a mirror that
+            // the next evaluation overwrites
+            DeferredMatrix* deferred_matrix = input_pin_.get_deferred_matrix();
 
-            if(draw_matrix_table(*input_pin_.get_data(), page_index_, this->get_node_size(), are_entries_editable_))
+            draw_matrix_table(deferred_matrix->get_chain(), deferred_matrix, table_state_, this->get_node_size());
+        }
+        else if(input_pin_.get_data_pointer())
+        {
+            if(draw_matrix_table(*input_pin_.get_data_pointer(), table_state_, this->get_node_size(), are_entries_editable_))
             {
                 // This means the user updated the data manually by changinge it
                 // directly in the table
@@ -130,6 +151,22 @@ public:
         (*json_file)["nodes"][node_name]["type"] = node_type.c_str();
 
         (*json_file)["nodes"][node_name]["are entries editable"] = are_entries_editable_;
+
+        (*json_file)["nodes"][node_name]["input pin id"] = input_pin_.get_id();
+        (*json_file)["nodes"][node_name]["output pin id"] = output_pin_.get_id();
+    }
+
+    void load_from_json_internal(const std::string& node_name, const nlohmann::json& json_file)
+    {
+        const auto& node_json = json_file["nodes"][node_name];
+
+        are_entries_editable_ = node_json.value("are entries editable", are_entries_editable_);
+
+        input_pin_.set_id(node_json.value("input pin id", input_pin_.get_id()));
+        input_pin_.set_parent_node_id(this->get_id());
+
+        output_pin_.set_id(node_json.value("output pin id", output_pin_.get_id()));
+        output_pin_.set_parent_node_id(this->get_id());
     }
 
 
@@ -141,7 +178,7 @@ private:
 
     bool are_entries_editable_ = true;
 
-    int page_index_ = 0;
+    MatrixTableState table_state_;
 
     static std::string node_type;
 };
@@ -6,6 +6,8 @@
 //-------------------------------------------------------------------
 #include <vector>
 
+#include <compute/transpose.hpp>
+
 #include "../node_styling.hpp"
 #include "../node.hpp"
 //-------------------------------------------------------------------
@@ -90,48 +92,50 @@ public:
 
 
 
+    Pin<MatrixType>* get_output_pin()
+    {
+        return &output_pin_;
+    }
+
+    void compute_internal()
+    {
+        input_data_has_been_updated_callback();
+    }
+
+
+
     void input_data_has_been_updated_callback()
     {
-        if(input_pin_.get_data())
+        if(!input_pin_.get_data_pointer())
         {
-            switch(selected_operation_type_)
-            {
-                default:
-                case 0: // Transpose
-                    resulting_matrix_ = LazyMatrix::transpose(*input_pin_.get_data());
-                break;
-
-                case 1: // Negate
-                    resulting_matrix_ = -(*input_pin_.get_data());
-                break;
-
-                case 2: // sign
-                    resulting_matrix_ = LazyMatrix::sign(*input_pin_.get_data());
-                break;
-
-                case 3: // abs
-                    resulting_matrix_ = LazyMatrix::abs(*input_pin_.get_data());
-                break;
-
-                case 4: // sqrt
-                    resulting_matrix_ = LazyMatrix::sqrt(*input_pin_.get_data());
-                break;
-
-                case 5: // exp (e^x)
-                    resulting_matrix_ = LazyMatrix::exp(*input_pin_.get_data());
-                break;
-
-                case 6: // exp2 (2^x)
-                    resulting_matrix_ = LazyMatrix::exp2(*input_pin_.get_data());
-                break;
-            }
+            deferred_matrix_.mirror_matrix();
+            resulting_matrix_.resize(0,0);
+            output_pin_.update_data(&resulting_matrix_);
+        }
+        else if(selected_operation_type_ <= 0) // Transpose
+        {
+            // The input is read through a view, so a deferred input is
+            // computed into its storage instead of being materialized
+            Compute::MatrixView input_view = input_pin_.get_view();
+
+            deferred_matrix_.mirror_matrix();
+            resulting_matrix_.resize(input_view.columns(), input_view.rows());
+
+            if(input_view.size() > 0)
+                Compute::transpose(input_view, &resulting_matrix_(0,0), input_view.rows());
+
+            output_pin_.update_data(&resulting_matrix_);
         }
         else
         {
-            resulting_matrix_.resize(0,0);
+            // Elementwise operators (negate, sign, abs, sqrt, exp, exp2)
+            // are deferred, so that chains of them are computed in one pass
+            auto chain = make_elementwise_chain(input_pin_.get_data_pointer(), input_pin_.get_deferred_matrix());
+            chain.append_operation(static_cast<Compute::UnaryOperation>(selected_operation_type_ - 1));
+
+            deferred_matrix_.set_chain(chain);
+            output_pin_.update_data(&resulting_matrix_, &deferred_matrix_);
         }
-        
-        output_pin_.update_data(&resulting_matrix_);
     }
     
     
@@ -168,13 +172,53 @@ public:
 
 
 
+    int64_t get_output_bytes()const
+    {
+        return deferred_matrix_.get_number_of_bytes();
+    }
+
+    DeferredMatrix* get_evictable_output()
+    {
+        return output_pin_.get_deferred_matrix();
+    }
+
+    DeferredMatrix* get_reattachable_output()
+    {
+        return &deferred_matrix_;
+    }
+
+    void rebind_deferred_matrices()
+    {
+        deferred_matrix_.rebind_matrix(&resulting_matrix_);
+    }
+
+
+
     void save_to_json_internal(const std::string& node_name, nlohmann::json* json_file)
     {
         (*json_file)["nodes"][node_name]["type"] = node_type.c_str();
 
         (*json_file)["nodes"][node_name]["selected operation type"] = selected_operation_type_;
 
+        deferred_matrix_.materialize();
         (*json_file)["nodes"][node_name]["resulting matrix"] = resulting_matrix_.get_filename_of_memory_mapped_file();
+
+        (*json_file)["nodes"][node_name]["input pin id"] = input_pin_.get_id();
+        (*json_file)["nodes"][node_name]["output pin id"] = output_pin_.get_id();
+    }
+
+    void load_from_json_internal(const std::string& node_name, const nlohmann::json& json_file)
+    {
+        const auto& node_json = json_file["nodes"][node_name];
+
+        selected_operation_type_ = node_json.value("selected operation type", selected_operation_type_);
+        previously_selected_operation_type_ = selected_operation_type_;
+
+        input_pin_.set_id(node_json.value("input pin id", input_pin_.get_id()));
+        input_pin_.set_parent_node_id(this->get_id());
+
+        output_pin_.set_id(node_json.value("output pin id", output_pin_.get_id()));
+        output_pin_.set_parent_node_id(this->get_id());
     }
 
 
@@ -187,6 +231,7 @@ private:
     int previously_selected_operation_type_ = 0;
 
     MatrixType resulting_matrix_;
+    DeferredMatrix deferred_matrix_{&resulting_matrix_};
 
     Pin<MatrixType> input_pin_;
     Pin<MatrixType> output_pin_;
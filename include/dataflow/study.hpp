@@ -4,6 +4,9 @@
 
 
 //-------------------------------------------------------------------
+#include <filesystem>
+#include <fstream>
+
 #include "link_manager.hpp"
 #include "node_manager.hpp"
 
@@ -37,9 +40,15 @@ public:
     bool get_is_study_open()const;
     bool get_is_study_active()const;
 
+    int64_t get_memory_budget()const;
+    void set_memory_budget(int64_t memory_budget_in_bytes);
+
     template<typename TypeOfNode>
     TypeOfNode& add_node(std::string node_title = "new node");
 
+    bool save_to_file(const std::filesystem::path& study_filename);
+    bool load_from_file(const std::filesystem::path& study_filename);
+
     bool draw();
     
     static void mini_map_node_hovering_callback(int node_id, void* user_data);
@@ -51,12 +60,16 @@ private: // Private functions
     void handle_drag_and_drop();
     void handle_popup_context_menu();
     void handle_popup_context_menu_answer();
+    void draw_memory_usage();
+    void draw_save_and_load();
 
 
 
 private: // Private variables
 
     int id_ = LazyApp::UniqueID::generate_uuid_hash();
+    int memory_budget_id_ = LazyApp::UniqueID::generate_uuid_hash();
+    int study_filename_id_ = LazyApp::UniqueID::generate_uuid_hash();
 
     bool is_study_open_ = true;
     bool is_study_active_ = false;
@@ -66,8 +79,17 @@ private: // Private variables
 
     int popup_context_menu_answer_ = -1;
 
+    // File the study is saved to/loaded from, its node results are
+    // saved next to it in the "<file name>_results" directory
+    std::string study_filename_ = std::string(MAX_NAME_LENGTH, 0);
+    std::string save_and_load_status_;
+
     ImVec2 size_ = ImVec2(0.0f, 0.0f);
 
+    // Once the node results take more memory than this, the least
+    // recently viewed results that can be recomputed are evicted
+    int64_t memory_budget_in_bytes_ = int64_t(2) << 30;
+
     ImNodesEditorContext* editor_context_ = nullptr;
 
     DataFlow::NodeManager node_manager_;
@@ -85,6 +107,8 @@ inline Study::Study()
     // have dynamic window titles
     study_identifying_name_ = std::string("Study:") + std::to_string(id_);
 
+    study_filename_.replace(0, std::string("study.json").size(), "study.json");
+
     // Initialize the imnodes editor context
     editor_context_ = ImNodes::EditorContextCreate();
 }
@@ -141,6 +165,24 @@ inline bool Study::get_is_study_active()const
 
 
 
+//-------------------------------------------------------------------
+inline int64_t Study::get_memory_budget()const
+{
+    return memory_budget_in_bytes_;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+inline void Study::set_memory_budget(int64_t memory_budget_in_bytes)
+{
+    memory_budget_in_bytes_ = memory_budget_in_bytes;
+}
+//-------------------------------------------------------------------
+
+
+
 //-------------------------------------------------------------------
 template<typename TypeOfNode>
 
@@ -166,15 +208,12 @@ inline bool Study::draw()
 
             is_study_active_ = true;
 
-            if(ImGui::Button("save"))
-            {
-                nlohmann::json json_file;
+            auto frame_start_time = std::chrono::steady_clock::now();
 
-                node_manager_.save_to_json(&json_file);
-                link_manager_.save_to_json(node_manager_, &json_file);
+            draw_save_and_load();
 
-                std::cout << "json file =\n\n" << json_file.dump(4) << "\n\n\n";
-            }
+            ImGui::SameLine();
+            draw_memory_usage();
             
             ImNodes::EditorContextSet(editor_context_);
 
@@ -206,6 +245,9 @@ inline bool Study::draw()
             handle_drag_and_drop();
 
             handle_popup_context_menu_answer();
+
+            // Results that weren't viewed this frame can be evicted
+            node_manager_.enforce_memory_budget(memory_budget_in_bytes_, frame_start_time);
         
             ImGui::EndTabItem();
         }
@@ -221,6 +263,133 @@ inline bool Study::draw()
 
 
 
+//-------------------------------------------------------------------
+inline bool Study::save_to_file(const std::filesystem::path& study_filename)
+{
+    ImNodes::EditorContextSet(editor_context_);
+
+    nlohmann::json json_file;
+
+    json_file["study"]["name"] = name_;
+    json_file["study"]["memory budget"] = memory_budget_in_bytes_;
+
+    node_manager_.save_to_json(&json_file);
+    link_manager_.save_to_json(node_manager_, &json_file);
+
+    // The results are saved as matrix files next to the study, so
+    // that loading the study attaches them instead of recomputing them
+    std::filesystem::path results_directory = study_filename.stem().string() + "_results";
+    if(!node_manager_.save_results(study_filename.parent_path(), results_directory, &json_file))
+        return false;
+
+    std::ofstream file(study_filename);
+
+    if(!file)
+        return false;
+
+    file << json_file.dump(4);
+
+    return bool(file);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+inline bool Study::load_from_file(const std::filesystem::path& study_filename)
+{
+    std::ifstream file(study_filename);
+
+    if(!file)
+        return false;
+
+    nlohmann::json json_file = nlohmann::json::parse(file, nullptr, false);
+
+    if(json_file.is_discarded())
+        return false;
+
+    ImNodes::EditorContextSet(editor_context_);
+
+    link_manager_.remove_all_links();
+    node_manager_.remove_all_nodes();
+
+    if(json_file.contains("study"))
+    {
+        name_ = json_file["study"].value("name", name_);
+        memory_budget_in_bytes_ = json_file["study"].value("memory budget", memory_budget_in_bytes_);
+    }
+
+    bool was_study_loaded = node_manager_.load_from_json(json_file, std::bind(&LinkManager::remove_link_that_belongs_to_pin, &link_manager_, std::placeholders::_1));
+
+    for(int node_id : node_manager_.get_node_ids())
+    {
+        const auto& node_json = json_file["nodes"][std::string("node ") + std::to_string(node_id)];
+        ImNodes::SetNodeGridSpacePos(node_id, ImVec2(node_json.value("x_pos", 0.0f), node_json.value("y_pos", 0.0f)));
+    }
+
+    // Connecting the links doesn't compute anything, the
+    // results are restored (or computed) once all is connected
+    {
+        PinNotifications::ScopedSuspension suspension;
+        was_study_loaded = link_manager_.load_from_json(node_manager_, json_file) && was_study_loaded;
+    }
+
+    node_manager_.restore_results(study_filename.parent_path(), json_file);
+
+    return was_study_loaded;
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+inline void Study::draw_save_and_load()
+{
+    ImGui::PushItemWidth(250);
+    ImGui::PushID(study_filename_id_);
+    ImGui::InputText("##study file", study_filename_.data(), study_filename_.size());
+    ImGui::PopID();
+    ImGui::PopItemWidth();
+
+    ImGui::SameLine();
+    if(ImGui::Button("save"))
+        save_and_load_status_ = save_to_file(study_filename_.c_str()) ? "saved" : "could not save the study";
+
+    ImGui::SameLine();
+    if(ImGui::Button("load"))
+        save_and_load_status_ = load_from_file(study_filename_.c_str()) ? "loaded" : "could not (fully) load the study";
+
+    if(!save_and_load_status_.empty())
+    {
+        ImGui::SameLine();
+        ImGui::Text("%s", save_and_load_status_.c_str());
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+inline void Study::draw_memory_usage()
+{
+    constexpr double bytes_per_megabyte = 1024.0 * 1024.0;
+
+    int memory_budget_in_megabytes = static_cast<int>(memory_budget_in_bytes_ / int64_t(bytes_per_megabyte));
+
+    ImGui::Text("memory: %.1f MB of", node_manager_.get_output_bytes() / bytes_per_megabyte);
+    ImGui::SameLine();
+
+    ImGui::PushItemWidth(150);
+    ImGui::PushID(memory_budget_id_);
+    if(ImGui::InputInt("MB budget", &memory_budget_in_megabytes, 64, 1024))
+        memory_budget_in_bytes_ = std::max(int64_t(0), int64_t(memory_budget_in_megabytes) * int64_t(bytes_per_megabyte));
+    ImGui::PopID();
+    ImGui::PopItemWidth();
+}
+//-------------------------------------------------------------------
+
+
+
 //-------------------------------------------------------------------
 inline void Study::mini_map_node_hovering_callback(int node_id, void* user_data)
 {
@@ -247,18 +416,48 @@ inline void Study::handle_drag_and_drop()
             ImNodes::SetNodeScreenSpacePos(new_node.get_id(), ImGui::GetMousePos());
         }
 
+        else if(ImGui::AcceptDragDropPayload("IMAGE_SEQUENCE_NODE"))
+        {
+            auto& new_node = add_node<ImageSequenceNode>();
+            ImNodes::SetNodeScreenSpacePos(new_node.get_id(), ImGui::GetMousePos());
+        }
+
         else if(ImGui::AcceptDragDropPayload("CSV_LOADER_NODE"))
         {
             auto& new_node = add_node<CsvLoaderNode>();
             ImNodes::SetNodeScreenSpacePos(new_node.get_id(), ImGui::GetMousePos());
         }
 
+        else if(ImGui::AcceptDragDropPayload("BINARY_LOADER_NODE"))
+        {
+            auto& new_node = add_node<BinaryLoaderNode>();
+            ImNodes::SetNodeScreenSpacePos(new_node.get_id(), ImGui::GetMousePos());
+        }
+
         else if(ImGui::AcceptDragDropPayload("UNARY_OPERATOR_NODE"))
         {
             auto& new_node = add_node<UnaryOperatorNode>();
             ImNodes::SetNodeScreenSpacePos(new_node.get_id(), ImGui::GetMousePos());
         }
 
+        else if(ImGui::AcceptDragDropPayload("BINARY_OPERATOR_NODE"))
+        {
+            auto& new_node = add_node<BinaryOperatorNode>();
+            ImNodes::SetNodeScreenSpacePos(new_node.get_id(), ImGui::GetMousePos());
+        }
+
+        else if(ImGui::AcceptDragDropPayload("STATISTICS_NODE"))
+        {
+            auto& new_node = add_node<StatisticsNode>();
+            ImNodes::SetNodeScreenSpacePos(new_node.get_id(), ImGui::GetMousePos());
+        }
+
+        else if(ImGui::AcceptDragDropPayload("FFT_NODE"))
+        {
+            auto& new_node = add_node<FftNode>();
+            ImNodes::SetNodeScreenSpacePos(new_node.get_id(), ImGui::GetMousePos());
+        }
+
         else if(ImGui::AcceptDragDropPayload("AUGMENT_NODE"))
         {
             auto& new_node = add_node<AugmentNode>();
@@ -367,6 +566,31 @@ inline void Study::handle_popup_context_menu()
                 popup_context_menu_answer_ = 9;
             if(ImGui::IsItemHovered())
                 ImGui::SetMouseCursor(ImGuiMouseCursor_Hand);
+                
+            if(ImGui::Selectable(" * Binary Operator Node"))
+                popup_context_menu_answer_ = 10;
+            if(ImGui::IsItemHovered())
+                ImGui::SetMouseCursor(ImGuiMouseCursor_Hand);
+
+            if(ImGui::Selectable(" * Image Sequence Node"))
+                popup_context_menu_answer_ = 11;
+            if(ImGui::IsItemHovered())
+                ImGui::SetMouseCursor(ImGuiMouseCursor_Hand);
+
+            if(ImGui::Selectable(" * Binary Loader Node"))
+                popup_context_menu_answer_ = 12;
+            if(ImGui::IsItemHovered())
+                ImGui::SetMouseCursor(ImGuiMouseCursor_Hand);
+
+            if(ImGui::Selectable(" * Statistics Node"))
+                popup_context_menu_answer_ = 13;
+            if(ImGui::IsItemHovered())
+                ImGui::SetMouseCursor(ImGuiMouseCursor_Hand);
+
+            if(ImGui::Selectable(" * FFT Node"))
+                popup_context_menu_answer_ = 14;
+            if(ImGui::IsItemHovered())
+                ImGui::SetMouseCursor(ImGuiMouseCursor_Hand);
         
         ImGui::EndGroup();
 
@@ -456,6 +680,41 @@ inline void Study::handle_popup_context_menu_answer()
             ImNodes::SetNodeScreenSpacePos(new_node.get_id(), ImGui::GetMousePos());
         }
         break;
+
+        case 10: // Binary Operator Node
+        {
+            auto& new_node = add_node<BinaryOperatorNode>();
+            ImNodes::SetNodeScreenSpacePos(new_node.get_id(), ImGui::GetMousePos());
+        }
+        break;
+
+        case 11: // Image Sequence Node
+        {
+            auto& new_node = add_node<ImageSequenceNode>();
+            ImNodes::SetNodeScreenSpacePos(new_node.get_id(), ImGui::GetMousePos());
+        }
+        break;
+
+        case 12: // Binary Loader Node
+        {
+            auto& new_node = add_node<BinaryLoaderNode>();
+            ImNodes::SetNodeScreenSpacePos(new_node.get_id(), ImGui::GetMousePos());
+        }
+        break;
+
+        case 13: // Statistics Node
+        {
+            auto& new_node = add_node<StatisticsNode>();
+            ImNodes::SetNodeScreenSpacePos(new_node.get_id(), ImGui::GetMousePos());
+        }
+        break;
+
+        case 14: // FFT Node
+        {
+            auto& new_node = add_node<FftNode>();
+            ImNodes::SetNodeScreenSpacePos(new_node.get_id(), ImGui::GetMousePos());
+        }
+        break;
     }
 
     // Reset the answer so we only add
@@ -0,0 +1,204 @@
+#ifndef INCLUDE_TABLE_CELL_CACHE_HPP_
+#define INCLUDE_TABLE_CELL_CACHE_HPP_
+
+
+
+//-------------------------------------------------------------------
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Define everything within the namespace DataFlow
+namespace DataFlow
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Formatted text of the cells of a table, kept from one frame to the next.
+ *
+ * An ImGuiListClipper asks for several ranges of rows every frame: the
+ * frozen header row, the row it measures when it doesn't know the row
+ * height yet, and then the visible rows. Once the table is scrolled
+ * past its first page these don't overlap, so the first rows of the
+ * table (NUMBER_OF_PINNED_ROWS) are cached apart from the body rows,
+ * and each part is only refreshed when a range leaves it.
+ *
+ * The body caches rows above and below the visible ones as well, so
+ * that scrolling doesn't refresh it every frame either.
+ */
+//-------------------------------------------------------------------
+class TableCellCache
+{
+public:
+
+    // The header row and the row the clipper measures
+    static constexpr int64_t NUMBER_OF_PINNED_ROWS = 2;
+
+
+
+    void invalidate()
+    {
+        ++data_version_;
+    }
+
+
+
+    /**
+     * @brief Makes sure the text of table rows [first_row, last_row) and columns [first_column, last_column) is cached.
+     *
+     * @param data Identifies the table's values (it is only compared).
+     * @param page_index Page of columns shown, changing it refreshes the cache.
+     * @param format_cell Called as format_cell(row, column, text) to append the text of a cell to text.
+     */
+    template<typename FormatCell>
+
+    void cache_cells(const void* data,
+                     int page_index,
+                     int64_t number_of_rows,
+                     int64_t first_row,
+                     int64_t last_row,
+                     int64_t first_column,
+                     int64_t last_column,
+                     FormatCell& format_cell)
+    {
+        const Key key{data, number_of_rows, page_index, data_version_, first_column, last_column};
+
+        if(first_row < NUMBER_OF_PINNED_ROWS)
+        {
+            const int64_t last_pinned_row = std::min(number_of_rows, NUMBER_OF_PINNED_ROWS);
+
+            if(!pinned_rows_.contains(key, first_row, std::min(last_row, last_pinned_row)))
+                refresh(pinned_rows_, key, 0, last_pinned_row, format_cell);
+        }
+
+        first_row = std::max(first_row, NUMBER_OF_PINNED_ROWS);
+
+        if(first_row >= last_row || body_rows_.contains(key, first_row, last_row))
+            return;
+
+        const int64_t margin = last_row - first_row;
+
+        refresh(body_rows_,
+                key,
+                std::max(NUMBER_OF_PINNED_ROWS, first_row - margin),
+                std::min(number_of_rows, last_row + margin),
+                format_cell);
+    }
+
+    // Text of a cell, which has to be cached
+    std::string_view get_cell_text(int64_t row, int64_t column)const
+    {
+        return (row < NUMBER_OF_PINNED_ROWS ? pinned_rows_ : body_rows_).get_cell_text(row, column);
+    }
+
+    // Number of times part of the cache was formatted again
+    uint64_t get_number_of_refreshes()const
+    {
+        return number_of_refreshes_;
+    }
+
+
+
+private:
+
+    // What the cached text was formatted from
+    struct Key
+    {
+        const void* data = nullptr;
+        int64_t number_of_rows = 0;
+        int page_index = -1;
+        uint64_t data_version = 0;
+        int64_t first_column = 0;
+        int64_t last_column = 0;
+
+        bool operator==(const Key& key)const
+        {
+            return data == key.data &&
+                   number_of_rows == key.number_of_rows &&
+                   page_index == key.page_index &&
+                   data_version == key.data_version &&
+                   first_column == key.first_column &&
+                   last_column == key.last_column;
+        }
+    };
+
+    struct CachedRows
+    {
+        Key key;
+        bool is_valid = false;
+
+        int64_t first_row = 0;
+        int64_t last_row = 0;
+
+        std::string text;
+        std::vector<std::size_t> cell_offsets;
+
+        bool contains(const Key& other_key, int64_t first, int64_t last)const
+        {
+            return is_valid && key == other_key && first >= first_row && last <= last_row;
+        }
+
+        std::string_view get_cell_text(int64_t row, int64_t column)const
+        {
+            const int64_t cell = (row - first_row) * (key.last_column - key.first_column) + (column - key.first_column);
+
+            return std::string_view(text.data() + cell_offsets[cell], cell_offsets[cell + 1] - cell_offsets[cell]);
+        }
+    };
+
+
+
+    template<typename FormatCell>
+
+    void refresh(CachedRows& rows, const Key& key, int64_t first_row, int64_t last_row, FormatCell& format_cell)
+    {
+        rows.key = key;
+        rows.is_valid = true;
+        rows.first_row = first_row;
+        rows.last_row = last_row;
+
+        rows.text.clear();
+        rows.cell_offsets.clear();
+
+        for(int64_t row = first_row; row < last_row; ++row)
+        {
+            for(int64_t column = key.first_column; column < key.last_column; ++column)
+            {
+                rows.cell_offsets.push_back(rows.text.size());
+                format_cell(row, column, rows.text);
+            }
+        }
+
+        rows.cell_offsets.push_back(rows.text.size());
+
+        ++number_of_refreshes_;
+    }
+
+
+
+    uint64_t data_version_ = 0;
+    uint64_t number_of_refreshes_ = 0;
+
+    CachedRows pinned_rows_;
+    CachedRows body_rows_;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+} // namespace DataFlow
+//-------------------------------------------------------------------
+
+
+
+#endif  // INCLUDE_TABLE_CELL_CACHE_HPP_
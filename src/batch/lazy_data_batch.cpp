@@ -0,0 +1,92 @@
+#include <iostream>
+#include <dataflow/batch_runner.hpp>
+
+
+
+//-------------------------------------------------------------------
+// Runs a study saved by the LazyData editor without opening a window
+//
+// usage: LazyDataBatch <study.json> [--output-dir <directory>]
+//                                   [--format csv|npy]
+//                                   [--node <node id>]...
+//
+// -- If no nodes are given, the results of the nodes that aren't
+//    linked to any other node are written
+//-------------------------------------------------------------------
+int print_usage()
+{
+    std::cerr << "usage: LazyDataBatch <study.json> [--output-dir <directory>] [--format csv|npy] [--node <node id>]...\n";
+    return 1;
+}
+
+
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+        return print_usage();
+
+    std::filesystem::path study_filename = argv[1];
+    std::filesystem::path output_directory = std::filesystem::current_path();
+    std::string format = "npy";
+    std::vector<int> selected_node_ids;
+
+    for(int i = 2; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+
+        if(i + 1 >= argc)
+            return print_usage();
+
+        if(argument == "--output-dir")
+            output_directory = argv[++i];
+        else if(argument == "--format")
+            format = argv[++i];
+        else if(argument == "--node")
+            selected_node_ids.push_back(std::atoi(argv[++i]));
+        else
+            return print_usage();
+    }
+
+    if(format != "csv" && format != "npy")
+        return print_usage();
+
+
+
+    DataFlow::BatchRunner batch_runner;
+
+    if(!batch_runner.load_study(study_filename))
+    {
+        std::cerr << "could not load the study: " << study_filename << "\n";
+        return 1;
+    }
+
+    batch_runner.run();
+
+    if(selected_node_ids.empty())
+        selected_node_ids = batch_runner.get_terminal_node_ids();
+
+    std::filesystem::create_directories(output_directory);
+
+    int exit_code = 0;
+
+    for(int node_id : selected_node_ids)
+    {
+        std::filesystem::path output_filename = output_directory / ("node_" + std::to_string(node_id) + "." + format);
+
+        if(batch_runner.write_node_output(node_id, output_filename))
+        {
+            std::cout << "wrote " << output_filename.string() << "\n";
+        }
+        else
+        {
+            std::cerr << "could not write the result of node " << node_id << "\n";
+            exit_code = 1;
+        }
+    }
+
+    batch_runner.print_timings(std::cout);
+
+    return exit_code;
+}
+//-------------------------------------------------------------------
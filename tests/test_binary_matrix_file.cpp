@@ -0,0 +1,224 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_binary_matrix_file.cpp
+ * @brief Tests for raw and .npy binary matrix files using the Catch2 framework.
+ *
+ * This file checks that .npy headers and raw layouts are read right,
+ * that elements of every type and order convert to the expected doubles,
+ * and that files of doubles are mapped in place, row or column major.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <catch2/catch_all.hpp>
+#include <compute/binary_matrix_file.hpp>
+#include <compute/matrix_storage.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace
+{
+    // An .npy version 1 file's bytes (header padded to 64 bytes)
+    std::string make_npy_file(const std::string& dictionary, const std::string& data)
+    {
+        std::string header = dictionary;
+
+        while((10 + header.size() + 1) % 64 != 0)
+            header += ' ';
+
+        header += '\n';
+
+        std::string file("\x93NUMPY\x01\x00", 8);
+        file += char(header.size() & 0xff);
+        file += char(header.size() >> 8);
+
+        return file + header + data;
+    }
+
+    template<typename ElementType>
+    std::string to_bytes(const std::vector<ElementType>& elements)
+    {
+        return std::string(reinterpret_cast<const char*>(elements.data()), elements.size() * sizeof(ElementType));
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that .npy headers are parsed into layouts.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Npy headers", "[BinaryMatrixFile]")
+{
+    Compute::BinaryMatrixLayout layout;
+
+    std::string file = make_npy_file("{'descr': '<f8', 'fortran_order': False, 'shape': (3, 4), }", "");
+
+    REQUIRE(Compute::parse_npy_header(file.data(), int64_t(file.size()), layout));
+    REQUIRE(layout.element_type == Compute::BinaryElementType::Float64);
+    REQUIRE_FALSE(layout.is_big_endian);
+    REQUIRE_FALSE(layout.is_column_major);
+    REQUIRE(layout.rows == 3);
+    REQUIRE(layout.columns == 4);
+    REQUIRE(layout.offset == file.size());
+    REQUIRE(layout.can_be_mapped());
+
+    file = make_npy_file("{'descr': '>i2', 'fortran_order': True, 'shape': (5,), }", "");
+
+    REQUIRE(Compute::parse_npy_header(file.data(), int64_t(file.size()), layout));
+    REQUIRE(layout.element_type == Compute::BinaryElementType::Int16);
+    REQUIRE(layout.is_big_endian);
+    REQUIRE(layout.is_column_major);
+    REQUIRE(layout.rows == 5);
+    REQUIRE(layout.columns == 1);
+    REQUIRE_FALSE(layout.can_be_mapped());
+
+    file = make_npy_file("{'descr': '|u1', 'fortran_order': False, 'shape': (2, 3, 4), }", "");
+
+    REQUIRE(Compute::parse_npy_header(file.data(), int64_t(file.size()), layout));
+    REQUIRE(layout.rows == 2);
+    REQUIRE(layout.columns == 12);
+
+    // Not numbers, or not an .npy file at all
+    file = make_npy_file("{'descr': '<U8', 'fortran_order': False, 'shape': (2,), }", "");
+    REQUIRE_FALSE(Compute::parse_npy_header(file.data(), int64_t(file.size()), layout));
+
+    const std::string text = "1,2,3\n";
+    REQUIRE_FALSE(Compute::parse_npy_header(text.data(), int64_t(text.size()), layout));
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that elements of every type and order convert to doubles.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Binary matrices convert to doubles", "[BinaryMatrixFile]")
+{
+    // Raw rows of 3 floats, after an 8-byte header, with a trailing partial row
+    const std::vector<float> floats = {1.5f, -2, 3, 4, 5, 6.25f, 7};
+    const std::string raw = std::string(8, 'h') + to_bytes(floats);
+
+    auto layout = Compute::make_raw_matrix_layout(raw.size(), Compute::BinaryElementType::Float32, 3, 8);
+
+    REQUIRE(layout.rows == 2);
+    REQUIRE(layout.columns == 3);
+
+    std::vector<double> values(6);
+    Compute::convert_binary_matrix(raw.data() + layout.offset, layout, values.data());
+
+    REQUIRE(values == std::vector<double>{1.5, -2, 3, 4, 5, 6.25});
+
+    // Big-endian 16-bit integers, column major
+    const std::string big_endian("\xff\xfe\x00\x01\x00\x02\x01\x00", 8);
+
+    layout = Compute::BinaryMatrixLayout();
+    layout.element_type = Compute::BinaryElementType::Int16;
+    layout.is_big_endian = true;
+    layout.is_column_major = true;
+    layout.rows = 2;
+    layout.columns = 2;
+
+    values.assign(4, 0.0);
+    Compute::convert_binary_matrix(big_endian.data(), layout, values.data());
+
+    REQUIRE(values == std::vector<double>{-2, 2, 1, 256});
+
+    // Many rows of unsigned bytes, split across threads
+    std::string bytes(100000 * 3, '\0');
+    for(std::size_t i = 0; i < bytes.size(); ++i)
+        bytes[i] = char(i % 251);
+
+    layout = Compute::make_raw_matrix_layout(bytes.size(), Compute::BinaryElementType::UInt8, 3, 0);
+
+    values.assign(bytes.size(), -1.0);
+    Compute::convert_binary_matrix(bytes.data(), layout, values.data());
+
+    int64_t number_of_mismatches = 0;
+    for(std::size_t i = 0; i < bytes.size(); ++i)
+        number_of_mismatches += (values[i] != double(i % 251));
+
+    REQUIRE(number_of_mismatches == 0);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that .npy files of doubles are mapped in place.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Npy files of doubles are mapped", "[BinaryMatrixFile]")
+{
+    const auto directory = std::filesystem::temp_directory_path() / "lazydata_test_binary_matrix_file";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    const std::vector<double> elements = {1, 2, 3, 4, 5, 6};
+
+    for(bool is_column_major : {false, true})
+    {
+        const auto filename = directory / (is_column_major ? "fortran.npy" : "c.npy");
+
+        {
+            std::ofstream file(filename, std::ios::binary);
+            file << make_npy_file(std::string("{'descr': '<f8', 'fortran_order': ") + (is_column_major ? "True" : "False") + ", 'shape': (2, 3), }",
+                                  to_bytes(elements));
+        }
+
+        Compute::BinaryMatrixLayout layout;
+        REQUIRE(Compute::read_npy_layout(filename, layout));
+        REQUIRE(layout.can_be_mapped());
+
+        Compute::MatrixStorage storage;
+        REQUIRE(storage.attach_raw(filename, layout.offset, layout.rows, layout.columns, layout.is_column_major));
+        REQUIRE(storage.get_tier() == Compute::MatrixStorage::Tier::Attached);
+        REQUIRE(storage.is_raw_attachment());
+
+        const auto view = storage.view();
+
+        REQUIRE(view.rows() == 2);
+        REQUIRE(view.columns() == 3);
+
+        for(int64_t i = 0; i < 2; ++i)
+        {
+            for(int64_t j = 0; j < 3; ++j)
+            {
+                const double expected_value = is_column_major ? elements[j * 2 + i] : elements[i * 3 + j];
+                REQUIRE(view(i, j) == expected_value);
+            }
+        }
+
+        // Too big for the file
+        REQUIRE_FALSE(storage.attach_raw(filename, layout.offset, 3, 3));
+    }
+
+    // Truncated files aren't read
+    {
+        std::ofstream file(directory / "truncated.npy", std::ios::binary);
+        file << make_npy_file("{'descr': '<f8', 'fortran_order': False, 'shape': (20, 3), }", to_bytes(elements));
+    }
+
+    Compute::BinaryMatrixLayout layout;
+    REQUIRE_FALSE(Compute::read_npy_layout(directory / "truncated.npy", layout));
+
+    std::filesystem::remove_all(directory);
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,162 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_binary_operations.cpp
+ * @brief Tests for the elementwise binary operations and the matrix multiply using the Catch2 framework.
+ *
+ * This file checks broadcasting of rows, columns and single values, and
+ * compares the tiled matrix multiply (with every micro-kernel the CPU
+ * supports) with a naive triple loop, for sizes that aren't multiples
+ * of the register or cache blocks.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <catch2/catch_all.hpp>
+#include <compute/binary_operations.hpp>
+#include <compute/gemm.hpp>
+
+#include <cmath>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace
+{
+    std::vector<double> make_test_data(int64_t rows, int64_t columns, double seed)
+    {
+        std::vector<double> data(rows * columns);
+
+        for(int64_t i = 0; i < rows * columns; ++i)
+            data[i] = std::sin(seed + 0.37 * double(i));
+
+        return data;
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that rows, columns and single values are broadcast.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Elementwise operations broadcast rows and columns", "[BinaryOperations]")
+{
+    auto matrix = make_test_data(5, 4, 0.0);
+    auto row = make_test_data(1, 4, 1.0);
+    auto column = make_test_data(5, 1, 2.0);
+    double value = 3.0;
+
+    Compute::MatrixView matrix_view(matrix.data(), 5, 4, 4);
+    Compute::MatrixView row_view(row.data(), 1, 4, 4);
+    Compute::MatrixView column_view(column.data(), 5, 1, 1);
+    Compute::MatrixView value_view(&value, 1, 1, 1);
+
+    std::vector<double> result(5 * 4);
+
+    REQUIRE(Compute::evaluate_binary_operation(Compute::BinaryOperation::Subtract, matrix_view, row_view, result.data(), 4));
+    for(int64_t i = 0; i < 5; ++i)
+        for(int64_t j = 0; j < 4; ++j)
+            REQUIRE(result[i * 4 + j] == matrix[i * 4 + j] - row[j]);
+
+    REQUIRE(Compute::evaluate_binary_operation(Compute::BinaryOperation::Divide, column_view, matrix_view, result.data(), 4));
+    for(int64_t i = 0; i < 5; ++i)
+        for(int64_t j = 0; j < 4; ++j)
+            REQUIRE(result[i * 4 + j] == column[i] / matrix[i * 4 + j]);
+
+    // A column and a row make a whole matrix
+    REQUIRE(Compute::evaluate_binary_operation(Compute::BinaryOperation::Multiply, column_view, row_view, result.data(), 4));
+    for(int64_t i = 0; i < 5; ++i)
+        for(int64_t j = 0; j < 4; ++j)
+            REQUIRE(result[i * 4 + j] == column[i] * row[j]);
+
+    REQUIRE(Compute::evaluate_binary_operation(Compute::BinaryOperation::Add, value_view, matrix_view, result.data(), 4));
+    for(int64_t i = 0; i < 5 * 4; ++i)
+        REQUIRE(result[i] == value + matrix[i]);
+
+    // Mismatched sizes are rejected
+    REQUIRE(!Compute::are_broadcastable(matrix_view, Compute::MatrixView(row.data(), 1, 3, 3)));
+    REQUIRE(!Compute::evaluate_binary_operation(Compute::BinaryOperation::Add, matrix_view, matrix_view.transposed(), result.data(), 4));
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that the tiled matrix multiply matches a naive one.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Matrix multiply matches a naive triple loop", "[Gemm]")
+{
+    struct Sizes { int64_t m, k, n; };
+
+    const Sizes sizes[] = {{1, 1, 1}, {3, 5, 7}, {130, 300, 9}, {5, 260, 2100}, {67, 33, 45}};
+
+    for(int i = 0; i <= int(Compute::detect_instruction_set()); ++i)
+    {
+        for(const auto& size : sizes)
+        {
+            auto a = make_test_data(size.m, size.k, 0.5);
+            auto b = make_test_data(size.k, size.n, 1.5);
+
+            std::vector<double> result(size.m * size.n, -1.0);
+
+            REQUIRE(Compute::multiply(Compute::MatrixView(a.data(), size.m, size.k, size.k),
+                                      Compute::MatrixView(b.data(), size.k, size.n, size.n),
+                                      result.data(),
+                                      size.n,
+                                      Compute::InstructionSet(i)));
+
+            for(int64_t row = 0; row < size.m; ++row)
+            {
+                for(int64_t column = 0; column < size.n; ++column)
+                {
+                    double expected_value = 0;
+                    for(int64_t l = 0; l < size.k; ++l)
+                        expected_value += a[row * size.k + l] * b[l * size.n + column];
+
+                    REQUIRE(result[row * size.n + column] == Catch::Approx(expected_value).margin(1e-10));
+                }
+            }
+        }
+    }
+}
+
+
+
+/**
+ * @brief Test that transposed views are multiplied without being copied first.
+ */
+TEST_CASE("Matrix multiply reads transposed views", "[Gemm]")
+{
+    auto a = make_test_data(40, 6, 0.25);
+
+    Compute::MatrixView a_view(a.data(), 40, 6, 6);
+
+    // a^T * a
+    std::vector<double> result(6 * 6);
+    REQUIRE(Compute::multiply(a_view.transposed(), a_view, result.data(), 6));
+
+    for(int64_t i = 0; i < 6; ++i)
+    {
+        for(int64_t j = 0; j < 6; ++j)
+        {
+            double expected_value = 0;
+            for(int64_t l = 0; l < 40; ++l)
+                expected_value += a[l * 6 + i] * a[l * 6 + j];
+
+            REQUIRE(result[i * 6 + j] == Catch::Approx(expected_value).margin(1e-12));
+        }
+    }
+
+    REQUIRE(!Compute::multiply(a_view, a_view, result.data(), 6));
+}
+//-------------------------------------------------------------------
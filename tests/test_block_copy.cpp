@@ -0,0 +1,69 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_block_copy.cpp
+ * @brief Tests for copying matrices into blocks of bigger ones using the Catch2 framework.
+ *
+ * This file checks that augmented results assembled block by block
+ * match the inputs, with zeros wherever an input is narrower or shorter
+ * than its block, and that rewriting one block leaves the others alone.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <catch2/catch_all.hpp>
+#include <compute/block_copy.hpp>
+
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that inputs are copied into their blocks and padded with zeros.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Matrices are copied into blocks and padded with zeros", "[BlockCopy]")
+{
+    // Augmenting a 3x4 and a 2x2 (transposed) matrix by columns gives a 3x6 result
+    std::vector<double> first(3 * 4);
+    for(std::size_t i = 0; i < first.size(); ++i)
+        first[i] = double(i + 1);
+
+    std::vector<double> second = {-1.0, -2.0, -3.0, -4.0};
+
+    Compute::MatrixView first_view(first.data(), 3, 4, 4);
+    Compute::MatrixView second_view = Compute::MatrixView(second.data(), 2, 2, 2).transposed();
+
+    std::vector<double> result(3 * 6, 99.0);
+
+    Compute::copy_into_block(first_view, &result[0], 6, 3, 4);
+    Compute::copy_into_block(second_view, &result[4], 6, 3, 2);
+
+    for(int64_t i = 0; i < 3; ++i)
+    {
+        for(int64_t j = 0; j < 4; ++j)
+            REQUIRE(result[i * 6 + j] == first_view(i,j));
+
+        for(int64_t j = 0; j < 2; ++j)
+            REQUIRE(result[i * 6 + 4 + j] == ((i < 2) ? second_view(i,j) : 0.0));
+    }
+
+    // Rewriting a block only touches that block
+    second[0] = -10.0;
+    Compute::copy_into_block(second_view, &result[4], 6, 3, 2);
+
+    REQUIRE(result[4] == -10.0);
+    REQUIRE(result[3] == first_view(0,3));
+
+    // Blocks wider than the source are padded on the right
+    std::vector<double> wide_result(2 * 5, 99.0);
+    Compute::copy_into_block(second_view, wide_result.data(), 5, 2, 5);
+
+    REQUIRE(wide_result == std::vector<double>{-10.0, -3.0, 0.0, 0.0, 0.0, -2.0, -4.0, 0.0, 0.0, 0.0});
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,146 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_csv_cache.cpp
+ * @brief Tests for the cache of parsed CSV files using the Catch2 framework.
+ *
+ * This file checks that a cached CSV file is found again with its
+ * column names, that changing the file or the header options misses
+ * the cache, and that the least recently used entries are pruned.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <catch2/catch_all.hpp>
+#include <compute/csv_cache.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that a cached CSV file is found (and attached) until it changes.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Cached CSV files are found until they change", "[CsvCache]")
+{
+    const auto directory = std::filesystem::temp_directory_path() / "lazydata_test_csv_cache";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    const auto csv_filename = directory / "data.csv";
+    const auto cache_directory = directory / "cache";
+
+    {
+        std::ofstream file(csv_filename);
+        file << "a,b\n1,2\n3,4\n";
+    }
+
+    Compute::CsvOptions options;
+    options.has_column_headers = true;
+
+    const Compute::CsvCacheKey key = Compute::make_csv_cache_key(csv_filename, options);
+    REQUIRE(key.file_size == 12);
+
+    REQUIRE(Compute::find_csv_cache(key, cache_directory).empty());
+
+    std::vector<double> data = {1, 2, 3, 4};
+    REQUIRE(Compute::write_csv_cache(key, cache_directory, Compute::MatrixView(data.data(), 2, 2, 2), {"a", "b"}));
+
+    std::vector<std::string> column_headers;
+    const auto cache_filename = Compute::find_csv_cache(key, cache_directory, &column_headers);
+
+    REQUIRE(!cache_filename.empty());
+    REQUIRE(column_headers == std::vector<std::string>{"a", "b"});
+
+    {
+        Compute::MatrixStorage storage;
+        REQUIRE(storage.attach(cache_filename));
+        REQUIRE(storage.rows() == 2);
+        REQUIRE(storage.columns() == 2);
+        REQUIRE(storage.view()(1, 0) == 3.0);
+    }
+
+    // Other header options have their own entry
+    options.has_column_headers = false;
+    REQUIRE(Compute::find_csv_cache(Compute::make_csv_cache_key(csv_filename, options), cache_directory).empty());
+    options.has_column_headers = true;
+
+    // A changed file misses the cache
+    {
+        std::ofstream file(csv_filename);
+        file << "a,b\n1,2\n3,5\n";
+    }
+
+    REQUIRE(Compute::find_csv_cache(Compute::make_csv_cache_key(csv_filename, options), cache_directory).empty());
+
+    std::filesystem::remove_all(directory);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that the least recently used entries are pruned when the cache grows too big.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("The least recently used CSV cache entries are pruned", "[CsvCache]")
+{
+    const auto directory = std::filesystem::temp_directory_path() / "lazydata_test_csv_cache_pruning";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    const auto cache_directory = directory / "cache";
+
+    Compute::CsvOptions options;
+    std::vector<Compute::CsvCacheKey> keys;
+
+    for(int i = 0; i < 3; ++i)
+    {
+        const auto csv_filename = directory / ("data" + std::to_string(i) + ".csv");
+
+        std::ofstream file(csv_filename);
+        file << "1,2\n3," << i << "\n";
+        file.close();
+
+        keys.push_back(Compute::make_csv_cache_key(csv_filename, options));
+    }
+
+    std::vector<double> data = {1, 2, 3, 4};
+    const Compute::MatrixView view(data.data(), 2, 2, 2);
+
+    REQUIRE(Compute::write_csv_cache(keys[0], cache_directory, view, {}));
+    REQUIRE(Compute::write_csv_cache(keys[1], cache_directory, view, {}));
+
+    uint64_t cache_size = 0;
+    for(const auto& file : std::filesystem::directory_iterator(cache_directory))
+        cache_size += file.file_size();
+
+    // Finding the first entry makes the second one the least recently used
+    REQUIRE(!Compute::find_csv_cache(keys[0], cache_directory).empty());
+
+    // Room for two entries only
+    REQUIRE(Compute::write_csv_cache(keys[2], cache_directory, view, {}, cache_size));
+
+    REQUIRE(!Compute::find_csv_cache(keys[0], cache_directory).empty());
+    REQUIRE(Compute::find_csv_cache(keys[1], cache_directory).empty());
+    REQUIRE(!Compute::find_csv_cache(keys[2], cache_directory).empty());
+
+    // The entry just written is kept even if it doesn't fit
+    REQUIRE(Compute::write_csv_cache(keys[1], cache_directory, view, {}, 0));
+
+    REQUIRE(Compute::find_csv_cache(keys[0], cache_directory).empty());
+    REQUIRE(!Compute::find_csv_cache(keys[1], cache_directory).empty());
+    REQUIRE(Compute::find_csv_cache(keys[2], cache_directory).empty());
+
+    std::filesystem::remove_all(directory);
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,256 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_csv_parser.cpp
+ * @brief Tests for the multithreaded CSV parser using the Catch2 framework.
+ *
+ * This file checks that CSV texts parse to the expected matrices,
+ * including headers, quoted fields holding delimiters or newlines,
+ * missing or invalid fields, and texts cut into many small chunks.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <catch2/catch_all.hpp>
+#include <compute/csv_parser.hpp>
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace
+{
+    std::vector<double> parse_csv(const std::string& text, const Compute::CsvOptions& options, int64_t& rows, int64_t& columns)
+    {
+        Compute::CsvParser parser;
+        parser.index(text.data(), int64_t(text.size()), options);
+
+        rows = parser.rows();
+        columns = parser.columns();
+
+        std::vector<double> values(rows * columns, -1.0);
+        parser.parse(values.data());
+
+        REQUIRE(parser.get_progress() == 1.0);
+
+        return values;
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that a plain CSV text parses row by row.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Plain CSV text", "[CsvParser]")
+{
+    int64_t rows = 0;
+    int64_t columns = 0;
+
+    auto values = parse_csv("1,2,3\n4.5,-6,+7e2\n", Compute::CsvOptions(), rows, columns);
+
+    REQUIRE(rows == 2);
+    REQUIRE(columns == 3);
+    REQUIRE(values == std::vector<double>{1, 2, 3, 4.5, -6, 700});
+
+    // Without a newline at the end, with windows newlines and spaces
+    values = parse_csv("1, 2 ,3\r\n4,5,6", Compute::CsvOptions(), rows, columns);
+
+    REQUIRE(rows == 2);
+    REQUIRE(values == std::vector<double>{1, 2, 3, 4, 5, 6});
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that headers are skipped and the column names kept.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("CSV headers", "[CsvParser]")
+{
+    const std::string text = "name;\"a;b\";c\nx;1;2\ny;3;4\n";
+
+    Compute::CsvOptions options;
+    options.has_column_headers = true;
+    options.has_row_headers = true;
+
+    Compute::CsvParser parser;
+    parser.index(text.data(), int64_t(text.size()), options);
+
+    REQUIRE(parser.get_delimiter() == ';');
+    REQUIRE(parser.rows() == 2);
+    REQUIRE(parser.columns() == 2);
+    REQUIRE(parser.get_column_headers() == std::vector<std::string>{"a;b", "c"});
+
+    std::vector<double> values(4);
+    parser.parse(values.data());
+
+    REQUIRE(values == std::vector<double>{1, 2, 3, 4});
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that quoted, missing and invalid fields are handled.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Quoted, missing and invalid CSV fields", "[CsvParser]")
+{
+    int64_t rows = 0;
+    int64_t columns = 0;
+
+    auto values = parse_csv("\"1\",\"a\nb\",3\n4,,x\n5\n6,7,8,9\n\"1\"2,\"3\"\"\",nan\n", Compute::CsvOptions(), rows, columns);
+
+    REQUIRE(rows == 5);
+    REQUIRE(columns == 3);
+
+    REQUIRE(values[0] == 1.0);
+    REQUIRE(std::isnan(values[1]));
+    REQUIRE(values[2] == 3.0);
+
+    REQUIRE(values[3] == 4.0);
+    REQUIRE(std::isnan(values[4]));
+    REQUIRE(std::isnan(values[5]));
+
+    REQUIRE(values[6] == 5.0);
+    REQUIRE(std::isnan(values[7]));
+    REQUIRE(std::isnan(values[8]));
+
+    REQUIRE(values[9] == 6.0);
+    REQUIRE(values[10] == 7.0);
+    REQUIRE(values[11] == 8.0);
+
+    REQUIRE(std::isnan(values[12]));
+    REQUIRE(std::isnan(values[13]));
+    REQUIRE(std::isnan(values[14]));
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that texts cut into many chunks (some starting inside quotes) parse the same.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("CSV text cut into many chunks", "[CsvParser]")
+{
+    const int64_t number_of_rows = 5000;
+    const int64_t number_of_columns = 7;
+
+    std::string text = "a,b,c,d,e,f,g\n";
+    std::vector<double> expected_values;
+
+    for(int64_t i = 0; i < number_of_rows; ++i)
+    {
+        for(int64_t j = 0; j < number_of_columns; ++j)
+        {
+            const double value = double(i * number_of_columns + j) / 8.0;
+            expected_values.push_back(value);
+
+            // Some quoted fields, a few of them spanning lines
+            if(j == 3 && i % 5 == 0)
+                text += "\"" + std::to_string(value) + "\"";
+            else if(j == 6 && i % 11 == 0)
+                text += std::to_string(value) + " \"note\n,spanning lines\"";
+            else
+                text += std::to_string(value);
+
+            text += (j + 1 < number_of_columns) ? "," : "\n";
+        }
+
+        if(i % 11 == 0)
+            expected_values.back() = std::numeric_limits<double>::quiet_NaN();
+    }
+
+    for(int64_t chunk_size : {int64_t(64), int64_t(100), int64_t(4096), Compute::CsvOptions::DEFAULT_CHUNK_SIZE})
+    {
+        Compute::CsvOptions options;
+        options.has_column_headers = true;
+        options.chunk_size = chunk_size;
+
+        int64_t rows = 0;
+        int64_t columns = 0;
+
+        auto values = parse_csv(text, options, rows, columns);
+
+        REQUIRE(rows == number_of_rows);
+        REQUIRE(columns == number_of_columns);
+
+        int64_t number_of_mismatches = 0;
+
+        for(std::size_t i = 0; i < values.size(); ++i)
+        {
+            const bool are_both_nan = std::isnan(values[i]) && std::isnan(expected_values[i]);
+
+            if(!are_both_nan && values[i] != expected_values[i])
+                ++number_of_mismatches;
+        }
+
+        REQUIRE(number_of_mismatches == 0);
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that a text being appended to can be parsed piece by piece.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("CSV text parsed as it's appended to", "[CsvParser]")
+{
+    const std::string text = "x;y\n1;2\n3;\"4\n\";5\n6;7";
+
+    Compute::CsvOptions options;
+    options.has_column_headers = true;
+    options.skip_incomplete_last_line = true;
+
+    Compute::CsvParser parser;
+
+    // Only the header and the first row are complete
+    parser.index(text.data(), 13, options);
+
+    REQUIRE(parser.rows() == 1);
+    REQUIRE(parser.columns() == 2);
+    REQUIRE(parser.get_consumed_size() == 8);
+
+    std::vector<double> values(2);
+    parser.parse(values.data());
+
+    REQUIRE(values == std::vector<double>{1, 2});
+
+    // The rest, without its last line, with the layout found so far
+    Compute::CsvOptions appended_options;
+    appended_options.delimiter = parser.get_delimiter();
+    appended_options.columns = parser.columns();
+    appended_options.skip_incomplete_last_line = true;
+
+    parser.index(text.data() + 8, int64_t(text.size()) - 8, appended_options);
+
+    REQUIRE(parser.rows() == 1);
+    REQUIRE(parser.get_consumed_size() == int64_t(text.size()) - 8 - 3);
+
+    values.assign(2, -1.0);
+    parser.parse(values.data());
+
+    REQUIRE(values[0] == 3.0);
+    REQUIRE(std::isnan(values[1]));
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,382 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_elementwise_chain.cpp
+ * @brief Tests for the fused elementwise chains using the Catch2 framework.
+ *
+ * This file checks that a chain of region selections, row/column selections
+ * and unary operations evaluated in one pass gives the same result as
+ * applying each step one after the other, on one thread or many.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <catch2/catch_all.hpp>
+#include <compute/elementwise_chain.hpp>
+
+#include <atomic>
+#include <vector>
+#include <cmath>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace
+{
+    std::vector<double> make_test_data(int64_t rows, int64_t columns)
+    {
+        std::vector<double> data(rows * columns);
+
+        for(int64_t i = 0; i < rows; ++i)
+            for(int64_t j = 0; j < columns; ++j)
+                data[i * columns + j] = double(i) - 0.5 * double(j) + 0.25;
+
+        return data;
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that an unmodified chain copies its source.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Chain without operations copies the source", "[ElementwiseChain]")
+{
+    auto data = make_test_data(7, 1100);
+    Compute::ElementwiseChain chain(Compute::MatrixView(data.data(), 7, 1100, 1100));
+
+    REQUIRE(chain.rows() == 7);
+    REQUIRE(chain.columns() == 1100);
+
+    std::vector<double> result(chain.size());
+    chain.evaluate(result.data(), chain.columns());
+
+    REQUIRE(result == data);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that fused operations and selections match step-by-step evaluation.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Fused chain matches step by step evaluation", "[ElementwiseChain]")
+{
+    const int64_t rows = 20;
+    const int64_t columns = 1300;
+    auto data = make_test_data(rows, columns);
+
+    Compute::ElementwiseChain chain(Compute::MatrixView(data.data(), rows, columns, columns));
+
+    // abs -> roi -> negate -> select -> exp
+    chain.append_operation(Compute::UnaryOperation::Abs);
+    chain.select_region(15, 1250, 2, 3); // corners in any order
+    chain.append_operation(Compute::UnaryOperation::Negate);
+    chain.select_rows_and_columns({0, 2, 5, 100}, {1, 2, 3, 4, 700, 10, -1});
+    chain.append_operation(Compute::UnaryOperation::Exp);
+
+    // Invalid row 100 and column -1 are skipped
+    REQUIRE(chain.rows() == 3);
+    REQUIRE(chain.columns() == 6);
+
+    std::vector<double> result(chain.size());
+    chain.evaluate(result.data(), chain.columns());
+
+    std::vector<int64_t> expected_rows = {2, 4, 7};
+    std::vector<int64_t> expected_columns = {4, 5, 6, 7, 703, 13};
+
+    for(int64_t i = 0; i < 3; ++i)
+    {
+        for(int64_t j = 0; j < 6; ++j)
+        {
+            double expected = std::exp(-std::abs(data[expected_rows[i] * columns + expected_columns[j]]));
+            REQUIRE(result[i * 6 + j] == Catch::Approx(expected));
+        }
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that regions are clamped to the source and empty regions give empty chains.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Region selection is clamped", "[ElementwiseChain]")
+{
+    auto data = make_test_data(4, 5);
+
+    Compute::ElementwiseChain chain(Compute::MatrixView(data.data(), 4, 5, 5));
+    chain.select_region(2, 3, 100, 100);
+
+    REQUIRE(chain.rows() == 2);
+    REQUIRE(chain.columns() == 2);
+
+    std::vector<double> result(chain.size());
+    chain.evaluate(result.data(), chain.columns());
+    REQUIRE(result[3] == data[3 * 5 + 4]);
+
+    chain.select_region(10, 10, 20, 20);
+    REQUIRE(chain.size() == 0);
+
+    Compute::ElementwiseChain empty_chain(Compute::MatrixView(nullptr, 4, 5, 5));
+    REQUIRE(empty_chain.size() == 0);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that a region without operations is viewed in place.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Region selection is a strided view of the source", "[ElementwiseChain]")
+{
+    auto data = make_test_data(40, 30);
+
+    Compute::ElementwiseChain chain(Compute::MatrixView(data.data(), 40, 30, 30));
+    chain.select_region(35, 29, 10, 5);
+    chain.select_region(2, 1, 20, 10);
+
+    REQUIRE(chain.is_strided_view());
+
+    Compute::MatrixView view = chain.as_view();
+
+    REQUIRE(view.rows() == 19);
+    REQUIRE(view.columns() == 10);
+    REQUIRE(view.row_stride() == 30);
+    REQUIRE_FALSE(view.is_contiguous());
+    REQUIRE(view.data() == &data[12 * 30 + 6]);
+
+    std::vector<double> result(chain.size());
+    chain.evaluate(result.data(), chain.columns());
+
+    for(int64_t i = 0; i < view.rows(); ++i)
+        for(int64_t j = 0; j < view.columns(); ++j)
+            REQUIRE(view(i,j) == result[i * view.columns() + j]);
+
+    chain.append_operation(Compute::UnaryOperation::Abs);
+    REQUIRE_FALSE(chain.is_strided_view());
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that runs of selected columns and scattered columns are both gathered right.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Selected columns are gathered in runs or one by one", "[ElementwiseChain]")
+{
+    const int64_t rows = 3;
+    const int64_t columns = 5000;
+    auto data = make_test_data(rows, columns);
+
+    std::vector<int64_t> runs;
+    for(int64_t j = 10; j < 1500; ++j)
+        runs.push_back(j);
+    for(int64_t j = 2000; j < 4000; ++j)
+        runs.push_back(j);
+    runs.push_back(7);
+
+    std::vector<int64_t> scattered;
+    for(int64_t j = columns - 1; j >= 0; j -= 3)
+        scattered.push_back(j);
+
+    for(const auto& selected_columns : {runs, scattered})
+    {
+        for(bool is_transposed : {false, true})
+        {
+            // The transposed source exercises strided rows
+            std::vector<double> transposed_data(rows * columns);
+            for(int64_t i = 0; i < rows; ++i)
+                for(int64_t j = 0; j < columns; ++j)
+                    transposed_data[j * rows + i] = data[i * columns + j];
+
+            Compute::MatrixView source = is_transposed ? Compute::MatrixView(transposed_data.data(), columns, rows, rows).transposed()
+                                                       : Compute::MatrixView(data.data(), rows, columns, columns);
+
+            Compute::ElementwiseChain chain(source);
+            chain.select_rows_and_columns({0, 1, 2}, selected_columns);
+
+            REQUIRE(chain.columns() == int64_t(selected_columns.size()));
+
+            std::vector<double> result(chain.size());
+            chain.evaluate(result.data(), chain.columns());
+
+            for(int64_t i = 0; i < rows; ++i)
+                for(std::size_t j = 0; j < selected_columns.size(); ++j)
+                    REQUIRE(result[i * selected_columns.size() + j] == data[i * columns + selected_columns[j]]);
+        }
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that chains split across threads match single threaded evaluation.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Parallel evaluation matches single threaded evaluation", "[ElementwiseChain]")
+{
+    // Narrow rows are grouped into tiles, wide rows are split into tiles
+    for(auto [rows, columns] : {std::pair<int64_t, int64_t>(3001, 37), std::pair<int64_t, int64_t>(3, 100003)})
+    {
+        auto data = make_test_data(rows, columns);
+
+        Compute::ElementwiseChain chain(Compute::MatrixView(data.data(), rows, columns, columns));
+        chain.select_region(1, 2, rows - 1, columns - 2);
+        chain.append_operation(Compute::UnaryOperation::Abs);
+        chain.append_operation(Compute::UnaryOperation::Sqrt);
+
+        REQUIRE(chain.size() > Compute::ElementwiseChain::TASK_SIZE);
+
+        std::vector<double> parallel_result(chain.size());
+        chain.evaluate(parallel_result.data(), chain.columns());
+
+        std::vector<double> serial_result(chain.size());
+        chain.evaluate_rows(0, chain.rows(), serial_result.data(), chain.columns());
+
+        REQUIRE(parallel_result == serial_result);
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that concatenated chains read their parts in place, padding them with zeros.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Concatenation matches the copied result", "[ElementwiseChain]")
+{
+    auto first_data = make_test_data(30, 700);
+    auto second_data = make_test_data(5, 900);
+
+    Compute::ElementwiseChain first(Compute::MatrixView(first_data.data(), 30, 700, 700));
+    first.append_operation(Compute::UnaryOperation::Abs);
+
+    Compute::ElementwiseChain second(Compute::MatrixView(second_data.data(), 5, 900, 900));
+    second.select_region(1, 100, 4, 899);
+
+    // The element of the concatenation at (i,j) when a part is
+    // placed at (row_offset, column_offset) of it, zero outside of it
+    auto part_element = [&](int part, int64_t i, int64_t j)
+    {
+        if(part == 0)
+            return (i < 30 && j < 700) ? std::abs(first_data[i * 700 + j]) : 0.0;
+
+        return (i < 4 && j < 800) ? second_data[(i + 1) * 900 + (j + 100)] : 0.0;
+    };
+
+    SECTION("By rows")
+    {
+        auto chain = Compute::ElementwiseChain::concatenate({first, Compute::ElementwiseChain(), second}, Compute::ConcatenationDirection::Rows);
+        chain.append_operation(Compute::UnaryOperation::Negate);
+
+        REQUIRE(chain.is_concatenation());
+        REQUIRE(chain.rows() == 34);
+        REQUIRE(chain.columns() == 800);
+
+        std::vector<double> result(chain.size());
+        chain.evaluate(result.data(), chain.columns());
+
+        for(int64_t i = 0; i < 34; ++i)
+            for(int64_t j = 0; j < 800; ++j)
+                REQUIRE(result[i * 800 + j] == -(i < 30 ? part_element(0, i, j) : part_element(1, i - 30, j)));
+    }
+
+    SECTION("By columns, through a region that straddles both parts")
+    {
+        auto chain = Compute::ElementwiseChain::concatenate({first, second}, Compute::ConcatenationDirection::Columns);
+
+        REQUIRE(chain.rows() == 30);
+        REQUIRE(chain.columns() == 1500);
+
+        chain.select_region(2, 600, 10, 799);
+        chain.select_rows_and_columns({0, 1, 3, 8}, {0, 1, 99, 100, 101, 150, 199});
+
+        std::vector<double> result(chain.size());
+        chain.evaluate(result.data(), chain.columns());
+
+        std::vector<int64_t> expected_rows = {2, 3, 5, 10};
+        std::vector<int64_t> expected_columns = {600, 601, 699, 700, 701, 750, 799};
+
+        for(int64_t i = 0; i < 4; ++i)
+        {
+            for(int64_t j = 0; j < 7; ++j)
+            {
+                const int64_t row = expected_rows[i];
+                const int64_t column = expected_columns[j];
+
+                const double expected = (column < 700) ? part_element(0, row, column) : part_element(1, row, column - 700);
+                REQUIRE(result[i * 7 + j] == expected);
+            }
+        }
+    }
+
+    SECTION("Nested concatenations")
+    {
+        auto columns = Compute::ElementwiseChain::concatenate({first, second}, Compute::ConcatenationDirection::Columns);
+        auto chain = Compute::ElementwiseChain::concatenate({columns, first}, Compute::ConcatenationDirection::Rows);
+
+        REQUIRE(chain.rows() == 60);
+        REQUIRE(chain.columns() == 1500);
+
+        std::vector<double> result(chain.size());
+        chain.evaluate(result.data(), chain.columns());
+
+        REQUIRE(result[4 * 1500 + 1000] == 0.0);
+        REQUIRE(result[3 * 1500 + 1000] == part_element(1, 3, 300));
+        REQUIRE(result[45 * 1500 + 10] == part_element(0, 15, 10));
+        REQUIRE(result[45 * 1500 + 710] == 0.0);
+    }
+
+    SECTION("Only empty parts")
+    {
+        auto chain = Compute::ElementwiseChain::concatenate({Compute::ElementwiseChain()}, Compute::ConcatenationDirection::Rows);
+
+        REQUIRE_FALSE(chain.is_concatenation());
+        REQUIRE(chain.size() == 0);
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that every task of a parallel_for runs exactly once, even when nested.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Thread pool runs every task exactly once", "[ThreadPool]")
+{
+    Compute::ThreadPool thread_pool(4);
+    REQUIRE(thread_pool.get_number_of_threads() == 4);
+
+    std::vector<std::atomic<int>> counts(1000);
+
+    thread_pool.parallel_for(10, [&](int64_t i)
+    {
+        thread_pool.parallel_for(100, [&](int64_t j){ ++counts[i * 100 + j]; });
+    });
+
+    for(const auto& count : counts)
+        REQUIRE(count == 1);
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,255 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_fft.cpp
+ * @brief Tests for the fast Fourier transforms using the Catch2 framework.
+ *
+ * This file checks radix-2 and Bluestein transforms against a direct
+ * DFT, row, column and 2D transforms of real and complex matrices, and
+ * that inverse transforms give the input back.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <catch2/catch_all.hpp>
+#include <compute/elementwise_chain.hpp>
+#include <compute/fft.hpp>
+
+#include <cmath>
+#include <complex>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace
+{
+    using Compute::Complex;
+
+    // Direct DFT of count elements data[first + k * stride]
+    std::vector<Complex> compute_reference_dft(const std::vector<Complex>& data, int64_t first, int64_t count, int64_t stride, bool is_inverse)
+    {
+        const double pi = std::acos(-1.0);
+        const double sign = is_inverse ? 1.0 : -1.0;
+
+        std::vector<Complex> result(count);
+
+        for(int64_t k = 0; k < count; ++k)
+        {
+            Complex sum(0, 0);
+
+            for(int64_t t = 0; t < count; ++t)
+                sum += data[first + t * stride] * std::polar(1.0, sign * 2.0 * pi * double((k * t) % count) / double(count));
+
+            result[k] = is_inverse ? sum / double(count) : sum;
+        }
+
+        return result;
+    }
+
+    std::vector<double> make_test_data(int64_t count, double phase)
+    {
+        std::vector<double> data(count);
+
+        for(int64_t i = 0; i < count; ++i)
+            data[i] = std::sin(0.37 * double(i) + phase) * double(i % 7 + 1) + 0.25;
+
+        return data;
+    }
+
+    bool is_close(const Complex& value, const Complex& expected_value, double tolerance)
+    {
+        return std::abs(value - expected_value) <= tolerance;
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test plans of every kind of length against the direct DFT.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Plans match the direct DFT", "[FFT]")
+{
+    const int64_t lengths[] = {1, 2, 3, 4, 5, 7, 8, 12, 16, 17, 64, 100, 127, 256, 360};
+
+    for(int64_t length : lengths)
+    {
+        const auto plan = Compute::get_fft_plan(length);
+
+        REQUIRE(plan->get_length() == length);
+        REQUIRE(plan == Compute::get_fft_plan(length));
+        REQUIRE(plan->uses_bluestein() == (length > 1 && !Compute::FftPlan::is_power_of_2(length)));
+
+        const auto real = make_test_data(length, 0.0);
+        const auto imaginary = make_test_data(length, 1.0);
+
+        std::vector<Complex> data(length);
+        for(int64_t i = 0; i < length; ++i)
+            data[i] = Complex(real[i], imaginary[i]);
+
+        std::vector<Complex> scratch(plan->get_scratch_size());
+
+        for(bool is_inverse : {false, true})
+        {
+            auto result = data;
+            plan->transform(result.data(), is_inverse, scratch.data());
+
+            auto expected_result = compute_reference_dft(data, 0, length, 1, is_inverse);
+
+            int64_t number_of_mismatches = 0;
+
+            // transform() doesn't scale inverse transforms
+            for(int64_t k = 0; k < length; ++k)
+                number_of_mismatches += !is_close(result[k], expected_result[k] * (is_inverse ? double(length) : 1.0), 1e-9 * double(length));
+
+            REQUIRE(number_of_mismatches == 0);
+        }
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test row, column and 2D transforms of real and complex matrices.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Matrix transforms match the direct DFT", "[FFT]")
+{
+    struct Sizes { int64_t rows; int64_t columns; };
+
+    const Sizes sizes[] = {{1, 1}, {1, 16}, {7, 1}, {5, 12}, {33, 20}, {64, 9}, {3, 1000}};
+
+    for(const auto& size : sizes)
+    {
+        const int64_t count = size.rows * size.columns;
+
+        auto real = make_test_data(count, 0.0);
+        auto imaginary = make_test_data(count, 2.0);
+
+        const Compute::ElementwiseChain real_chain(Compute::MatrixView(real.data(), size.rows, size.columns, size.columns));
+        const Compute::ElementwiseChain imaginary_chain(Compute::MatrixView(imaginary.data(), size.rows, size.columns, size.columns));
+
+        for(bool is_real : {true, false})
+        {
+            std::vector<Complex> input(count);
+            for(int64_t i = 0; i < count; ++i)
+                input[i] = Complex(real[i], is_real ? 0.0 : imaginary[i]);
+
+            for(bool is_inverse : {false, true})
+            {
+                // Rows
+                std::vector<Complex> result(count);
+                Compute::compute_fft(real_chain, is_real ? nullptr : &imaginary_chain, Compute::FftAxis::Rows, is_inverse, result.data());
+
+                int64_t number_of_mismatches = 0;
+
+                for(int64_t i = 0; i < size.rows; ++i)
+                {
+                    const auto expected_row = compute_reference_dft(input, i * size.columns, size.columns, 1, is_inverse);
+
+                    for(int64_t j = 0; j < size.columns; ++j)
+                        number_of_mismatches += !is_close(result[i * size.columns + j], expected_row[j], 1e-9 * double(size.columns));
+                }
+
+                // Columns
+                Compute::compute_fft(real_chain, is_real ? nullptr : &imaginary_chain, Compute::FftAxis::Columns, is_inverse, result.data());
+
+                for(int64_t j = 0; j < size.columns; ++j)
+                {
+                    const auto expected_column = compute_reference_dft(input, j, size.rows, size.columns, is_inverse);
+
+                    for(int64_t i = 0; i < size.rows; ++i)
+                        number_of_mismatches += !is_close(result[i * size.columns + j], expected_column[i], 1e-9 * double(size.rows));
+                }
+
+                // 2D, the columns of the rows' transforms
+                std::vector<Complex> row_transforms(count);
+
+                for(int64_t i = 0; i < size.rows; ++i)
+                {
+                    const auto row = compute_reference_dft(input, i * size.columns, size.columns, 1, is_inverse);
+                    std::copy(row.begin(), row.end(), row_transforms.begin() + i * size.columns);
+                }
+
+                Compute::compute_fft(real_chain, is_real ? nullptr : &imaginary_chain, Compute::FftAxis::Both, is_inverse, result.data());
+
+                for(int64_t j = 0; j < size.columns; ++j)
+                {
+                    const auto expected_column = compute_reference_dft(row_transforms, j, size.rows, size.columns, is_inverse);
+
+                    for(int64_t i = 0; i < size.rows; ++i)
+                        number_of_mismatches += !is_close(result[i * size.columns + j], expected_column[i], 1e-9 * double(count));
+                }
+
+                REQUIRE(number_of_mismatches == 0);
+            }
+        }
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that inverse transforms give back the input, across many threaded rows.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Inverse transforms undo forward transforms", "[FFT]")
+{
+    const int64_t rows = 300;
+    const int64_t columns = 250;
+
+    auto real = make_test_data(rows * columns, 0.5);
+
+    Compute::ElementwiseChain chain(Compute::MatrixView(real.data(), rows, columns, columns));
+    chain.append_operation(Compute::UnaryOperation::Abs);
+
+    std::vector<Complex> spectrum(rows * columns);
+    Compute::compute_fft(chain, nullptr, Compute::FftAxis::Both, false, spectrum.data());
+
+    // Spectrum of a real matrix is conjugate symmetric
+    REQUIRE(is_close(spectrum[1 * columns + 2], std::conj(spectrum[(rows - 1) * columns + columns - 2]), 1e-8));
+
+    Compute::transform_rows(spectrum.data(), rows, columns, true, false);
+    Compute::transform_columns(spectrum.data(), rows, columns, true, false);
+
+    std::vector<double> values(rows * columns);
+    Compute::extract_complex_part(spectrum.data(), rows * columns, Compute::ComplexPart::Real, values.data());
+
+    std::vector<double> imaginary_parts(rows * columns);
+    Compute::extract_complex_part(spectrum.data(), rows * columns, Compute::ComplexPart::Imaginary, imaginary_parts.data());
+
+    int64_t number_of_mismatches = 0;
+
+    for(int64_t i = 0; i < rows * columns; ++i)
+    {
+        number_of_mismatches += std::abs(values[i] - std::abs(real[i])) > 1e-9;
+        number_of_mismatches += std::abs(imaginary_parts[i]) > 1e-9;
+    }
+
+    REQUIRE(number_of_mismatches == 0);
+
+    // Parts of a single value
+    const Complex value(3, -4);
+    double part = 0;
+
+    Compute::extract_complex_part(&value, 1, Compute::ComplexPart::Magnitude, &part);
+    REQUIRE(part == Catch::Approx(5));
+
+    Compute::extract_complex_part(&value, 1, Compute::ComplexPart::Power, &part);
+    REQUIRE(part == Catch::Approx(25));
+
+    Compute::extract_complex_part(&value, 1, Compute::ComplexPart::Phase, &part);
+    REQUIRE(part == Catch::Approx(std::atan2(-4.0, 3.0)));
+}
+//-------------------------------------------------------------------
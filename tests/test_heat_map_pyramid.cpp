@@ -0,0 +1,239 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_heat_map_pyramid.cpp
+ * @brief Tests for the aggregated heat map pyramid using the Catch2 framework.
+ *
+ * This file checks the sizes and values of the aggregated levels, that
+ * means of upper levels are the means of the matrix cells they cover,
+ * the choice of level for a zoom, and the coloring of tiles.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <catch2/catch_all.hpp>
+#include <compute/heat_map_pyramid.hpp>
+
+#include <cmath>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that each level aggregates 2x2 blocks of the level below.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Heat map levels aggregate blocks of cells", "[HeatMapPyramid]")
+{
+    const int64_t rows = 1000;
+    const int64_t columns = 601;
+
+    std::vector<double> data(rows * columns);
+    for(int64_t i = 0; i < rows; ++i)
+        for(int64_t j = 0; j < columns; ++j)
+            data[i * columns + j] = double((i * 31 + j * 17) % 101);
+
+    data[5 * columns + 7] = std::nan("");
+
+    Compute::MatrixView view(data.data(), rows, columns, columns);
+
+    for(auto aggregation : {Compute::HeatMapAggregation::Mean, Compute::HeatMapAggregation::Max})
+    {
+        Compute::HeatMapPyramid pyramid;
+        pyramid.build(view, aggregation);
+
+        // 1000x601 -> 500x301 -> 250x151 (fits in a tile)
+        REQUIRE(pyramid.get_number_of_levels() == 3);
+        REQUIRE(pyramid.rows(1) == 500);
+        REQUIRE(pyramid.columns(1) == 301);
+        REQUIRE(pyramid.rows(2) == 250);
+        REQUIRE(pyramid.columns(2) == 151);
+
+        REQUIRE(pyramid.get_minimum_value() == 0.0);
+        REQUIRE(pyramid.get_maximum_value() == 100.0);
+
+        for(int64_t i = 0; i < pyramid.rows(1); ++i)
+        {
+            for(int64_t j = 0; j < pyramid.columns(1); ++j)
+            {
+                double sum = 0.0;
+                double maximum = -1.0;
+                int count = 0;
+
+                for(int64_t k = 2 * i; k < std::min(rows, 2 * i + 2); ++k)
+                {
+                    for(int64_t l = 2 * j; l < std::min(columns, 2 * j + 2); ++l)
+                    {
+                        if(std::isnan(view(k,l)))
+                            continue;
+
+                        sum += view(k,l);
+                        maximum = std::max(maximum, view(k,l));
+                        ++count;
+                    }
+                }
+
+                const double expected = (aggregation == Compute::HeatMapAggregation::Mean) ? sum / count : maximum;
+                REQUIRE(pyramid.get_value(view, 1, i, j) == Catch::Approx(expected));
+            }
+        }
+
+        // A cell of level 2 covers 4x4 cells of the matrix
+        if(aggregation == Compute::HeatMapAggregation::Max)
+        {
+            double maximum = -1.0;
+            for(int64_t k = 40; k < 44; ++k)
+                for(int64_t l = 20; l < 24; ++l)
+                    maximum = std::max(maximum, view(k,l));
+
+            REQUIRE(pyramid.get_value(view, 2, 10, 5) == maximum);
+        }
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that every level's means are the means of the matrix cells they cover.
+ *
+ * Blocks along the last row and column are smaller, and NaNs leave
+ * holes, so averaging the cells below with equal weights would be off.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Heat map means are weighted by the cells they cover", "[HeatMapPyramid]")
+{
+    const int64_t rows = 1100;
+    const int64_t columns = 37;
+
+    std::vector<double> data(rows * columns);
+    for(int64_t i = 0; i < rows; ++i)
+        for(int64_t j = 0; j < columns; ++j)
+            data[i * columns + j] = double((i * 7 + j * 13) % 53) - 20.0;
+
+    // A few NaNs, and a whole block of them
+    for(int64_t i = 0; i < rows; i += 97)
+        data[i * columns + (i % columns)] = std::nan("");
+    for(int64_t i = 8; i < 16; ++i)
+        for(int64_t j = 0; j < 8; ++j)
+            data[i * columns + j] = std::nan("");
+
+    Compute::MatrixView view(data.data(), rows, columns, columns);
+
+    Compute::HeatMapPyramid pyramid;
+    pyramid.build(view, Compute::HeatMapAggregation::Mean);
+
+    // 1100x37 -> 550x19 -> 275x10 -> 138x5
+    REQUIRE(pyramid.get_number_of_levels() == 4);
+
+    int64_t number_of_mismatches = 0;
+
+    for(int64_t level = 1; level < pyramid.get_number_of_levels(); ++level)
+    {
+        const int64_t cell_size = Compute::HeatMapPyramid::get_cell_size(level);
+
+        for(int64_t i = 0; i < pyramid.rows(level); ++i)
+        {
+            for(int64_t j = 0; j < pyramid.columns(level); ++j)
+            {
+                double sum = 0.0;
+                int64_t count = 0;
+
+                for(int64_t k = i * cell_size; k < std::min(rows, (i + 1) * cell_size); ++k)
+                {
+                    for(int64_t l = j * cell_size; l < std::min(columns, (j + 1) * cell_size); ++l)
+                    {
+                        if(std::isnan(view(k,l)))
+                            continue;
+
+                        sum += view(k,l);
+                        ++count;
+                    }
+                }
+
+                const double value = pyramid.get_value(view, level, i, j);
+
+                if(count == 0)
+                    number_of_mismatches += !std::isnan(value);
+                else
+                    number_of_mismatches += std::abs(value - sum / double(count)) > 1e-4;
+            }
+        }
+    }
+
+    REQUIRE(number_of_mismatches == 0);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that the chosen level has about one cell per pixel.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Heat map level matches the zoom", "[HeatMapPyramid]")
+{
+    std::vector<double> data(4096 * 4096, 1.0);
+    Compute::MatrixView view(data.data(), 4096, 4096, 4096);
+
+    Compute::HeatMapPyramid pyramid;
+    pyramid.build(view, Compute::HeatMapAggregation::Mean);
+
+    REQUIRE(pyramid.get_number_of_levels() == 5);
+
+    REQUIRE(pyramid.choose_level(4096, 4096, 512, 512) == 3);
+    REQUIRE(pyramid.choose_level(4096, 4096, 4000, 4000) == 0);
+    REQUIRE(pyramid.choose_level(300, 300, 512, 512) == 0);
+    REQUIRE(pyramid.choose_level(4096, 4096, 10, 10) == 4);
+    REQUIRE(pyramid.choose_level(4096, 1024, 512, 1024) == 3);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that tiles are colored over the range of values, with transparent NaNs.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Heat map tiles are colored over the range of values", "[HeatMapPyramid]")
+{
+    const int64_t rows = 300;
+    const int64_t columns = 2;
+
+    std::vector<double> data(rows * columns);
+    for(int64_t i = 0; i < rows * columns; ++i)
+        data[i] = double(i) - 10.0;
+    data[3] = std::nan("");
+
+    Compute::MatrixView view(data.data(), rows, columns, columns);
+
+    Compute::HeatMapPyramid pyramid;
+    pyramid.build(view, Compute::HeatMapAggregation::Mean);
+
+    std::vector<uint32_t> colormap(Compute::HeatMapPyramid::COLORMAP_SIZE);
+    for(std::size_t i = 0; i < colormap.size(); ++i)
+        colormap[i] = uint32_t(i) + 1;
+
+    std::vector<uint32_t> image;
+    int64_t tile_rows = 0;
+    int64_t tile_columns = 0;
+
+    pyramid.color_tile(view, 0, 1, 0, colormap, image, tile_rows, tile_columns);
+    REQUIRE(tile_rows == rows - Compute::HeatMapPyramid::TILE_SIZE);
+    REQUIRE(tile_columns == 2);
+    REQUIRE(image.back() == colormap.back());
+
+    pyramid.color_tile(view, 0, 0, 0, colormap, image, tile_rows, tile_columns);
+    REQUIRE(tile_rows == Compute::HeatMapPyramid::TILE_SIZE);
+    REQUIRE(image[0] == colormap.front());
+    REQUIRE(image[3] == 0);
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,70 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_image_conversion.cpp
+ * @brief Tests for the conversion of 8-bit images into matrices using the Catch2 framework.
+ *
+ * This file checks that rgb and rgba images convert to the same packed
+ * and planar matrices as a plain per-pixel loop, whatever their width.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <catch2/catch_all.hpp>
+#include <compute/image_conversion.hpp>
+
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that rgb(a) images convert like a per-pixel loop.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Images convert to packed and planar matrices", "[ImageConversion]")
+{
+    for(int64_t pixel_size : {int64_t(3), int64_t(4)})
+    {
+        for(int64_t columns : {int64_t(1), int64_t(5), int64_t(64), int64_t(67)})
+        {
+            const int64_t rows = 37;
+
+            std::vector<uint8_t> pixels(rows * columns * pixel_size);
+            for(std::size_t i = 0; i < pixels.size(); ++i)
+                pixels[i] = uint8_t((i * 37 + 11) % 256);
+
+            std::vector<double> packed(rows * columns * 3, -1.0);
+            std::vector<double> planar(rows * columns * 3, -1.0);
+
+            Compute::convert_rgb_image(pixels.data(), pixel_size, rows, columns, Compute::ChannelLayout::Packed, packed.data());
+            Compute::convert_rgb_image(pixels.data(), pixel_size, rows, columns, Compute::ChannelLayout::Planar, planar.data());
+
+            int64_t number_of_mismatches = 0;
+
+            for(int64_t i = 0; i < rows; ++i)
+            {
+                for(int64_t j = 0; j < columns; ++j)
+                {
+                    for(int64_t channel = 0; channel < 3; ++channel)
+                    {
+                        const double expected_value = pixels[(i * columns + j) * pixel_size + channel];
+
+                        if(packed[i * columns * 3 + 3 * j + channel] != expected_value)
+                            ++number_of_mismatches;
+
+                        if(planar[i * columns * 3 + channel * columns + j] != expected_value)
+                            ++number_of_mismatches;
+                    }
+                }
+            }
+
+            REQUIRE(number_of_mismatches == 0);
+        }
+    }
+}
+//-------------------------------------------------------------------
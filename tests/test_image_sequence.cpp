@@ -0,0 +1,195 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_image_sequence.cpp
+ * @brief Tests for image sequences and the prefetch ring using the Catch2 framework.
+ *
+ * This file checks that the files of a sequence are listed in natural
+ * order, that the prefetch ring keeps a bounded window of frames
+ * loading ahead and hands out the right ones, and that it bounds the
+ * frames loading at once and never loads the ones dropped meanwhile.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <catch2/catch_all.hpp>
+#include <compute/image_sequence.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that a directory's files of one extension are listed in natural order.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Image sequences are listed in natural order", "[ImageSequence]")
+{
+    REQUIRE(Compute::is_natural_order_less("frame_2.png", "frame_10.png"));
+    REQUIRE(Compute::is_natural_order_less("frame_009.png", "frame_10.png"));
+    REQUIRE_FALSE(Compute::is_natural_order_less("frame_10.png", "frame_2.png"));
+    REQUIRE(Compute::is_natural_order_less("a.png", "b.png"));
+    REQUIRE(Compute::is_natural_order_less("frame.png", "frame_1.png"));
+
+    const auto directory = std::filesystem::temp_directory_path() / "lazydata_test_image_sequence";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    for(const char* name : {"frame_10.png", "frame_2.PNG", "frame_1.png", "notes.txt", "frame_3.jpg"})
+        std::ofstream(directory / name) << "x";
+
+    const auto frames = Compute::list_image_sequence(directory / "frame_1.png");
+
+    REQUIRE(frames.size() == 3);
+    REQUIRE(frames[0].filename() == "frame_1.png");
+    REQUIRE(frames[1].filename() == "frame_2.PNG");
+    REQUIRE(frames[2].filename() == "frame_10.png");
+
+    REQUIRE(Compute::list_image_sequence(directory / "missing" / "frame_1.png").empty());
+
+    std::filesystem::remove_all(directory);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that the prefetch ring loads a bounded window of frames ahead.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Prefetch ring loads frames ahead", "[ImageSequence]")
+{
+    std::atomic<int64_t> number_of_loads{0};
+
+    Compute::PrefetchRing<int64_t> ring(3);
+    ring.set_loader([&](int64_t index)
+    {
+        ++number_of_loads;
+        return index * 10;
+    });
+
+    // Not in the ring, loaded on the spot
+    REQUIRE(ring.get(5) == 50);
+    REQUIRE(number_of_loads == 1);
+
+    // Only as many frames as the capacity are loaded
+    ring.prefetch(0, 100);
+
+    REQUIRE(ring.contains(0));
+    REQUIRE(ring.contains(2));
+    REQUIRE_FALSE(ring.contains(3));
+
+    for(int64_t index = 0; index < 3; ++index)
+        REQUIRE(ring.get(index) == index * 10);
+
+    REQUIRE(number_of_loads == 4);
+
+    // Moving the window only loads the frames that weren't in it
+    ring.prefetch(1, 4);
+
+    REQUIRE_FALSE(ring.contains(0));
+    REQUIRE(ring.get(3) == 30);
+    REQUIRE(ring.get(1) == 10);
+    REQUIRE(number_of_loads == 5);
+
+    // Copies share the frames already loading
+    auto ring_copy = ring;
+    REQUIRE(ring_copy.get(2) == 20);
+    REQUIRE(number_of_loads == 5);
+
+    ring.clear();
+    REQUIRE_FALSE(ring.contains(1));
+    REQUIRE(ring.get_number_of_loading_frames() == 0);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that the ring's workers bound the frames loading at once, and skip dropped frames.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Prefetch ring bounds and cancels loading frames", "[ImageSequence]")
+{
+    std::atomic<bool> is_released{false};
+    std::atomic<int64_t> number_of_loading_frames{0};
+    std::atomic<int64_t> maximum_number_of_loading_frames{0};
+
+    std::mutex mutex;
+    std::vector<int64_t> loaded_indices;
+
+    Compute::PrefetchRing<int64_t> ring(8, 2);
+    ring.set_loader([&](int64_t index)
+    {
+        const int64_t number_of_frames = ++number_of_loading_frames;
+
+        int64_t maximum = maximum_number_of_loading_frames;
+        while(number_of_frames > maximum && !maximum_number_of_loading_frames.compare_exchange_weak(maximum, number_of_frames))
+        {
+        }
+
+        while(!is_released)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            loaded_indices.push_back(index);
+        }
+
+        --number_of_loading_frames;
+
+        return index * 10;
+    });
+
+    ring.prefetch(0, 8);
+
+    // Both workers are busy, the other frames wait
+    while(number_of_loading_frames < 2)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    int64_t frame = -1;
+    REQUIRE_FALSE(ring.try_get(0, frame));
+    REQUIRE(ring.get_number_of_loading_frames() == 8);
+
+    // Moving far away drops the waiting frames, and the two loading
+    ring.prefetch({100, 101});
+
+    REQUIRE_FALSE(ring.contains(2));
+    REQUIRE(ring.get_number_of_loading_frames() == 4);
+
+    is_released = true;
+
+    REQUIRE(ring.get(101) == 1010);
+    REQUIRE(ring.get(100) == 1000);
+    REQUIRE(ring.try_get(100, frame));
+    REQUIRE(frame == 1000);
+
+    // The frames dropped while loading are thrown away
+    REQUIRE_FALSE(ring.contains(0));
+    REQUIRE_FALSE(ring.contains(1));
+
+    while(ring.get_number_of_loading_frames() > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    REQUIRE(maximum_number_of_loading_frames == 2);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::sort(loaded_indices.begin(), loaded_indices.end());
+    REQUIRE(loaded_indices == std::vector<int64_t>{0, 1, 100, 101});
+}
+//-------------------------------------------------------------------
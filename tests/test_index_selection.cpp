@@ -0,0 +1,110 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_index_selection.cpp
+ * @brief Tests for the bitset row/column selections using the Catch2 framework.
+ *
+ * This file checks selecting and deselecting indices and ranges,
+ * resizing selections, and listing the selected indices and runs.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <catch2/catch_all.hpp>
+#include <compute/index_selection.hpp>
+
+#include <set>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that the selection matches a std::set after random changes.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Selection matches a set of indices", "[IndexSelection]")
+{
+    const int64_t size = 1000;
+
+    Compute::IndexSelection selection(size);
+    std::set<int64_t> expected;
+
+    uint64_t state = 12345;
+    auto next_random = [&](){ state = state * 6364136223846793005ULL + 1442695040888963407ULL; return int64_t(state >> 33); };
+
+    for(int step = 0; step < 200; ++step)
+    {
+        const int64_t first = next_random() % size;
+        const int64_t last = std::min(size, first + next_random() % 150);
+        const bool is_selected = (next_random() % 3) != 0;
+
+        selection.select_range(first, last, is_selected);
+
+        for(int64_t i = first; i < last; ++i)
+        {
+            if(is_selected)
+                expected.insert(i);
+            else
+                expected.erase(i);
+        }
+
+        const int64_t index = next_random() % size;
+        selection.deselect(index);
+        expected.erase(index);
+    }
+
+    REQUIRE(selection.count() == int64_t(expected.size()));
+    REQUIRE(selection.to_indices() == std::vector<int64_t>(expected.begin(), expected.end()));
+
+    std::vector<int64_t> indices_from_ranges;
+    for(const auto& range : selection.to_ranges())
+    {
+        REQUIRE(range.first < range.second);
+        REQUIRE_FALSE(selection.is_selected(range.second));
+
+        for(int64_t i = range.first; i < range.second; ++i)
+            indices_from_ranges.push_back(i);
+    }
+
+    REQUIRE(indices_from_ranges == selection.to_indices());
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that resizing drops indices out of range and that select all respects the size.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Selection resizing and select all", "[IndexSelection]")
+{
+    Compute::IndexSelection selection(130);
+    selection.select_all();
+
+    REQUIRE(selection.count() == 130);
+    REQUIRE(selection.are_all_selected());
+    REQUIRE(selection.to_ranges() == std::vector<std::pair<int64_t, int64_t>>{{0, 130}});
+
+    selection.resize(70);
+    REQUIRE(selection.count() == 70);
+
+    selection.resize(200);
+    REQUIRE(selection.count() == 70);
+    REQUIRE_FALSE(selection.is_selected(100));
+    REQUIRE_FALSE(selection.are_all_selected());
+
+    selection.select(500);
+    selection.select(-1);
+    REQUIRE(selection.count() == 70);
+
+    selection.clear();
+    REQUIRE(selection.to_indices().empty());
+    REQUIRE(selection.to_ranges().empty());
+}
+//-------------------------------------------------------------------
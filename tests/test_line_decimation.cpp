@@ -0,0 +1,160 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_line_decimation.cpp
+ * @brief Tests for the min/max line decimation pyramid using the Catch2 framework.
+ *
+ * This file checks that decimated lines keep the extremes of every
+ * visible bucket, stay in order, and return about two points per pixel
+ * whatever the zoom level.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <catch2/catch_all.hpp>
+#include <compute/line_decimation.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace
+{
+    std::vector<double> make_test_line(int64_t number_of_points)
+    {
+        std::vector<double> y(number_of_points);
+
+        for(int64_t i = 0; i < number_of_points; ++i)
+            y[i] = std::sin(0.001 * double(i)) + ((i % 9973 == 0) ? 5.0 : 0.0);
+
+        return y;
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that the whole line decimates to a few points per pixel and keeps its extremes.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Decimated line keeps the extremes", "[LineDecimation]")
+{
+    const int64_t number_of_points = 1000000;
+    auto y = make_test_line(number_of_points);
+
+    Compute::LineDecimation line_decimation;
+    line_decimation.build(nullptr, y.data(), number_of_points);
+
+    REQUIRE(line_decimation.get_number_of_levels() > 1);
+
+    std::vector<double> xs;
+    std::vector<double> ys;
+    line_decimation.get_points(nullptr, y.data(), 0.0, double(number_of_points), 500, xs, ys);
+
+    REQUIRE(xs.size() == ys.size());
+    REQUIRE(ys.size() <= 4 * 500);
+    REQUIRE(ys.size() >= 2 * 500);
+    REQUIRE(std::is_sorted(xs.begin(), xs.end()));
+
+    REQUIRE(*std::max_element(ys.begin(), ys.end()) == *std::max_element(y.begin(), y.end()));
+    REQUIRE(*std::min_element(ys.begin(), ys.end()) == *std::min_element(y.begin(), y.end()));
+
+    // Every point is a point of the line
+    for(std::size_t i = 0; i < xs.size(); ++i)
+        REQUIRE(ys[i] == y[int64_t(xs[i])]);
+
+    // Every spike is visible
+    for(int64_t i = 0; i < number_of_points; i += 9973)
+        REQUIRE(std::find(xs.begin(), xs.end(), double(i)) != xs.end());
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that zooming in returns the visible points of the line themselves.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Zoomed in decimation returns the visible points", "[LineDecimation]")
+{
+    const int64_t number_of_points = 200000;
+    auto y = make_test_line(number_of_points);
+
+    std::vector<double> x(number_of_points);
+    for(int64_t i = 0; i < number_of_points; ++i)
+        x[i] = 0.5 * double(i) - 100.0;
+
+    Compute::LineDecimation line_decimation;
+    line_decimation.build(x.data(), y.data(), number_of_points);
+    REQUIRE(line_decimation.is_x_sorted());
+
+    std::vector<double> xs;
+    std::vector<double> ys;
+    line_decimation.get_points(x.data(), y.data(), 1000.0, 1100.0, 800, xs, ys);
+
+    REQUIRE(std::is_sorted(xs.begin(), xs.end()));
+
+    // The 201 visible points and their neighbours are all there
+    const int64_t first_visible = 2200;
+    const int64_t last_visible = 2400;
+
+    auto first = std::find(xs.begin(), xs.end(), x[first_visible - 1]);
+    REQUIRE(first != xs.end());
+
+    for(int64_t i = first_visible - 1; i <= last_visible + 1; ++i, ++first)
+    {
+        REQUIRE(*first == x[i]);
+        REQUIRE(ys[first - xs.begin()] == y[i]);
+    }
+
+    // The rest of the line is only there coarsely
+    REQUIRE(xs.size() < 2 * Compute::LineDecimation::COARSEST_LEVEL_SIZE + 300);
+    REQUIRE(xs.front() <= x[100]);
+    REQUIRE(xs.back() >= x[number_of_points - 100]);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that short lines and lines with unsorted x are plotted whole.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Short and unsorted lines", "[LineDecimation]")
+{
+    std::vector<double> y = {3.0, 1.0, 2.0};
+
+    Compute::LineDecimation line_decimation;
+    line_decimation.build(nullptr, y.data(), 3);
+
+    std::vector<double> xs;
+    std::vector<double> ys;
+    line_decimation.get_points(nullptr, y.data(), -10.0, 10.0, 100, xs, ys);
+
+    REQUIRE(xs == std::vector<double>{0.0, 1.0, 2.0});
+    REQUIRE(ys == y);
+
+    std::vector<double> x(5000);
+    std::vector<double> long_y(5000, 1.0);
+    for(int64_t i = 0; i < 5000; ++i)
+        x[i] = double((i * 7919) % 5000);
+
+    line_decimation.build(x.data(), long_y.data(), 5000);
+    REQUIRE_FALSE(line_decimation.is_x_sorted());
+
+    line_decimation.get_points(x.data(), long_y.data(), 0.0, 1.0, 10, xs, ys);
+    REQUIRE(ys.size() >= 2 * 10);
+    REQUIRE(ys.size() < 5000);
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,104 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_matrix_file.cpp
+ * @brief Tests for saving results to matrix files and attaching them back using the Catch2 framework.
+ *
+ * This file checks that results written to matrix files are attached
+ * back without being copied, that attached files are left untouched and
+ * that files that changed since they were saved are detected.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <catch2/catch_all.hpp>
+#include <compute/matrix_file.hpp>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that a saved result is attached back as it was saved.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Matrix files are attached back without copying", "[MatrixFile]")
+{
+    const auto directory = std::filesystem::temp_directory_path() / "lazydata_test_matrix_file";
+    std::filesystem::create_directories(directory);
+
+    const auto filename = directory / "result.lzd";
+
+    std::vector<double> data(6 * 4);
+    for(std::size_t i = 0; i < data.size(); ++i)
+        data[i] = double(i);
+
+    // Save the transpose of the data, which doesn't have contiguous rows
+    Compute::MatrixView view(data.data(), 6, 4, 4);
+    REQUIRE(Compute::write_matrix_file(view.transposed(), filename));
+
+    const auto fingerprint = Compute::compute_matrix_file_fingerprint(filename);
+    REQUIRE(fingerprint.file_size == sizeof(Compute::SpillFileHeader) + 24 * sizeof(double));
+
+    {
+        Compute::MatrixStorage storage;
+        REQUIRE(storage.attach(filename));
+        REQUIRE(storage.get_tier() == Compute::MatrixStorage::Tier::Attached);
+        REQUIRE(storage.rows() == 4);
+        REQUIRE(storage.columns() == 6);
+        REQUIRE(storage.view()(3, 5) == view(5, 3));
+        REQUIRE(storage.view()(1, 2) == view(2, 1));
+
+        // Attached files are mapped copy-on-write
+        storage.data()[0] = -1.0;
+    }
+
+    // Releasing an attached storage keeps the file as it was
+    REQUIRE(std::filesystem::exists(filename));
+    REQUIRE(Compute::compute_matrix_file_fingerprint(filename) == fingerprint);
+
+    std::filesystem::remove_all(directory);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that files that changed since they were saved are detected.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Changed or invalid matrix files are detected", "[MatrixFile]")
+{
+    const auto directory = std::filesystem::temp_directory_path() / "lazydata_test_matrix_file";
+    std::filesystem::create_directories(directory);
+
+    const auto filename = directory / "result.lzd";
+
+    std::vector<double> data(10 * 10, 1.0);
+    REQUIRE(Compute::write_matrix_file(Compute::MatrixView(data.data(), 10, 10, 10), filename));
+
+    const auto fingerprint = Compute::compute_matrix_file_fingerprint(filename);
+
+    // Changing a value changes the hash
+    data[55] = 2.0;
+    REQUIRE(Compute::write_matrix_file(Compute::MatrixView(data.data(), 10, 10, 10), filename));
+    REQUIRE(Compute::compute_matrix_file_fingerprint(filename) != fingerprint);
+
+    // A truncated file can't be attached
+    std::filesystem::resize_file(filename, std::filesystem::file_size(filename) - sizeof(double));
+
+    Compute::MatrixStorage storage;
+    REQUIRE(!storage.attach(filename));
+    REQUIRE(storage.get_tier() == Compute::MatrixStorage::Tier::Empty);
+
+    // Neither can a missing file
+    REQUIRE(!storage.attach(directory / "missing.lzd"));
+    REQUIRE(Compute::compute_matrix_file_fingerprint(directory / "missing.lzd").file_size == 0);
+
+    std::filesystem::remove_all(directory);
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,154 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_matrix_generator.cpp
+ * @brief Tests for the procedural matrix generators using the Catch2 framework.
+ *
+ * This file checks the Philox generator against its known answers, that
+ * generated matrices have the expected elements, and that random ones
+ * come out the same however they're split across threads.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <catch2/catch_all.hpp>
+#include <compute/elementwise_chain.hpp>
+#include <compute/matrix_generator.hpp>
+
+#include <cmath>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test Philox4x32-10 against the known answers of its reference implementation.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Philox known answers", "[MatrixGenerator]")
+{
+    REQUIRE(Compute::philox4x32({0, 0, 0, 0}, {0, 0}) ==
+            std::array<uint32_t, 4>{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+
+    REQUIRE(Compute::philox4x32({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff}) ==
+            std::array<uint32_t, 4>{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd});
+
+    REQUIRE(Compute::philox4x32({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0}) ==
+            std::array<uint32_t, 4>{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1});
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that generated matrices have the expected elements.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Generated matrices", "[MatrixGenerator]")
+{
+    Compute::MatrixGenerator generator;
+    generator.rows = 3;
+    generator.columns = 4;
+
+    std::vector<double> values(12);
+
+    generator.type = Compute::GeneratorType::Iota;
+    generator.initial_value = 2;
+    generator.step = 0.5;
+
+    Compute::ElementwiseChain::generate(generator).evaluate(values.data(), 4);
+
+    for(int64_t i = 0; i < 12; ++i)
+        REQUIRE(values[i] == 2 + 0.5 * double(i));
+
+    generator.type = Compute::GeneratorType::SineWave;
+    generator.columns = 1;
+
+    Compute::ElementwiseChain::generate(generator).evaluate(values.data(), 1);
+
+    for(int64_t i = 0; i < 3; ++i)
+        REQUIRE(values[i] == Catch::Approx(std::sin(2 * 3.14159265358979 * 0.1 * double(i))));
+
+    // A region of a generated matrix, with an operation on top
+    generator.type = Compute::GeneratorType::Constant;
+    generator.columns = 4;
+    generator.value = -3;
+
+    auto chain = Compute::ElementwiseChain::generate(generator);
+    chain.select_region(1, 1, 2, 2);
+    chain.append_operation(Compute::UnaryOperation::Abs);
+
+    REQUIRE(chain.is_generated());
+    REQUIRE_FALSE(chain.is_strided_view());
+    REQUIRE(chain.rows() == 2);
+    REQUIRE(chain.columns() == 2);
+
+    values.assign(4, 0.0);
+    chain.evaluate(values.data(), 2);
+
+    REQUIRE(values == std::vector<double>{3, 3, 3, 3});
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that random matrices don't depend on how they're split up.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Random matrices are reproducible", "[MatrixGenerator]")
+{
+    Compute::MatrixGenerator generator;
+    generator.type = Compute::GeneratorType::Random;
+    generator.rows = 301;
+    generator.columns = 257;
+    generator.min_value = -2;
+    generator.max_value = 5;
+    generator.seed = 42;
+
+    const int64_t size = generator.rows * generator.columns;
+
+    // In parallel, through a chain
+    std::vector<double> parallel_values(size);
+    Compute::ElementwiseChain::generate(generator).evaluate(parallel_values.data(), generator.columns);
+
+    // Element by element, in reverse order
+    std::vector<double> single_values(size);
+    for(int64_t i = generator.rows - 1; i >= 0; --i)
+        for(int64_t j = generator.columns - 1; j >= 0; --j)
+            generator.generate(i, j, 1, &single_values[i * generator.columns + j]);
+
+    // In odd-sized segments
+    std::vector<double> segment_values(size);
+    for(int64_t i = 0; i < generator.rows; ++i)
+        for(int64_t j = 0; j < generator.columns; j += 7)
+            generator.generate(i, j, std::min(int64_t(7), generator.columns - j), &segment_values[i * generator.columns + j]);
+
+    REQUIRE(parallel_values == single_values);
+    REQUIRE(parallel_values == segment_values);
+
+    double sum = 0;
+    for(double value : parallel_values)
+    {
+        REQUIRE(value >= -2.0);
+        REQUIRE(value < 5.0);
+        sum += value;
+    }
+
+    REQUIRE(sum / double(size) == Catch::Approx(1.5).margin(0.05));
+
+    // Another seed gives other numbers
+    generator.seed = 43;
+
+    std::vector<double> other_values(size);
+    Compute::ElementwiseChain::generate(generator).evaluate(other_values.data(), generator.columns);
+
+    REQUIRE(other_values != parallel_values);
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,133 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_matrix_storage.cpp
+ * @brief Tests for the tiered storage of intermediate results using the Catch2 framework.
+ *
+ * This file checks that small results are kept in RAM, big ones are spilled
+ * to scratch files, budgets are respected and spill files are deleted as
+ * soon as their storage is released.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <catch2/catch_all.hpp>
+#include <compute/matrix_storage.hpp>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace
+{
+    // Sets a storage policy for the duration of a test
+    struct ScopedStoragePolicy
+    {
+        ScopedStoragePolicy(const Compute::StoragePolicy& policy)
+        : previous_policy(Compute::StorageManager::get_policy())
+        {
+            Compute::StorageManager::set_policy(policy);
+        }
+
+        ~ScopedStoragePolicy()
+        {
+            Compute::StorageManager::set_policy(previous_policy);
+        }
+
+        Compute::StoragePolicy previous_policy;
+    };
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that small results live in RAM and big results are spilled.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Storage tier depends on the size of the result", "[MatrixStorage]")
+{
+    Compute::StoragePolicy policy;
+    policy.ram_threshold_bytes = 1024;
+    policy.scratch_directory = std::filesystem::temp_directory_path() / "lazydata_test_scratch";
+
+    ScopedStoragePolicy scoped_policy(policy);
+
+    Compute::MatrixStorage small_storage;
+    REQUIRE(small_storage.resize(3, 3));
+    REQUIRE(small_storage.get_tier() == Compute::MatrixStorage::Tier::Ram);
+
+    std::filesystem::path spill_filename;
+
+    {
+        Compute::MatrixStorage big_storage;
+        REQUIRE(big_storage.resize(100, 50));
+        REQUIRE(big_storage.get_tier() == Compute::MatrixStorage::Tier::Spilled);
+
+        spill_filename = big_storage.get_spill_filename();
+        REQUIRE(std::filesystem::exists(spill_filename));
+        REQUIRE(spill_filename.parent_path() == policy.scratch_directory);
+
+        for(int64_t i = 0; i < big_storage.size(); ++i)
+            big_storage.data()[i] = double(i);
+
+        auto view = big_storage.view();
+        REQUIRE(view.rows() == 100);
+        REQUIRE(view.columns() == 50);
+        REQUIRE(view(99, 49) == 4999.0);
+    }
+
+    // The spill file is deleted together with its storage
+    REQUIRE(!std::filesystem::exists(spill_filename));
+
+    std::filesystem::remove_all(policy.scratch_directory);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that the RAM and spill budgets are respected.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Storage budgets are respected", "[MatrixStorage]")
+{
+    Compute::StoragePolicy policy;
+    policy.ram_threshold_bytes = 1024;
+    policy.ram_budget_bytes = Compute::StorageManager::get_ram_bytes_in_use() + 1024;
+    policy.spill_budget_bytes = Compute::StorageManager::get_spilled_bytes_in_use() + 1024;
+    policy.scratch_directory = std::filesystem::temp_directory_path() / "lazydata_test_scratch";
+
+    ScopedStoragePolicy scoped_policy(policy);
+
+    Compute::MatrixStorage first;
+    Compute::MatrixStorage second;
+    Compute::MatrixStorage third;
+
+    // 100 doubles = 800 bytes, the second one no longer fits
+    // in the RAM budget so it is spilled instead
+    REQUIRE(first.resize(10, 10));
+    REQUIRE(first.get_tier() == Compute::MatrixStorage::Tier::Ram);
+
+    REQUIRE(second.resize(10, 10));
+    REQUIRE(second.get_tier() == Compute::MatrixStorage::Tier::Spilled);
+
+    // Neither budget has room left
+    REQUIRE(!third.resize(10, 10));
+    REQUIRE(third.get_tier() == Compute::MatrixStorage::Tier::Empty);
+
+    // Releasing storage gives the bytes back
+    first.release();
+    REQUIRE(third.resize(10, 10));
+    REQUIRE(third.get_tier() == Compute::MatrixStorage::Tier::Ram);
+
+    second.release();
+    third.release();
+    std::filesystem::remove_all(policy.scratch_directory);
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,151 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_simd_unary_kernels.cpp
+ * @brief Tests for the vectorized unary kernels using the Catch2 framework.
+ *
+ * This file checks the kernel of every instruction set the CPU supports
+ * against the scalar definitions of the operations, including special
+ * values (signed zeros, infinities, NaNs, subnormals, values that
+ * overflow) and buffers whose size isn't a multiple of the vector width.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <catch2/catch_all.hpp>
+#include <compute/elementwise_operations.hpp>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+std::vector<double> get_test_values()
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    std::vector<double> values =
+    {
+        0.0, -0.0, 1.0, -1.0, 0.5, -0.5, 2.0, 1e-300, -1e-300,
+        std::numeric_limits<double>::denorm_min(),
+        -std::numeric_limits<double>::denorm_min(),
+        std::numeric_limits<double>::min(),
+        std::numeric_limits<double>::max(),
+        -std::numeric_limits<double>::max(),
+        infinity, -infinity,
+        std::numeric_limits<double>::quiet_NaN(),
+        700.0, -700.0, 709.7, -708.3, -745.0, -746.0, 710.0,
+        1000.0, -1000.0, 1023.5, -1022.5, -1074.0, -1075.0, 1024.0,
+        0.34657359, -0.34657359, 12.25, -12.25
+    };
+
+    std::mt19937_64 generator(12345);
+    std::uniform_real_distribution<double> distribution(-800.0, 800.0);
+
+    // An odd number of values, so that the tails are tested too
+    for(int i = 0; i < 1001; ++i)
+        values.push_back(distribution(generator));
+
+    return values;
+}
+
+
+
+bool are_equivalent(double value, double expected_value, double relative_tolerance)
+{
+    if(std::isnan(expected_value))
+        return std::isnan(value);
+
+    if(std::isinf(expected_value) || expected_value == 0.0 || relative_tolerance == 0.0)
+        return std::memcmp(&value, &expected_value, sizeof(double)) == 0;
+
+    return std::abs(value - expected_value) <= relative_tolerance * std::abs(expected_value);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test every kernel against the scalar definitions.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("SIMD unary kernels match the scalar definitions", "[SimdUnaryKernels]")
+{
+    const std::vector<double> values = get_test_values();
+
+    const Compute::UnaryOperation operations[] =
+    {
+        Compute::UnaryOperation::Negate,
+        Compute::UnaryOperation::Sign,
+        Compute::UnaryOperation::Abs,
+        Compute::UnaryOperation::Sqrt,
+        Compute::UnaryOperation::Exp,
+        Compute::UnaryOperation::Exp2
+    };
+
+    const int detected_instruction_set = int(Compute::detect_instruction_set());
+
+    for(int i = 0; i <= detected_instruction_set; ++i)
+    {
+        const Compute::InstructionSet instruction_set = Compute::InstructionSet(i);
+
+        for(Compute::UnaryOperation operation : operations)
+        {
+            // exp/exp2 are within a few ulps, the others are exact
+            const bool is_exponential = (operation == Compute::UnaryOperation::Exp ||
+                                         operation == Compute::UnaryOperation::Exp2);
+            const double relative_tolerance = is_exponential ? 1e-15 : 0.0;
+
+            // Every size up to a few vectors, then everything at once
+            for(std::size_t size : {std::size_t(1), std::size_t(3), std::size_t(7), std::size_t(9), std::size_t(17), values.size()})
+            {
+                for(std::size_t offset = 0; offset + size <= values.size(); offset += size)
+                {
+                    std::vector<double> data(values.begin() + offset, values.begin() + offset + size);
+
+                    Compute::apply_unary_operation(operation, data.data(), int64_t(data.size()), instruction_set);
+
+                    for(std::size_t j = 0; j < size; ++j)
+                    {
+                        const double expected_value = Compute::apply_unary_operation(operation, values[offset + j]);
+
+                        INFO(Compute::get_instruction_set_name(instruction_set) << " operation " << int(operation)
+                             << " of " << values[offset + j] << ": " << data[j] << " vs " << expected_value);
+                        REQUIRE(are_equivalent(data[j], expected_value, relative_tolerance));
+                    }
+
+                    if(size == values.size())
+                        break;
+                }
+            }
+        }
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that unsupported instruction sets fall back to supported ones.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Unsupported instruction sets fall back to supported ones", "[SimdUnaryKernels]")
+{
+    REQUIRE(int(Compute::get_instruction_set()) <= int(Compute::detect_instruction_set()));
+
+    std::vector<double> data = {4.0, 9.0, 16.0, 25.0, 36.0};
+
+    Compute::apply_unary_operation(Compute::UnaryOperation::Sqrt, data.data(), int64_t(data.size()), Compute::InstructionSet::AVX512);
+
+    REQUIRE(data == std::vector<double>{2.0, 3.0, 4.0, 5.0, 6.0});
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,282 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_statistics.cpp
+ * @brief Tests for the one pass matrix statistics using the Catch2 framework.
+ *
+ * This file checks global, row and column statistics against a plain
+ * two pass reference, on every instruction set, with NaNs, on fused
+ * chains that are evaluated while they're summarized, and on values
+ * far from zero where a naive sum of squares loses the variance.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <catch2/catch_all.hpp>
+#include <compute/elementwise_chain.hpp>
+#include <compute/statistics.hpp>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace
+{
+    std::vector<double> make_test_data(int64_t rows, int64_t columns, double offset = 0.0)
+    {
+        std::vector<double> data(rows * columns);
+
+        for(int64_t i = 0; i < rows * columns; ++i)
+            data[i] = offset + std::sin(0.37 * double(i)) * double(i % 17 + 1);
+
+        return data;
+    }
+
+    // Two pass statistics of the values data[first + k * stride], k < count
+    Compute::Statistics compute_reference_statistics(const std::vector<double>& data, int64_t first, int64_t count, int64_t stride)
+    {
+        Compute::Statistics statistics;
+
+        long double sum = 0;
+
+        for(int64_t k = 0; k < count; ++k)
+        {
+            const double x = data[first + k * stride];
+
+            if(std::isnan(x))
+            {
+                ++statistics.nan_count;
+                continue;
+            }
+
+            ++statistics.count;
+            sum += x;
+            statistics.sum_of_squares += x * x;
+            statistics.min = std::min(statistics.min, x);
+            statistics.max = std::max(statistics.max, x);
+        }
+
+        statistics.sum = double(sum);
+        statistics.mean = statistics.count > 0 ? double(sum / statistics.count) : 0.0;
+
+        for(int64_t k = 0; k < count; ++k)
+        {
+            const double x = data[first + k * stride];
+
+            if(!std::isnan(x))
+                statistics.m2 += (x - statistics.mean) * (x - statistics.mean);
+        }
+
+        return statistics;
+    }
+
+    bool is_close(double value, double expected_value, double relative_tolerance = 1e-9)
+    {
+        if(std::isnan(expected_value))
+            return std::isnan(value);
+
+        return std::abs(value - expected_value) <= relative_tolerance * std::max(1.0, std::abs(expected_value));
+    }
+
+    bool are_close(const Compute::Statistics& statistics, const Compute::Statistics& expected_statistics)
+    {
+        for(int i = 0; i < Compute::NUMBER_OF_STATISTICS; ++i)
+        {
+            const auto statistic = Compute::Statistic(i);
+
+            if(!is_close(statistics.get(statistic), expected_statistics.get(statistic)))
+                return false;
+        }
+
+        return true;
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test global, row and column statistics against the reference on every instruction set.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Statistics match the reference", "[Statistics]")
+{
+    struct Sizes { int64_t rows; int64_t columns; };
+
+    const Sizes sizes[] = {{1, 1}, {3, 7}, {1, 5000}, {300, 3}, {130, 1100}, {2000, 33}};
+
+    for(int i = 0; i <= int(Compute::detect_instruction_set()); ++i)
+    {
+        const auto instruction_set = Compute::InstructionSet(i);
+
+        for(const auto& size : sizes)
+        {
+            auto data = make_test_data(size.rows, size.columns);
+
+            // A few NaNs, and a column with nothing else
+            for(int64_t k = 0; k < size.rows * size.columns; k += 11)
+                data[k] = std::numeric_limits<double>::quiet_NaN();
+
+            if(size.columns > 2)
+            {
+                for(int64_t row = 0; row < size.rows; ++row)
+                    data[row * size.columns + 2] = std::numeric_limits<double>::quiet_NaN();
+            }
+
+            const Compute::ElementwiseChain chain(Compute::MatrixView(data.data(), size.rows, size.columns, size.columns));
+
+            const auto statistics = Compute::compute_statistics(chain, instruction_set);
+            REQUIRE(are_close(statistics, compute_reference_statistics(data, 0, size.rows * size.columns, 1)));
+
+            const auto row_statistics = Compute::compute_row_statistics(chain, instruction_set);
+            REQUIRE(int64_t(row_statistics.size()) == size.rows);
+
+            int64_t number_of_mismatches = 0;
+
+            for(int64_t row = 0; row < size.rows; ++row)
+                number_of_mismatches += !are_close(row_statistics[row], compute_reference_statistics(data, row * size.columns, size.columns, 1));
+
+            const auto column_statistics = Compute::compute_column_statistics(chain, instruction_set);
+            REQUIRE(int64_t(column_statistics.size()) == size.columns);
+
+            for(int64_t column = 0; column < size.columns; ++column)
+                number_of_mismatches += !are_close(column_statistics[column], compute_reference_statistics(data, column, size.rows, size.columns));
+
+            REQUIRE(number_of_mismatches == 0);
+        }
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that NaNs are counted and left out, and that all-NaN sets have no mean.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("NaNs are counted and skipped", "[Statistics]")
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    std::vector<double> data = {1, nan, 3, nan,
+                                nan, nan, nan, nan};
+
+    const Compute::ElementwiseChain chain(Compute::MatrixView(data.data(), 2, 4, 4));
+
+    const auto statistics = Compute::compute_statistics(chain);
+
+    REQUIRE(statistics.get(Compute::Statistic::Sum) == 4);
+    REQUIRE(statistics.get(Compute::Statistic::Mean) == 2);
+    REQUIRE(statistics.get(Compute::Statistic::Variance) == 1);
+    REQUIRE(statistics.get(Compute::Statistic::Min) == 1);
+    REQUIRE(statistics.get(Compute::Statistic::Max) == 3);
+    REQUIRE(statistics.get(Compute::Statistic::NanCount) == 6);
+    REQUIRE(statistics.get(Compute::Statistic::L2Norm) == Catch::Approx(std::sqrt(10.0)));
+
+    const auto row_statistics = Compute::compute_row_statistics(chain);
+
+    REQUIRE(row_statistics[1].get(Compute::Statistic::Sum) == 0);
+    REQUIRE(std::isnan(row_statistics[1].get(Compute::Statistic::Mean)));
+    REQUIRE(std::isnan(row_statistics[1].get(Compute::Statistic::Variance)));
+    REQUIRE(std::isnan(row_statistics[1].get(Compute::Statistic::Min)));
+    REQUIRE(row_statistics[1].get(Compute::Statistic::NanCount) == 4);
+
+    REQUIRE(Compute::compute_statistics(Compute::ElementwiseChain()).count == 0);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that fused and selected chains are summarized like their evaluated result.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Statistics of fused chains", "[Statistics]")
+{
+    const int64_t rows = 90;
+    const int64_t columns = 1300;
+    auto data = make_test_data(rows, columns);
+
+    Compute::ElementwiseChain chain(Compute::MatrixView(data.data(), rows, columns, columns));
+
+    chain.append_operation(Compute::UnaryOperation::Abs);
+    chain.select_region(5, 3, 80, 1290);
+    chain.append_operation(Compute::UnaryOperation::Sqrt);
+
+    std::vector<double> result(chain.size());
+    chain.evaluate(result.data(), chain.columns());
+
+    REQUIRE(are_close(Compute::compute_statistics(chain), compute_reference_statistics(result, 0, int64_t(result.size()), 1)));
+
+    const auto column_statistics = Compute::compute_column_statistics(chain);
+
+    int64_t number_of_mismatches = 0;
+
+    for(int64_t column = 0; column < chain.columns(); ++column)
+        number_of_mismatches += !are_close(column_statistics[column], compute_reference_statistics(result, column, chain.rows(), chain.columns()));
+
+    REQUIRE(number_of_mismatches == 0);
+
+    // A strided window is read in place
+    Compute::ElementwiseChain window(Compute::MatrixView(data.data(), rows, columns, columns));
+    window.select_region(10, 20, 49, 619);
+
+    REQUIRE(window.is_strided_view());
+
+    std::vector<double> window_result(window.size());
+    window.evaluate(window_result.data(), window.columns());
+
+    REQUIRE(are_close(Compute::compute_statistics(window), compute_reference_statistics(window_result, 0, int64_t(window_result.size()), 1)));
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that a small variance is kept on values with a large offset.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Variance survives a large offset", "[Statistics]")
+{
+    const int64_t rows = 3000;
+    const int64_t columns = 40;
+    const double offset = 1e9;
+
+    // Values offset + {-1, 0, 1}, whose variance is 2/3 whatever the offset
+    std::vector<double> data(rows * columns);
+
+    for(int64_t i = 0; i < rows * columns; ++i)
+        data[i] = offset + double((i / columns + i % columns) % 3) - 1.0;
+
+    const Compute::ElementwiseChain chain(Compute::MatrixView(data.data(), rows, columns, columns));
+
+    for(int i = 0; i <= int(Compute::detect_instruction_set()); ++i)
+    {
+        const auto instruction_set = Compute::InstructionSet(i);
+
+        const auto statistics = Compute::compute_statistics(chain, instruction_set);
+
+        REQUIRE(statistics.get(Compute::Statistic::Variance) == Catch::Approx(2.0 / 3.0).epsilon(1e-6));
+        REQUIRE(statistics.get(Compute::Statistic::Sum) == Catch::Approx(offset * double(rows * columns)).epsilon(1e-15));
+
+        const auto column_statistics = Compute::compute_column_statistics(chain, instruction_set);
+
+        for(int64_t column = 0; column < columns; column += 13)
+        {
+            REQUIRE(column_statistics[column].get(Compute::Statistic::Variance) == Catch::Approx(2.0 / 3.0).epsilon(1e-6));
+            REQUIRE(column_statistics[column].get(Compute::Statistic::Mean) == Catch::Approx(offset).epsilon(1e-15));
+        }
+    }
+}
+//-------------------------------------------------------------------
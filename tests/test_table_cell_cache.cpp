@@ -0,0 +1,143 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_table_cell_cache.cpp
+ * @brief Tests for the cache of formatted table cells using the Catch2 framework.
+ *
+ * This file drives the cache with the ranges of rows a list clipper
+ * asks for, frame after frame, and checks the cells are only formatted
+ * again when the rows shown, the page or the data change.
+ *
+ * @namespace DataFlow
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <catch2/catch_all.hpp>
+#include <dataflow/table_cell_cache.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+namespace
+{
+    const int64_t number_of_rows = 10000;
+    const int64_t number_of_columns = 6;
+
+    struct Formatter
+    {
+        int64_t number_of_formatted_cells = 0;
+
+        void operator()(int64_t row, int64_t column, std::string& text)
+        {
+            text += std::to_string(row) + "," + std::to_string(column);
+            ++number_of_formatted_cells;
+        }
+    };
+
+    // Caches and reads the ranges of rows of one frame, the way the table drawing does
+    bool draw_frame(DataFlow::TableCellCache& cache, const void* data, int page_index, const std::vector<std::pair<int64_t, int64_t>>& steps, Formatter& formatter)
+    {
+        bool are_cells_right = true;
+
+        for(const auto& [first_row, last_row] : steps)
+        {
+            cache.cache_cells(data, page_index, number_of_rows, first_row, last_row, 0, number_of_columns, formatter);
+
+            for(int64_t row = first_row; row < last_row; ++row)
+                for(int64_t column = 0; column < number_of_columns; ++column)
+                    are_cells_right &= cache.get_cell_text(row, column) == std::to_string(row) + "," + std::to_string(column);
+        }
+
+        return are_cells_right;
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that consecutive frames of a scrolled table don't refresh the cache.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Consecutive frames reuse the cached cells", "[TableCellCache]")
+{
+    DataFlow::TableCellCache cache;
+    Formatter formatter;
+    int data = 0;
+
+    // Header row, measured row and visible rows, as a clipper steps through them
+    const std::vector<std::pair<int64_t, int64_t>> steps = {{0, 1}, {1, 2}, {500, 530}};
+
+    REQUIRE(draw_frame(cache, &data, 0, steps, formatter));
+
+    const auto number_of_refreshes = cache.get_number_of_refreshes();
+    const auto number_of_formatted_cells = formatter.number_of_formatted_cells;
+
+    REQUIRE(number_of_refreshes == 2);
+
+    REQUIRE(draw_frame(cache, &data, 0, steps, formatter));
+    REQUIRE(cache.get_number_of_refreshes() == number_of_refreshes);
+    REQUIRE(formatter.number_of_formatted_cells == number_of_formatted_cells);
+
+    // Once the row height is known the clipper doesn't measure anymore
+    REQUIRE(draw_frame(cache, &data, 0, {{0, 1}, {500, 530}}, formatter));
+    REQUIRE(cache.get_number_of_refreshes() == number_of_refreshes);
+
+    // Scrolling a little stays within the cached margin
+    REQUIRE(draw_frame(cache, &data, 0, {{0, 1}, {510, 540}}, formatter));
+    REQUIRE(cache.get_number_of_refreshes() == number_of_refreshes);
+
+    // Scrolling to the top shows the pinned rows along with the body
+    DataFlow::TableCellCache top_cache;
+    REQUIRE(draw_frame(top_cache, &data, 0, {{0, 1}, {1, 30}}, formatter));
+    REQUIRE(draw_frame(top_cache, &data, 0, {{0, 1}, {1, 30}}, formatter));
+    REQUIRE(top_cache.get_number_of_refreshes() == 2);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that leaving the cached rows, changing the page or the data refreshes the cache.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("The cache is refreshed when what's shown changes", "[TableCellCache]")
+{
+    DataFlow::TableCellCache cache;
+    Formatter formatter;
+    int data = 0;
+    int other_data = 0;
+
+    REQUIRE(draw_frame(cache, &data, 0, {{0, 1}, {500, 530}}, formatter));
+    auto number_of_refreshes = cache.get_number_of_refreshes();
+
+    // Scrolling far away refreshes the body only
+    REQUIRE(draw_frame(cache, &data, 0, {{0, 1}, {5000, 5030}}, formatter));
+    REQUIRE(cache.get_number_of_refreshes() == number_of_refreshes + 1);
+    number_of_refreshes = cache.get_number_of_refreshes();
+
+    // Another page, other data or invalidated data refresh both parts
+    REQUIRE(draw_frame(cache, &data, 1, {{0, 1}, {5000, 5030}}, formatter));
+    REQUIRE(cache.get_number_of_refreshes() == number_of_refreshes + 2);
+
+    REQUIRE(draw_frame(cache, &other_data, 1, {{0, 1}, {5000, 5030}}, formatter));
+    REQUIRE(cache.get_number_of_refreshes() == number_of_refreshes + 4);
+
+    cache.invalidate();
+    REQUIRE(draw_frame(cache, &other_data, 1, {{0, 1}, {5000, 5030}}, formatter));
+    REQUIRE(cache.get_number_of_refreshes() == number_of_refreshes + 6);
+
+    // The last rows of the table
+    REQUIRE(draw_frame(cache, &other_data, 1, {{0, 1}, {number_of_rows - 20, number_of_rows}}, formatter));
+    REQUIRE(cache.get_number_of_refreshes() == number_of_refreshes + 7);
+}
+//-------------------------------------------------------------------
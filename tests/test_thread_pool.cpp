@@ -0,0 +1,74 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_thread_pool.cpp
+ * @brief Tests for the thread pool using the Catch2 framework.
+ *
+ * This file checks that parallel_for runs every task once, and that a
+ * task that throws has its exception rethrown to the calling thread
+ * instead of leaving it waiting.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <catch2/catch_all.hpp>
+#include <compute/thread_pool.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that every task runs exactly once.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("parallel_for runs every task once", "[ThreadPool]")
+{
+    Compute::ThreadPool thread_pool(4);
+
+    std::vector<std::atomic<int>> number_of_runs(1000);
+
+    thread_pool.parallel_for(int64_t(number_of_runs.size()), [&number_of_runs](int64_t i)
+    {
+        ++number_of_runs[i];
+    });
+
+    for(const auto& runs : number_of_runs)
+        REQUIRE(runs == 1);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that an exception thrown by a task reaches the calling thread.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("parallel_for rethrows the exception of a failed task", "[ThreadPool]")
+{
+    Compute::ThreadPool thread_pool(4);
+
+    auto failing_task = [](int64_t i)
+    {
+        if(i == 17)
+            throw std::runtime_error("task failed");
+    };
+
+    REQUIRE_THROWS_AS(thread_pool.parallel_for(100, failing_task), std::runtime_error);
+
+    // The pool is still usable afterwards
+    std::atomic<int64_t> sum{0};
+
+    thread_pool.parallel_for(100, [&sum](int64_t i){ sum += i; });
+
+    REQUIRE(sum == 4950);
+}
+//-------------------------------------------------------------------
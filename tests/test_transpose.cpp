@@ -0,0 +1,113 @@
+//-------------------------------------------------------------------
+/**
+ * @file test_transpose.cpp
+ * @brief Tests for the cache-blocked transposes using the Catch2 framework.
+ *
+ * This file checks the out-of-place, in-place and column-selecting
+ * transposes against a naive transpose, for sizes that aren't multiples
+ * of the tile size.
+ *
+ * @namespace Compute
+ */
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+#include <catch2/catch_all.hpp>
+#include <compute/transpose.hpp>
+
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that the out-of-place transpose matches a naive transpose.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Transpose matches a naive transpose", "[Transpose]")
+{
+    for(auto [rows, columns] : {std::pair<int64_t, int64_t>(1, 1),
+                                std::pair<int64_t, int64_t>(1, 1000),
+                                std::pair<int64_t, int64_t>(517, 3),
+                                std::pair<int64_t, int64_t>(301, 700)})
+    {
+        std::vector<double> data(rows * columns);
+        for(std::size_t i = 0; i < data.size(); ++i)
+            data[i] = double(i);
+
+        Compute::MatrixView view(data.data(), rows, columns, columns);
+
+        std::vector<double> result(data.size(), -1.0);
+        Compute::transpose(view, result.data(), rows);
+
+        for(int64_t i = 0; i < rows; ++i)
+            for(int64_t j = 0; j < columns; ++j)
+                REQUIRE(result[j * rows + i] == view(i,j));
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that square matrices are transposed onto themselves.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Square matrices are transposed in place", "[Transpose]")
+{
+    for(int64_t size : {2, 31, 32, 33, 250})
+    {
+        // Leave some padding at the end of each row
+        const int64_t row_stride = size + 3;
+
+        std::vector<double> data(size * row_stride, -1.0);
+        for(int64_t i = 0; i < size; ++i)
+            for(int64_t j = 0; j < size; ++j)
+                data[i * row_stride + j] = double(i * size + j);
+
+        Compute::transpose(Compute::MatrixView(data.data(), size, size, row_stride), data.data(), row_stride);
+
+        for(int64_t i = 0; i < size; ++i)
+        {
+            for(int64_t j = 0; j < size; ++j)
+                REQUIRE(data[i * row_stride + j] == double(j * size + i));
+
+            for(int64_t j = size; j < row_stride; ++j)
+                REQUIRE(data[i * row_stride + j] == -1.0);
+        }
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief Test that selected columns become the rows of the destination.
+ */
+//-------------------------------------------------------------------
+TEST_CASE("Selected columns are transposed into rows", "[Transpose]")
+{
+    const int64_t rows = 1000;
+    const int64_t columns = 6;
+
+    std::vector<double> data(rows * columns);
+    for(std::size_t i = 0; i < data.size(); ++i)
+        data[i] = double(i);
+
+    Compute::MatrixView view(data.data(), rows, columns, columns);
+
+    const std::vector<int64_t> selected_columns = {4, 1, 4};
+
+    std::vector<double> result(selected_columns.size() * rows);
+    Compute::transpose_columns(view, selected_columns.data(), int64_t(selected_columns.size()), result.data(), rows);
+
+    for(std::size_t k = 0; k < selected_columns.size(); ++k)
+        for(int64_t i = 0; i < rows; ++i)
+            REQUIRE(result[k * rows + i] == view(i, selected_columns[k]));
+}
+//-------------------------------------------------------------------